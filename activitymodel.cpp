@@ -0,0 +1,176 @@
+#include "activitymodel.h"
+#include <QColor>
+#include <QSet>
+
+namespace {
+
+// Longer statements are cut in the grid; the tooltip and the details pane
+// show everything the server returned.
+const int DisplayQueryChars = 200;
+
+QString formatDuration(qint64 ms) {
+    if (ms < 0) return QString();
+    if (ms < 60000) return QString("%1 s").arg(ms / 1000.0, 0, 'f', 1);
+    qint64 seconds = ms / 1000;
+    if (seconds < 3600) return QString("%1 min %2 s").arg(seconds / 60).arg(seconds % 60);
+    return QString("%1 h %2 min").arg(seconds / 3600).arg(seconds % 3600 / 60);
+}
+
+} // namespace
+
+ActivityModel::ActivityModel(QObject *parent)
+    : QAbstractTableModel(parent)
+{
+}
+
+int ActivityModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : sessions.size();
+}
+
+int ActivityModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant ActivityModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QVariant();
+    }
+    switch (section) {
+    case Id: return QObject::tr("ID");
+    case User: return QObject::tr("User");
+    case Database: return QObject::tr("Database");
+    case Client: return QObject::tr("Client");
+    case State: return QObject::tr("State");
+    case Wait: return QObject::tr("Wait");
+    case Running: return QObject::tr("Running");
+    case BlockedBy: return QObject::tr("Blocked By");
+    case Blocking: return QObject::tr("Blocking");
+    case Query: return QObject::tr("Query");
+    }
+    return QVariant();
+}
+
+QVariant ActivityModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= sessions.size()) {
+        return QVariant();
+    }
+    const ServerActivity::Session &session = sessions.at(index.row());
+
+    if (role == Qt::BackgroundRole) {
+        // Translucent, so the highlight works with light and dark themes.
+        if (session.blocking > 0) return QColor(220, 60, 60, 90);
+        if (!session.blockedBy.isEmpty()) return QColor(230, 160, 40, 90);
+        return QVariant();
+    }
+    if (role == Qt::ToolTipRole) {
+        if (index.column() == Query) return session.query;
+        if (index.column() == BlockedBy && !session.blockedBy.isEmpty()) return blockingChain(session.id);
+        return QVariant();
+    }
+    // Raw values for sorting through the proxy.
+    if (role == Qt::UserRole) {
+        switch (index.column()) {
+        case Id: return session.id.toLongLong();
+        case Running: return session.runningMs;
+        case Blocking: return session.blocking;
+        case BlockedBy: return session.blockedBy.size();
+        default: break;
+        }
+        return data(index, Qt::DisplayRole);
+    }
+    if (role != Qt::DisplayRole) {
+        return QVariant();
+    }
+
+    switch (index.column()) {
+    case Id: return session.id;
+    case User: return session.user;
+    case Database: return session.database;
+    case Client: return session.client;
+    case State: return session.state;
+    case Wait: return session.wait;
+    case Running: return formatDuration(session.runningMs);
+    case BlockedBy: return session.blockedBy.join(", ");
+    case Blocking: return session.blocking > 0 ? QString::number(session.blocking) : QString();
+    case Query: return session.query.simplified().left(DisplayQueryChars);
+    }
+    return QVariant();
+}
+
+const ServerActivity::Session &ActivityModel::session(int row) const
+{
+    return sessions.at(row);
+}
+
+void ActivityModel::update(const QVector<ServerActivity::Session> &snapshot)
+{
+    QHash<QString, int> incoming;
+    incoming.reserve(snapshot.size());
+    for (int i = 0; i < snapshot.size(); ++i) {
+        incoming.insert(snapshot.at(i).id, i);
+    }
+
+    // Sessions that ended, removed in runs from the bottom up.
+    for (int row = sessions.size() - 1; row >= 0; --row) {
+        if (incoming.contains(sessions.at(row).id)) continue;
+        int last = row;
+        while (row > 0 && !incoming.contains(sessions.at(row - 1).id)) --row;
+        beginRemoveRows(QModelIndex(), row, last);
+        sessions.erase(sessions.begin() + row, sessions.begin() + last + 1);
+        endRemoveRows();
+    }
+
+    // Sessions that changed, reported in runs of adjacent rows.
+    rowById.clear();
+    int runStart = -1;
+    for (int row = 0; row < sessions.size(); ++row) {
+        rowById.insert(sessions.at(row).id, row);
+        const ServerActivity::Session &fresh = snapshot.at(incoming.value(sessions.at(row).id));
+        bool changed = sessions.at(row) != fresh;
+        if (changed) {
+            sessions[row] = fresh;
+            if (runStart < 0) runStart = row;
+        }
+        if (runStart >= 0 && (!changed || row == sessions.size() - 1)) {
+            emit dataChanged(index(runStart, 0), index(changed ? row : row - 1, ColumnCount - 1));
+            runStart = -1;
+        }
+    }
+
+    // New sessions, appended.
+    QVector<ServerActivity::Session> added;
+    for (const ServerActivity::Session &session : snapshot) {
+        if (!rowById.contains(session.id)) added << session;
+    }
+    if (!added.isEmpty()) {
+        beginInsertRows(QModelIndex(), sessions.size(), sessions.size() + added.size() - 1);
+        for (const ServerActivity::Session &session : added) {
+            rowById.insert(session.id, sessions.size());
+            sessions << session;
+        }
+        endInsertRows();
+    }
+}
+
+QString ActivityModel::blockingChain(const QString &id) const
+{
+    QStringList chain = {id};
+    QSet<QString> seen = {id};
+    QString current = id;
+    while (true) {
+        int row = rowById.value(current, -1);
+        if (row < 0 || sessions.at(row).blockedBy.isEmpty()) break;
+        current = sessions.at(row).blockedBy.first();
+        if (seen.contains(current)) {
+            chain << QObject::tr("%1 (deadlock)").arg(current);
+            break;
+        }
+        seen.insert(current);
+        chain << current;
+    }
+    return chain.join(QObject::tr(" waits for "));
+}
@@ -0,0 +1,34 @@
+#ifndef ACTIVITYMODEL_H
+#define ACTIVITYMODEL_H
+
+#include <QAbstractTableModel>
+#include <QHash>
+#include <QVector>
+#include "serveractivity.h"
+
+// Sessions shown by the activity monitor. update() diffs a new snapshot
+// against the current rows by session id and reports only removed, changed
+// and added rows, so views keep selection and scroll position and repaint
+// only what moved.
+class ActivityModel : public QAbstractTableModel {
+public:
+    enum Column { Id, User, Database, Client, State, Wait, Running, BlockedBy, Blocking, Query, ColumnCount };
+
+    explicit ActivityModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    void update(const QVector<ServerActivity::Session> &snapshot);
+    const ServerActivity::Session &session(int row) const;
+    // "a waits for b waits for c", following the first blocker of each session.
+    QString blockingChain(const QString &id) const;
+
+private:
+    QVector<ServerActivity::Session> sessions;
+    QHash<QString, int> rowById;
+};
+
+#endif // ACTIVITYMODEL_H
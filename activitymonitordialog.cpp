@@ -0,0 +1,203 @@
+#include "activitymonitordialog.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QSplitter>
+#include <QHeaderView>
+#include <QMessageBox>
+#include <QLocale>
+#include <QTime>
+#include <QtConcurrent>
+
+ActivityMonitorDialog::ActivityMonitorDialog(QWidget *parent, const QString &serverName,
+                                             const DatabaseConnection::ConnectionParams &params)
+    : QDialog(parent), activity(params), settings("DBManager", "Settings")
+{
+    setWindowTitle(tr("Activity - %1").arg(serverName));
+    resize(1000, 600);
+
+    // One thread that never expires: the monitor's connection lives on it.
+    pool.setMaxThreadCount(1);
+    pool.setExpiryTimeout(-1);
+
+    auto layout = new QVBoxLayout(this);
+    auto controlsLayout = new QHBoxLayout;
+    controlsLayout->addWidget(new QLabel(tr("Refresh every"), this));
+    intervalSpinBox = new QDoubleSpinBox(this);
+    intervalSpinBox->setRange(0.5, 60.0);
+    intervalSpinBox->setSingleStep(0.5);
+    intervalSpinBox->setDecimals(1);
+    intervalSpinBox->setSuffix(tr(" s"));
+    intervalSpinBox->setValue(settings.value("activity/interval", 2.0).toDouble());
+    controlsLayout->addWidget(intervalSpinBox);
+    idleCheckBox = new QCheckBox(tr("Show idle sessions"), this);
+    idleCheckBox->setChecked(settings.value("activity/showIdle", false).toBool());
+    controlsLayout->addWidget(idleCheckBox);
+    pauseButton = new QPushButton(tr("Pause"), this);
+    controlsLayout->addWidget(pauseButton);
+    controlsLayout->addStretch();
+    cancelButton = new QPushButton(tr("Cancel Query"), this);
+    killButton = new QPushButton(tr("Kill Session"), this);
+    controlsLayout->addWidget(cancelButton);
+    controlsLayout->addWidget(killButton);
+    layout->addLayout(controlsLayout);
+
+    auto splitter = new QSplitter(Qt::Vertical, this);
+    model = new ActivityModel(this);
+    proxy = new QSortFilterProxyModel(this);
+    proxy->setSourceModel(model);
+    proxy->setSortRole(Qt::UserRole);
+    sessionsView = new QTableView(splitter);
+    sessionsView->setModel(proxy);
+    sessionsView->setSortingEnabled(true);
+    sessionsView->sortByColumn(ActivityModel::Running, Qt::DescendingOrder);
+    sessionsView->setSelectionBehavior(QAbstractItemView::SelectRows);
+    sessionsView->setSelectionMode(QAbstractItemView::SingleSelection);
+    sessionsView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    sessionsView->verticalHeader()->hide();
+    sessionsView->verticalHeader()->setDefaultSectionSize(sessionsView->fontMetrics().height() + 6);
+    sessionsView->horizontalHeader()->setStretchLastSection(true);
+    detailsEdit = new QPlainTextEdit(splitter);
+    detailsEdit->setReadOnly(true);
+    splitter->setStretchFactor(0, 4);
+    splitter->setStretchFactor(1, 1);
+    layout->addWidget(splitter);
+
+    statusLabel = new QLabel(this);
+    layout->addWidget(statusLabel);
+
+    connect(&pollTimer, &QTimer::timeout, this, &ActivityMonitorDialog::poll);
+    connect(&pollWatcher, &QFutureWatcher<ServerActivity::Snapshot>::finished,
+            this, &ActivityMonitorDialog::showSnapshot);
+    connect(&cancelWatcher, &QFutureWatcher<QString>::finished, this, &ActivityMonitorDialog::showCancelResult);
+    connect(pauseButton, &QPushButton::clicked, this, &ActivityMonitorDialog::togglePause);
+    connect(cancelButton, &QPushButton::clicked, [this]() { cancelSelected(false); });
+    connect(killButton, &QPushButton::clicked, [this]() { cancelSelected(true); });
+    connect(intervalSpinBox, QOverload<double>::of(&QDoubleSpinBox::valueChanged), [this](double seconds) {
+        settings.setValue("activity/interval", seconds);
+        pollTimer.setInterval(static_cast<int>(seconds * 1000));
+    });
+    connect(idleCheckBox, &QCheckBox::toggled, [this](bool checked) {
+        settings.setValue("activity/showIdle", checked);
+        poll();
+    });
+    connect(sessionsView->selectionModel(), &QItemSelectionModel::currentRowChanged,
+            this, &ActivityMonitorDialog::updateDetails);
+
+    pollTimer.setInterval(static_cast<int>(intervalSpinBox->value() * 1000));
+    pollTimer.start();
+    poll();
+}
+
+ActivityMonitorDialog::~ActivityMonitorDialog()
+{
+    pollTimer.stop();
+    pollWatcher.waitForFinished();
+    cancelWatcher.waitForFinished();
+    // The connection has to be closed on the thread that opened it.
+    ServerActivity *source = &activity;
+    QtConcurrent::run(&pool, [source]() { source->close(); }).waitForFinished();
+}
+
+void ActivityMonitorDialog::poll()
+{
+    // A poll still running (slow server) is not queued behind another one.
+    if (pollWatcher.isRunning()) return;
+    ServerActivity *source = &activity;
+    bool includeIdle = idleCheckBox->isChecked();
+    pollWatcher.setFuture(QtConcurrent::run(&pool, [source, includeIdle]() {
+        return source->poll(includeIdle);
+    }));
+}
+
+void ActivityMonitorDialog::showSnapshot()
+{
+    ServerActivity::Snapshot snapshot = pollWatcher.result();
+    if (!snapshot.ok) {
+        statusLabel->setText(tr("Refresh failed: %1").arg(snapshot.error));
+        return;
+    }
+    model->update(snapshot.sessions);
+
+    int active = 0;
+    int waiting = 0;
+    for (const ServerActivity::Session &session : snapshot.sessions) {
+        if (session.state == "active" || session.state == "Query") active++;
+        if (!session.blockedBy.isEmpty()) waiting++;
+    }
+    QLocale locale;
+    statusLabel->setText(tr("%1 sessions, %2 running, %3 waiting on locks; refreshed in %4 ms at %5")
+                             .arg(locale.toString(snapshot.sessions.size()))
+                             .arg(locale.toString(active))
+                             .arg(locale.toString(waiting))
+                             .arg(snapshot.elapsedMs)
+                             .arg(QTime::currentTime().toString("HH:mm:ss")));
+    updateDetails();
+}
+
+void ActivityMonitorDialog::togglePause()
+{
+    if (pollTimer.isActive()) {
+        pollTimer.stop();
+        pauseButton->setText(tr("Resume"));
+    } else {
+        pollTimer.start();
+        pauseButton->setText(tr("Pause"));
+        poll();
+    }
+}
+
+QString ActivityMonitorDialog::selectedId() const
+{
+    QModelIndex current = sessionsView->currentIndex();
+    if (!current.isValid()) return QString();
+    return model->session(proxy->mapToSource(current).row()).id;
+}
+
+void ActivityMonitorDialog::cancelSelected(bool terminate)
+{
+    QString id = selectedId();
+    if (id.isEmpty() || cancelWatcher.isRunning()) return;
+    if (terminate && QMessageBox::question(this, windowTitle(),
+                                           tr("Kill session %1? Its open transaction is rolled back.").arg(id))
+                         != QMessageBox::Yes) {
+        return;
+    }
+
+    ServerActivity *source = &activity;
+    cancelWatcher.setFuture(QtConcurrent::run(&pool, [source, id, terminate]() {
+        QString error;
+        return source->cancel(id, terminate, &error) ? QString() : error;
+    }));
+    statusLabel->setText(terminate ? tr("Killing session %1...").arg(id) : tr("Canceling query of %1...").arg(id));
+}
+
+void ActivityMonitorDialog::showCancelResult()
+{
+    QString error = cancelWatcher.result();
+    if (!error.isEmpty()) {
+        QMessageBox::warning(this, windowTitle(), error);
+    }
+    poll();
+}
+
+void ActivityMonitorDialog::updateDetails()
+{
+    QModelIndex current = sessionsView->currentIndex();
+    bool selected = current.isValid();
+    cancelButton->setEnabled(selected);
+    killButton->setEnabled(selected);
+    if (!selected) {
+        detailsEdit->clear();
+        return;
+    }
+    const ServerActivity::Session &session = model->session(proxy->mapToSource(current).row());
+    QString details;
+    if (!session.blockedBy.isEmpty()) {
+        details += tr("Lock chain: %1\n\n").arg(model->blockingChain(session.id));
+    }
+    details += session.query;
+    // Avoid resetting the scroll position when nothing changed.
+    if (detailsEdit->toPlainText() != details) {
+        detailsEdit->setPlainText(details);
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef ACTIVITYMONITORDIALOG_H
+#define ACTIVITYMONITORDIALOG_H
+
+#include <QDialog>
+#include <QTableView>
+#include <QSortFilterProxyModel>
+#include <QDoubleSpinBox>
+#include <QCheckBox>
+#include <QPushButton>
+#include <QPlainTextEdit>
+#include <QLabel>
+#include <QTimer>
+#include <QThreadPool>
+#include <QFutureWatcher>
+#include <QSettings>
+#include "serveractivity.h"
+#include "activitymodel.h"
+
+// Live sessions of one server. Polls run on a single pooled thread that
+// keeps the monitor's own connection, so a slow poll never blocks the
+// window and never piles up.
+class ActivityMonitorDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    ActivityMonitorDialog(QWidget *parent, const QString &serverName,
+                          const DatabaseConnection::ConnectionParams &params);
+    ~ActivityMonitorDialog();
+
+private slots:
+    void poll();
+    void showSnapshot();
+    void togglePause();
+    void cancelSelected(bool terminate);
+    void showCancelResult();
+    void updateDetails();
+
+private:
+    QString selectedId() const;
+
+    QTableView *sessionsView;
+    ActivityModel *model;
+    QSortFilterProxyModel *proxy;
+    QDoubleSpinBox *intervalSpinBox;
+    QCheckBox *idleCheckBox;
+    QPushButton *pauseButton;
+    QPushButton *cancelButton;
+    QPushButton *killButton;
+    QPlainTextEdit *detailsEdit;
+    QLabel *statusLabel;
+    QTimer pollTimer;
+    QThreadPool pool;
+    ServerActivity activity;
+    QFutureWatcher<ServerActivity::Snapshot> pollWatcher;
+    QFutureWatcher<QString> cancelWatcher;
+    QSettings settings;
+};
+
+#endif // ACTIVITYMONITORDIALOG_H
@@ -0,0 +1,19 @@
+TEMPLATE = app
+TARGET = db_manager
+
+include(../db_manager.pri)
+
+# You can make your code fail to compile if it uses deprecated APIs.
+# In order to do so, uncomment the following line.
+#DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
+
+SOURCES += \
+    ../main.cpp
+
+# Keep the binary in the top-level build directory, where release.sh expects it.
+DESTDIR = $$OUT_PWD/..
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
@@ -0,0 +1,507 @@
+#include "benchmarkdialog.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QGridLayout>
+#include <QSplitter>
+#include <QHeaderView>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QDir>
+#include <QMessageBox>
+#include <QPainter>
+#include <QHelpEvent>
+#include <QToolTip>
+#include <QLocale>
+#include <QtConcurrent>
+#include <cmath>
+
+namespace {
+
+enum RunColumn {
+    LabelColumn,
+    StartedColumn,
+    ClientsColumn,
+    IterationsColumn,
+    ErrorsColumn,
+    ThroughputColumn,
+    MinColumn,
+    P50Column,
+    P95Column,
+    P99Column,
+    MaxColumn,
+    ColumnCount
+};
+
+// The change against the baseline, appended to a cell of another run.
+QString delta(double value, double base) {
+    if (base <= 0) return QString();
+    double change = (value - base) * 100.0 / base;
+    return QString(" (%1%2%)").arg(change >= 0 ? "+" : "").arg(change, 0, 'f', std::fabs(change) < 10 ? 1 : 0);
+}
+
+QString statementPreview(const QueryBenchmark::Run &run) {
+    QString sql = run.sql.simplified();
+    return sql.size() > 200 ? sql.left(200) + QString::fromUtf8("…") : sql;
+}
+
+} // namespace
+
+LatencyHistogramWidget::LatencyHistogramWidget(QWidget *parent)
+    : QWidget(parent)
+{
+    setMinimumSize(300, 160);
+}
+
+void LatencyHistogramWidget::setRuns(const QueryBenchmark::Run *selected, const QueryBenchmark::Run *baseline)
+{
+    this->selected = selected ? selected->histogram : QVector<int>();
+    this->baseline = baseline && baseline != selected ? baseline->histogram : QVector<int>();
+    selectedLabel = selected ? selected->label : QString();
+    baselineLabel = baseline ? baseline->label : QString();
+    update();
+}
+
+QRect LatencyHistogramWidget::plotArea() const
+{
+    int text = fontMetrics().height();
+    return rect().adjusted(8, text + 8, -8, -(text + 8));
+}
+
+void LatencyHistogramWidget::visibleBins(int *first, int *last) const
+{
+    // Only the range either run reached, so the bars are wide enough to read.
+    *first = QueryBenchmark::HistogramBins;
+    *last = -1;
+    for (const QVector<int> *histogram : {&selected, &baseline}) {
+        for (int bin = 0; bin < histogram->size(); ++bin) {
+            if (histogram->at(bin) > 0) {
+                *first = qMin(*first, bin);
+                *last = qMax(*last, bin);
+            }
+        }
+    }
+}
+
+void LatencyHistogramWidget::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    painter.fillRect(rect(), palette().base());
+    painter.setPen(palette().text().color());
+
+    int first;
+    int last;
+    visibleBins(&first, &last);
+    if (last < 0) {
+        painter.drawText(rect(), Qt::AlignCenter, tr("Select a run"));
+        return;
+    }
+
+    // Shares rather than counts, so runs of different length compare.
+    auto share = [](const QVector<int> &histogram, int bin) {
+        qint64 total = 0;
+        for (int count : histogram) {
+            total += count;
+        }
+        return total > 0 && bin < histogram.size() ? histogram.at(bin) / static_cast<double>(total) : 0.0;
+    };
+    double highest = 0;
+    for (int bin = first; bin <= last; ++bin) {
+        highest = qMax(highest, qMax(share(selected, bin), share(baseline, bin)));
+    }
+
+    QString legend = selectedLabel.isEmpty() ? tr("Selected run") : selectedLabel;
+    if (!baseline.isEmpty()) {
+        legend = tr("%1, outlined: baseline %2").arg(legend, baselineLabel);
+    }
+    painter.drawText(rect().adjusted(8, 4, -8, 0), Qt::AlignLeft | Qt::AlignTop,
+                     tr("%1, up to %2% per bar").arg(legend).arg(highest * 100, 0, 'f', 1));
+
+    QRect area = plotArea();
+    int bins = last - first + 1;
+    double width = static_cast<double>(area.width()) / bins;
+    auto barAt = [&](int bin, double value) {
+        int height = static_cast<int>(std::ceil(area.height() * value / qMax(highest, 1e-9)));
+        return QRectF(area.left() + (bin - first) * width + 1, area.bottom() - height + 1,
+                      qMax(1.0, width - 2), height);
+    };
+    for (int bin = first; bin <= last; ++bin) {
+        painter.fillRect(barAt(bin, share(selected, bin)), palette().highlight());
+    }
+    if (!baseline.isEmpty()) {
+        painter.setPen(QPen(palette().text().color(), 1, Qt::DashLine));
+        for (int bin = first; bin <= last; ++bin) {
+            if (share(baseline, bin) > 0) {
+                painter.drawRect(barAt(bin, share(baseline, bin)));
+            }
+        }
+        painter.setPen(palette().text().color());
+    }
+    painter.drawLine(area.bottomLeft(), area.bottomRight());
+
+    QRect labels = rect().adjusted(8, 0, -8, -4);
+    painter.drawText(labels, Qt::AlignLeft | Qt::AlignBottom,
+                     QueryBenchmark::formatLatency(QueryBenchmark::binLowerUs(first)));
+    painter.drawText(labels, Qt::AlignRight | Qt::AlignBottom,
+                     QueryBenchmark::formatLatency(QueryBenchmark::binLowerUs(last + 1)));
+}
+
+bool LatencyHistogramWidget::event(QEvent *event)
+{
+    int first;
+    int last;
+    if (event->type() != QEvent::ToolTip) {
+        return QWidget::event(event);
+    }
+    visibleBins(&first, &last);
+    auto help = static_cast<QHelpEvent *>(event);
+    QRect area = plotArea();
+    int bins = last - first + 1;
+    int bin = last < 0 ? -1 : first + (help->pos().x() - area.left()) * bins / qMax(1, area.width());
+    if (last < 0 || bin < first || bin > last) {
+        QToolTip::hideText();
+        return true;
+    }
+    QLocale locale;
+    QString text = tr("%1 .. %2: %3 statements")
+                       .arg(QueryBenchmark::formatLatency(QueryBenchmark::binLowerUs(bin)),
+                            QueryBenchmark::formatLatency(QueryBenchmark::binLowerUs(bin + 1)),
+                            locale.toString(bin < selected.size() ? selected.at(bin) : 0));
+    if (!baseline.isEmpty()) {
+        text += tr(", baseline %1").arg(locale.toString(bin < baseline.size() ? baseline.at(bin) : 0));
+    }
+    QToolTip::showText(help->globalPos(), text, this);
+    return true;
+}
+
+BenchmarkDialog::BenchmarkDialog(QWidget *parent, const QString &serverName,
+                                 const DatabaseConnection::ConnectionParams &params, const QString &sql)
+    : QDialog(parent), serverName(serverName), params(params), baseline(-1), iterations(0),
+      settings("DBManager", "Settings")
+{
+    setWindowTitle(tr("Benchmark on %1/%2").arg(serverName, params.dbName));
+    resize(1000, 750);
+
+    auto layout = new QVBoxLayout(this);
+    sqlEdit = new QPlainTextEdit(sql, this);
+    sqlEdit->setMaximumHeight(120);
+    layout->addWidget(sqlEdit);
+
+    auto optionsLayout = new QGridLayout;
+    optionsLayout->addWidget(new QLabel(tr("Warm-up per client:"), this), 0, 0);
+    warmupSpinBox = new QSpinBox(this);
+    warmupSpinBox->setRange(0, 10000);
+    warmupSpinBox->setValue(settings.value("benchmark/warmup", 5).toInt());
+    optionsLayout->addWidget(warmupSpinBox, 0, 1);
+    optionsLayout->addWidget(new QLabel(tr("Iterations:"), this), 0, 2);
+    iterationsSpinBox = new QSpinBox(this);
+    iterationsSpinBox->setRange(1, 10000000);
+    iterationsSpinBox->setValue(settings.value("benchmark/iterations", 100).toInt());
+    optionsLayout->addWidget(iterationsSpinBox, 0, 3);
+    optionsLayout->addWidget(new QLabel(tr("Concurrent clients:"), this), 0, 4);
+    clientsSpinBox = new QSpinBox(this);
+    clientsSpinBox->setRange(1, 256);
+    clientsSpinBox->setValue(settings.value("benchmark/clients", 1).toInt());
+    optionsLayout->addWidget(clientsSpinBox, 0, 5);
+
+    optionsLayout->addWidget(new QLabel(tr("Parameters file:"), this), 1, 0);
+    parametersEdit = new QLineEdit(this);
+    parametersEdit->setPlaceholderText(tr("None: the statement runs as written"));
+    parametersEdit->setToolTip(tr("One set of values per line for the ? placeholders, "
+                                  "separated by commas or tabs; NULL is a null value"));
+    optionsLayout->addWidget(parametersEdit, 1, 1, 1, 4);
+    auto browseButton = new QPushButton(tr("Browse..."), this);
+    optionsLayout->addWidget(browseButton, 1, 5);
+
+    optionsLayout->addWidget(new QLabel(tr("Label:"), this), 2, 0);
+    labelEdit = new QLineEdit(this);
+    labelEdit->setPlaceholderText(tr("e.g. before the index"));
+    optionsLayout->addWidget(labelEdit, 2, 1, 1, 4);
+    runButton = new QPushButton(tr("Run"), this);
+    runButton->setDefault(true);
+    optionsLayout->addWidget(runButton, 2, 5);
+    layout->addLayout(optionsLayout);
+
+    auto splitter = new QSplitter(Qt::Vertical, this);
+    auto runsPane = new QWidget(splitter);
+    auto runsLayout = new QVBoxLayout(runsPane);
+    runsLayout->setContentsMargins(0, 0, 0, 0);
+    runsTable = new QTableWidget(0, ColumnCount, runsPane);
+    runsTable->setHorizontalHeaderLabels({tr("Label"), tr("Started"), tr("Clients"), tr("Iterations"),
+                                          tr("Errors"), tr("Throughput/s"), tr("Min"), tr("p50"), tr("p95"),
+                                          tr("p99"), tr("Max")});
+    runsTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    runsTable->setSelectionMode(QAbstractItemView::SingleSelection);
+    runsTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    runsTable->verticalHeader()->hide();
+    runsTable->horizontalHeader()->setStretchLastSection(true);
+    runsLayout->addWidget(runsTable, 1);
+    auto runButtonsLayout = new QHBoxLayout;
+    auto baselineButton = new QPushButton(tr("Set as Baseline"), runsPane);
+    runButtonsLayout->addWidget(baselineButton);
+    auto deleteButton = new QPushButton(tr("Delete"), runsPane);
+    runButtonsLayout->addWidget(deleteButton);
+    runButtonsLayout->addStretch();
+    runsLayout->addLayout(runButtonsLayout);
+    histogram = new LatencyHistogramWidget(splitter);
+    splitter->setStretchFactor(0, 3);
+    splitter->setStretchFactor(1, 2);
+    layout->addWidget(splitter, 1);
+
+    progressBar = new QProgressBar(this);
+    progressBar->setRange(0, 1);
+    progressBar->setValue(0);
+    layout->addWidget(progressBar);
+    statusLabel = new QLabel(this);
+    statusLabel->setWordWrap(true);
+    statusLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
+    layout->addWidget(statusLabel);
+
+    progressTimer.setInterval(500);
+    connect(&progressTimer, &QTimer::timeout, this, &BenchmarkDialog::updateProgress);
+    connect(&watcher, &QFutureWatcher<QueryBenchmark::Run>::finished, this, &BenchmarkDialog::showResult);
+    connect(runButton, &QPushButton::clicked, this, &BenchmarkDialog::startOrCancel);
+    connect(browseButton, &QPushButton::clicked, this, &BenchmarkDialog::browseParameters);
+    connect(baselineButton, &QPushButton::clicked, this, &BenchmarkDialog::setBaseline);
+    connect(deleteButton, &QPushButton::clicked, this, &BenchmarkDialog::removeRun);
+    connect(runsTable, &QTableWidget::itemSelectionChanged, this, &BenchmarkDialog::showRun);
+
+    runs = QueryBenchmark::loadRuns();
+    refreshRuns();
+    statusLabel->setText(tr("Statements run on %1 connections of their own; results are read in full.")
+                             .arg(serverName));
+}
+
+BenchmarkDialog::~BenchmarkDialog()
+{
+    // The worker uses this dialog's progress counters.
+    progress.canceled.storeRelaxed(1);
+    watcher.waitForFinished();
+}
+
+void BenchmarkDialog::browseParameters()
+{
+    QString path = QFileDialog::getOpenFileName(this, tr("Parameters File"), parametersEdit->text(),
+                                                tr("Parameter sets (*.csv *.tsv *.txt);;All files (*)"));
+    if (!path.isEmpty()) {
+        parametersEdit->setText(QDir::toNativeSeparators(path));
+    }
+}
+
+void BenchmarkDialog::startOrCancel()
+{
+    if (watcher.isRunning()) {
+        progress.canceled.storeRelaxed(1);
+        runButton->setEnabled(false);
+        return;
+    }
+
+    QueryBenchmark::Options options;
+    options.params = params;
+    options.serverName = serverName;
+    options.sql = sqlEdit->toPlainText().trimmed();
+    options.warmup = warmupSpinBox->value();
+    options.iterations = iterationsSpinBox->value();
+    options.clients = clientsSpinBox->value();
+    options.label = labelEdit->text().trimmed();
+    if (options.sql.isEmpty()) {
+        statusLabel->setText(tr("Enter a statement to benchmark."));
+        return;
+    }
+    if (!parametersEdit->text().trimmed().isEmpty()) {
+        QString error;
+        if (!QueryBenchmark::loadParameters(parametersEdit->text().trimmed(), &options.parameterSets, &error)) {
+            statusLabel->setText(tr("Cannot read the parameters: %1").arg(error));
+            return;
+        }
+    }
+    if (DatabaseConnection::isWriteStatement(options.sql) &&
+        QMessageBox::question(this, tr("Benchmark"),
+                              tr("This statement changes data and will run %1 times on %2/%3. Continue?")
+                                  .arg(options.warmup * options.clients + options.iterations)
+                                  .arg(serverName, params.dbName)) != QMessageBox::Yes) {
+        return;
+    }
+    if (options.label.isEmpty()) {
+        options.label = tr("Run %1").arg(runs.size() + 1);
+    }
+    settings.setValue("benchmark/warmup", options.warmup);
+    settings.setValue("benchmark/iterations", options.iterations);
+    settings.setValue("benchmark/clients", options.clients);
+
+    progress.done.storeRelaxed(0);
+    progress.errors.storeRelaxed(0);
+    progress.canceled.storeRelaxed(0);
+    iterations = options.iterations;
+    statusLabel->setText(options.parameterSets.isEmpty()
+                             ? tr("Warming up...")
+                             : tr("Warming up with %1 parameter sets...").arg(options.parameterSets.size()));
+
+    QueryBenchmark::Progress *shared = &progress;
+    watcher.setFuture(QtConcurrent::run([options, shared]() {
+        return QueryBenchmark::run(options, shared);
+    }));
+    setRunning(true);
+}
+
+void BenchmarkDialog::setRunning(bool running)
+{
+    runButton->setText(running ? tr("Cancel") : tr("Run"));
+    runButton->setEnabled(true);
+    sqlEdit->setReadOnly(running);
+    warmupSpinBox->setEnabled(!running);
+    iterationsSpinBox->setEnabled(!running);
+    clientsSpinBox->setEnabled(!running);
+    parametersEdit->setEnabled(!running);
+    if (running) {
+        progressBar->setRange(0, qMax(1, iterations));
+        progressBar->setValue(0);
+        progressTimer.start();
+    } else {
+        progressTimer.stop();
+    }
+}
+
+void BenchmarkDialog::updateProgress()
+{
+    QLocale locale;
+    int done = progress.done.loadRelaxed();
+    int errors = progress.errors.loadRelaxed();
+    progressBar->setValue(qMin(done, iterations));
+    if (done == 0) return;
+    QString text = tr("%1 of %2 statements").arg(locale.toString(done), locale.toString(iterations));
+    if (errors > 0) {
+        text += tr(", %1 errors").arg(locale.toString(errors));
+    }
+    statusLabel->setText(text);
+}
+
+void BenchmarkDialog::showResult()
+{
+    setRunning(false);
+    QueryBenchmark::Run run = watcher.result();
+    progressBar->setValue(qMin(run.executed + run.errors, iterations));
+    bool canceled = progress.canceled.loadRelaxed();
+    if (run.executed == 0) {
+        statusLabel->setText(canceled ? tr("Canceled.")
+                                      : tr("No statement completed: %1").arg(run.firstError));
+        return;
+    }
+    if (canceled) {
+        run.label = tr("%1 (canceled)").arg(run.label);
+    }
+
+    // Without a baseline, the latest run of the same statement is the one
+    // this run is most likely meant to be compared with.
+    if (baseline < 0) {
+        for (int i = runs.size() - 1; i >= 0; --i) {
+            if (runs.at(i).sql == run.sql && runs.at(i).serverName == run.serverName) {
+                baseline = i;
+                break;
+            }
+        }
+    }
+    runs << run;
+    saveRuns();
+    refreshRuns();
+    runsTable->selectRow(runs.size() - 1);
+
+    QLocale locale;
+    QString summary = tr("%1 statements in %2 s: %3/s, p50 %4, p99 %5")
+                          .arg(locale.toString(run.executed))
+                          .arg(run.elapsedMs / 1000.0, 0, 'f', 2)
+                          .arg(locale.toString(run.throughput, 'f', 1),
+                               QueryBenchmark::formatLatency(run.p50Us), QueryBenchmark::formatLatency(run.p99Us));
+    if (run.errors > 0) {
+        summary += tr("; %1 errors, first: %2").arg(locale.toString(run.errors), run.firstError);
+    }
+    statusLabel->setText(summary);
+}
+
+int BenchmarkDialog::selectedRun() const
+{
+    int row = runsTable->currentRow();
+    return row >= 0 && row < runs.size() && runsTable->selectionModel()->hasSelection() ? row : -1;
+}
+
+void BenchmarkDialog::refreshRuns()
+{
+    QLocale locale;
+    const QueryBenchmark::Run *base = baseline >= 0 && baseline < runs.size() ? &runs.at(baseline) : nullptr;
+    runsTable->setRowCount(runs.size());
+    for (int row = 0; row < runs.size(); ++row) {
+        const QueryBenchmark::Run &run = runs.at(row);
+        bool compared = base && row != baseline;
+        auto latency = [&](qint64 us, qint64 baseUs) {
+            return QueryBenchmark::formatLatency(us) + (compared ? delta(us, baseUs) : QString());
+        };
+        QStringList cells = {row == baseline ? tr("%1 (baseline)").arg(run.label) : run.label,
+                             locale.toString(run.started, QLocale::ShortFormat),
+                             locale.toString(run.clients),
+                             locale.toString(run.executed),
+                             locale.toString(run.errors),
+                             locale.toString(run.throughput, 'f', 1)
+                                 + (compared ? delta(run.throughput, base->throughput) : QString()),
+                             latency(run.minUs, compared ? base->minUs : 0),
+                             latency(run.p50Us, compared ? base->p50Us : 0),
+                             latency(run.p95Us, compared ? base->p95Us : 0),
+                             latency(run.p99Us, compared ? base->p99Us : 0),
+                             latency(run.maxUs, compared ? base->maxUs : 0)};
+        QString tooltip = tr("%1/%2, warm-up %3 per client%4\n%5")
+                              .arg(run.serverName, run.database)
+                              .arg(run.warmup)
+                              .arg(run.parameterSets > 0 ? tr(", %1 parameter sets").arg(run.parameterSets)
+                                                         : QString(),
+                                   statementPreview(run));
+        if (!run.firstError.isEmpty()) {
+            tooltip += "\n" + run.firstError;
+        }
+        for (int cell = 0; cell < cells.size(); ++cell) {
+            auto item = new QTableWidgetItem(cells.at(cell));
+            item->setToolTip(tooltip);
+            if (cell >= ClientsColumn) {
+                item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+            }
+            runsTable->setItem(row, cell, item);
+        }
+    }
+    runsTable->resizeColumnsToContents();
+    showRun();
+}
+
+void BenchmarkDialog::showRun()
+{
+    int row = selectedRun();
+    histogram->setRuns(row >= 0 ? &runs.at(row) : nullptr,
+                       baseline >= 0 && baseline < runs.size() ? &runs.at(baseline) : nullptr);
+}
+
+void BenchmarkDialog::setBaseline()
+{
+    int row = selectedRun();
+    if (row < 0) return;
+    baseline = row;
+    refreshRuns();
+    runsTable->selectRow(row);
+}
+
+void BenchmarkDialog::removeRun()
+{
+    int row = selectedRun();
+    if (row < 0) return;
+    runs.removeAt(row);
+    if (baseline == row) {
+        baseline = -1;
+    } else if (baseline > row) {
+        baseline--;
+    }
+    saveRuns();
+    refreshRuns();
+}
+
+void BenchmarkDialog::saveRuns()
+{
+    QString error;
+    if (!QueryBenchmark::saveRuns(runs, &error)) {
+        statusLabel->setText(tr("The runs could not be saved: %1").arg(error));
+    }
+}
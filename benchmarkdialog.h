@@ -0,0 +1,90 @@
+#ifndef BENCHMARKDIALOG_H
+#define BENCHMARKDIALOG_H
+
+#include <QDialog>
+#include <QWidget>
+#include <QPlainTextEdit>
+#include <QLineEdit>
+#include <QSpinBox>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QProgressBar>
+#include <QLabel>
+#include <QTimer>
+#include <QFutureWatcher>
+#include <QSettings>
+#include "querybenchmark.h"
+
+// Latency histograms of two runs on the same log-scale bins: the baseline
+// as an outline behind the selected run.
+class LatencyHistogramWidget : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit LatencyHistogramWidget(QWidget *parent = nullptr);
+
+    void setRuns(const QueryBenchmark::Run *selected, const QueryBenchmark::Run *baseline);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    bool event(QEvent *event) override;
+
+private:
+    QRect plotArea() const;
+    void visibleBins(int *first, int *last) const;
+
+    QVector<int> selected;
+    QVector<int> baseline;
+    QString selectedLabel;
+    QString baselineLabel;
+};
+
+// Runs a statement repeatedly with warm-up, iterations and concurrent
+// clients, and keeps the runs for comparing before and after a change.
+class BenchmarkDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    BenchmarkDialog(QWidget *parent, const QString &serverName,
+                    const DatabaseConnection::ConnectionParams &params, const QString &sql);
+    ~BenchmarkDialog();
+
+private slots:
+    void startOrCancel();
+    void browseParameters();
+    void updateProgress();
+    void showResult();
+    void showRun();
+    void setBaseline();
+    void removeRun();
+
+private:
+    void setRunning(bool running);
+    void refreshRuns();
+    void saveRuns();
+    int selectedRun() const;
+
+    QString serverName;
+    DatabaseConnection::ConnectionParams params;
+    QVector<QueryBenchmark::Run> runs;
+    int baseline;                 // index into runs, -1 for none
+    int iterations;               // of the running benchmark
+
+    QPlainTextEdit *sqlEdit;
+    QLineEdit *labelEdit;
+    QSpinBox *warmupSpinBox;
+    QSpinBox *iterationsSpinBox;
+    QSpinBox *clientsSpinBox;
+    QLineEdit *parametersEdit;
+    QPushButton *runButton;
+    QTableWidget *runsTable;
+    LatencyHistogramWidget *histogram;
+    QProgressBar *progressBar;
+    QLabel *statusLabel;
+    QTimer progressTimer;
+    QFutureWatcher<QueryBenchmark::Run> watcher;
+    QueryBenchmark::Progress progress;
+    QSettings settings;
+};
+
+#endif // BENCHMARKDIALOG_H
@@ -0,0 +1,16 @@
+TEMPLATE = app
+TARGET = db_manager_bench
+
+QT += testlib
+
+CONFIG += console
+CONFIG -= app_bundle
+
+include(../db_manager.pri)
+
+SOURCES += \
+    tst_throughput.cpp \
+    benchmetrics.cpp
+
+HEADERS += \
+    benchmetrics.h
@@ -0,0 +1,98 @@
+#include "benchmetrics.h"
+#include <QFile>
+#include <QByteArray>
+#include <atomic>
+#include <cstdlib>
+#if defined(Q_OS_UNIX)
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+std::atomic<quint64> allocationCount(0);
+std::atomic<quint64> allocationBytes(0);
+
+inline void countAllocation(size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocationBytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+} // namespace
+
+#if defined(__GLIBC__)
+// Qt containers allocate with malloc() directly, so hooking operator new
+// alone would miss most of the traffic. glibc exposes its allocator under
+// __libc_* names, which lets the benchmark binary wrap it without dlsym.
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+
+void *malloc(size_t size) {
+    countAllocation(size);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+    countAllocation(count * size);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    countAllocation(size);
+    return __libc_realloc(ptr, size);
+}
+}
+#endif
+
+bool BenchMetrics::allocationsSupported() {
+#if defined(__GLIBC__)
+    return true;
+#else
+    return false;
+#endif
+}
+
+BenchMetrics::Allocations BenchMetrics::allocations() {
+    Allocations result;
+    result.count = allocationCount.load(std::memory_order_relaxed);
+    result.bytes = allocationBytes.load(std::memory_order_relaxed);
+    return result;
+}
+
+void BenchMetrics::resetPeakRss() {
+#if defined(Q_OS_LINUX)
+    // Writing 5 to clear_refs resets VmHWM to the current RSS (Linux 4.0+).
+    QFile clearRefs("/proc/self/clear_refs");
+    if (clearRefs.open(QIODevice::WriteOnly)) {
+        clearRefs.write("5");
+    }
+#endif
+}
+
+qint64 BenchMetrics::peakRssKb() {
+#if defined(Q_OS_LINUX)
+    QFile status("/proc/self/status");
+    if (status.open(QIODevice::ReadOnly)) {
+        const QList<QByteArray> lines = status.readAll().split('\n');
+        for (const QByteArray &line : lines) {
+            if (line.startsWith("VmHWM:")) {
+                return line.mid(6).trimmed().split(' ').value(0).toLongLong();
+            }
+        }
+    }
+#endif
+#if defined(Q_OS_UNIX)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return -1;
+    }
+#if defined(Q_OS_MACOS)
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+#else
+    return -1;
+#endif
+}
@@ -0,0 +1,22 @@
+#ifndef BENCHMETRICS_H
+#define BENCHMETRICS_H
+
+#include <QtGlobal>
+
+// Process-level counters reported next to each benchmark stage: heap
+// allocations (counted by interposing malloc on glibc) and peak RSS.
+class BenchMetrics {
+public:
+    struct Allocations {
+        quint64 count;
+        quint64 bytes;
+    };
+
+    static bool allocationsSupported();
+    static Allocations allocations();
+
+    static void resetPeakRss();
+    static qint64 peakRssKb();
+};
+
+#endif // BENCHMETRICS_H
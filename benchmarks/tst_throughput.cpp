@@ -0,0 +1,598 @@
+#include <QtTest>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QSqlError>
+#include <QTableWidget>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QElapsedTimer>
+#include <QMap>
+#include "tableutils.h"
+#include "resultexporter.h"
+#include "tableprofiler.h"
+#include "resultpivot.h"
+#include "resultstore.h"
+#include "resultmemory.h"
+#include "tracer.h"
+#include "benchmetrics.h"
+
+namespace {
+
+const char *const ConnectionName = "db_manager_bench";
+const int InsertBatch = 500;
+
+const char *const FirstNames[] = {
+    "John", "Jane", "Mike", "Sarah", "Robert", "Lisa", "David", "Emma", "James", "Anna"
+};
+const char *const LastNames[] = {
+    "Smith", "Doe", "Johnson", "Williams", "Brown", "Anderson", "Wilson", "Taylor", "Martin", "Clark"
+};
+
+QString mismatch(const char *what, qint64 actual, qint64 expected) {
+    return QString("%1: %2 instead of %3").arg(what).arg(actual).arg(expected);
+}
+
+QString env(const char *name, const QString &defaultValue) {
+    QString value = qEnvironmentVariable(name);
+    return value.isEmpty() ? defaultValue : value;
+}
+
+// xorshift64*, seeded from the row id so every backend gets identical data.
+quint64 rowHash(quint64 id) {
+    quint64 x = id * 0x9E3779B97F4A7C15ULL + 1;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+// Sink that only counts what the exporter writes.
+class NullDevice : public QIODevice {
+public:
+    NullDevice() { open(QIODevice::WriteOnly); }
+
+protected:
+    qint64 readData(char *, qint64) override { return -1; }
+    qint64 writeData(const char *, qint64 len) override { return len; }
+};
+
+} // namespace
+
+// Throughput of the result-handling hot paths on deterministic datasets.
+//
+// Environment:
+//   DBM_BENCH_ROWS      comma-separated row counts (default 10000,100000)
+//   DBM_BENCH_DRIVER    QSQLITE (default), QPSQL or QMYSQL
+//   DBM_BENCH_HOST, DBM_BENCH_PORT, DBM_BENCH_DB, DBM_BENCH_USER,
+//   DBM_BENCH_PASSWORD  server settings, defaulting to docker/docker-compose.yml
+//   DBM_BENCH_JSON      report path (default bench_results.json)
+class ThroughputBenchmark : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void fetch_data();
+    void fetch();
+    void decode_data();
+    void decode();
+    void render_data();
+    void render();
+    void renderBatch_data();
+    void renderBatch();
+    void traced_data();
+    void traced();
+    void profile_data();
+    void profile();
+    void pivot_data();
+    void pivot();
+    void spool_data();
+    void spool();
+    void sort_data();
+    void sort();
+    void exportCsv_data();
+    void exportCsv();
+    void copy_data();
+    void copy();
+
+private:
+    void addRowCounts();
+    QString tableName(int rows) const;
+    bool ensureDataset(int rows);
+    QString selectSql(int rows) const;
+    bool loadTable(int rows);
+    // fn returns what went wrong, or nothing; the caller verifies it, as a
+    // QVERIFY inside fn would only return from fn.
+    template <typename Fn> QString measure(const QString &stage, int rows, Fn fn);
+
+    QSqlDatabase db;
+    QString driver;
+    QList<int> rowCounts;
+    QTableWidget *table = nullptr;
+    int loadedRows = -1;
+    QMap<QString, QJsonObject> results;
+};
+
+void ThroughputBenchmark::initTestCase()
+{
+    const QStringList counts = env("DBM_BENCH_ROWS", "10000,100000").split(',', Qt::SkipEmptyParts);
+    for (const QString &count : counts) {
+        bool ok;
+        int rows = count.trimmed().toInt(&ok);
+        if (ok && rows > 0) {
+            rowCounts << rows;
+        }
+    }
+    QVERIFY2(!rowCounts.isEmpty(), "DBM_BENCH_ROWS has no valid row counts");
+
+    driver = env("DBM_BENCH_DRIVER", "QSQLITE").toUpper();
+    db = QSqlDatabase::addDatabase(driver, ConnectionName);
+    if (driver == "QSQLITE") {
+        db.setDatabaseName(QDir(QDir::tempPath()).filePath("db_manager_bench.sqlite"));
+    } else {
+        db.setHostName(env("DBM_BENCH_HOST", "127.0.0.1"));
+        db.setPort(env("DBM_BENCH_PORT", driver == "QPSQL" ? "5432" : "3306").toInt());
+        db.setDatabaseName(env("DBM_BENCH_DB", "test_db"));
+        db.setUserName(env("DBM_BENCH_USER", "test_user"));
+        db.setPassword(env("DBM_BENCH_PASSWORD", "test_password"));
+    }
+    QVERIFY2(db.open(), qPrintable(db.lastError().text()));
+
+    if (driver == "QSQLITE") {
+        QSqlQuery pragma(db);
+        pragma.exec("PRAGMA journal_mode = OFF");
+        pragma.exec("PRAGMA synchronous = OFF");
+    }
+
+    for (int rows : rowCounts) {
+        QVERIFY2(ensureDataset(rows), qPrintable(db.lastError().text()));
+    }
+
+    table = new QTableWidget;
+}
+
+void ThroughputBenchmark::cleanupTestCase()
+{
+    delete table;
+    table = nullptr;
+
+    QJsonArray stages;
+    for (const QJsonObject &stage : qAsConst(results)) {
+        stages.append(stage);
+    }
+
+    QJsonObject report;
+    report["driver"] = driver;
+    report["qt_version"] = QString(qVersion());
+    report["build_abi"] = QSysInfo::buildAbi();
+    report["allocations_counted"] = BenchMetrics::allocationsSupported();
+    report["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    report["stages"] = stages;
+
+    QFile file(env("DBM_BENCH_JSON", "bench_results.json"));
+    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        file.write(QJsonDocument(report).toJson());
+        qInfo("Benchmark report written to %s", qPrintable(file.fileName()));
+    } else {
+        qWarning("Cannot write %s: %s", qPrintable(file.fileName()), qPrintable(file.errorString()));
+    }
+
+    db.close();
+    db = QSqlDatabase();
+    QSqlDatabase::removeDatabase(ConnectionName);
+}
+
+void ThroughputBenchmark::addRowCounts()
+{
+    QTest::addColumn<int>("rows");
+    for (int rows : qAsConst(rowCounts)) {
+        QTest::newRow(qPrintable(QString::number(rows))) << rows;
+    }
+}
+
+QString ThroughputBenchmark::tableName(int rows) const
+{
+    return QString("bench_employees_%1").arg(rows);
+}
+
+QString ThroughputBenchmark::selectSql(int rows) const
+{
+    return QString("SELECT id, department_id, first_name, last_name, email, salary, hire_date "
+                   "FROM %1 ORDER BY id").arg(tableName(rows));
+}
+
+bool ThroughputBenchmark::ensureDataset(int rows)
+{
+    QSqlQuery query(db);
+    if (query.exec(QString("SELECT COUNT(*) FROM %1").arg(tableName(rows))) &&
+        query.next() && query.value(0).toInt() == rows) {
+        return true;
+    }
+
+    query.exec(QString("DROP TABLE IF EXISTS %1").arg(tableName(rows)));
+    // Same shape as the employees table in docker/*/init.sql.
+    if (!query.exec(QString("CREATE TABLE %1 ("
+                            "id INTEGER PRIMARY KEY, "
+                            "department_id INTEGER, "
+                            "first_name VARCHAR(50) NOT NULL, "
+                            "last_name VARCHAR(50) NOT NULL, "
+                            "email VARCHAR(100), "
+                            "salary DECIMAL(10,2), "
+                            "hire_date DATE)").arg(tableName(rows)))) {
+        return false;
+    }
+
+    qInfo("Generating %d rows into %s", rows, qPrintable(tableName(rows)));
+    db.transaction();
+    QString sql;
+    for (int start = 1; start <= rows; start += InsertBatch) {
+        sql = QString("INSERT INTO %1 (id, department_id, first_name, last_name, email, salary, hire_date) VALUES ")
+                  .arg(tableName(rows));
+        int end = qMin(start + InsertBatch - 1, rows);
+        for (int id = start; id <= end; ++id) {
+            quint64 h = rowHash(id);
+            QString first = FirstNames[h % 10];
+            QString last = LastNames[(h >> 8) % 10];
+            if (id > start) sql += ',';
+            sql += QString("(%1,%2,'%3','%4','%5.%6.%1@example.com',%7.%8,'%9')")
+                       .arg(id)
+                       .arg((h >> 16) % 4 + 1)
+                       .arg(first, last, first.toLower(), last.toLower())
+                       .arg(40000 + (h >> 20) % 60000)
+                       .arg((h >> 40) % 100, 2, 10, QChar('0'))
+                       .arg(QDate(2015, 1, 1).addDays((h >> 48) % 3650).toString(Qt::ISODate));
+        }
+        if (!query.exec(sql)) {
+            db.rollback();
+            return false;
+        }
+    }
+    return db.commit();
+}
+
+bool ThroughputBenchmark::loadTable(int rows)
+{
+    if (loadedRows == rows) {
+        return true;
+    }
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    if (!query.exec(selectSql(rows))) {
+        return false;
+    }
+    TableUtils::fillFromQuery(table, query);
+    loadedRows = rows;
+    return table->rowCount() == rows;
+}
+
+template <typename Fn>
+QString ThroughputBenchmark::measure(const QString &stage, int rows, Fn fn)
+{
+    BenchMetrics::resetPeakRss();
+    BenchMetrics::Allocations before = BenchMetrics::allocations();
+    QElapsedTimer timer;
+    timer.start();
+
+    QString failure = fn();
+    if (!failure.isEmpty()) {
+        return failure;
+    }
+
+    qint64 ns = timer.nsecsElapsed();
+    BenchMetrics::Allocations after = BenchMetrics::allocations();
+
+    // QBENCHMARK may repeat the body; keep the fastest run.
+    QString key = QString("%1/%2").arg(stage).arg(rows);
+    if (results.contains(key) && results[key]["seconds"].toDouble() <= ns / 1e9) {
+        return QString();
+    }
+
+    QJsonObject result;
+    result["stage"] = stage;
+    result["rows"] = rows;
+    result["seconds"] = ns / 1e9;
+    result["rows_per_sec"] = ns > 0 ? rows / (ns / 1e9) : 0.0;
+    result["peak_rss_kb"] = BenchMetrics::peakRssKb();
+    result["allocations"] = static_cast<qint64>(after.count - before.count);
+    result["allocated_bytes"] = static_cast<qint64>(after.bytes - before.bytes);
+    results[key] = result;
+    return QString();
+}
+
+void ThroughputBenchmark::fetch_data()
+{
+    addRowCounts();
+}
+
+void ThroughputBenchmark::fetch()
+{
+    QFETCH(int, rows);
+    QBENCHMARK {
+        QString failure = measure("fetch", rows, [&]() {
+            QSqlQuery query(db);
+            query.setForwardOnly(true);
+            if (!query.exec(selectSql(rows))) return query.lastError().text();
+            int count = 0;
+            while (query.next()) {
+                ++count;
+            }
+            return count == rows ? QString() : mismatch("rows", count, rows);
+        });
+        QVERIFY2(failure.isEmpty(), qPrintable(failure));
+    }
+}
+
+void ThroughputBenchmark::decode_data()
+{
+    addRowCounts();
+}
+
+void ThroughputBenchmark::decode()
+{
+    QFETCH(int, rows);
+    QBENCHMARK {
+        QString failure = measure("decode", rows, [&]() {
+            QSqlQuery query(db);
+            query.setForwardOnly(true);
+            if (!query.exec(selectSql(rows))) return query.lastError().text();
+            int columnCount = query.record().count();
+            qint64 characters = 0;
+            while (query.next()) {
+                for (int col = 0; col < columnCount; ++col) {
+                    characters += query.value(col).toString().size();
+                }
+            }
+            return characters > 0 ? QString() : QString("no characters decoded");
+        });
+        QVERIFY2(failure.isEmpty(), qPrintable(failure));
+    }
+}
+
+void ThroughputBenchmark::render_data()
+{
+    addRowCounts();
+}
+
+void ThroughputBenchmark::render()
+{
+    QFETCH(int, rows);
+    QBENCHMARK {
+        QString failure = measure("render", rows, [&]() {
+            QSqlQuery query(db);
+            query.setForwardOnly(true);
+            if (!query.exec(selectSql(rows))) return query.lastError().text();
+            int filled = TableUtils::fillFromQuery(table, query).rows;
+            return filled == rows ? QString() : mismatch("rows", filled, rows);
+        });
+        QVERIFY2(failure.isEmpty(), qPrintable(failure));
+    }
+    loadedRows = rows;
+}
+
+void ThroughputBenchmark::renderBatch_data()
+{
+    addRowCounts();
+}
+
+void ThroughputBenchmark::renderBatch()
+{
+    QFETCH(int, rows);
+    QBENCHMARK {
+        QString failure = measure("renderBatch", rows, [&]() {
+            // The query tabs' path: rows read into a batch (on the worker in
+            // the app), then the grid filled from it.
+            QSqlQuery query(db);
+            query.setForwardOnly(true);
+            if (!query.exec(selectSql(rows))) return query.lastError().text();
+            TableUtils::RowBatch batch;
+            int read = TableUtils::readBatch(query, TableUtils::FetchLimits(), false, &batch).rows;
+            TableUtils::fillFromBatch(table, batch);
+            return read == rows ? QString() : mismatch("rows", read, rows);
+        });
+        QVERIFY2(failure.isEmpty(), qPrintable(failure));
+    }
+    loadedRows = rows;
+}
+
+void ThroughputBenchmark::traced_data()
+{
+    addRowCounts();
+}
+
+void ThroughputBenchmark::traced()
+{
+    // renderBatch with tracing on; the difference is the tracer's overhead.
+    QFETCH(int, rows);
+    Tracer::Settings trace = Tracer::settings();
+    Tracer::Settings enabled = trace;
+    enabled.enabled = true;
+    Tracer::setSettings(enabled);
+    QBENCHMARK {
+        QString failure = measure("traced", rows, [&]() {
+            QSqlQuery query(db);
+            query.setForwardOnly(true);
+            if (!query.exec(selectSql(rows))) return query.lastError().text();
+            TableUtils::RowBatch batch;
+            int read = TableUtils::readBatch(query, TableUtils::FetchLimits(), false, &batch).rows;
+            TableUtils::fillFromBatch(table, batch);
+            return read == rows ? QString() : mismatch("rows", read, rows);
+        });
+        QVERIFY2(failure.isEmpty(), qPrintable(failure));
+    }
+    Tracer::setSettings(trace);
+    loadedRows = rows;
+}
+
+void ThroughputBenchmark::profile_data()
+{
+    addRowCounts();
+}
+
+void ThroughputBenchmark::profile()
+{
+    QFETCH(int, rows);
+    QBENCHMARK {
+        QString failure = measure("profile", rows, [&]() {
+            QSqlQuery query(db);
+            query.setForwardOnly(true);
+            if (!query.exec(selectSql(rows))) return query.lastError().text();
+            TableProfiler::Report report;
+            QString error;
+            if (!TableProfiler::profileQuery(query, TableProfiler::Options(), nullptr, &report, &error)) return error;
+            return report.rows == rows ? QString() : mismatch("rows", report.rows, rows);
+        });
+        QVERIFY2(failure.isEmpty(), qPrintable(failure));
+    }
+}
+
+void ThroughputBenchmark::pivot_data()
+{
+    addRowCounts();
+}
+
+void ThroughputBenchmark::pivot()
+{
+    QFETCH(int, rows);
+    QVERIFY(loadTable(rows));
+    // Average salary and distinct first names per department, pivoted by
+    // last name; includes copying and encoding the grid columns.
+    ResultPivot::Spec spec;
+    spec.groupColumns << 1;
+    spec.pivotColumn = 3;
+    ResultPivot::Aggregate salary;
+    salary.function = ResultPivot::Avg;
+    salary.column = 5;
+    ResultPivot::Aggregate names;
+    names.function = ResultPivot::CountDistinct;
+    names.column = 2;
+    spec.aggregates << ResultPivot::Aggregate() << salary << names;
+    QStringList headers;
+    for (int col = 0; col < table->columnCount(); ++col) {
+        headers << table->horizontalHeaderItem(col)->text();
+    }
+    QBENCHMARK {
+        QString failure = measure("pivot", rows, [&]() {
+            QVector<ResultPivot::ColumnPtr> columns(table->columnCount());
+            for (int col : {1, 2, 3, 5}) {
+                QVector<QString> texts(rows);
+                for (int row = 0; row < rows; ++row) {
+                    texts[row] = table->item(row, col)->text();
+                }
+                columns[col] = ResultPivot::encode(texts, QThread::idealThreadCount());
+            }
+            ResultPivot::Result result = ResultPivot::aggregate(columns, headers, rows, spec,
+                                                                QThread::idealThreadCount());
+            if (!result.ok) return result.error;
+            return result.groups == 4 ? QString() : mismatch("groups", result.groups, 4);
+        });
+        QVERIFY2(failure.isEmpty(), qPrintable(failure));
+    }
+}
+
+void ThroughputBenchmark::spool_data()
+{
+    addRowCounts();
+}
+
+void ThroughputBenchmark::spool()
+{
+    QFETCH(int, rows);
+    QVERIFY(loadTable(rows));
+    // A budget of one byte spills every chunk but the last, so this is the
+    // write to the spill file plus mapping every chunk back in.
+    ResultMemory::Settings memory = ResultMemory::settings();
+    ResultMemory::Settings tight = memory;
+    tight.budgetBytes = 1;
+    ResultMemory::setSettings(tight);
+    QStringList headers;
+    for (int col = 0; col < table->columnCount(); ++col) {
+        headers << table->horizontalHeaderItem(col)->text();
+    }
+    QVector<QStringList> cells(rows);
+    for (int row = 0; row < rows; ++row) {
+        for (int col = 0; col < table->columnCount(); ++col) {
+            cells[row] << table->item(row, col)->text();
+        }
+    }
+    QBENCHMARK {
+        QString failure = measure("spool", rows, [&]() {
+            ResultStore store(headers);
+            QString error;
+            for (int start = 0; start < rows; start += ResultStore::ChunkRows) {
+                if (!store.append(cells.mid(start, ResultStore::ChunkRows), &error)) return error;
+            }
+            for (int row = 0; row < rows; ++row) {
+                int size = store.row(row, &error).size();
+                if (!error.isEmpty()) return error;
+                if (size != headers.size()) return mismatch("cells", size, headers.size());
+            }
+            return store.rowCount() == rows ? QString() : mismatch("rows", store.rowCount(), rows);
+        });
+        QVERIFY2(failure.isEmpty(), qPrintable(failure));
+    }
+    ResultMemory::setSettings(memory);
+}
+
+void ThroughputBenchmark::sort_data()
+{
+    addRowCounts();
+}
+
+void ThroughputBenchmark::sort()
+{
+    QFETCH(int, rows);
+    QVERIFY(loadTable(rows));
+    Qt::SortOrder order = Qt::AscendingOrder;
+    QBENCHMARK {
+        measure("sort", rows, [&]() {
+            // Salary: numeric comparisons on an unsorted column.
+            TableUtils::sortRows(table, 5, order);
+            return QString();
+        });
+        order = order == Qt::AscendingOrder ? Qt::DescendingOrder : Qt::AscendingOrder;
+    }
+}
+
+void ThroughputBenchmark::exportCsv_data()
+{
+    addRowCounts();
+}
+
+void ThroughputBenchmark::exportCsv()
+{
+    QFETCH(int, rows);
+    QVERIFY(loadTable(rows));
+    QBENCHMARK {
+        QString failure = measure("export", rows, [&]() {
+            NullDevice sink;
+            return TableUtils::exportTable(table, &sink, ResultExporter::Csv) ? QString() : QString("export failed");
+        });
+        QVERIFY2(failure.isEmpty(), qPrintable(failure));
+    }
+}
+
+void ThroughputBenchmark::copy_data()
+{
+    addRowCounts();
+}
+
+void ThroughputBenchmark::copy()
+{
+    QFETCH(int, rows);
+    QVERIFY(loadTable(rows));
+    table->selectAll();
+    QBENCHMARK {
+        QString failure = measure("copy", rows, [&]() {
+            return TableUtils::selectionToText(table).isEmpty() ? QString("nothing copied") : QString();
+        });
+        QVERIFY2(failure.isEmpty(), qPrintable(failure));
+    }
+    table->clearSelection();
+}
+
+QTEST_MAIN(ThroughputBenchmark)
+
+#include "tst_throughput.moc"
@@ -0,0 +1,83 @@
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWaitCondition>
+#include <QQueue>
+#include "tracer.h"
+
+// Blocking FIFO between pipeline stages running on different threads. push()
+// waits while the queue is full, so a fast producer cannot run ahead of its
+// consumer by more than `capacity` items.
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(int capacity) : capacity(qMax(1, capacity)), closed(false), aborted(false) {}
+
+    // Returns false once the queue was aborted; the item is dropped.
+    bool push(const T &item) {
+        QMutexLocker locker(&mutex);
+        if (items.size() >= capacity && !aborted) {
+            qint64 started = Tracer::isEnabled() ? Tracer::now() : -1;
+            while (items.size() >= capacity && !aborted) {
+                notFull.wait(&mutex);
+            }
+            waited(started);
+        }
+        if (aborted) return false;
+        items.enqueue(item);
+        notEmpty.wakeOne();
+        return true;
+    }
+
+    // Returns false when the queue is drained and closed, or aborted.
+    bool pop(T *item) {
+        QMutexLocker locker(&mutex);
+        if (items.isEmpty() && !closed && !aborted) {
+            qint64 started = Tracer::isEnabled() ? Tracer::now() : -1;
+            while (items.isEmpty() && !closed && !aborted) {
+                notEmpty.wait(&mutex);
+            }
+            waited(started);
+        }
+        if (aborted || items.isEmpty()) return false;
+        *item = items.dequeue();
+        notFull.wakeOne();
+        return true;
+    }
+
+    // The producer is done; consumers drain what is left.
+    void close() {
+        QMutexLocker locker(&mutex);
+        closed = true;
+        notEmpty.wakeAll();
+    }
+
+    // Stops both sides and drops pending items.
+    void abort() {
+        QMutexLocker locker(&mutex);
+        aborted = true;
+        items.clear();
+        notEmpty.wakeAll();
+        notFull.wakeAll();
+    }
+
+private:
+    static void waited(qint64 started) {
+        if (started >= 0) {
+            Tracer::count(Tracer::QueueWaits);
+            Tracer::count(Tracer::QueueWaitNs, Tracer::now() - started);
+        }
+    }
+
+    QMutex mutex;
+    QWaitCondition notEmpty;
+    QWaitCondition notFull;
+    QQueue<T> items;
+    const int capacity;
+    bool closed;
+    bool aborted;
+};
+
+#endif // BOUNDEDQUEUE_H
@@ -0,0 +1,284 @@
+#include "browsequery.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QObject>
+
+namespace {
+
+struct IndexColumns {
+    QString name;
+    QStringList columns;
+};
+
+QString placeholders(int count) {
+    QStringList marks;
+    for (int i = 0; i < count; ++i) {
+        marks << "?";
+    }
+    return marks.join(", ");
+}
+
+QString escapeLike(QString value) {
+    return value.replace("\\", "\\\\").replace("%", "\\%").replace("_", "\\_");
+}
+
+// Whether a b-tree index leading with the column can narrow the condition.
+// On PostgreSQL "starts with" is a LIKE on the text of the column, which a
+// plain b-tree serves only under the C collation.
+bool indexable(BrowseQuery::Operator op, bool postgres) {
+    switch (op) {
+    case BrowseQuery::NotEquals:
+    case BrowseQuery::Contains:
+    case BrowseQuery::IsNotNull:
+        return false;
+    case BrowseQuery::StartsWith:
+        return !postgres;
+    default:
+        return true;
+    }
+}
+
+QVector<IndexColumns> loadIndexes(DatabaseConnection &connection, const QString &table) {
+    QVector<IndexColumns> indexes;
+    QSqlQuery query(connection.database());
+    if (connection.database().driverName() == "QPSQL") {
+        // Expression columns (attnum 0) have no attribute and drop out.
+        query.prepare("SELECT ic.relname, array_to_string(ARRAY(SELECT a.attname "
+                      "FROM unnest(i.indkey) WITH ORDINALITY k(attnum, n) "
+                      "JOIN pg_attribute a ON a.attrelid = i.indrelid AND a.attnum = k.attnum "
+                      "ORDER BY k.n), chr(31)) "
+                      "FROM pg_index i JOIN pg_class ic ON ic.oid = i.indexrelid "
+                      "WHERE i.indrelid = ?::regclass AND i.indisvalid AND i.indpred IS NULL "
+                      "ORDER BY i.indisprimary DESC, ic.relname");
+        query.addBindValue(connection.quoteIdentifier(table));
+        if (!query.exec()) return indexes;
+        while (query.next()) {
+            IndexColumns index;
+            index.name = query.value(0).toString();
+            index.columns = query.value(1).toString().split(QChar(0x1f), Qt::SkipEmptyParts);
+            indexes << index;
+        }
+        return indexes;
+    }
+    query.prepare("SELECT INDEX_NAME, COLUMN_NAME FROM information_schema.STATISTICS "
+                  "WHERE TABLE_SCHEMA = DATABASE() AND TABLE_NAME = ? AND COLUMN_NAME IS NOT NULL "
+                  "ORDER BY INDEX_NAME = 'PRIMARY' DESC, INDEX_NAME, SEQ_IN_INDEX");
+    query.addBindValue(table);
+    if (!query.exec()) return indexes;
+    while (query.next()) {
+        QString name = query.value(0).toString();
+        if (indexes.isEmpty() || indexes.last().name != name) {
+            IndexColumns index;
+            index.name = name;
+            indexes << index;
+        }
+        indexes.last().columns << query.value(1).toString();
+    }
+    return indexes;
+}
+
+} // namespace
+
+QString BrowseQuery::operatorName(Operator op) {
+    switch (op) {
+    case Equals: return "=";
+    case NotEquals: return "<>";
+    case Less: return "<";
+    case LessOrEqual: return "<=";
+    case Greater: return ">";
+    case GreaterOrEqual: return ">=";
+    case StartsWith: return QObject::tr("starts with");
+    case Contains: return QObject::tr("contains");
+    case In: return QObject::tr("in");
+    case IsNull: return QObject::tr("is null");
+    case IsNotNull: return QObject::tr("is not null");
+    case OperatorCount: break;
+    }
+    return QString();
+}
+
+bool BrowseQuery::takesValue(Operator op) {
+    return op != IsNull && op != IsNotNull;
+}
+
+bool BrowseQuery::seekable(const LargeValues::Column &column, bool postgres) {
+    static const QStringList postgresTypes = {
+        "smallint", "integer", "bigint", "oid", "boolean", "date", "uuid", "text", "character varying",
+        "character", "name"
+    };
+    static const QStringList mysqlTypes = {
+        "tinyint", "smallint", "mediumint", "int", "bigint", "date", "year", "char", "varchar"
+    };
+    return !column.large && (postgres ? postgresTypes : mysqlTypes).contains(column.baseType);
+}
+
+bool BrowseQuery::build(DatabaseConnection &connection, const LargeValues::Browse &browse, const Request &request,
+                        const Position &after, int limit, Statement *statement, QString *error) {
+    bool postgres = connection.database().driverName() == "QPSQL";
+    QStringList known;
+    // Conditions may name columns the projection leaves out.
+    for (const LargeValues::Column &column : browse.tableColumns) {
+        known << column.name;
+    }
+
+    QStringList where;
+    QVariantList values;
+    for (const Condition &condition : request.conditions) {
+        if (!known.isEmpty() && !known.contains(condition.column)) {
+            *error = QObject::tr("%1 has no column %2").arg(request.table, condition.column);
+            return false;
+        }
+        QString column = connection.quoteIdentifier(condition.column);
+        QString text = postgres ? column + "::text" : column;
+        switch (condition.op) {
+        case Equals: where << column + " = ?"; break;
+        case NotEquals: where << column + " <> ?"; break;
+        case Less: where << column + " < ?"; break;
+        case LessOrEqual: where << column + " <= ?"; break;
+        case Greater: where << column + " > ?"; break;
+        case GreaterOrEqual: where << column + " >= ?"; break;
+        case StartsWith: where << text + " LIKE ?"; break;
+        case Contains: where << text + (postgres ? " ILIKE ?" : " LIKE ?"); break;
+        case IsNull: where << column + " IS NULL"; break;
+        case IsNotNull: where << column + " IS NOT NULL"; break;
+        case In: {
+            QStringList items;
+            for (const QString &item : condition.value.split(',')) {
+                if (!item.trimmed().isEmpty()) {
+                    items << item.trimmed();
+                }
+            }
+            if (items.isEmpty()) {
+                *error = QObject::tr("Enter comma-separated values for %1 in").arg(condition.column);
+                return false;
+            }
+            where << QString("%1 IN (%2)").arg(column, placeholders(items.size()));
+            for (const QString &item : items) {
+                values << item;
+            }
+            break;
+        }
+        case OperatorCount: break;
+        }
+        if (condition.op == StartsWith) {
+            values << escapeLike(condition.value) + "%";
+        } else if (condition.op == Contains) {
+            values << "%" + escapeLike(condition.value) + "%";
+        } else if (takesValue(condition.op) && condition.op != In) {
+            values << condition.value;
+        }
+    }
+
+    QStringList order;
+    const QStringList &keys = browse.keyColumns;
+    QStringList quotedKeys;
+    for (const QString &key : keys) {
+        quotedKeys << connection.quoteIdentifier(key);
+    }
+    QString keyTuple = "(" + quotedKeys.join(", ") + ")";
+    bool keyOrder = request.sortColumn.isEmpty() || (keys.size() == 1 && request.sortColumn == keys.first());
+    QString direction = request.descending ? " DESC" : "";
+    if (!keys.isEmpty() && keyOrder) {
+        for (const QString &key : quotedKeys) {
+            order << key + direction;
+        }
+        if (after.valid) {
+            where << QString("%1 %2 (%3)").arg(keyTuple, request.descending ? "<" : ">", placeholders(keys.size()));
+            for (const QVariant &value : after.keyValues) {
+                values << value;
+            }
+        }
+    } else if (!request.sortColumn.isEmpty()) {
+        // NULLs last either way, so a page ending on NULL continues with
+        // the NULLs only.
+        QString sort = connection.quoteIdentifier(request.sortColumn);
+        if (postgres) {
+            order << sort + direction + " NULLS LAST";
+        } else {
+            order << sort + " IS NULL" << sort + direction;
+        }
+        order << quotedKeys;
+        if (after.valid && !keys.isEmpty()) {
+            if (after.sortValue.isNull()) {
+                where << QString("(%1 IS NULL AND %2 > (%3))").arg(sort, keyTuple, placeholders(keys.size()));
+            } else {
+                where << QString("(%1 %2 ? OR (%1 = ? AND %3 > (%4)) OR %1 IS NULL)")
+                             .arg(sort, request.descending ? "<" : ">", keyTuple, placeholders(keys.size()));
+                values << after.sortValue << after.sortValue;
+            }
+            for (const QVariant &value : after.keyValues) {
+                values << value;
+            }
+        }
+    }
+
+    statement->sql = browse.sql;
+    if (!where.isEmpty()) {
+        statement->sql += " WHERE " + where.join(" AND ");
+    }
+    if (!order.isEmpty()) {
+        statement->sql += " ORDER BY " + order.join(", ");
+    }
+    if (limit > 0) {
+        statement->sql += QString(" LIMIT %1").arg(limit);
+    }
+    statement->values = values;
+    return true;
+}
+
+QString BrowseQuery::indexUse(DatabaseConnection &connection, const Request &request) {
+    bool postgres = connection.database().driverName() == "QPSQL";
+    QVector<IndexColumns> indexes = loadIndexes(connection, request.table);
+
+    auto leadingIndex = [&indexes](const QString &column) {
+        for (const IndexColumns &index : indexes) {
+            if (!index.columns.isEmpty() && index.columns.first() == column) {
+                return index.name;
+            }
+        }
+        return QString();
+    };
+
+    QStringList sentences;
+    QStringList unindexed;
+    QStringList unusable;
+    QString used;
+    // Equality first: it narrows the most.
+    for (bool equality : {true, false}) {
+        for (const Condition &condition : request.conditions) {
+            bool isEquality = condition.op == Equals || condition.op == In || condition.op == IsNull;
+            if (!used.isEmpty() || isEquality != equality || !indexable(condition.op, postgres)) continue;
+            QString index = leadingIndex(condition.column);
+            if (!index.isEmpty()) {
+                used = QObject::tr("The filter on %1 can use the index %2.").arg(condition.column, index);
+            }
+        }
+    }
+    for (const Condition &condition : request.conditions) {
+        if (!indexable(condition.op, postgres)) {
+            unusable << QString("%1 %2").arg(condition.column, operatorName(condition.op));
+        } else if (leadingIndex(condition.column).isEmpty() && !unindexed.contains(condition.column)) {
+            unindexed << condition.column;
+        }
+    }
+    if (!used.isEmpty()) {
+        sentences << used;
+    } else if (!request.conditions.isEmpty()) {
+        sentences << QObject::tr("No index can serve this filter; the server reads the whole table.");
+        if (!unindexed.isEmpty()) {
+            sentences << QObject::tr("No index leads with %1.").arg(unindexed.join(", "));
+        }
+        if (!unusable.isEmpty()) {
+            sentences << QObject::tr("%1 cannot use a b-tree index.").arg(unusable.join(", "));
+        }
+    }
+
+    if (!request.sortColumn.isEmpty()) {
+        QString index = leadingIndex(request.sortColumn);
+        sentences << (index.isEmpty()
+                          ? QObject::tr("Sorting by %1 sorts every matching row (no index leads with it).")
+                                .arg(request.sortColumn)
+                          : QObject::tr("Sorted by %1 through the index %2.").arg(request.sortColumn, index));
+    }
+    return sentences.join(' ');
+}
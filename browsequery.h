@@ -0,0 +1,72 @@
+#ifndef BROWSEQUERY_H
+#define BROWSEQUERY_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QVariant>
+#include "databaseconnection.h"
+#include "largevalues.h"
+
+// The statement behind browsing a table: the filter bar's conditions as a
+// parameterized WHERE, the sort done by the server, and pages read by key.
+// With a primary key each page seeks past the last row shown,
+//   WHERE <filter> AND (key) > (?) ORDER BY key LIMIT n
+// so a page costs the same at the end of the table as at the start. Without
+// one, or when the key or sort column does not survive the round trip
+// through the driver, the result is read on, as a query's is.
+class BrowseQuery {
+public:
+    enum Operator {
+        Equals, NotEquals, Less, LessOrEqual, Greater, GreaterOrEqual,
+        StartsWith, Contains, In, IsNull, IsNotNull, OperatorCount
+    };
+
+    struct Condition {
+        Condition() : op(Equals) {}
+        QString column;
+        Operator op;
+        QString value;        // In: comma-separated
+    };
+
+    struct Request {
+        Request() : descending(false) {}
+        QString table;
+        QStringList columns;             // projection, in grid order; empty for the default
+        QVector<Condition> conditions;   // all must hold
+        QString sortColumn;              // empty for key order
+        bool descending;
+    };
+
+    // Where the previous page ended: its last row's sort and key values.
+    struct Position {
+        Position() : valid(false) {}
+        bool valid;
+        QVariant sortValue;
+        QVector<QVariant> keyValues;
+    };
+
+    struct Statement {
+        QString sql;
+        QVariantList values;
+    };
+
+    // Rows per page, whatever row cap the session has for queries.
+    static const int PageRows = 1000;
+
+    static QString operatorName(Operator op);
+    static bool takesValue(Operator op);
+    // Whether a value of the column comes back from the driver exactly, so
+    // a page can seek past it. Timestamps lose their microseconds and
+    // decimals become doubles; such keys and sorts read on from the cursor.
+    static bool seekable(const LargeValues::Column &column, bool postgres);
+
+    // `limit` 0 reads to the end; keyColumns empty means no seeking.
+    static bool build(DatabaseConnection &connection, const LargeValues::Browse &browse, const Request &request,
+                      const Position &after, int limit, Statement *statement, QString *error);
+    // Which index, per the catalog, can serve the filter or the sort; a
+    // sentence for the filter bar.
+    static QString indexUse(DatabaseConnection &connection, const Request &request);
+};
+
+#endif // BROWSEQUERY_H
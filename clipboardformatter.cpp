@@ -0,0 +1,297 @@
+#include "clipboardformatter.h"
+#include <QSet>
+#include <climits>
+
+namespace {
+
+const int InsertBatchRows = 1000;
+
+bool isCanceled(const QAtomicInt *canceled) {
+    return canceled && canceled->loadRelaxed() != 0;
+}
+
+} // namespace
+
+ClipboardFormatter::Snapshot ClipboardFormatter::capture(const QTableWidget *table, const QString &tableName,
+                                                         QChar identifierQuote) {
+    Snapshot snapshot;
+    snapshot.tableName = tableName;
+    snapshot.identifierQuote = identifierQuote;
+
+    const QList<QTableWidgetSelectionRange> ranges = table->selectedRanges();
+    if (ranges.isEmpty()) {
+        return snapshot;
+    }
+
+    // Map table rows/columns that hold a selected cell to snapshot positions.
+    QVector<int> rowIndex(table->rowCount(), -1);
+    QVector<int> columnIndex(table->columnCount(), -1);
+    for (const QTableWidgetSelectionRange &range : ranges) {
+        for (int row = range.topRow(); row <= range.bottomRow(); ++row) {
+            rowIndex[row] = 0;
+        }
+        for (int col = range.leftColumn(); col <= range.rightColumn(); ++col) {
+            columnIndex[col] = 0;
+        }
+    }
+    for (int row = 0; row < rowIndex.size(); ++row) {
+        if (rowIndex[row] == 0) {
+            rowIndex[row] = snapshot.rowCount++;
+        }
+    }
+    int columnCount = 0;
+    for (int col = 0; col < columnIndex.size(); ++col) {
+        if (columnIndex[col] == 0) {
+            columnIndex[col] = columnCount++;
+            QTableWidgetItem *header = table->horizontalHeaderItem(col);
+            snapshot.headers << (header ? header->text() : QString::number(col + 1));
+        }
+    }
+
+    qint64 cellCount = qint64(snapshot.rowCount) * columnCount;
+    snapshot.cells.resize(cellCount);
+    snapshot.nulls.resize(cellCount);
+    snapshot.nulls.fill(true);
+
+    for (const QTableWidgetSelectionRange &range : ranges) {
+        for (int row = range.topRow(); row <= range.bottomRow(); ++row) {
+            int base = rowIndex[row] * columnCount;
+            for (int col = range.leftColumn(); col <= range.rightColumn(); ++col) {
+                QTableWidgetItem *item = table->item(row, col);
+                if (!item) continue;
+                int index = base + columnIndex[col];
+                if (!snapshot.nulls.testBit(index)) continue;
+                snapshot.cells[index] = item->text();
+                snapshot.nulls.clearBit(index);
+                snapshot.totalChars += snapshot.cells[index].size();
+            }
+        }
+    }
+    return snapshot;
+}
+
+QString ClipboardFormatter::formatName(Format format) {
+    switch (format) {
+    case Tsv: return QObject::tr("TSV");
+    case Csv: return QObject::tr("CSV");
+    case Markdown: return QObject::tr("Markdown");
+    case Json: return QObject::tr("JSON");
+    case SqlInsert: return QObject::tr("SQL INSERT");
+    case SqlInList: return QObject::tr("SQL IN list");
+    }
+    return QString();
+}
+
+QString ClipboardFormatter::format(const Snapshot &snapshot, Format format,
+                                   QAtomicInt *rowsDone, const QAtomicInt *canceled) {
+    const int columnCount = snapshot.headers.size();
+    const int rowCount = snapshot.rowCount;
+    if (columnCount == 0 || rowCount == 0) {
+        return QString();
+    }
+
+    qint64 headerChars = 0;
+    for (const QString &header : snapshot.headers) {
+        headerChars += header.size() + 4;
+    }
+
+    // Per-cell overhead: separators and quoting for the delimited formats,
+    // keys for JSON, quotes and commas for SQL.
+    qint64 perCell = 3;
+    if (format == Json) {
+        perCell = headerChars / columnCount + 6;
+    } else if (format == SqlInsert || format == SqlInList) {
+        perCell = 4;
+    }
+    QString out;
+    out.reserve(static_cast<int>(qMin<qint64>(snapshot.totalChars + perCell * snapshot.cellCount() +
+                                              headerChars + rowCount * 4, INT_MAX / 2)));
+
+    auto reportRow = [rowsDone](int row) {
+        if (rowsDone && (row & 1023) == 0) {
+            rowsDone->storeRelaxed(row);
+        }
+    };
+
+    switch (format) {
+    case Tsv:
+    case Csv: {
+        QChar delimiter = format == Tsv ? QChar('\t') : QChar(',');
+        if (format == Csv) {
+            for (int col = 0; col < columnCount; ++col) {
+                if (col > 0) out += delimiter;
+                appendDelimited(out, snapshot.headers.at(col), delimiter, false);
+            }
+            out += '\n';
+        }
+        for (int row = 0; row < rowCount; ++row) {
+            if (isCanceled(canceled)) return QString();
+            reportRow(row);
+            int base = row * columnCount;
+            for (int col = 0; col < columnCount; ++col) {
+                if (col > 0) out += delimiter;
+                appendDelimited(out, snapshot.cells.at(base + col), delimiter, false);
+            }
+            out += '\n';
+        }
+        break;
+    }
+    case Markdown: {
+        auto appendCell = [&out](const QString &value) {
+            QString escaped = value;
+            escaped.replace('|', "\\|").replace('\n', "<br>");
+            out += ' ';
+            out += escaped;
+            out += " |";
+        };
+        out += '|';
+        for (const QString &header : snapshot.headers) appendCell(header);
+        out += "\n|";
+        for (int col = 0; col < columnCount; ++col) out += " --- |";
+        out += '\n';
+        for (int row = 0; row < rowCount; ++row) {
+            if (isCanceled(canceled)) return QString();
+            reportRow(row);
+            out += '|';
+            int base = row * columnCount;
+            for (int col = 0; col < columnCount; ++col) {
+                appendCell(snapshot.cells.at(base + col));
+            }
+            out += '\n';
+        }
+        break;
+    }
+    case Json: {
+        out += "[\n";
+        for (int row = 0; row < rowCount; ++row) {
+            if (isCanceled(canceled)) return QString();
+            reportRow(row);
+            out += row == 0 ? "  {" : ",\n  {";
+            int base = row * columnCount;
+            for (int col = 0; col < columnCount; ++col) {
+                if (col > 0) out += ", ";
+                appendJsonString(out, snapshot.headers.at(col));
+                out += ": ";
+                if (snapshot.nulls.testBit(base + col)) {
+                    out += "null";
+                } else {
+                    appendJsonString(out, snapshot.cells.at(base + col));
+                }
+            }
+            out += '}';
+        }
+        out += "\n]\n";
+        break;
+    }
+    case SqlInsert: {
+        QString table = quoteIdentifier(snapshot.tableName.isEmpty() ? QString("table_name") : snapshot.tableName,
+                                        snapshot.identifierQuote);
+        QStringList quotedColumns;
+        for (const QString &header : snapshot.headers) {
+            quotedColumns << quoteIdentifier(header, snapshot.identifierQuote);
+        }
+        QString prefix = QString("INSERT INTO %1 (%2) VALUES\n").arg(table, quotedColumns.join(", "));
+        for (int row = 0; row < rowCount; ++row) {
+            if (isCanceled(canceled)) return QString();
+            reportRow(row);
+            out += row % InsertBatchRows == 0 ? prefix : QString(",\n");
+            out += '(';
+            int base = row * columnCount;
+            for (int col = 0; col < columnCount; ++col) {
+                if (col > 0) out += ", ";
+                appendSqlLiteral(out, snapshot.cells.at(base + col), snapshot.nulls.testBit(base + col));
+            }
+            out += ')';
+            if (row % InsertBatchRows == InsertBatchRows - 1 || row == rowCount - 1) {
+                out += ";\n";
+            }
+        }
+        break;
+    }
+    case SqlInList: {
+        QSet<QString> seen;
+        seen.reserve(snapshot.cellCount());
+        out += "IN (";
+        bool first = true;
+        for (int row = 0; row < rowCount; ++row) {
+            if (isCanceled(canceled)) return QString();
+            reportRow(row);
+            int base = row * columnCount;
+            for (int col = 0; col < columnCount; ++col) {
+                if (snapshot.nulls.testBit(base + col)) continue;
+                const QString &value = snapshot.cells.at(base + col);
+                if (seen.contains(value)) continue;
+                seen.insert(value);
+                if (!first) out += ", ";
+                first = false;
+                appendSqlLiteral(out, value, false);
+            }
+        }
+        out += ")";
+        break;
+    }
+    }
+
+    if (rowsDone) {
+        rowsDone->storeRelaxed(rowCount);
+    }
+    return out;
+}
+
+void ClipboardFormatter::appendDelimited(QString &out, const QString &value, QChar delimiter, bool quoteAll) {
+    bool needsQuotes = quoteAll || value.contains(delimiter) || value.contains('"') ||
+                       value.contains('\n') || value.contains('\r');
+    if (!needsQuotes) {
+        out += value;
+        return;
+    }
+    out += '"';
+    if (value.contains('"')) {
+        QString escaped = value;
+        out += escaped.replace("\"", "\"\"");
+    } else {
+        out += value;
+    }
+    out += '"';
+}
+
+void ClipboardFormatter::appendJsonString(QString &out, const QString &value) {
+    out += '"';
+    for (const QChar ch : value) {
+        switch (ch.unicode()) {
+        case '"':  out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (ch.unicode() < 0x20) {
+                out += QString("\\u%1").arg(ch.unicode(), 4, 16, QChar('0'));
+            } else {
+                out += ch;
+            }
+        }
+    }
+    out += '"';
+}
+
+void ClipboardFormatter::appendSqlLiteral(QString &out, const QString &value, bool isNull) {
+    if (isNull) {
+        out += "NULL";
+        return;
+    }
+    out += '\'';
+    if (value.contains('\'')) {
+        QString escaped = value;
+        out += escaped.replace("'", "''");
+    } else {
+        out += value;
+    }
+    out += '\'';
+}
+
+QString ClipboardFormatter::quoteIdentifier(const QString &name, QChar quote) {
+    QString escaped = name;
+    escaped.replace(quote, QString(2, quote));
+    return quote + escaped + quote;
+}
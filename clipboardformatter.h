@@ -0,0 +1,54 @@
+#ifndef CLIPBOARDFORMATTER_H
+#define CLIPBOARDFORMATTER_H
+
+#include <QTableWidget>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QBitArray>
+#include <QAtomicInt>
+
+// Turns the grid selection into clipboard text. capture() must run on the GUI
+// thread; it only copies the (implicitly shared) cell strings, so format()
+// can then build the text in a worker thread.
+class ClipboardFormatter {
+public:
+    enum Format {
+        Tsv,
+        Csv,
+        Markdown,
+        Json,
+        SqlInsert,
+        SqlInList
+    };
+
+    // Union of all selected ranges, as the rows x columns that contain a
+    // selected cell. Cells outside every range, and cells without an item,
+    // are marked as null.
+    struct Snapshot {
+        Snapshot() : rowCount(0), totalChars(0), identifierQuote('"') {}
+        QStringList headers;
+        int rowCount;
+        QVector<QString> cells;
+        QBitArray nulls;
+        qint64 totalChars;
+        QString tableName;
+        QChar identifierQuote;
+
+        int cellCount() const { return cells.size(); }
+    };
+
+    static Snapshot capture(const QTableWidget *table, const QString &tableName = QString(),
+                            QChar identifierQuote = '"');
+    static QString format(const Snapshot &snapshot, Format format,
+                          QAtomicInt *rowsDone = nullptr, const QAtomicInt *canceled = nullptr);
+    static QString formatName(Format format);
+
+private:
+    static void appendDelimited(QString &out, const QString &value, QChar delimiter, bool quoteAll);
+    static void appendJsonString(QString &out, const QString &value);
+    static void appendSqlLiteral(QString &out, const QString &value, bool isNull);
+    static QString quoteIdentifier(const QString &name, QChar quote);
+};
+
+#endif // CLIPBOARDFORMATTER_H
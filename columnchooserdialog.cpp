@@ -0,0 +1,162 @@
+#include "columnchooserdialog.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QPushButton>
+#include <QLabel>
+#include <QSettings>
+#include <QCryptographicHash>
+
+namespace {
+
+const int NameRole = Qt::UserRole;
+
+QString projectionKey(const QString &server, const QString &database, const QString &table)
+{
+    // Server and table names may hold the separators QSettings keys use.
+    QStringList parts = {server, database, table};
+    QByteArray id = QCryptographicHash::hash(parts.join('\n').toUtf8(), QCryptographicHash::Md5).toHex();
+    return "projection/" + QString::fromLatin1(id.left(16));
+}
+
+} // namespace
+
+ColumnChooserDialog::ColumnChooserDialog(QWidget *parent, const LargeValues::Browse &browse, bool defaultProjection)
+    : QDialog(parent), keyColumns(browse.keyColumns), tableColumns(browse.tableColumns),
+      defaults(defaultProjection)
+{
+    setWindowTitle(tr("Columns of %1").arg(browse.table));
+    setMinimumSize(320, 420);
+
+    auto layout = new QVBoxLayout(this);
+    auto hint = new QLabel(tr("Checked columns are selected, in this order; drag them to reorder. "
+                              "Large columns are left out unless checked."), this);
+    hint->setWordWrap(true);
+    layout->addWidget(hint);
+
+    columnList = new QListWidget(this);
+    columnList->setDragDropMode(QAbstractItemView::InternalMove);
+    columnList->setDefaultDropAction(Qt::MoveAction);
+    layout->addWidget(columnList);
+
+    // The grid's columns first, as they are shown, then the rest in table order.
+    QStringList shown;
+    for (const LargeValues::Column &column : browse.columns) {
+        addColumn(column, true);
+        shown << column.name;
+    }
+    for (const LargeValues::Column &column : tableColumns) {
+        if (!shown.contains(column.name)) {
+            addColumn(column, false);
+        }
+    }
+
+    auto moveLayout = new QHBoxLayout;
+    auto upButton = new QPushButton(tr("Up"), this);
+    auto downButton = new QPushButton(tr("Down"), this);
+    auto allButton = new QPushButton(tr("All"), this);
+    auto defaultsButton = new QPushButton(tr("Defaults"), this);
+    moveLayout->addWidget(upButton);
+    moveLayout->addWidget(downButton);
+    moveLayout->addStretch();
+    moveLayout->addWidget(allButton);
+    moveLayout->addWidget(defaultsButton);
+    layout->addLayout(moveLayout);
+
+    auto buttonLayout = new QHBoxLayout;
+    auto okButton = new QPushButton(tr("OK"), this);
+    auto cancelButton = new QPushButton(tr("Cancel"), this);
+    okButton->setDefault(true);
+    buttonLayout->addStretch();
+    buttonLayout->addWidget(okButton);
+    buttonLayout->addWidget(cancelButton);
+    layout->addLayout(buttonLayout);
+
+    connect(upButton, &QPushButton::clicked, [this]() { moveCurrent(-1); });
+    connect(downButton, &QPushButton::clicked, [this]() { moveCurrent(1); });
+    connect(allButton, &QPushButton::clicked, this, &ColumnChooserDialog::checkAll);
+    connect(defaultsButton, &QPushButton::clicked, this, &ColumnChooserDialog::restoreDefaults);
+    connect(okButton, &QPushButton::clicked, this, &QDialog::accept);
+    connect(cancelButton, &QPushButton::clicked, this, &QDialog::reject);
+    connect(columnList, &QListWidget::itemChanged, [this]() { defaults = false; });
+    connect(columnList->model(), &QAbstractItemModel::rowsMoved, [this]() { defaults = false; });
+}
+
+void ColumnChooserDialog::addColumn(const LargeValues::Column &column, bool checked)
+{
+    auto item = new QListWidgetItem(column.name, columnList);
+    item->setData(NameRole, column.name);
+    bool key = keyColumns.contains(column.name);
+    Qt::ItemFlags flags = Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemIsDragEnabled;
+    if (key) {
+        item->setToolTip(tr("Primary key; always selected"));
+        checked = true;
+    } else {
+        flags |= Qt::ItemIsUserCheckable;
+    }
+    if (column.large) {
+        item->setText(tr("%1 (large)").arg(column.name));
+        item->setToolTip(tr("Selected as a preview with its size"));
+    }
+    item->setFlags(flags);
+    item->setCheckState(checked ? Qt::Checked : Qt::Unchecked);
+}
+
+QStringList ColumnChooserDialog::columns() const
+{
+    QStringList result;
+    if (defaults) return result;
+    for (int row = 0; row < columnList->count(); ++row) {
+        QListWidgetItem *item = columnList->item(row);
+        if (item->checkState() == Qt::Checked) {
+            result << item->data(NameRole).toString();
+        }
+    }
+    return result;
+}
+
+void ColumnChooserDialog::moveCurrent(int offset)
+{
+    int row = columnList->currentRow();
+    int target = row + offset;
+    if (row < 0 || target < 0 || target >= columnList->count()) return;
+    QListWidgetItem *item = columnList->takeItem(row);
+    columnList->insertItem(target, item);
+    columnList->setCurrentRow(target);
+    defaults = false;
+}
+
+void ColumnChooserDialog::checkAll()
+{
+    for (int row = 0; row < columnList->count(); ++row) {
+        columnList->item(row)->setCheckState(Qt::Checked);
+    }
+}
+
+void ColumnChooserDialog::restoreDefaults()
+{
+    {
+        const QSignalBlocker blocker(columnList);
+        columnList->clear();
+        for (const LargeValues::Column &column : tableColumns) {
+            addColumn(column, !column.large);
+        }
+    }
+    defaults = true;
+}
+
+QStringList ColumnChooserDialog::savedColumns(const QString &server, const QString &database, const QString &table)
+{
+    QSettings settings("DBManager", "Settings");
+    return settings.value(projectionKey(server, database, table)).toStringList();
+}
+
+void ColumnChooserDialog::saveColumns(const QString &server, const QString &database, const QString &table,
+                                      const QStringList &columns)
+{
+    QSettings settings("DBManager", "Settings");
+    if (columns.isEmpty()) {
+        settings.remove(projectionKey(server, database, table));
+    } else {
+        settings.setValue(projectionKey(server, database, table), columns);
+    }
+}
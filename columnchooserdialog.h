@@ -0,0 +1,40 @@
+#ifndef COLUMNCHOOSERDIALOG_H
+#define COLUMNCHOOSERDIALOG_H
+
+#include <QDialog>
+#include <QListWidget>
+#include <QStringList>
+#include "largevalues.h"
+
+// Which columns of a table the grid selects, and in what order. The choice
+// is kept per server, database and table; without one, browsing leaves out
+// the large TEXT/BLOB/JSON columns.
+class ColumnChooserDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    ColumnChooserDialog(QWidget *parent, const LargeValues::Browse &browse, bool defaultProjection);
+
+    // Empty when the default projection was chosen.
+    QStringList columns() const;
+
+    static QStringList savedColumns(const QString &server, const QString &database, const QString &table);
+    // An empty list forgets the table's projection.
+    static void saveColumns(const QString &server, const QString &database, const QString &table,
+                            const QStringList &columns);
+
+private slots:
+    void moveCurrent(int offset);
+    void checkAll();
+    void restoreDefaults();
+
+private:
+    void addColumn(const LargeValues::Column &column, bool checked);
+
+    QListWidget *columnList;
+    QStringList keyColumns;
+    QVector<LargeValues::Column> tableColumns;
+    bool defaults;
+};
+
+#endif // COLUMNCHOOSERDIALOG_H
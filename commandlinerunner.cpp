@@ -0,0 +1,272 @@
+#include "commandlinerunner.h"
+#include "resultexporter.h"
+#include "tracer.h"
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLoggingCategory>
+#include <QSqlRecord>
+#include <cstring>
+#include <cstdio>
+
+namespace {
+
+const char *const HeadlessOptions[] = {
+    "-e", "--execute", "-f", "--file", "--server", "--list-servers", "-h", "--help"
+};
+
+double toMs(qint64 ns) {
+    return ns / 1000000.0;
+}
+
+// Writes the spans of the run as a Chrome trace on every way out of it.
+class TraceFile {
+public:
+    TraceFile(const QString &path, QTextStream &err) : path(path), err(err) {
+        if (!path.isEmpty()) {
+            Tracer::Settings settings;
+            settings.enabled = true;
+            Tracer::setSettings(settings);
+        }
+    }
+    ~TraceFile() {
+        QString error;
+        if (!path.isEmpty() && !Tracer::writeChromeTrace(path, &error)) {
+            err << "Failed to write trace: " << error << "\n";
+        }
+    }
+
+private:
+    QString path;
+    QTextStream &err;
+};
+
+} // namespace
+
+CommandLineRunner::CommandLineRunner()
+    : out(stdout), err(stderr), connectNs(0), executeNs(0), fetchNs(0), writeNs(0), totalNs(0) {
+}
+
+bool CommandLineRunner::isHeadlessInvocation(int argc, char *argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        for (const char *option : HeadlessOptions) {
+            size_t length = std::strlen(option);
+            if (std::strncmp(argv[i], option, length) == 0 &&
+                (argv[i][length] == '\0' || argv[i][length] == '=')) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+int CommandLineRunner::run(const QStringList &arguments) {
+    QElapsedTimer totalTimer;
+    totalTimer.start();
+
+    // Keep stderr machine-readable: the connection layer logs through qDebug().
+    QLoggingCategory::setFilterRules("*.debug=false");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("DB Manager headless mode: run a statement against a saved server.");
+    parser.addHelpOption();
+
+    QCommandLineOption serverOption("server", "Saved server name.", "name");
+    QCommandLineOption dbOption("db", "Database to use instead of the saved one.", "database");
+    QCommandLineOption executeOption({"e", "execute"}, "SQL statement to run.", "sql");
+    QCommandLineOption fileOption({"f", "file"}, "Read the statement from a file ('-' for stdin).", "path");
+    QCommandLineOption formatOption("format", "Output format: csv, tsv or json.", "format", "csv");
+    QCommandLineOption outputOption({"o", "output"}, "Output file (default: stdout).", "path");
+    QCommandLineOption noHeaderOption("no-header", "Do not write the column header line.");
+    QCommandLineOption noStatsOption("no-stats", "Do not print timing statistics to stderr.");
+    QCommandLineOption listOption("list-servers", "List saved servers and exit.");
+    QCommandLineOption traceOption("trace", "Write a Chrome trace of the run to a file.", "path");
+
+    parser.addOptions({serverOption, dbOption, executeOption, fileOption, formatOption,
+                       outputOption, noHeaderOption, noStatsOption, listOption, traceOption});
+    parser.process(arguments);
+    TraceFile trace(parser.value(traceOption), err);
+
+    if (parser.isSet(listOption)) {
+        const QStringList servers = connection.getSavedServers();
+        for (const QString &server : servers) {
+            out << server << "\n";
+        }
+        out.flush();
+        return Success;
+    }
+
+    QString serverName = parser.value(serverOption);
+    if (serverName.isEmpty()) {
+        err << "Missing --server\n";
+        return UsageError;
+    }
+    if (!connection.getSavedServers().contains(serverName)) {
+        err << "Unknown server: " << serverName << "\n";
+        return UsageError;
+    }
+
+    ResultExporter::Format format;
+    if (!ResultExporter::formatFromName(parser.value(formatOption), &format)) {
+        err << "Unknown format: " << parser.value(formatOption) << "\n";
+        return UsageError;
+    }
+
+    QString sql;
+    if (!readStatement(parser.value(executeOption), parser.value(fileOption), &sql)) {
+        return UsageError;
+    }
+
+    DatabaseConnection::ConnectionParams params = connection.loadConnectionSettings(serverName);
+    if (parser.isSet(dbOption)) {
+        params.dbName = parser.value(dbOption);
+    }
+
+    QElapsedTimer stageTimer;
+    stageTimer.start();
+    if (!connection.connect(params)) {
+        err << "Failed to connect to server: " << connection.lastError().text() << "\n";
+        return ConnectionError;
+    }
+    connectNs = stageTimer.nsecsElapsed();
+
+    stageTimer.restart();
+    QSqlQuery result;
+    if (!connection.executeQuery(sql, result, true)) {
+        QString message = result.lastError().isValid() ? result.lastError().text()
+                                                       : connection.lastError().text();
+        err << "Query execution error: " << message << "\n";
+        return QueryError;
+    }
+    executeNs = stageTimer.nsecsElapsed();
+
+    qint64 rows = 0;
+    qint64 bytes = 0;
+    qint64 affectedRows = -1;
+    int columnCount = 0;
+
+    if (result.isSelect()) {
+        QFile outputFile;
+        QString outputName = parser.value(outputOption);
+        bool opened;
+        if (outputName.isEmpty() || outputName == "-") {
+            opened = outputFile.open(stdout, QIODevice::WriteOnly);
+        } else {
+            outputFile.setFileName(outputName);
+            opened = outputFile.open(QIODevice::WriteOnly | QIODevice::Truncate);
+        }
+        if (!opened) {
+            err << "Failed to open output: " << outputFile.errorString() << "\n";
+            return OutputError;
+        }
+
+        ResultExporter exporter(&outputFile, format);
+        exporter.setWriteHeader(!parser.isSet(noHeaderOption));
+
+        QSqlRecord record = result.record();
+        columnCount = record.count();
+        QStringList headers;
+        for (int i = 0; i < columnCount; ++i) {
+            headers << record.fieldName(i);
+        }
+        exporter.writeHeader(headers);
+
+        QVariantList values;
+        values.reserve(columnCount);
+        QElapsedTimer writeTimer;
+
+        stageTimer.restart();
+        Tracer::Scope span(Tracer::Export);
+        while (result.next()) {
+            values.clear();
+            for (int col = 0; col < columnCount; ++col) {
+                values << result.value(col);
+            }
+            writeTimer.start();
+            exporter.writeRow(values);
+            writeNs += writeTimer.nsecsElapsed();
+        }
+        writeTimer.start();
+        bool finished = exporter.finish();
+        writeNs += writeTimer.nsecsElapsed();
+        fetchNs = stageTimer.nsecsElapsed() - writeNs;
+
+        rows = exporter.rowsWritten();
+        bytes = exporter.bytesWritten();
+        span.setValue(rows);
+        Tracer::count(Tracer::RowsFetched, rows);
+        outputFile.close();
+
+        if (!finished) {
+            err << "Failed to write output: " << exporter.errorString() << "\n";
+            return OutputError;
+        }
+    } else {
+        affectedRows = result.numRowsAffected();
+    }
+
+    totalNs = totalTimer.nsecsElapsed();
+
+    if (!parser.isSet(noStatsOption)) {
+        printStats(serverName, params.dbName, rows, columnCount, bytes, affectedRows);
+    }
+    return Success;
+}
+
+bool CommandLineRunner::readStatement(const QString &inlineSql, const QString &fileName, QString *sql) {
+    if (!inlineSql.isEmpty() && !fileName.isEmpty()) {
+        err << "Use either --execute or --file, not both\n";
+        return false;
+    }
+
+    if (!fileName.isEmpty()) {
+        QFile file;
+        bool opened;
+        if (fileName == "-") {
+            opened = file.open(stdin, QIODevice::ReadOnly);
+        } else {
+            file.setFileName(fileName);
+            opened = file.open(QIODevice::ReadOnly);
+        }
+        if (!opened) {
+            err << "Failed to read " << fileName << ": " << file.errorString() << "\n";
+            return false;
+        }
+        *sql = QString::fromUtf8(file.readAll());
+    } else {
+        *sql = inlineSql;
+    }
+
+    *sql = sql->trimmed();
+    if (sql->isEmpty()) {
+        err << "Missing --execute or --file\n";
+        return false;
+    }
+    return true;
+}
+
+void CommandLineRunner::printStats(const QString &serverName, const QString &dbName, qint64 rows,
+                                   int columns, qint64 bytes, qint64 affectedRows) {
+    double fetchSeconds = (fetchNs + writeNs) / 1e9;
+
+    QJsonObject stats;
+    stats["server"] = serverName;
+    stats["database"] = dbName;
+    stats["rows"] = rows;
+    stats["columns"] = columns;
+    stats["bytes"] = bytes;
+    if (affectedRows >= 0) {
+        stats["affected_rows"] = affectedRows;
+    }
+    stats["connect_ms"] = toMs(connectNs);
+    stats["execute_ms"] = toMs(executeNs);
+    stats["fetch_ms"] = toMs(fetchNs);
+    stats["write_ms"] = toMs(writeNs);
+    stats["total_ms"] = toMs(totalNs);
+    stats["rows_per_sec"] = fetchSeconds > 0 ? rows / fetchSeconds : 0.0;
+
+    err << QString::fromUtf8(QJsonDocument(stats).toJson(QJsonDocument::Compact)) << "\n";
+    err.flush();
+}
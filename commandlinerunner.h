@@ -0,0 +1,44 @@
+#ifndef COMMANDLINERUNNER_H
+#define COMMANDLINERUNNER_H
+
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+#include "databaseconnection.h"
+
+// Headless entry point: runs one statement against a saved server and streams
+// the result to a file or stdout. Only QtCore/QtSql are touched on this path,
+// no QApplication or widgets are created.
+class CommandLineRunner {
+public:
+    enum ExitCode {
+        Success = 0,
+        UsageError = 1,
+        ConnectionError = 2,
+        QueryError = 3,
+        OutputError = 4
+    };
+
+    CommandLineRunner();
+
+    static bool isHeadlessInvocation(int argc, char *argv[]);
+
+    int run(const QStringList &arguments);
+
+private:
+    bool readStatement(const QString &inlineSql, const QString &fileName, QString *sql);
+    void printStats(const QString &serverName, const QString &dbName, qint64 rows, int columns,
+                    qint64 bytes, qint64 affectedRows);
+
+    QTextStream out;
+    QTextStream err;
+    DatabaseConnection connection;
+
+    qint64 connectNs;
+    qint64 executeNs;
+    qint64 fetchNs;
+    qint64 writeNs;
+    qint64 totalNs;
+};
+
+#endif // COMMANDLINERUNNER_H
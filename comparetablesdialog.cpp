@@ -0,0 +1,241 @@
+#include "comparetablesdialog.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QFormLayout>
+#include <QGroupBox>
+#include <QMessageBox>
+#include <QHeaderView>
+#include <QtConcurrent>
+
+namespace {
+
+QString displayValue(const QVariant &value) {
+    return value.isNull() ? QString("NULL") : value.toString();
+}
+
+} // namespace
+
+CompareTablesDialog::CompareTablesDialog(QWidget *parent, const QString &serverName,
+                                         const QString &database, const QString &table)
+    : QDialog(parent), settings("DBManager", "Settings")
+{
+    setWindowTitle(tr("Compare Tables"));
+    resize(800, 550);
+
+    auto layout = new QVBoxLayout(this);
+    auto sidesLayout = new QHBoxLayout;
+    sidesLayout->addWidget(createSide(tr("Source"), &sourceServerComboBox, &sourceDatabaseEdit, &sourceTableEdit));
+    sidesLayout->addWidget(createSide(tr("Target"), &targetServerComboBox, &targetDatabaseEdit, &targetTableEdit));
+    layout->addLayout(sidesLayout);
+
+    auto optionsLayout = new QFormLayout;
+    chunkRowsSpinBox = new QSpinBox(this);
+    chunkRowsSpinBox->setRange(100, 10000000);
+    chunkRowsSpinBox->setSingleStep(1000);
+    chunkRowsSpinBox->setValue(settings.value("compare/chunkRows", 10000).toInt());
+    optionsLayout->addRow(tr("Rows per chunk:"), chunkRowsSpinBox);
+    workersSpinBox = new QSpinBox(this);
+    workersSpinBox->setRange(1, 32);
+    workersSpinBox->setValue(settings.value("compare/workers", 4).toInt());
+    optionsLayout->addRow(tr("Parallel connections:"), workersSpinBox);
+    layout->addLayout(optionsLayout);
+
+    auto runLayout = new QHBoxLayout;
+    progressBar = new QProgressBar(this);
+    progressBar->setRange(0, 1);
+    progressBar->setValue(0);
+    compareButton = new QPushButton(tr("Compare"), this);
+    compareButton->setDefault(true);
+    auto closeButton = new QPushButton(tr("Close"), this);
+    runLayout->addWidget(progressBar, 1);
+    runLayout->addWidget(compareButton);
+    runLayout->addWidget(closeButton);
+    layout->addLayout(runLayout);
+
+    summaryLabel = new QLabel(this);
+    summaryLabel->setWordWrap(true);
+    layout->addWidget(summaryLabel);
+
+    resultTable = new QTableWidget(0, 3, this);
+    resultTable->setHorizontalHeaderLabels({tr("Key"), tr("Difference"), tr("Details")});
+    resultTable->horizontalHeader()->setStretchLastSection(true);
+    resultTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    resultTable->verticalHeader()->hide();
+    layout->addWidget(resultTable, 1);
+
+    QStringList servers = dbConnection.getSavedServers();
+    sourceServerComboBox->addItems(servers);
+    targetServerComboBox->addItems(servers);
+    if (!serverName.isEmpty()) {
+        sourceServerComboBox->setCurrentText(serverName);
+    }
+    sourceDatabaseEdit->setText(database);
+    sourceTableEdit->setText(table);
+    targetTableEdit->setText(table);
+    targetServerComboBox->setCurrentText(settings.value("compare/targetServer").toString());
+    targetDatabaseEdit->setText(settings.value("compare/targetDatabase", database).toString());
+
+    progressTimer.setInterval(200);
+    connect(&progressTimer, &QTimer::timeout, this, &CompareTablesDialog::updateProgress);
+    connect(&watcher, &QFutureWatcher<TableComparer::Result>::finished, this, &CompareTablesDialog::showResult);
+    connect(compareButton, &QPushButton::clicked, this, &CompareTablesDialog::startOrCancel);
+    connect(closeButton, &QPushButton::clicked, this, &QDialog::reject);
+}
+
+CompareTablesDialog::~CompareTablesDialog()
+{
+    // The workers use this dialog's progress counters.
+    progress.canceled.storeRelaxed(1);
+    watcher.waitForFinished();
+}
+
+QWidget *CompareTablesDialog::createSide(const QString &title, QComboBox **server,
+                                         QLineEdit **database, QLineEdit **table)
+{
+    auto group = new QGroupBox(title, this);
+    auto formLayout = new QFormLayout(group);
+    *server = new QComboBox(group);
+    *database = new QLineEdit(group);
+    *table = new QLineEdit(group);
+    (*database)->setPlaceholderText(tr("Server default"));
+    formLayout->addRow(tr("Server:"), *server);
+    formLayout->addRow(tr("Database:"), *database);
+    formLayout->addRow(tr("Table:"), *table);
+    return group;
+}
+
+bool CompareTablesDialog::buildOptions(TableComparer::Options *options)
+{
+    if (sourceServerComboBox->currentText().isEmpty() || targetServerComboBox->currentText().isEmpty()) {
+        QMessageBox::warning(this, windowTitle(), tr("Choose a source and a target server"));
+        return false;
+    }
+    if (sourceTableEdit->text().trimmed().isEmpty() || targetTableEdit->text().trimmed().isEmpty()) {
+        QMessageBox::warning(this, windowTitle(), tr("Enter the table to compare on both sides"));
+        return false;
+    }
+
+    options->source = dbConnection.loadConnectionSettings(sourceServerComboBox->currentText());
+    options->target = dbConnection.loadConnectionSettings(targetServerComboBox->currentText());
+    if (!sourceDatabaseEdit->text().trimmed().isEmpty()) {
+        options->source.dbName = sourceDatabaseEdit->text().trimmed();
+    }
+    if (!targetDatabaseEdit->text().trimmed().isEmpty()) {
+        options->target.dbName = targetDatabaseEdit->text().trimmed();
+    }
+    // A comparison legitimately runs long, but never writes.
+    options->source.statementTimeout = 0;
+    options->target.statementTimeout = 0;
+    options->source.readOnly = true;
+    options->target.readOnly = true;
+    options->sourceTable = sourceTableEdit->text().trimmed();
+    options->targetTable = targetTableEdit->text().trimmed();
+    options->chunkRows = chunkRowsSpinBox->value();
+    options->leafRows = qMin(1000, chunkRowsSpinBox->value());
+    options->workers = workersSpinBox->value();
+    return true;
+}
+
+void CompareTablesDialog::startOrCancel()
+{
+    if (watcher.isRunning()) {
+        progress.canceled.storeRelaxed(1);
+        compareButton->setEnabled(false);
+        return;
+    }
+
+    TableComparer::Options options;
+    if (!buildOptions(&options)) return;
+
+    settings.setValue("compare/chunkRows", chunkRowsSpinBox->value());
+    settings.setValue("compare/workers", workersSpinBox->value());
+    settings.setValue("compare/targetServer", targetServerComboBox->currentText());
+    settings.setValue("compare/targetDatabase", targetDatabaseEdit->text());
+
+    progress.rangesTotal.storeRelaxed(0);
+    progress.rangesDone.storeRelaxed(0);
+    progress.canceled.storeRelaxed(0);
+    resultTable->setRowCount(0);
+    summaryLabel->setText(tr("Splitting %1 into key ranges...").arg(options.sourceTable));
+
+    TableComparer::Progress *shared = &progress;
+    watcher.setFuture(QtConcurrent::run([options, shared]() {
+        return TableComparer::compare(options, shared);
+    }));
+    setRunning(true);
+}
+
+void CompareTablesDialog::setRunning(bool running)
+{
+    compareButton->setText(running ? tr("Cancel") : tr("Compare"));
+    compareButton->setEnabled(true);
+    sourceServerComboBox->setEnabled(!running);
+    targetServerComboBox->setEnabled(!running);
+    chunkRowsSpinBox->setEnabled(!running);
+    workersSpinBox->setEnabled(!running);
+    if (running) {
+        progressBar->setRange(0, 0);
+        progressTimer.start();
+    } else {
+        progressTimer.stop();
+    }
+}
+
+void CompareTablesDialog::updateProgress()
+{
+    int total = progress.rangesTotal.loadRelaxed();
+    int done = progress.rangesDone.loadRelaxed();
+    if (total == 0) return;
+    progressBar->setRange(0, total);
+    progressBar->setValue(done);
+    summaryLabel->setText(tr("Compared %1 of %2 key ranges").arg(done).arg(total));
+}
+
+void CompareTablesDialog::showResult()
+{
+    setRunning(false);
+    TableComparer::Result result = watcher.result();
+    progressBar->setRange(0, 1);
+    progressBar->setValue(result.ok ? 1 : 0);
+
+    QStringList summary;
+    if (!result.ok) {
+        summary << tr("Comparison failed: %1").arg(result.error);
+    } else if (result.differences.isEmpty()) {
+        summary << tr("Tables are identical");
+    } else {
+        summary << tr("%1 differing rows%2").arg(result.differences.size())
+                       .arg(result.truncated ? tr(" (stopped at the limit)") : QString());
+    }
+    summary << tr("%1 of %2 ranges differed, %3 rows transferred, %4 ms")
+                   .arg(result.rangesDiffering).arg(result.rangesCompared)
+                   .arg(result.rowsTransferred).arg(result.elapsedMs);
+    if (!result.ignoredColumns.isEmpty()) {
+        summary << tr("Columns not on both sides were ignored: %1").arg(result.ignoredColumns.join(", "));
+    }
+    summaryLabel->setText(summary.join("\n"));
+
+    resultTable->setRowCount(result.differences.size());
+    for (int row = 0; row < result.differences.size(); ++row) {
+        const TableComparer::Difference &difference = result.differences.at(row);
+        QStringList details;
+        for (int col = 0; col < result.columns.size(); ++col) {
+            QVariant source = difference.sourceRow.value(col);
+            QVariant target = difference.targetRow.value(col);
+            if (difference.kind == TableComparer::Changed) {
+                if (source != target) {
+                    details << QString("%1: %2 -> %3").arg(result.columns.at(col), displayValue(source),
+                                                            displayValue(target));
+                }
+            } else {
+                const QVariant &value = difference.kind == TableComparer::MissingInTarget ? source : target;
+                details << QString("%1=%2").arg(result.columns.at(col), displayValue(value));
+            }
+        }
+        resultTable->setItem(row, 0, new QTableWidgetItem(displayValue(difference.key)));
+        resultTable->setItem(row, 1, new QTableWidgetItem(TableComparer::kindName(difference.kind)));
+        resultTable->setItem(row, 2, new QTableWidgetItem(details.join("; ")));
+    }
+    resultTable->resizeColumnToContents(0);
+    resultTable->resizeColumnToContents(1);
+}
@@ -0,0 +1,54 @@
+#ifndef COMPARETABLESDIALOG_H
+#define COMPARETABLESDIALOG_H
+
+#include <QDialog>
+#include <QComboBox>
+#include <QLineEdit>
+#include <QSpinBox>
+#include <QPushButton>
+#include <QProgressBar>
+#include <QLabel>
+#include <QTableWidget>
+#include <QTimer>
+#include <QFutureWatcher>
+#include <QSettings>
+#include "tablecomparer.h"
+
+class CompareTablesDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    CompareTablesDialog(QWidget *parent, const QString &serverName = QString(),
+                        const QString &database = QString(), const QString &table = QString());
+    ~CompareTablesDialog();
+
+private slots:
+    void startOrCancel();
+    void updateProgress();
+    void showResult();
+
+private:
+    QWidget *createSide(const QString &title, QComboBox **server, QLineEdit **database, QLineEdit **table);
+    bool buildOptions(TableComparer::Options *options);
+    void setRunning(bool running);
+
+    QComboBox *sourceServerComboBox;
+    QLineEdit *sourceDatabaseEdit;
+    QLineEdit *sourceTableEdit;
+    QComboBox *targetServerComboBox;
+    QLineEdit *targetDatabaseEdit;
+    QLineEdit *targetTableEdit;
+    QSpinBox *chunkRowsSpinBox;
+    QSpinBox *workersSpinBox;
+    QPushButton *compareButton;
+    QProgressBar *progressBar;
+    QLabel *summaryLabel;
+    QTableWidget *resultTable;
+    QTimer progressTimer;
+    QFutureWatcher<TableComparer::Result> watcher;
+    TableComparer::Progress progress;
+    DatabaseConnection dbConnection;
+    QSettings settings;
+};
+
+#endif // COMPARETABLESDIALOG_H
@@ -0,0 +1,228 @@
+#include "copytabledialog.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QFormLayout>
+#include <QGroupBox>
+#include <QMessageBox>
+#include <QLocale>
+#include <QtConcurrent>
+
+CopyTableDialog::CopyTableDialog(QWidget *parent, const QString &serverName,
+                                 const QString &database, const QString &table)
+    : QDialog(parent), lastRows(0), lastElapsed(0), settings("DBManager", "Settings")
+{
+    setWindowTitle(tr("Copy Table"));
+    setMinimumWidth(650);
+
+    auto layout = new QVBoxLayout(this);
+    auto sidesLayout = new QHBoxLayout;
+    sidesLayout->addWidget(createSide(tr("Source"), &sourceServerComboBox, &sourceDatabaseEdit, &sourceTableEdit));
+    sidesLayout->addWidget(createSide(tr("Target"), &targetServerComboBox, &targetDatabaseEdit, &targetTableEdit));
+    layout->addLayout(sidesLayout);
+
+    auto optionsLayout = new QFormLayout;
+    partitionsSpinBox = new QSpinBox(this);
+    partitionsSpinBox->setRange(1, 64);
+    partitionsSpinBox->setValue(settings.value("copy/partitions", 4).toInt());
+    optionsLayout->addRow(tr("Parallel partitions:"), partitionsSpinBox);
+    pageRowsSpinBox = new QSpinBox(this);
+    pageRowsSpinBox->setRange(100, 1000000);
+    pageRowsSpinBox->setSingleStep(1000);
+    pageRowsSpinBox->setValue(settings.value("copy/pageRows", 5000).toInt());
+    optionsLayout->addRow(tr("Rows per page:"), pageRowsSpinBox);
+    createTableCheckBox = new QCheckBox(tr("Create the target table if it does not exist"), this);
+    createTableCheckBox->setChecked(settings.value("copy/createTable", true).toBool());
+    optionsLayout->addRow(createTableCheckBox);
+    truncateCheckBox = new QCheckBox(tr("Truncate the target table first"), this);
+    optionsLayout->addRow(truncateCheckBox);
+    resumeCheckBox = new QCheckBox(tr("Resume an interrupted copy"), this);
+    resumeCheckBox->setChecked(true);
+    optionsLayout->addRow(resumeCheckBox);
+    layout->addLayout(optionsLayout);
+
+    progressBar = new QProgressBar(this);
+    progressBar->setRange(0, 1);
+    progressBar->setValue(0);
+    layout->addWidget(progressBar);
+    statusLabel = new QLabel(this);
+    statusLabel->setWordWrap(true);
+    layout->addWidget(statusLabel);
+
+    auto buttonLayout = new QHBoxLayout;
+    copyButton = new QPushButton(tr("Copy"), this);
+    copyButton->setDefault(true);
+    auto closeButton = new QPushButton(tr("Close"), this);
+    buttonLayout->addStretch();
+    buttonLayout->addWidget(copyButton);
+    buttonLayout->addWidget(closeButton);
+    layout->addLayout(buttonLayout);
+
+    QStringList servers = dbConnection.getSavedServers();
+    sourceServerComboBox->addItems(servers);
+    targetServerComboBox->addItems(servers);
+    if (!serverName.isEmpty()) {
+        sourceServerComboBox->setCurrentText(serverName);
+    }
+    sourceDatabaseEdit->setText(database);
+    sourceTableEdit->setText(table);
+    targetTableEdit->setText(table);
+    targetServerComboBox->setCurrentText(settings.value("copy/targetServer").toString());
+    targetDatabaseEdit->setText(settings.value("copy/targetDatabase").toString());
+
+    progressTimer.setInterval(500);
+    connect(&progressTimer, &QTimer::timeout, this, &CopyTableDialog::updateProgress);
+    connect(&watcher, &QFutureWatcher<TableCopier::Result>::finished, this, &CopyTableDialog::showResult);
+    connect(copyButton, &QPushButton::clicked, this, &CopyTableDialog::startOrCancel);
+    connect(closeButton, &QPushButton::clicked, this, &QDialog::reject);
+}
+
+CopyTableDialog::~CopyTableDialog()
+{
+    // The pipeline uses this dialog's progress counters; a canceled copy
+    // keeps its checkpoint and can be resumed.
+    progress.canceled.storeRelaxed(1);
+    watcher.waitForFinished();
+}
+
+QWidget *CopyTableDialog::createSide(const QString &title, QComboBox **server,
+                                     QLineEdit **database, QLineEdit **table)
+{
+    auto group = new QGroupBox(title, this);
+    auto formLayout = new QFormLayout(group);
+    *server = new QComboBox(group);
+    *database = new QLineEdit(group);
+    *table = new QLineEdit(group);
+    (*database)->setPlaceholderText(tr("Server default"));
+    formLayout->addRow(tr("Server:"), *server);
+    formLayout->addRow(tr("Database:"), *database);
+    formLayout->addRow(tr("Table:"), *table);
+    return group;
+}
+
+bool CopyTableDialog::buildOptions(TableCopier::Options *options)
+{
+    if (sourceServerComboBox->currentText().isEmpty() || targetServerComboBox->currentText().isEmpty()) {
+        QMessageBox::warning(this, windowTitle(), tr("Choose a source and a target server"));
+        return false;
+    }
+    if (sourceTableEdit->text().trimmed().isEmpty() || targetTableEdit->text().trimmed().isEmpty()) {
+        QMessageBox::warning(this, windowTitle(), tr("Enter the source and target table names"));
+        return false;
+    }
+
+    options->source = dbConnection.loadConnectionSettings(sourceServerComboBox->currentText());
+    options->target = dbConnection.loadConnectionSettings(targetServerComboBox->currentText());
+    if (!sourceDatabaseEdit->text().trimmed().isEmpty()) {
+        options->source.dbName = sourceDatabaseEdit->text().trimmed();
+    }
+    if (!targetDatabaseEdit->text().trimmed().isEmpty()) {
+        options->target.dbName = targetDatabaseEdit->text().trimmed();
+    }
+    if (options->target.readOnly) {
+        QMessageBox::warning(this, windowTitle(),
+                             tr("Server %1 is configured as read-only").arg(targetServerComboBox->currentText()));
+        return false;
+    }
+    options->source.statementTimeout = 0;
+    options->target.statementTimeout = 0;
+    options->source.readOnly = true;
+    options->sourceTable = sourceTableEdit->text().trimmed();
+    options->targetTable = targetTableEdit->text().trimmed();
+    options->partitions = partitionsSpinBox->value();
+    options->pageRows = pageRowsSpinBox->value();
+    options->createTable = createTableCheckBox->isChecked();
+    options->truncateTarget = truncateCheckBox->isChecked();
+    options->resume = resumeCheckBox->isChecked();
+    return true;
+}
+
+void CopyTableDialog::startOrCancel()
+{
+    if (watcher.isRunning()) {
+        progress.canceled.storeRelaxed(1);
+        copyButton->setEnabled(false);
+        return;
+    }
+
+    TableCopier::Options options;
+    if (!buildOptions(&options)) return;
+
+    settings.setValue("copy/partitions", partitionsSpinBox->value());
+    settings.setValue("copy/pageRows", pageRowsSpinBox->value());
+    settings.setValue("copy/createTable", createTableCheckBox->isChecked());
+    settings.setValue("copy/targetServer", targetServerComboBox->currentText());
+    settings.setValue("copy/targetDatabase", targetDatabaseEdit->text());
+
+    progress.rowsCopied.storeRelaxed(0);
+    progress.bytesWritten.storeRelaxed(0);
+    progress.estimatedRows.storeRelaxed(-1);
+    progress.canceled.storeRelaxed(0);
+    lastRows = 0;
+    lastElapsed = 0;
+    runTimer.start();
+    statusLabel->setText(tr("Preparing %1...").arg(options.sourceTable));
+
+    TableCopier::Progress *shared = &progress;
+    watcher.setFuture(QtConcurrent::run([options, shared]() {
+        return TableCopier::copy(options, shared);
+    }));
+    setRunning(true);
+}
+
+void CopyTableDialog::setRunning(bool running)
+{
+    copyButton->setText(running ? tr("Cancel") : tr("Copy"));
+    copyButton->setEnabled(true);
+    sourceServerComboBox->setEnabled(!running);
+    targetServerComboBox->setEnabled(!running);
+    partitionsSpinBox->setEnabled(!running);
+    pageRowsSpinBox->setEnabled(!running);
+    if (running) {
+        progressBar->setRange(0, 0);
+        progressTimer.start();
+    } else {
+        progressTimer.stop();
+    }
+}
+
+void CopyTableDialog::updateProgress()
+{
+    qint64 rows = progress.rowsCopied.loadRelaxed();
+    qint64 estimate = progress.estimatedRows.loadRelaxed();
+    qint64 elapsed = runTimer.elapsed();
+
+    // Rate over the last interval, so a resumed copy does not start inflated.
+    qint64 interval = qMax<qint64>(1, elapsed - lastElapsed);
+    qint64 rowsPerSecond = (rows - lastRows) * 1000 / interval;
+    lastRows = rows;
+    lastElapsed = elapsed;
+
+    if (estimate > 0) {
+        progressBar->setRange(0, 1000);
+        progressBar->setValue(static_cast<int>(qMin<qint64>(1000, rows * 1000 / estimate)));
+    }
+    QLocale locale;
+    statusLabel->setText(tr("%1 rows copied, %2 rows/s, %3 sent")
+                             .arg(locale.toString(rows), locale.toString(rowsPerSecond),
+                                  locale.formattedDataSize(progress.bytesWritten.loadRelaxed())));
+}
+
+void CopyTableDialog::showResult()
+{
+    setRunning(false);
+    TableCopier::Result result = watcher.result();
+    progressBar->setRange(0, 1);
+    progressBar->setValue(result.ok ? 1 : 0);
+
+    QLocale locale;
+    QStringList lines = result.notes;
+    if (result.ok) {
+        double seconds = qMax<qint64>(1, result.elapsedMs) / 1000.0;
+        lines << tr("Copied %1 rows in %2 s (%3 partitions)")
+                     .arg(locale.toString(result.rowsCopied)).arg(seconds, 0, 'f', 1).arg(result.partitions);
+    } else {
+        lines << tr("Copy stopped after %1 rows: %2").arg(locale.toString(result.rowsCopied), result.error);
+        lines << tr("Run the copy again with \"Resume\" checked to continue from the last checkpoint.");
+    }
+    statusLabel->setText(lines.join("\n"));
+}
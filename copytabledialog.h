@@ -0,0 +1,60 @@
+#ifndef COPYTABLEDIALOG_H
+#define COPYTABLEDIALOG_H
+
+#include <QDialog>
+#include <QComboBox>
+#include <QLineEdit>
+#include <QSpinBox>
+#include <QCheckBox>
+#include <QPushButton>
+#include <QProgressBar>
+#include <QLabel>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+#include <QSettings>
+#include "tablecopier.h"
+
+class CopyTableDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    CopyTableDialog(QWidget *parent, const QString &serverName = QString(),
+                    const QString &database = QString(), const QString &table = QString());
+    ~CopyTableDialog();
+
+private slots:
+    void startOrCancel();
+    void updateProgress();
+    void showResult();
+
+private:
+    QWidget *createSide(const QString &title, QComboBox **server, QLineEdit **database, QLineEdit **table);
+    bool buildOptions(TableCopier::Options *options);
+    void setRunning(bool running);
+
+    QComboBox *sourceServerComboBox;
+    QLineEdit *sourceDatabaseEdit;
+    QLineEdit *sourceTableEdit;
+    QComboBox *targetServerComboBox;
+    QLineEdit *targetDatabaseEdit;
+    QLineEdit *targetTableEdit;
+    QSpinBox *partitionsSpinBox;
+    QSpinBox *pageRowsSpinBox;
+    QCheckBox *createTableCheckBox;
+    QCheckBox *truncateCheckBox;
+    QCheckBox *resumeCheckBox;
+    QPushButton *copyButton;
+    QProgressBar *progressBar;
+    QLabel *statusLabel;
+    QTimer progressTimer;
+    QElapsedTimer runTimer;
+    qint64 lastRows;
+    qint64 lastElapsed;
+    QFutureWatcher<TableCopier::Result> watcher;
+    TableCopier::Progress progress;
+    DatabaseConnection dbConnection;
+    QSettings settings;
+};
+
+#endif // COPYTABLEDIALOG_H
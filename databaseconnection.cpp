@@ -1,6 +1,9 @@
 #include "databaseconnection.h"
+#include "tracer.h"
 #include <QSqlQuery>
 #include <QSqlDriver>
+#include <QRegularExpression>
+#include <QObject>
 
 DatabaseConnection::DatabaseConnection() : lastExecutionTime(""), settings("DBManager", "Connections") {
 }
@@ -13,6 +16,7 @@ bool DatabaseConnection::connect(const ConnectionParams& params) {
     if (!params.isValid()) {
         return false;
     }
+    Tracer::Scope span(Tracer::Connect);
 
     if (db.isOpen()) {
         disconnect();
@@ -24,6 +28,7 @@ bool DatabaseConnection::connect(const ConnectionParams& params) {
     }
 
     currentParams = params;
+    lastQueryError = QSqlError();
     
     db = QSqlDatabase::addDatabase(params.driver, connectionName);
     
@@ -54,6 +59,10 @@ bool DatabaseConnection::connect(const ConnectionParams& params) {
              
     if (!result) {
         qDebug() << "Connection error:" << db.lastError().text();
+    } else if (!applySessionLimits()) {
+        // Callers asking for a read-only session or a timeout rely on it.
+        db.close();
+        result = false;
     }
     
     return result;
@@ -74,9 +83,51 @@ bool DatabaseConnection::isConnected() const {
 }
 
 QSqlError DatabaseConnection::lastError() const {
+    if (lastQueryError.isValid()) {
+        return lastQueryError;
+    }
     return db.lastError();
 }
 
+const DatabaseConnection::ConnectionParams& DatabaseConnection::connectionParams() const {
+    return currentParams;
+}
+
+bool DatabaseConnection::applySessionLimits() {
+    QSqlQuery query(db);
+
+    if (currentParams.statementTimeout > 0) {
+        int timeoutMs = currentParams.statementTimeout * 1000;
+        bool applied;
+        if (db.driverName() == "QPSQL") {
+            applied = query.exec(QString("SET statement_timeout = %1").arg(timeoutMs));
+        } else {
+            // MAX_EXECUTION_TIME is MySQL 5.7.8+; MariaDB calls it max_statement_time (seconds).
+            applied = query.exec(QString("SET SESSION MAX_EXECUTION_TIME = %1").arg(timeoutMs)) ||
+                      query.exec(QString("SET SESSION max_statement_time = %1").arg(currentParams.statementTimeout));
+        }
+        if (!applied) {
+            lastQueryError = QSqlError(QString(), QObject::tr("Cannot set the statement timeout: %1")
+                                                      .arg(query.lastError().text()),
+                                       QSqlError::ConnectionError);
+            return false;
+        }
+    }
+
+    if (currentParams.readOnly) {
+        QString sql = db.driverName() == "QPSQL"
+            ? "SET SESSION CHARACTERISTICS AS TRANSACTION READ ONLY"
+            : "SET SESSION TRANSACTION READ ONLY";
+        if (!query.exec(sql)) {
+            lastQueryError = QSqlError(QString(), QObject::tr("Cannot make the session read-only: %1")
+                                                      .arg(query.lastError().text()),
+                                       QSqlError::ConnectionError);
+            return false;
+        }
+    }
+    return true;
+}
+
 QStringList DatabaseConnection::tables() const {
     return db.tables();
 }
@@ -85,11 +136,41 @@ QSqlDatabase& DatabaseConnection::database() {
     return db;
 }
 
-bool DatabaseConnection::executeQuery(const QString& query, QSqlQuery& result) {
+QString DatabaseConnection::quoteIdentifier(const QString& name) const {
+    if (!db.driver()) {
+        return name;
+    }
+    return db.driver()->escapeIdentifier(name, QSqlDriver::TableName);
+}
+
+// Pins the settings that change how values are rendered as text, for tools
+// that compare or move data between two servers with different defaults.
+void DatabaseConnection::normalizeSessionFormats() {
+    QSqlQuery query(db);
+    if (db.driverName() == "QPSQL") {
+        query.exec("SET TIME ZONE 'UTC'");
+        query.exec("SET DateStyle = 'ISO, YMD'");
+        query.exec("SET extra_float_digits = 3");
+    } else {
+        query.exec("SET time_zone = '+00:00'");
+    }
+}
+
+bool DatabaseConnection::executeQuery(const QString& query, QSqlQuery& result, bool forwardOnly) {
     if (!isConnected()) {
         return false;
     }
 
+    lastQueryError = QSqlError();
+
+    if (currentParams.readOnly && isWriteStatement(query)) {
+        lastQueryError = QSqlError(QString(), QObject::tr("Server is configured as read-only"),
+                                   QSqlError::StatementError);
+        return false;
+    }
+
+    Tracer::Scope span(Tracer::Execute);
+    Tracer::count(Tracer::Statements);
     QDateTime startTime = QDateTime::currentDateTime();
     
     bool isModification = query.trimmed().toUpper().startsWith("UPDATE") ||
@@ -102,6 +183,7 @@ bool DatabaseConnection::executeQuery(const QString& query, QSqlQuery& result) {
     }
     
     result = QSqlQuery(db);
+    result.setForwardOnly(forwardOnly);
     bool success = result.exec(query);
     
     if (isModification) {
@@ -120,6 +202,8 @@ bool DatabaseConnection::executeQuery(const QString& query, QSqlQuery& result) {
     lastExecutionTime = QString("%1 ms").arg(startTime.msecsTo(endTime));
     
     if (!success) {
+        lastQueryError = result.lastError();
+        Tracer::count(Tracer::StatementErrors);
         qDebug() << "Query error:" << result.lastError().text();
     }
     
@@ -170,6 +254,36 @@ QStringList DatabaseConnection::getAvailableDrivers() {
     return QSqlDatabase::drivers();
 }
 
+bool DatabaseConnection::isWriteStatement(const QString& query) {
+    static const QStringList writeKeywords = {
+        "INSERT", "UPDATE", "DELETE", "REPLACE", "MERGE", "UPSERT", "TRUNCATE",
+        "CREATE", "ALTER", "DROP", "RENAME", "GRANT", "REVOKE", "COPY", "LOAD"
+    };
+    // Comments and opening parentheses before the first keyword.
+    static const QRegularExpression lead("^(\\s+|--[^\\n]*(\\n|$)|#[^\\n]*(\\n|$)|/\\*.*?\\*/|\\()+",
+                                         QRegularExpression::DotMatchesEverythingOption);
+    // A WITH may wrap a data change (PostgreSQL) or precede one (MySQL).
+    static const QRegularExpression modifying("\\b(INSERT|UPDATE|DELETE|MERGE)\\b",
+                                              QRegularExpression::CaseInsensitiveOption);
+    QString statement = query;
+    statement.remove(lead);
+    QString firstWord = statement.section(QRegularExpression("[\\s(]+"), 0, 0).toUpper();
+    if (firstWord == "WITH") {
+        return modifying.match(statement).hasMatch();
+    }
+    return writeKeywords.contains(firstWord);
+}
+
+DatabaseConnection::ConnectionParams DatabaseConnection::defaultLimits() {
+    QSettings defaults("DBManager", "Settings");
+    ConnectionParams params;
+    params.statementTimeout = defaults.value("defaultStatementTimeout", 0).toInt();
+    params.maxRows = defaults.value("defaultMaxRows", 0).toInt();
+    params.maxResultMemoryMb = defaults.value("defaultMaxResultMemoryMb", 512).toInt();
+    params.readOnly = defaults.value("defaultReadOnly", false).toBool();
+    return params;
+}
+
 void DatabaseConnection::saveConnectionSettings(const QString& serverName, const ConnectionParams& params) {
     settings.beginGroup(serverName);
     settings.setValue("driver", params.driver);
@@ -178,10 +292,15 @@ void DatabaseConnection::saveConnectionSettings(const QString& serverName, const
     settings.setValue("dbName", params.dbName);
     settings.setValue("user", params.user);
     settings.setValue("password", params.password);
+    settings.setValue("statementTimeout", params.statementTimeout);
+    settings.setValue("maxRows", params.maxRows);
+    settings.setValue("maxResultMemoryMb", params.maxResultMemoryMb);
+    settings.setValue("readOnly", params.readOnly);
     settings.endGroup();
 }
 
 DatabaseConnection::ConnectionParams DatabaseConnection::loadConnectionSettings(const QString& serverName) {
+    ConnectionParams defaults = defaultLimits();
     ConnectionParams params;
     settings.beginGroup(serverName);
     params.driver = settings.value("driver").toString();
@@ -190,6 +309,10 @@ DatabaseConnection::ConnectionParams DatabaseConnection::loadConnectionSettings(
     params.dbName = settings.value("dbName").toString();
     params.user = settings.value("user").toString();
     params.password = settings.value("password").toString();
+    params.statementTimeout = settings.value("statementTimeout", defaults.statementTimeout).toInt();
+    params.maxRows = settings.value("maxRows", defaults.maxRows).toInt();
+    params.maxResultMemoryMb = settings.value("maxResultMemoryMb", defaults.maxResultMemoryMb).toInt();
+    params.readOnly = settings.value("readOnly", defaults.readOnly).toBool();
     settings.endGroup();
     return params;
 }
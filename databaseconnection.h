@@ -18,6 +18,12 @@ public:
         QString user;
         QString password;
         int port;
+
+        // Execution guardrails; 0 means no limit.
+        int statementTimeout = 0;    // seconds, enforced by the server
+        int maxRows = 0;             // rows fetched into the grid per batch
+        int maxResultMemoryMb = 0;   // estimated client memory per batch
+        bool readOnly = false;
         
         bool isValid() const {
             return !driver.isEmpty() && !host.isEmpty() && 
@@ -33,15 +39,23 @@ public:
     void disconnect();
     bool isConnected() const;
     QSqlError lastError() const;
+    const ConnectionParams& connectionParams() const;
     QStringList tables() const;
     QSqlDatabase& database();
+    QString quoteIdentifier(const QString& name) const;
+    void normalizeSessionFormats();
     
-    bool executeQuery(const QString& query, QSqlQuery& result);
+    bool executeQuery(const QString& query, QSqlQuery& result, bool forwardOnly = false);
     QString getLastExecutionTime() const;
     QStringList getDatabases() const;
     bool changeDatabase(const QString& dbName);
     
     static QStringList getAvailableDrivers();
+    // A hint for warnings and early refusals, not a guard: it reads the
+    // leading keyword (past comments and parentheses) and any data change
+    // inside a WITH. Read-only sessions are enforced by the server.
+    static bool isWriteStatement(const QString& query);
+    static ConnectionParams defaultLimits();
     
     void saveConnectionSettings(const QString& serverName, const ConnectionParams& params);
     ConnectionParams loadConnectionSettings(const QString& serverName);
@@ -49,7 +63,11 @@ public:
     void removeServerSettings(const QString& serverName);
     
 private:
+    // False, with the error set, when a requested limit cannot be applied.
+    bool applySessionLimits();
+
     QString lastExecutionTime;
+    QSqlError lastQueryError;
     QSettings settings;
 
 private:
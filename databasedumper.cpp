@@ -0,0 +1,687 @@
+#include "databasedumper.h"
+#include "tablecopier.h"
+#include "tablestatistics.h"
+#include <QSqlQuery>
+#include <QSqlIndex>
+#include <QSqlError>
+#include <QFile>
+#include <QDir>
+#include <QDateTime>
+#include <QSet>
+#include <QMutex>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <QElapsedTimer>
+#include <QRegularExpression>
+#include <QObject>
+#include <QtConcurrent>
+#include <algorithm>
+
+namespace {
+
+// Output is buffered and written (and compressed) in blocks of this size.
+const int FlushBytes = 1024 * 1024;
+// A page is written as several statements above this size (characters).
+const int MaxStatementChars = 1024 * 1024;
+
+quint32 crc32(const QByteArray &data) {
+    static const QVector<quint32> table = []() {
+        QVector<quint32> entries(256);
+        for (quint32 n = 0; n < 256; ++n) {
+            quint32 c = n;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            entries[n] = c;
+        }
+        return entries;
+    }();
+    quint32 crc = 0xFFFFFFFFu;
+    for (char byte : data) {
+        crc = table.at((crc ^ static_cast<uchar>(byte)) & 0xFF) ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+void appendLittleEndian(QByteArray *bytes, quint32 value) {
+    for (int i = 0; i < 4; ++i) {
+        bytes->append(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+// One gzip member. qCompress() returns a 4-byte length and a zlib stream
+// (2-byte header, raw deflate, 4-byte Adler-32); gzip wants the raw deflate
+// data with its own header and trailer.
+QByteArray gzipMember(const QByteArray &data) {
+    QByteArray zlib = qCompress(data, 6);
+    QByteArray member("\x1f\x8b\x08\x00\x00\x00\x00\x00\x00\xff", 10);
+    member.append(zlib.constData() + 6, zlib.size() - 10);
+    appendLittleEndian(&member, crc32(data));
+    appendLittleEndian(&member, static_cast<quint32>(data.size()));
+    return member;
+}
+
+// Buffered output file. With compression every flushed block becomes one
+// gzip member; gunzip and zcat read consecutive members as one stream.
+class DumpFile {
+public:
+    DumpFile(const QString &path, bool compress, QAtomicInteger<qint64> *bytesWritten)
+        : file(path), compress(compress), bytesWritten(bytesWritten) {}
+
+    bool open() {
+        return file.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    }
+
+    bool write(const QString &text) {
+        buffer += text.toUtf8();
+        return buffer.size() < FlushBytes || flush();
+    }
+
+    bool flush() {
+        if (buffer.isEmpty()) return true;
+        QByteArray block = compress ? gzipMember(buffer) : buffer;
+        buffer.clear();
+        if (file.write(block) != block.size()) return false;
+        bytesWritten->fetchAndAddRelaxed(block.size());
+        return true;
+    }
+
+    bool close() {
+        bool ok = flush();
+        file.close();
+        return ok && file.error() == QFileDevice::NoError;
+    }
+
+    QString errorString() const {
+        return file.errorString();
+    }
+
+private:
+    QFile file;
+    bool compress;
+    QByteArray buffer;
+    QAtomicInteger<qint64> *bytesWritten;
+};
+
+// COPY text format; values are selected as text, so only escaping is left.
+QString copyField(const QVariant &value) {
+    if (value.isNull()) {
+        return "\\N";
+    }
+    QString text = value.toString();
+    text.replace('\\', "\\\\");
+    text.replace('\t', "\\t");
+    text.replace('\n', "\\n");
+    text.replace('\r', "\\r");
+    return text;
+}
+
+QString fileNameFor(const QString &table, bool compress, QSet<QString> *used) {
+    static const QRegularExpression unsafe("[^A-Za-z0-9_.-]");
+    QString base = QString(table).replace(unsafe, "_");
+    QString name = base;
+    for (int suffix = 2; used->contains(name.toLower()); ++suffix) {
+        name = QString("%1_%2").arg(base).arg(suffix);
+    }
+    used->insert(name.toLower());
+    return name + (compress ? ".sql.gz" : ".sql");
+}
+
+// What a table file holds besides its rows.
+struct TableDefinition {
+    TableDefinition() : identityAlways(false) {}
+    QString create;                // before the data
+    QString afterData;             // constraints, indexes and sequence values
+    QStringList foreignKeys;       // loaded once every table is in
+    QStringList generatedColumns;  // computed by the server, not dumped
+    bool identityAlways;           // rows need OVERRIDING SYSTEM VALUE
+};
+
+class DumpJob {
+public:
+    DumpJob(const DatabaseDumper::Options &options, DatabaseDumper::Progress *progress)
+        : options(options), progress(progress), postgres(false) {}
+
+    const DatabaseDumper::Options &options;
+    DatabaseDumper::Progress *progress;
+    bool postgres;
+    QString snapshot;        // PostgreSQL snapshot id
+    QString header;
+    QStringList tables;
+    QStringList fileNames;
+    QAtomicInt next;
+    QSemaphore ready;
+    QStringList foreignKeys;     // PostgreSQL, across tables; under the mutex
+
+    void fail(const QString &message) {
+        QMutexLocker locker(&mutex);
+        if (error.isEmpty()) error = message;
+    }
+
+    QString errorString() {
+        QMutexLocker locker(&mutex);
+        return error;
+    }
+
+    bool stopped() {
+        return progress->canceled.loadRelaxed() || !errorString().isEmpty();
+    }
+
+    void run();
+
+private:
+    bool beginSnapshot(DatabaseConnection &connection, QString *error);
+    bool tableDefinition(DatabaseConnection &connection, const QString &table, TableDefinition *definition,
+                         QString *error);
+    bool postgresDefinition(DatabaseConnection &connection, const QString &table, TableDefinition *definition,
+                            QString *error);
+    bool dumpTable(DatabaseConnection &connection, int index, QString *error);
+
+    QMutex mutex;
+    QString error;
+};
+
+bool DumpJob::beginSnapshot(DatabaseConnection &connection, QString *error) {
+    QSqlQuery query(connection.database());
+    QStringList statements;
+    if (postgres) {
+        statements << "BEGIN ISOLATION LEVEL REPEATABLE READ READ ONLY"
+                   << QString("SET TRANSACTION SNAPSHOT '%1'").arg(QString(snapshot).replace('\'', "''"));
+    } else {
+        statements << "SET SESSION TRANSACTION ISOLATION LEVEL REPEATABLE READ"
+                   << "START TRANSACTION WITH CONSISTENT SNAPSHOT";
+    }
+    for (const QString &statement : statements) {
+        if (!query.exec(statement)) {
+            *error = query.lastError().text();
+            return false;
+        }
+    }
+    return true;
+}
+
+void DumpJob::run() {
+    DatabaseConnection connection;
+    QString message;
+    bool started = connection.connect(options.params);
+    if (!started) {
+        message = connection.lastError().text();
+    } else {
+        connection.normalizeSessionFormats();
+        started = beginSnapshot(connection, &message);
+    }
+    // The coordinator waits for every worker before releasing its lock.
+    ready.release();
+    if (!started) {
+        fail(message);
+        return;
+    }
+
+    while (!stopped()) {
+        int index = next.fetchAndAddOrdered(1);
+        if (index >= tables.size()) break;
+        if (!dumpTable(connection, index, &message)) {
+            fail(QObject::tr("%1: %2").arg(tables.at(index), message));
+            break;
+        }
+        progress->tablesDone.fetchAndAddRelaxed(1);
+    }
+    QSqlQuery(connection.database()).exec("COMMIT");
+}
+
+bool DumpJob::tableDefinition(DatabaseConnection &connection, const QString &table,
+                              TableDefinition *definition, QString *error) {
+    if (postgres) {
+        return postgresDefinition(connection, table, definition, error);
+    }
+    QSqlQuery query(connection.database());
+    if (!query.exec("SHOW CREATE TABLE " + connection.quoteIdentifier(table)) || !query.next()) {
+        *error = query.lastError().text();
+        return false;
+    }
+    definition->create = query.value(1).toString() + ";\n";
+    query.prepare("SELECT COLUMN_NAME FROM information_schema.COLUMNS "
+                  "WHERE TABLE_SCHEMA = DATABASE() AND TABLE_NAME = ? "
+                  "AND EXTRA IN ('VIRTUAL GENERATED', 'STORED GENERATED')");
+    query.addBindValue(table);
+    if (!query.exec()) {
+        *error = query.lastError().text();
+        return false;
+    }
+    while (query.next()) {
+        definition->generatedColumns << query.value(0).toString();
+    }
+    return true;
+}
+
+// PostgreSQL has no SHOW CREATE TABLE; the definition is put together from
+// the catalog the way pg_dump orders it: sequences and columns (with
+// defaults, identity and generation) first, constraints and indexes after
+// the data, foreign keys once all tables are loaded. Views, functions,
+// triggers, types, comments and grants are not part of a table dump.
+bool DumpJob::postgresDefinition(DatabaseConnection &connection, const QString &table,
+                                 TableDefinition *definition, QString *error) {
+    QSqlQuery query(connection.database());
+    QString quotedTable = connection.quoteIdentifier(table);
+    auto run = [&query, &quotedTable, error](const QString &sql) {
+        query.prepare(sql);
+        query.addBindValue(quotedTable);
+        if (!query.exec()) {
+            *error = query.lastError().text();
+            return false;
+        }
+        return true;
+    };
+
+    // Sequences behind serial columns belong to the table; identity
+    // columns create their own, only their position is carried over.
+    if (!run("SELECT c.oid::regclass::text, format_type(s.seqtypid, NULL), s.seqincrement, s.seqmin, s.seqmax, "
+             "s.seqstart, s.seqcache, s.seqcycle, quote_ident(a.attname), d.deptype, a.attname "
+             "FROM pg_depend d JOIN pg_class c ON c.oid = d.objid AND c.relkind = 'S' "
+             "JOIN pg_sequence s ON s.seqrelid = c.oid "
+             "JOIN pg_attribute a ON a.attrelid = d.refobjid AND a.attnum = d.refobjsubid "
+             "WHERE d.classid = 'pg_class'::regclass AND d.refobjid = ?::regclass AND d.deptype IN ('a', 'i') "
+             "ORDER BY a.attnum")) {
+        return false;
+    }
+    struct Sequence {
+        QString name;
+        QString column;          // quoted
+        QString columnName;
+        bool identity;
+    };
+    QVector<Sequence> sequences;
+    while (query.next()) {
+        Sequence sequence;
+        sequence.name = query.value(0).toString();
+        sequence.column = query.value(8).toString();
+        sequence.identity = query.value(9).toString() == "i";
+        sequence.columnName = query.value(10).toString();
+        sequences << sequence;
+        if (sequence.identity) continue;
+        definition->create += QString("CREATE SEQUENCE %1 AS %2 INCREMENT BY %3 MINVALUE %4 MAXVALUE %5 "
+                                      "START WITH %6 CACHE %7%8;\n")
+                                  .arg(sequence.name, query.value(1).toString(), query.value(2).toString(),
+                                       query.value(3).toString(), query.value(4).toString(),
+                                       query.value(5).toString(), query.value(6).toString(),
+                                       query.value(7).toBool() ? " CYCLE" : "");
+    }
+
+    if (!run("SELECT quote_ident(a.attname), format_type(a.atttypid, a.atttypmod), a.attnotnull, "
+             "pg_get_expr(d.adbin, d.adrelid), a.attidentity, a.attgenerated, "
+             "(SELECT quote_ident(n.nspname) || '.' || quote_ident(co.collname) FROM pg_collation co "
+             "JOIN pg_namespace n ON n.oid = co.collnamespace JOIN pg_type t ON t.oid = a.atttypid "
+             "WHERE co.oid = a.attcollation AND a.attcollation <> t.typcollation), a.attname "
+             "FROM pg_attribute a LEFT JOIN pg_attrdef d ON d.adrelid = a.attrelid AND d.adnum = a.attnum "
+             "WHERE a.attrelid = ?::regclass AND a.attnum > 0 AND NOT a.attisdropped ORDER BY a.attnum")) {
+        return false;
+    }
+    QStringList columnDefinitions;
+    while (query.next()) {
+        QString column = query.value(0).toString() + " " + query.value(1).toString();
+        if (!query.value(6).isNull()) {
+            column += " COLLATE " + query.value(6).toString();
+        }
+        QString expression = query.value(3).toString();
+        QString identity = query.value(4).toString();
+        if (query.value(5).toString() == "s") {
+            column += QString(" GENERATED ALWAYS AS (%1) STORED").arg(expression);
+            definition->generatedColumns << query.value(7).toString();
+        } else if (!identity.isEmpty()) {
+            column += identity == "a" ? " GENERATED ALWAYS AS IDENTITY" : " GENERATED BY DEFAULT AS IDENTITY";
+            definition->identityAlways = definition->identityAlways || identity == "a";
+        } else if (!expression.isEmpty()) {
+            column += " DEFAULT " + expression;
+        }
+        if (query.value(2).toBool()) {
+            column += " NOT NULL";
+        }
+        columnDefinitions << column;
+    }
+    definition->create += QString("CREATE TABLE %1 (\n    %2\n);\n").arg(quotedTable, columnDefinitions.join(",\n    "));
+    for (const Sequence &sequence : sequences) {
+        if (!sequence.identity) {
+            definition->create += QString("ALTER SEQUENCE %1 OWNED BY %2.%3;\n")
+                                      .arg(sequence.name, quotedTable, sequence.column);
+        }
+    }
+
+    if (!run("SELECT quote_ident(conname), pg_get_constraintdef(oid, true), contype FROM pg_constraint "
+             "WHERE conrelid = ?::regclass AND contype IN ('p', 'u', 'c', 'x', 'f') AND conislocal "
+             "ORDER BY contype = 'c' DESC, contype = 'p' DESC, conname")) {
+        return false;
+    }
+    while (query.next()) {
+        QString statement = QString("ALTER TABLE %1 ADD CONSTRAINT %2 %3;\n")
+                                .arg(quotedTable, query.value(0).toString(), query.value(1).toString());
+        if (query.value(2).toString() == "f") {
+            definition->foreignKeys << statement;
+        } else {
+            definition->afterData += statement;
+        }
+    }
+
+    // Indexes of constraints came with them.
+    if (!run("SELECT pg_get_indexdef(i.indexrelid) FROM pg_index i WHERE i.indrelid = ?::regclass "
+             "AND NOT EXISTS (SELECT 1 FROM pg_constraint c WHERE c.conindid = i.indexrelid "
+             "AND c.conrelid = i.indrelid AND c.contype IN ('p', 'u', 'x')) ORDER BY i.indexrelid")) {
+        return false;
+    }
+    while (query.next()) {
+        definition->afterData += query.value(0).toString() + ";\n";
+    }
+
+    // Sequences are not transactional: these are the values at dump time,
+    // which may be past the rows the snapshot sees.
+    for (const Sequence &sequence : sequences) {
+        QSqlQuery position(connection.database());
+        if (!position.exec(QString("SELECT last_value, is_called FROM %1").arg(sequence.name)) || !position.next()) {
+            *error = position.lastError().text();
+            return false;
+        }
+        QString target = sequence.identity
+                             ? QString("pg_get_serial_sequence('%1', '%2')")
+                                   .arg(QString(quotedTable).replace('\'', "''"),
+                                        QString(sequence.columnName).replace('\'', "''"))
+                             : "'" + QString(sequence.name).replace('\'', "''") + "'";
+        definition->afterData += QString("SELECT setval(%1, %2, %3);\n")
+                                     .arg(target, position.value(0).toString(),
+                                          position.value(1).toBool() ? "true" : "false");
+    }
+    return true;
+}
+
+bool DumpJob::dumpTable(DatabaseConnection &connection, int index, QString *error) {
+    const QString &table = tables.at(index);
+    QSqlDatabase &db = connection.database();
+    QVector<TableCopier::Column> columns;
+    if (!TableCopier::readColumns(connection, table, &columns, error)) {
+        return false;
+    }
+    QSqlIndex primary = db.primaryIndex(table);
+    QString keyColumn = primary.count() == 1 ? primary.fieldName(0) : QString();
+    bool copyFormat = postgres && options.format == DatabaseDumper::Copy;
+
+    TableDefinition definition;
+    if (!tableDefinition(connection, table, &definition, error)) {
+        return false;
+    }
+    if (!definition.foreignKeys.isEmpty()) {
+        QMutexLocker locker(&mutex);
+        foreignKeys << definition.foreignKeys;
+    }
+    // Generated columns are computed again on load.
+    columns.erase(std::remove_if(columns.begin(), columns.end(), [&definition](const TableCopier::Column &column) {
+        return definition.generatedColumns.contains(column.name);
+    }), columns.end());
+
+    const int columnCount = columns.size();
+    QStringList selectExpressions;
+    QStringList names;
+    QVector<bool> temporal;
+    for (const TableCopier::Column &column : columns) {
+        QString name = connection.quoteIdentifier(column.name);
+        bool temporalColumn = TableCopier::isTemporal(column.baseType);
+        if (copyFormat || (postgres && temporalColumn)) {
+            selectExpressions << name + "::text";
+        } else if (temporalColumn) {
+            selectExpressions << QString("CAST(%1 AS CHAR)").arg(name);
+        } else {
+            selectExpressions << name;
+        }
+        names << name;
+        temporal << temporalColumn;
+    }
+    QString quotedTable = connection.quoteIdentifier(table);
+    QString quotedKey = keyColumn.isEmpty() ? QString() : connection.quoteIdentifier(keyColumn);
+    QString selectList = selectExpressions.join(", ");
+    if (!quotedKey.isEmpty()) {
+        // The raw key, for the next page's WHERE.
+        selectList += ", " + quotedKey;
+    }
+    QString insertPrefix = QString("INSERT INTO %1 (%2)%3 VALUES\n")
+                               .arg(quotedTable, names.join(", "),
+                                    definition.identityAlways ? " OVERRIDING SYSTEM VALUE" : "");
+
+    DumpFile file(QDir(options.outputDirectory).filePath(fileNames.at(index)), options.compress,
+                  &progress->bytesWritten);
+    if (!file.open()) {
+        *error = file.errorString();
+        return false;
+    }
+    bool ok = file.write(header + "\n" + definition.create + "\n");
+    if (copyFormat) {
+        ok = ok && file.write(QString("COPY %1 (%2) FROM stdin;\n").arg(quotedTable, names.join(", ")));
+    }
+
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.setNumericalPrecisionPolicy(QSql::HighPrecision);
+    QString chunk;
+    int chunkRows = 0;
+
+    // Ends the current statement (or COPY rows) and hands it to the file.
+    auto flushChunk = [&]() {
+        if (chunk.isEmpty()) return true;
+        if (!copyFormat) chunk += ";\n";
+        bool written = file.write(chunk);
+        progress->rowsDumped.fetchAndAddRelaxed(chunkRows);
+        chunk.clear();
+        chunkRows = 0;
+        return written;
+    };
+
+    QVariant after;
+    while (ok) {
+        if (stopped()) {
+            *error = QObject::tr("Canceled");
+            return false;
+        }
+        if (quotedKey.isEmpty()) {
+            query.prepare(QString("SELECT %1 FROM %2").arg(selectList, quotedTable));
+        } else {
+            // Keyset pages: each is an index range scan within the snapshot.
+            query.prepare(QString("SELECT %1 FROM %2%3 ORDER BY %4 LIMIT %5")
+                              .arg(selectList, quotedTable,
+                                   after.isValid() ? QString(" WHERE %1 > ?").arg(quotedKey) : QString(),
+                                   quotedKey)
+                              .arg(options.pageRows));
+            if (after.isValid()) query.addBindValue(after);
+        }
+        if (!query.exec()) {
+            *error = query.lastError().text();
+            return false;
+        }
+
+        int pageRows = 0;
+        while (ok && query.next()) {
+            if (copyFormat) {
+                for (int col = 0; col < columnCount; ++col) {
+                    if (col > 0) chunk += '\t';
+                    chunk += copyField(query.value(col));
+                }
+                chunk += '\n';
+            } else {
+                chunk += chunkRows == 0 ? insertPrefix : QString(",\n");
+                chunk += '(';
+                for (int col = 0; col < columnCount; ++col) {
+                    if (col > 0) chunk += ", ";
+                    chunk += TableCopier::sqlLiteral(query.value(col), temporal.at(col), postgres);
+                }
+                chunk += ')';
+            }
+            ++chunkRows;
+            ++pageRows;
+            if (!quotedKey.isEmpty()) {
+                after = query.value(columnCount);
+            }
+            if (chunk.size() >= MaxStatementChars || chunkRows >= options.pageRows) {
+                ok = flushChunk();
+                if (stopped()) {
+                    *error = QObject::tr("Canceled");
+                    return false;
+                }
+            }
+        }
+        ok = ok && flushChunk();
+        if (quotedKey.isEmpty() || pageRows < options.pageRows) break;
+    }
+
+    if (copyFormat) {
+        ok = ok && file.write("\\.\n");
+    }
+    if (!definition.afterData.isEmpty()) {
+        ok = ok && file.write("\n" + definition.afterData);
+    }
+    if (!file.close() || !ok) {
+        *error = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+QString DatabaseDumper::formatName(Format format) {
+    switch (format) {
+    case Inserts: return QObject::tr("INSERT statements");
+    case Copy: return QObject::tr("COPY (PostgreSQL)");
+    }
+    return QString();
+}
+
+DatabaseDumper::Result DatabaseDumper::dump(const Options &options, Progress *progress) {
+    Result result;
+    QElapsedTimer timer;
+    timer.start();
+    Progress localProgress;
+    if (!progress) {
+        progress = &localProgress;
+    }
+
+    static const QStringList supported = {"QPSQL", "QMYSQL"};
+    if (!supported.contains(options.params.driver)) {
+        result.error = QObject::tr("Dumps are supported for MySQL and PostgreSQL only");
+        return result;
+    }
+    if (!QDir().mkpath(options.outputDirectory)) {
+        result.error = QObject::tr("Cannot create %1").arg(options.outputDirectory);
+        return result;
+    }
+
+    DumpJob job(options, progress);
+    job.postgres = options.params.driver == "QPSQL";
+    if (!job.postgres && options.format == Copy) {
+        result.notes << QObject::tr("MySQL has no COPY; writing INSERT statements");
+    }
+
+    // The coordinator connection owns the snapshot (PostgreSQL) or the global
+    // read lock (MySQL) until every worker has started its transaction.
+    DatabaseConnection coordinator;
+    if (!coordinator.connect(options.params)) {
+        result.error = coordinator.lastError().text();
+        return result;
+    }
+    QSqlQuery query(coordinator.database());
+    bool locked = false;
+    if (job.postgres) {
+        if (!query.exec("BEGIN ISOLATION LEVEL REPEATABLE READ READ ONLY") ||
+            !query.exec("SELECT pg_export_snapshot()") || !query.next()) {
+            result.error = QObject::tr("Exporting a snapshot failed: %1").arg(query.lastError().text());
+            return result;
+        }
+        job.snapshot = query.value(0).toString();
+    }
+
+    QStringList tables = coordinator.tables();
+    if (!options.tables.isEmpty()) {
+        QStringList selected;
+        for (const QString &table : tables) {
+            if (options.tables.contains(table)) selected << table;
+        }
+        tables = selected;
+    }
+    if (tables.isEmpty()) {
+        result.error = QObject::tr("No tables to dump");
+        return result;
+    }
+
+    // Largest first, so one big table does not start last.
+    QHash<QString, TableStatistics::Table> statistics;
+    QString statisticsError;
+    if (TableStatistics::load(coordinator, &statistics, &statisticsError)) {
+        std::stable_sort(tables.begin(), tables.end(), [&statistics](const QString &a, const QString &b) {
+            return statistics.value(a).totalBytes() > statistics.value(b).totalBytes();
+        });
+    }
+    // Foreign keys go in a file of their own, loaded after the tables.
+    const QString foreignKeysName = "foreign_keys";
+    QSet<QString> usedNames;
+    if (job.postgres) {
+        usedNames.insert(foreignKeysName);
+    }
+    for (const QString &table : tables) {
+        job.fileNames << fileNameFor(table, options.compress, &usedNames);
+    }
+    job.tables = tables;
+    result.tables = tables.size();
+    progress->tablesTotal.storeRelaxed(tables.size());
+
+    int workers = qBound(1, options.workers, qMin(64, tables.size()));
+    result.workers = workers;
+    result.consistent = true;
+    if (!job.postgres && workers > 1) {
+        query.exec("SET SESSION lock_wait_timeout = 60");
+        locked = query.exec("FLUSH TABLES WITH READ LOCK");
+        if (!locked) {
+            result.consistent = false;
+            result.notes << QObject::tr("FLUSH TABLES WITH READ LOCK failed (%1); the workers' snapshots "
+                                        "start together but may differ slightly")
+                                .arg(query.lastError().text());
+        }
+    }
+
+    QString dumpedAt = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    job.header = QString("-- %1 on %2, dumped %3%4\n")
+                     .arg(options.params.dbName, options.params.host, dumpedAt,
+                          job.snapshot.isEmpty() ? QString() : ", snapshot " + job.snapshot);
+    job.header += job.postgres ? "SET client_encoding = 'UTF8';\n"
+                               : "SET NAMES utf8mb4;\nSET time_zone = '+00:00';\nSET FOREIGN_KEY_CHECKS = 0;\n";
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(workers);
+    QVector<QFuture<void>> futures;
+    for (int i = 0; i < workers; ++i) {
+        futures << QtConcurrent::run(&pool, [&job]() { job.run(); });
+    }
+    job.ready.acquire(workers);
+    if (locked) {
+        query.exec("UNLOCK TABLES");
+    }
+    for (QFuture<void> &future : futures) {
+        future.waitForFinished();
+    }
+    if (job.postgres) {
+        query.exec("COMMIT");
+    }
+
+    result.error = job.errorString();
+    if (result.error.isEmpty() && progress->canceled.loadRelaxed()) {
+        result.error = QObject::tr("Canceled");
+    }
+    if (result.error.isEmpty() && !job.foreignKeys.isEmpty()) {
+        QString fileName = foreignKeysName + (options.compress ? ".sql.gz" : ".sql");
+        DumpFile file(QDir(options.outputDirectory).filePath(fileName), options.compress, &progress->bytesWritten);
+        job.foreignKeys.sort();
+        if (!file.open() || !file.write(job.header + "\n" + job.foreignKeys.join(QString())) || !file.close()) {
+            result.error = QObject::tr("%1: %2").arg(fileName, file.errorString());
+        } else {
+            result.notes << QObject::tr("Foreign keys are in %1; load it after the table files").arg(fileName);
+        }
+    }
+    result.ok = result.error.isEmpty();
+    result.rowsDumped = progress->rowsDumped.loadRelaxed();
+    result.bytesWritten = progress->bytesWritten.loadRelaxed();
+    result.elapsedMs = timer.elapsed();
+    return result;
+}
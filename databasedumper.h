@@ -0,0 +1,69 @@
+#ifndef DATABASEDUMPER_H
+#define DATABASEDUMPER_H
+
+#include <QString>
+#include <QStringList>
+#include <QAtomicInt>
+#include <QAtomicInteger>
+#include "databaseconnection.h"
+
+// Dumps a database to one file per table (DDL, then data) with several
+// worker connections that all read the same snapshot. PostgreSQL exports
+// the coordinator's snapshot with pg_export_snapshot() and every worker
+// imports it; MySQL workers start WITH CONSISTENT SNAPSHOT while the
+// coordinator holds FLUSH TABLES WITH READ LOCK, which needs the RELOAD
+// privilege and covers InnoDB tables only. Tables are handed out largest
+// first, so the workers finish at about the same time.
+//
+// Only tables are dumped: MySQL's as SHOW CREATE TABLE gives them,
+// PostgreSQL's rebuilt from the catalog with defaults, sequences, identity
+// and generated columns, constraints and indexes; foreign keys go to
+// foreign_keys.sql, to load last. Views, routines, triggers, types,
+// comments and grants are left out.
+class DatabaseDumper {
+public:
+    enum Format {
+        Inserts,    // multi-row INSERT statements
+        Copy        // COPY ... FROM stdin blocks (PostgreSQL only)
+    };
+
+    struct Options {
+        Options() : workers(4), pageRows(5000), format(Inserts), compress(false) {}
+        DatabaseConnection::ConnectionParams params;
+        QString outputDirectory;
+        QStringList tables;    // empty means every table
+        int workers;
+        int pageRows;
+        Format format;
+        bool compress;         // gzip each file (.sql.gz)
+    };
+
+    // Shared with the GUI thread while dump() runs.
+    struct Progress {
+        QAtomicInt tablesTotal;
+        QAtomicInt tablesDone;
+        QAtomicInteger<qint64> rowsDumped;
+        QAtomicInteger<qint64> bytesWritten;
+        QAtomicInt canceled;
+    };
+
+    struct Result {
+        Result() : ok(false), consistent(false), workers(0), tables(0), rowsDumped(0),
+                   bytesWritten(0), elapsedMs(0) {}
+        bool ok;
+        bool consistent;       // all workers read the same snapshot
+        QString error;
+        QStringList notes;
+        int workers;
+        int tables;
+        qint64 rowsDumped;
+        qint64 bytesWritten;
+        qint64 elapsedMs;
+    };
+
+    // Blocks until done; run it off the GUI thread.
+    static Result dump(const Options &options, Progress *progress = nullptr);
+    static QString formatName(Format format);
+};
+
+#endif // DATABASEDUMPER_H
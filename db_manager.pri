@@ -0,0 +1,116 @@
+# Application sources shared by the GUI target and the benchmark suite.
+
+QT       += core gui sql network widgets concurrent
+
+CONFIG += c++17
+
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+SOURCES += \
+    $$PWD/mainwindow.cpp \
+    $$PWD/databaseconnection.cpp \
+    $$PWD/serversdialog.cpp \
+    $$PWD/settingsdialog.cpp \
+    $$PWD/resultexporter.cpp \
+    $$PWD/commandlinerunner.cpp \
+    $$PWD/tableutils.cpp \
+    $$PWD/tablesampler.cpp \
+    $$PWD/sampledialog.cpp \
+    $$PWD/clipboardformatter.cpp \
+    $$PWD/tablestatistics.cpp \
+    $$PWD/tablestatisticspanel.cpp \
+    $$PWD/tablecomparer.cpp \
+    $$PWD/comparetablesdialog.cpp \
+    $$PWD/tablecopier.cpp \
+    $$PWD/copytabledialog.cpp \
+    $$PWD/databasedumper.cpp \
+    $$PWD/dumpdatabasedialog.cpp \
+    $$PWD/largevalues.cpp \
+    $$PWD/valueviewerdialog.cpp \
+    $$PWD/schemaindex.cpp \
+    $$PWD/sqleditor.cpp \
+    $$PWD/sqlhighlighter.cpp \
+    $$PWD/serveractivity.cpp \
+    $$PWD/activitymodel.cpp \
+    $$PWD/activitymonitordialog.cpp \
+    $$PWD/querystatistics.cpp \
+    $$PWD/topqueriesmodel.cpp \
+    $$PWD/topqueriesdialog.cpp \
+    $$PWD/querysession.cpp \
+    $$PWD/querytab.cpp \
+    $$PWD/sketches.cpp \
+    $$PWD/tableprofiler.cpp \
+    $$PWD/profiletabledialog.cpp \
+    $$PWD/resultpivot.cpp \
+    $$PWD/pivotpanel.cpp \
+    $$PWD/resultmemory.cpp \
+    $$PWD/resultstore.cpp \
+    $$PWD/resultstoremodel.cpp \
+    $$PWD/sessionstore.cpp \
+    $$PWD/querybenchmark.cpp \
+    $$PWD/benchmarkdialog.cpp \
+    $$PWD/tracer.cpp \
+    $$PWD/indexadvisor.cpp \
+    $$PWD/indexadvisordialog.cpp \
+    $$PWD/foreignkeys.cpp \
+    $$PWD/browsequery.cpp \
+    $$PWD/filterbar.cpp \
+    $$PWD/limitsgroup.cpp \
+    $$PWD/columnchooserdialog.cpp
+
+HEADERS += \
+    $$PWD/mainwindow.h \
+    $$PWD/databaseconnection.h \
+    $$PWD/serversdialog.h \
+    $$PWD/settingsdialog.h \
+    $$PWD/resultexporter.h \
+    $$PWD/commandlinerunner.h \
+    $$PWD/tableutils.h \
+    $$PWD/tablesampler.h \
+    $$PWD/sampledialog.h \
+    $$PWD/clipboardformatter.h \
+    $$PWD/tablestatistics.h \
+    $$PWD/tablestatisticspanel.h \
+    $$PWD/tablecomparer.h \
+    $$PWD/comparetablesdialog.h \
+    $$PWD/boundedqueue.h \
+    $$PWD/tablecopier.h \
+    $$PWD/copytabledialog.h \
+    $$PWD/databasedumper.h \
+    $$PWD/dumpdatabasedialog.h \
+    $$PWD/largevalues.h \
+    $$PWD/valueviewerdialog.h \
+    $$PWD/schemaindex.h \
+    $$PWD/sqleditor.h \
+    $$PWD/sqlhighlighter.h \
+    $$PWD/serveractivity.h \
+    $$PWD/activitymodel.h \
+    $$PWD/activitymonitordialog.h \
+    $$PWD/querystatistics.h \
+    $$PWD/topqueriesmodel.h \
+    $$PWD/topqueriesdialog.h \
+    $$PWD/querysession.h \
+    $$PWD/querytab.h \
+    $$PWD/sketches.h \
+    $$PWD/tableprofiler.h \
+    $$PWD/profiletabledialog.h \
+    $$PWD/resultpivot.h \
+    $$PWD/pivotpanel.h \
+    $$PWD/resultmemory.h \
+    $$PWD/resultstore.h \
+    $$PWD/resultstoremodel.h \
+    $$PWD/sessionstore.h \
+    $$PWD/querybenchmark.h \
+    $$PWD/benchmarkdialog.h \
+    $$PWD/tracer.h \
+    $$PWD/indexadvisor.h \
+    $$PWD/indexadvisordialog.h \
+    $$PWD/foreignkeys.h \
+    $$PWD/browsequery.h \
+    $$PWD/filterbar.h \
+    $$PWD/limitsgroup.h \
+    $$PWD/columnchooserdialog.h
+
+FORMS += \
+    $$PWD/mainwindow.ui
@@ -1,30 +1,9 @@
-QT       += core gui sql network widgets
+TEMPLATE = subdirs
 
-greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+SUBDIRS += app
 
-CONFIG += c++17
+# Throughput benchmarks for the fetch/render/sort/export paths (see README).
+qtHaveModule(testlib): SUBDIRS += benchmarks
 
-# You can make your code fail to compile if it uses deprecated APIs.
-# In order to do so, uncomment the following line.
-#DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
-
-SOURCES += \
-    main.cpp \
-    mainwindow.cpp \
-    databaseconnection.cpp \
-    serversdialog.cpp \
-    settingsdialog.cpp
-
-HEADERS += \
-    mainwindow.h \
-    databaseconnection.h \
-    serversdialog.h \
-    settingsdialog.h
-
-FORMS += \
-    mainwindow.ui
-
-# Default rules for deployment.
-qnx: target.path = /tmp/$${TARGET}/bin
-else: unix:!android: target.path = /opt/$${TARGET}/bin
-!isEmpty(target.path): INSTALLS += target
+# Unit tests (make check).
+qtHaveModule(testlib): SUBDIRS += tests
@@ -0,0 +1,227 @@
+#include "dumpdatabasedialog.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QFormLayout>
+#include <QFileDialog>
+#include <QMessageBox>
+#include <QLocale>
+#include <QDir>
+#include <QDateTime>
+#include <QtConcurrent>
+
+DumpDatabaseDialog::DumpDatabaseDialog(QWidget *parent, const QString &serverName, const QString &database)
+    : QDialog(parent), settings("DBManager", "Settings")
+{
+    setWindowTitle(tr("Dump Database"));
+    setMinimumWidth(550);
+
+    auto layout = new QVBoxLayout(this);
+    auto formLayout = new QFormLayout;
+    serverComboBox = new QComboBox(this);
+    formLayout->addRow(tr("Server:"), serverComboBox);
+    databaseEdit = new QLineEdit(this);
+    databaseEdit->setPlaceholderText(tr("Server default"));
+    formLayout->addRow(tr("Database:"), databaseEdit);
+
+    auto directoryLayout = new QHBoxLayout;
+    directoryEdit = new QLineEdit(this);
+    auto browseButton = new QPushButton(tr("Browse..."), this);
+    directoryLayout->addWidget(directoryEdit);
+    directoryLayout->addWidget(browseButton);
+    formLayout->addRow(tr("Output directory:"), directoryLayout);
+
+    workersSpinBox = new QSpinBox(this);
+    workersSpinBox->setRange(1, 64);
+    workersSpinBox->setValue(settings.value("dump/workers", 4).toInt());
+    formLayout->addRow(tr("Parallel workers:"), workersSpinBox);
+    pageRowsSpinBox = new QSpinBox(this);
+    pageRowsSpinBox->setRange(100, 1000000);
+    pageRowsSpinBox->setSingleStep(1000);
+    pageRowsSpinBox->setValue(settings.value("dump/pageRows", 5000).toInt());
+    formLayout->addRow(tr("Rows per statement:"), pageRowsSpinBox);
+    formatComboBox = new QComboBox(this);
+    for (DatabaseDumper::Format format : {DatabaseDumper::Inserts, DatabaseDumper::Copy}) {
+        formatComboBox->addItem(DatabaseDumper::formatName(format), format);
+    }
+    formatComboBox->setCurrentIndex(formatComboBox->findData(settings.value("dump/format", DatabaseDumper::Inserts)));
+    formLayout->addRow(tr("Data format:"), formatComboBox);
+    compressCheckBox = new QCheckBox(tr("Compress files (gzip)"), this);
+    compressCheckBox->setChecked(settings.value("dump/compress", false).toBool());
+    formLayout->addRow(compressCheckBox);
+    layout->addLayout(formLayout);
+    auto scopeLabel = new QLabel(tr("Tables only: columns with their defaults, sequences, constraints and indexes, "
+                                    "then the rows. Views, functions, triggers, types and grants are not dumped."),
+                                 this);
+    scopeLabel->setWordWrap(true);
+    layout->addWidget(scopeLabel);
+
+    progressBar = new QProgressBar(this);
+    progressBar->setRange(0, 1);
+    progressBar->setValue(0);
+    layout->addWidget(progressBar);
+    statusLabel = new QLabel(this);
+    statusLabel->setWordWrap(true);
+    layout->addWidget(statusLabel);
+
+    auto buttonLayout = new QHBoxLayout;
+    dumpButton = new QPushButton(tr("Dump"), this);
+    dumpButton->setDefault(true);
+    auto closeButton = new QPushButton(tr("Close"), this);
+    buttonLayout->addStretch();
+    buttonLayout->addWidget(dumpButton);
+    buttonLayout->addWidget(closeButton);
+    layout->addLayout(buttonLayout);
+
+    serverComboBox->addItems(dbConnection.getSavedServers());
+    if (!serverName.isEmpty()) {
+        serverComboBox->setCurrentText(serverName);
+    }
+    databaseEdit->setText(database);
+    QString baseDirectory = settings.value("dump/directory", QDir::homePath()).toString();
+    if (!database.isEmpty()) {
+        directoryEdit->setText(QDir(baseDirectory).filePath(
+            database + "-" + QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss")));
+    } else {
+        directoryEdit->setText(baseDirectory);
+    }
+
+    progressTimer.setInterval(500);
+    connect(&progressTimer, &QTimer::timeout, this, &DumpDatabaseDialog::updateProgress);
+    connect(&watcher, &QFutureWatcher<DatabaseDumper::Result>::finished, this, &DumpDatabaseDialog::showResult);
+    connect(browseButton, &QPushButton::clicked, this, &DumpDatabaseDialog::browseDirectory);
+    connect(dumpButton, &QPushButton::clicked, this, &DumpDatabaseDialog::startOrCancel);
+    connect(closeButton, &QPushButton::clicked, this, &QDialog::reject);
+}
+
+DumpDatabaseDialog::~DumpDatabaseDialog()
+{
+    // The workers use this dialog's progress counters.
+    progress.canceled.storeRelaxed(1);
+    watcher.waitForFinished();
+}
+
+void DumpDatabaseDialog::browseDirectory()
+{
+    QString directory = QFileDialog::getExistingDirectory(this, tr("Output Directory"), directoryEdit->text());
+    if (!directory.isEmpty()) {
+        directoryEdit->setText(directory);
+    }
+}
+
+void DumpDatabaseDialog::startOrCancel()
+{
+    if (watcher.isRunning()) {
+        progress.canceled.storeRelaxed(1);
+        dumpButton->setEnabled(false);
+        return;
+    }
+
+    if (serverComboBox->currentText().isEmpty() || directoryEdit->text().trimmed().isEmpty()) {
+        QMessageBox::warning(this, windowTitle(), tr("Choose a server and an output directory"));
+        return;
+    }
+    QDir directory(directoryEdit->text().trimmed());
+    if (directory.exists() && !directory.entryList(QDir::Files).isEmpty() &&
+        QMessageBox::question(this, windowTitle(),
+                              tr("%1 is not empty. Existing dump files will be overwritten. Continue?")
+                                  .arg(directory.path())) != QMessageBox::Yes) {
+        return;
+    }
+
+    DatabaseDumper::Options options;
+    options.params = dbConnection.loadConnectionSettings(serverComboBox->currentText());
+    if (!databaseEdit->text().trimmed().isEmpty()) {
+        options.params.dbName = databaseEdit->text().trimmed();
+    }
+    options.params.statementTimeout = 0;
+    options.params.readOnly = true;
+    options.outputDirectory = directory.path();
+    options.workers = workersSpinBox->value();
+    options.pageRows = pageRowsSpinBox->value();
+    options.format = static_cast<DatabaseDumper::Format>(formatComboBox->currentData().toInt());
+    options.compress = compressCheckBox->isChecked();
+
+    settings.setValue("dump/workers", options.workers);
+    settings.setValue("dump/pageRows", options.pageRows);
+    settings.setValue("dump/format", options.format);
+    settings.setValue("dump/compress", options.compress);
+    QDir parent(directory);
+    if (parent.cdUp()) {
+        settings.setValue("dump/directory", parent.path());
+    }
+
+    progress.tablesTotal.storeRelaxed(0);
+    progress.tablesDone.storeRelaxed(0);
+    progress.rowsDumped.storeRelaxed(0);
+    progress.bytesWritten.storeRelaxed(0);
+    progress.canceled.storeRelaxed(0);
+    runTimer.start();
+    statusLabel->setText(tr("Taking a snapshot of %1...").arg(options.params.dbName));
+
+    DatabaseDumper::Progress *shared = &progress;
+    watcher.setFuture(QtConcurrent::run([options, shared]() {
+        return DatabaseDumper::dump(options, shared);
+    }));
+    setRunning(true);
+}
+
+void DumpDatabaseDialog::setRunning(bool running)
+{
+    dumpButton->setText(running ? tr("Cancel") : tr("Dump"));
+    dumpButton->setEnabled(true);
+    serverComboBox->setEnabled(!running);
+    databaseEdit->setEnabled(!running);
+    directoryEdit->setEnabled(!running);
+    workersSpinBox->setEnabled(!running);
+    pageRowsSpinBox->setEnabled(!running);
+    formatComboBox->setEnabled(!running);
+    compressCheckBox->setEnabled(!running);
+    if (running) {
+        progressBar->setRange(0, 0);
+        progressTimer.start();
+    } else {
+        progressTimer.stop();
+    }
+}
+
+void DumpDatabaseDialog::updateProgress()
+{
+    int total = progress.tablesTotal.loadRelaxed();
+    int done = progress.tablesDone.loadRelaxed();
+    if (total > 0) {
+        progressBar->setRange(0, total);
+        progressBar->setValue(done);
+    }
+    QLocale locale;
+    qint64 rows = progress.rowsDumped.loadRelaxed();
+    qint64 rowsPerSecond = rows * 1000 / qMax<qint64>(1, runTimer.elapsed());
+    statusLabel->setText(tr("%1 of %2 tables, %3 rows (%4 rows/s), %5 written")
+                             .arg(done).arg(total)
+                             .arg(locale.toString(rows), locale.toString(rowsPerSecond),
+                                  locale.formattedDataSize(progress.bytesWritten.loadRelaxed())));
+}
+
+void DumpDatabaseDialog::showResult()
+{
+    setRunning(false);
+    DatabaseDumper::Result result = watcher.result();
+    progressBar->setRange(0, 1);
+    progressBar->setValue(result.ok ? 1 : 0);
+
+    QLocale locale;
+    QStringList lines = result.notes;
+    if (result.ok) {
+        double seconds = qMax<qint64>(1, result.elapsedMs) / 1000.0;
+        lines << tr("Dumped %1 tables, %2 rows, %3 in %4 s with %5 workers")
+                     .arg(result.tables)
+                     .arg(locale.toString(result.rowsDumped), locale.formattedDataSize(result.bytesWritten))
+                     .arg(seconds, 0, 'f', 1)
+                     .arg(result.workers);
+        if (result.consistent) {
+            lines << tr("All tables were read from one snapshot.");
+        }
+    } else {
+        lines << tr("Dump failed: %1").arg(result.error);
+    }
+    statusLabel->setText(lines.join("\n"));
+}
@@ -0,0 +1,53 @@
+#ifndef DUMPDATABASEDIALOG_H
+#define DUMPDATABASEDIALOG_H
+
+#include <QDialog>
+#include <QComboBox>
+#include <QLineEdit>
+#include <QSpinBox>
+#include <QCheckBox>
+#include <QPushButton>
+#include <QProgressBar>
+#include <QLabel>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+#include <QSettings>
+#include "databasedumper.h"
+
+class DumpDatabaseDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    DumpDatabaseDialog(QWidget *parent, const QString &serverName = QString(),
+                       const QString &database = QString());
+    ~DumpDatabaseDialog();
+
+private slots:
+    void browseDirectory();
+    void startOrCancel();
+    void updateProgress();
+    void showResult();
+
+private:
+    void setRunning(bool running);
+
+    QComboBox *serverComboBox;
+    QLineEdit *databaseEdit;
+    QLineEdit *directoryEdit;
+    QSpinBox *workersSpinBox;
+    QSpinBox *pageRowsSpinBox;
+    QComboBox *formatComboBox;
+    QCheckBox *compressCheckBox;
+    QPushButton *dumpButton;
+    QProgressBar *progressBar;
+    QLabel *statusLabel;
+    QTimer progressTimer;
+    QElapsedTimer runTimer;
+    QFutureWatcher<DatabaseDumper::Result> watcher;
+    DatabaseDumper::Progress progress;
+    DatabaseConnection dbConnection;
+    QSettings settings;
+};
+
+#endif // DUMPDATABASEDIALOG_H
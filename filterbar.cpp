@@ -0,0 +1,147 @@
+#include "filterbar.h"
+#include <QHBoxLayout>
+#include <QPushButton>
+#include <QToolButton>
+
+FilterBar::FilterBar(QWidget *parent)
+    : QWidget(parent)
+{
+    auto layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->setSpacing(2);
+    linesLayout = new QVBoxLayout;
+    linesLayout->setSpacing(2);
+    layout->addLayout(linesLayout);
+
+    auto buttonLayout = new QHBoxLayout;
+    auto addButton = new QPushButton(tr("Add Filter"), this);
+    auto applyButton = new QPushButton(tr("Apply"), this);
+    auto clearButton = new QPushButton(tr("Clear"), this);
+    auto columnsButton = new QPushButton(tr("Columns..."), this);
+    buttonLayout->addWidget(columnsButton);
+    buttonLayout->addWidget(addButton);
+    indexLabel = new QLabel(this);
+    indexLabel->setWordWrap(true);
+    indexLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
+    buttonLayout->addWidget(indexLabel, 1);
+    buttonLayout->addWidget(applyButton);
+    buttonLayout->addWidget(clearButton);
+    layout->addLayout(buttonLayout);
+
+    connect(columnsButton, &QPushButton::clicked, this, &FilterBar::columnsRequested);
+    connect(addButton, &QPushButton::clicked, this, &FilterBar::addCondition);
+    connect(applyButton, &QPushButton::clicked, this, &FilterBar::applied);
+    connect(clearButton, &QPushButton::clicked, this, &FilterBar::clearConditions);
+}
+
+int FilterBar::addLine()
+{
+    Line line;
+    line.widget = new QWidget(this);
+    auto layout = new QHBoxLayout(line.widget);
+    layout->setContentsMargins(0, 0, 0, 0);
+    line.column = new QComboBox(line.widget);
+    line.column->addItems(columns);
+    line.op = new QComboBox(line.widget);
+    for (int op = 0; op < BrowseQuery::OperatorCount; ++op) {
+        line.op->addItem(BrowseQuery::operatorName(static_cast<BrowseQuery::Operator>(op)), op);
+    }
+    line.value = new QLineEdit(line.widget);
+    line.value->setPlaceholderText(tr("Value"));
+    auto removeButton = new QToolButton(line.widget);
+    removeButton->setText(QString::fromUtf8("✕"));
+    removeButton->setToolTip(tr("Remove this condition"));
+    layout->addWidget(line.column);
+    layout->addWidget(line.op);
+    layout->addWidget(line.value, 1);
+    layout->addWidget(removeButton);
+    linesLayout->addWidget(line.widget);
+
+    QLineEdit *value = line.value;
+    QWidget *widget = line.widget;
+    connect(line.op, QOverload<int>::of(&QComboBox::currentIndexChanged), [value](int index) {
+        auto op = static_cast<BrowseQuery::Operator>(index);
+        value->setEnabled(BrowseQuery::takesValue(op));
+        value->setPlaceholderText(op == BrowseQuery::In ? tr("Values, separated by commas") : tr("Value"));
+    });
+    connect(line.value, &QLineEdit::returnPressed, this, &FilterBar::applied);
+    connect(removeButton, &QToolButton::clicked, [this, widget]() {
+        removeLine(widget);
+        emit applied();
+    });
+    lines << line;
+    return lines.size() - 1;
+}
+
+void FilterBar::removeLine(QWidget *widget)
+{
+    for (int i = 0; i < lines.size(); ++i) {
+        if (lines.at(i).widget == widget) {
+            lines.removeAt(i);
+            break;
+        }
+    }
+    widget->deleteLater();
+}
+
+void FilterBar::addCondition()
+{
+    int index = addLine();
+    lines.at(index).value->setFocus();
+}
+
+void FilterBar::clearConditions()
+{
+    bool hadConditions = !lines.isEmpty();
+    while (!lines.isEmpty()) {
+        removeLine(lines.last().widget);
+    }
+    if (hadConditions) {
+        emit applied();
+    }
+}
+
+void FilterBar::setColumns(const QStringList &columns)
+{
+    QVector<BrowseQuery::Condition> kept;
+    for (const BrowseQuery::Condition &condition : conditions()) {
+        if (columns.contains(condition.column)) {
+            kept << condition;
+        }
+    }
+    this->columns = columns;
+    setConditions(kept);
+}
+
+void FilterBar::setConditions(const QVector<BrowseQuery::Condition> &conditions)
+{
+    while (!lines.isEmpty()) {
+        removeLine(lines.last().widget);
+    }
+    for (const BrowseQuery::Condition &condition : conditions) {
+        const Line &line = lines.at(addLine());
+        line.column->setCurrentText(condition.column);
+        line.op->setCurrentIndex(condition.op);
+        line.value->setText(condition.value);
+    }
+}
+
+QVector<BrowseQuery::Condition> FilterBar::conditions() const
+{
+    QVector<BrowseQuery::Condition> result;
+    for (const Line &line : lines) {
+        BrowseQuery::Condition condition;
+        condition.column = line.column->currentText();
+        condition.op = static_cast<BrowseQuery::Operator>(line.op->currentData().toInt());
+        condition.value = line.value->text();
+        if (!condition.column.isEmpty()) {
+            result << condition;
+        }
+    }
+    return result;
+}
+
+void FilterBar::setIndexUse(const QString &text)
+{
+    indexLabel->setText(text);
+}
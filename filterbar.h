@@ -0,0 +1,53 @@
+#ifndef FILTERBAR_H
+#define FILTERBAR_H
+
+#include <QWidget>
+#include <QVBoxLayout>
+#include <QComboBox>
+#include <QLineEdit>
+#include <QLabel>
+#include <QVector>
+#include "browsequery.h"
+
+// Conditions on the columns of a table opened from the tree, one per line
+// and all of them required. They are run on the server as a parameterized
+// WHERE; the bar also says whether an index can serve them, and leads to
+// the table's column chooser.
+class FilterBar : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit FilterBar(QWidget *parent = nullptr);
+
+    // Keeps the conditions on columns the table still has.
+    void setColumns(const QStringList &columns);
+    void setConditions(const QVector<BrowseQuery::Condition> &conditions);
+    QVector<BrowseQuery::Condition> conditions() const;
+    void setIndexUse(const QString &text);
+
+signals:
+    void applied();
+    void columnsRequested();
+
+public slots:
+    void addCondition();
+    void clearConditions();
+
+private:
+    struct Line {
+        QWidget *widget;
+        QComboBox *column;
+        QComboBox *op;
+        QLineEdit *value;
+    };
+
+    int addLine();
+    void removeLine(QWidget *widget);
+
+    QVBoxLayout *linesLayout;
+    QVector<Line> lines;
+    QStringList columns;
+    QLabel *indexLabel;
+};
+
+#endif // FILTERBAR_H
@@ -0,0 +1,192 @@
+#include "foreignkeys.h"
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QSqlError>
+
+namespace {
+
+const QChar Separator(0x1f);
+
+// Tables may come as schema.table; columns are quoted whole.
+QString quoteName(const QString &name, bool postgres, bool qualified) {
+    if (!postgres) {
+        return "`" + QString(name).replace("`", "``") + "`";
+    }
+    QStringList parts;
+    for (const QString &part : qualified ? name.split('.') : QStringList{name}) {
+        parts << "\"" + QString(part).replace("\"", "\"\"") + "\"";
+    }
+    return parts.join('.');
+}
+
+QString repeated(const QString &text, int count) {
+    QStringList parts;
+    for (int i = 0; i < count; ++i) {
+        parts << text;
+    }
+    return parts.join(", ");
+}
+
+QString quoteValue(const QString &value, bool postgres) {
+    QString escaped = value;
+    if (!postgres) {
+        escaped.replace("\\", "\\\\");
+    }
+    return "'" + escaped.replace("'", "''") + "'";
+}
+
+bool loadPostgres(DatabaseConnection &connection, const QString &table, ForeignKeys::TableKeys *keys,
+                  QString *error) {
+    QSqlQuery query(connection.database());
+    query.prepare(
+        "SELECT con.conname, sn.nspname, sc.relname, tn.nspname, tc.relname, "
+        "array_to_string(ARRAY(SELECT a.attname FROM unnest(con.conkey) WITH ORDINALITY k(attnum, n) "
+        "JOIN pg_attribute a ON a.attrelid = con.conrelid AND a.attnum = k.attnum ORDER BY k.n), chr(31)), "
+        "array_to_string(ARRAY(SELECT a.attname FROM unnest(con.confkey) WITH ORDINALITY k(attnum, n) "
+        "JOIN pg_attribute a ON a.attrelid = con.confrelid AND a.attnum = k.attnum ORDER BY k.n), chr(31)), "
+        "con.conrelid = ?::regclass "
+        "FROM pg_constraint con "
+        "JOIN pg_class sc ON sc.oid = con.conrelid JOIN pg_namespace sn ON sn.oid = sc.relnamespace "
+        "JOIN pg_class tc ON tc.oid = con.confrelid JOIN pg_namespace tn ON tn.oid = tc.relnamespace "
+        "WHERE con.contype = 'f' AND (con.conrelid = ?::regclass OR con.confrelid = ?::regclass) "
+        "ORDER BY sn.nspname, sc.relname, con.conname");
+    QString quoted = connection.quoteIdentifier(table);
+    query.addBindValue(quoted);
+    query.addBindValue(quoted);
+    query.addBindValue(quoted);
+    if (!query.exec()) {
+        *error = query.lastError().text();
+        return false;
+    }
+    // QPSQL lists tables outside "public" as schema.table.
+    auto name = [](const QString &schema, const QString &relation) {
+        return schema == "public" ? relation : schema + "." + relation;
+    };
+    while (query.next()) {
+        ForeignKeys::Key key;
+        key.name = query.value(0).toString();
+        key.table = name(query.value(1).toString(), query.value(2).toString());
+        key.referencedTable = name(query.value(3).toString(), query.value(4).toString());
+        key.columns = query.value(5).toString().split(Separator);
+        key.referencedColumns = query.value(6).toString().split(Separator);
+        bool outgoing = query.value(7).toBool();
+        (outgoing ? keys->outgoing : keys->incoming) << key;
+        // A key of the table to itself goes both ways.
+        if (outgoing && key.referencedTable == key.table) {
+            keys->incoming << key;
+        }
+    }
+    return true;
+}
+
+bool loadMysql(DatabaseConnection &connection, const QString &table, ForeignKeys::TableKeys *keys,
+               QString *error) {
+    QSqlQuery query(connection.database());
+    query.prepare("SELECT CONSTRAINT_NAME, TABLE_NAME, COLUMN_NAME, REFERENCED_TABLE_NAME, REFERENCED_COLUMN_NAME "
+                  "FROM information_schema.KEY_COLUMN_USAGE "
+                  "WHERE TABLE_SCHEMA = DATABASE() AND REFERENCED_TABLE_SCHEMA = DATABASE() "
+                  "AND REFERENCED_TABLE_NAME IS NOT NULL AND (TABLE_NAME = ? OR REFERENCED_TABLE_NAME = ?) "
+                  "ORDER BY TABLE_NAME, CONSTRAINT_NAME, ORDINAL_POSITION");
+    query.addBindValue(table);
+    query.addBindValue(table);
+    if (!query.exec()) {
+        *error = query.lastError().text();
+        return false;
+    }
+    QVector<ForeignKeys::Key> all;
+    while (query.next()) {
+        QString name = query.value(0).toString();
+        QString owner = query.value(1).toString();
+        if (all.isEmpty() || all.last().name != name || all.last().table != owner) {
+            ForeignKeys::Key key;
+            key.name = name;
+            key.table = owner;
+            key.referencedTable = query.value(3).toString();
+            all << key;
+        }
+        all.last().columns << query.value(2).toString();
+        all.last().referencedColumns << query.value(4).toString();
+    }
+    for (const ForeignKeys::Key &key : all) {
+        if (key.table == table) {
+            keys->outgoing << key;
+        }
+        if (key.referencedTable == table) {
+            keys->incoming << key;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool ForeignKeys::load(DatabaseConnection &connection, const QString &table, TableKeys *keys, QString *error) {
+    *keys = TableKeys();
+    if (connection.database().driverName() == "QPSQL") {
+        return loadPostgres(connection, table, keys, error);
+    }
+    return loadMysql(connection, table, keys, error);
+}
+
+bool ForeignKeys::fetchReferenced(DatabaseConnection &connection, const Key &key, Lookup *lookup, QString *error) {
+    QStringList columns;
+    for (const QString &column : key.referencedColumns) {
+        columns << connection.quoteIdentifier(column);
+    }
+    QString target = columns.size() == 1 ? columns.first() : "(" + columns.join(", ") + ")";
+    QString tuple = columns.size() == 1 ? QString("?") : "(" + repeated("?", columns.size()) + ")";
+    QString table = connection.quoteIdentifier(key.referencedTable);
+
+    for (int start = 0; start < lookup->values.size(); start += MaxBatchValues) {
+        int count = qMin(MaxBatchValues, lookup->values.size() - start);
+        QSqlQuery query(connection.database());
+        query.setForwardOnly(true);
+        query.prepare(QString("SELECT * FROM %1 WHERE %2 IN (%3)")
+                          .arg(table, target, repeated(tuple, count)));
+        for (int i = start; i < start + count; ++i) {
+            for (const QString &value : lookup->values.at(i)) {
+                query.addBindValue(value);
+            }
+        }
+        if (!query.exec()) {
+            *error = query.lastError().text();
+            return false;
+        }
+        QSqlRecord record = query.record();
+        QVector<int> keyFields;
+        for (const QString &column : key.referencedColumns) {
+            keyFields << record.indexOf(column);
+        }
+        QStringList names;
+        for (int field = 0; field < record.count(); ++field) {
+            names << record.fieldName(field);
+        }
+        while (query.next()) {
+            Row row;
+            row.columns = names;
+            for (int field = 0; field < names.size(); ++field) {
+                row.values << query.value(field).toString();
+            }
+            QStringList keyValues;
+            for (int field : keyFields) {
+                keyValues << row.values.value(field);
+            }
+            lookup->rows.insert(valueKey(keyValues), row);
+        }
+    }
+    return true;
+}
+
+QString ForeignKeys::valueKey(const QStringList &values) {
+    return values.join(Separator);
+}
+
+QString ForeignKeys::rowsSql(const QString &table, const QStringList &columns, const QStringList &values,
+                             bool postgres) {
+    QStringList conditions;
+    for (int i = 0; i < columns.size(); ++i) {
+        conditions << QString("%1 = %2").arg(quoteName(columns.at(i), postgres, false),
+                                             quoteValue(values.value(i), postgres));
+    }
+    return QString("SELECT * FROM %1 WHERE %2").arg(quoteName(table, postgres, true), conditions.join(" AND "));
+}
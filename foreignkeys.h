@@ -0,0 +1,58 @@
+#ifndef FOREIGNKEYS_H
+#define FOREIGNKEYS_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include "databaseconnection.h"
+
+// Foreign keys of a browsed table, for following a value to the row it
+// references and back. Referenced rows are looked up in batches, one
+// `WHERE (columns) IN (...)` per key for a whole page of the grid, so a
+// page costs one query per key rather than one per row.
+class ForeignKeys {
+public:
+    struct Key {
+        QString name;
+        QString table;                  // the referencing table
+        QStringList columns;
+        QString referencedTable;
+        QStringList referencedColumns;
+    };
+
+    struct TableKeys {
+        QVector<Key> outgoing;          // from the table to others
+        QVector<Key> incoming;          // from others (or itself) to the table
+        bool isEmpty() const { return outgoing.isEmpty() && incoming.isEmpty(); }
+    };
+
+    // A referenced row as grid texts; no columns when there is no such row.
+    struct Row {
+        QStringList columns;
+        QStringList values;
+    };
+
+    // The rows one key references for some of its values, each value being
+    // the grid texts of the key's columns.
+    struct Lookup {
+        Lookup() : key(-1) {}
+        int key;                        // index into TableKeys::outgoing
+        QVector<QStringList> values;
+        QHash<QString, Row> rows;       // by valueKey(); missing rows are absent
+        QString error;                  // set when the rows could not be read
+    };
+
+    static const int MaxBatchValues = 1000;
+
+    static bool load(DatabaseConnection &connection, const QString &table, TableKeys *keys, QString *error);
+    static bool fetchReferenced(DatabaseConnection &connection, const Key &key, Lookup *lookup, QString *error);
+    static QString valueKey(const QStringList &values);
+
+    // SELECT for the rows of `table` whose `columns` hold `values`, as typed
+    // in the editor when following a key.
+    static QString rowsSql(const QString &table, const QStringList &columns, const QStringList &values,
+                           bool postgres);
+};
+
+#endif // FOREIGNKEYS_H
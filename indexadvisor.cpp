@@ -0,0 +1,646 @@
+#include "indexadvisor.h"
+#include "tablestatistics.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QSqlRecord>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QHash>
+#include <QLocale>
+#include <QObject>
+
+namespace {
+
+// A scan is worth an index when the table is not tiny and the filter keeps
+// at most this share of the rows read.
+const double MinTableRows = 1000;
+const double MaxSelectivity = 0.1;
+// A nested loop over a full scan is flagged from this many outer rows on.
+const double MinOuterRows = 10;
+// MySQL does not tell whether a filesort spills; large ones are reported.
+const double MinFilesortRows = 10000;
+const int MaxIndexColumns = 3;
+
+struct ColumnRef {
+    QString qualifier;       // table or alias; empty when unqualified
+    QString column;
+    bool equality;
+};
+
+QString unquote(QString name) {
+    if (name.size() >= 2 && (name.startsWith('"') || name.startsWith('`'))) {
+        name = name.mid(1, name.size() - 2);
+    }
+    return name;
+}
+
+// Column references in a plan condition, with whether each is compared for
+// equality (or IN / = ANY). Literals and casts are dropped first so that
+// neither looks like a column.
+QVector<ColumnRef> columnRefs(QString expression, bool mysql) {
+    static const QRegularExpression literals("'(?:[^']|'')*'");
+    static const QRegularExpression casts("::\"?\\w+\"?(?: varying| without time zone| with time zone| precision)?(?:\\[\\])?");
+    static const QRegularExpression postgresRef("(?:(\"[^\"]+\"|[A-Za-z_]\\w*)\\.)?(\"[^\"]+\"|[A-Za-z_]\\w*)");
+    static const QRegularExpression mysqlRef("`([^`]+)`(?:\\.`([^`]+)`)?(?:\\.`([^`]+)`)?");
+    static const QRegularExpression equalAfter("^[\\s)]*(=(?!>)|IN\\s*\\(|= ANY)", QRegularExpression::CaseInsensitiveOption);
+    static const QRegularExpression equalBefore("(?<![<>!])=[\\s(]*$");
+
+    expression.replace(literals, "''");
+    expression.replace(casts, QString());
+    QVector<ColumnRef> refs;
+    QRegularExpressionMatchIterator it = (mysql ? mysqlRef : postgresRef).globalMatch(expression);
+    while (it.hasNext()) {
+        QRegularExpressionMatch match = it.next();
+        ColumnRef ref;
+        if (mysql) {
+            QStringList parts;
+            for (int i = 1; i <= 3; ++i) {
+                if (!match.captured(i).isEmpty()) {
+                    parts << match.captured(i);
+                }
+            }
+            ref.column = parts.takeLast();
+            ref.qualifier = parts.isEmpty() ? QString() : parts.last();
+        } else {
+            ref.qualifier = unquote(match.captured(1));
+            ref.column = unquote(match.captured(2));
+        }
+        QString after = expression.mid(match.capturedEnd());
+        QString before = expression.left(match.capturedStart());
+        ref.equality = equalAfter.match(after).hasMatch() || equalBefore.match(before).hasMatch();
+        refs << ref;
+    }
+    return refs;
+}
+
+double number(const QJsonValue &value) {
+    return value.isString() ? value.toString().toDouble() : value.toDouble(-1);
+}
+
+// work_mem as SHOW prints it: 4MB, 64kB, 1GB.
+qint64 memorySetting(const QString &text) {
+    static const QRegularExpression pattern("^(\\d+)\\s*(kB|MB|GB|TB)?$");
+    QRegularExpressionMatch match = pattern.match(text.trimmed());
+    if (!match.hasMatch()) return -1;
+    qint64 value = match.captured(1).toLongLong();
+    QString unit = match.captured(2);
+    if (unit == "kB") return value * 1024;
+    if (unit == "MB") return value * 1024 * 1024;
+    if (unit == "GB") return value * 1024 * 1024 * 1024;
+    if (unit == "TB") return value * 1024 * 1024 * 1024 * 1024;
+    return value;
+}
+
+// "ON table (columns)", keeping a DESC or NULLS suffix outside the quotes.
+QString indexTarget(DatabaseConnection &connection, const QString &table, const QStringList &columns) {
+    QStringList quoted;
+    for (const QString &column : columns) {
+        QString name = column.section(' ', 0, 0);
+        QString direction = column.section(' ', 1);
+        quoted << connection.quoteIdentifier(name) + (direction.isEmpty() ? QString() : " " + direction);
+    }
+    return QString("ON %1 (%2)").arg(connection.quoteIdentifier(table), quoted.join(", "));
+}
+
+class Advisor {
+public:
+    Advisor(DatabaseConnection &connection, const IndexAdvisor::Options &options, IndexAdvisor::Report *report)
+        : connection(connection), options(options), report(report), workMemBytes(-1) {}
+
+    bool loadCatalog(QString *error) {
+        if (!TableStatistics::load(connection, &tables, error)) {
+            return false;
+        }
+        if (report->postgres) {
+            QSqlQuery query(connection.database());
+            if (query.exec("SHOW work_mem") && query.next()) {
+                workMemBytes = memorySetting(query.value(0).toString());
+            }
+        } else {
+            readAliases();
+        }
+        return true;
+    }
+
+    void walkPostgres(const QJsonObject &node, int depth);
+    void walkMysql(const QJsonValue &value, int nestedPosition);
+
+private:
+    QString tableKey(const QString &schema, const QString &name) const {
+        return schema.isEmpty() || schema == "public" ? name : schema + "." + name;
+    }
+    double tableRows(const QString &table) const {
+        return tables.contains(table) ? double(tables.value(table).estimatedRows) : -1;
+    }
+    // The table's columns by lower-case name, read once.
+    const QHash<QString, QString> &columnsOf(const QString &table);
+    // Columns of `table` in the refs, qualified by `alias` or unqualified
+    // when `unqualified` is set; equality columns first, then the others.
+    QStringList indexColumns(const QString &table, const QString &alias, const QVector<ColumnRef> &refs,
+                             bool unqualified);
+    void addFinding(IndexAdvisor::Finding finding);
+    void readAliases();
+    QString resolveTable(const QString &name) const {
+        return aliases.value(name.toLower(), name);
+    }
+
+    void checkSeqScan(const QJsonObject &node);
+    void checkSort(const QJsonObject &node);
+    void checkNestedLoop(const QJsonObject &node);
+    void checkMysqlTable(const QJsonObject &table, int nestedPosition);
+
+    DatabaseConnection &connection;
+    const IndexAdvisor::Options &options;
+    IndexAdvisor::Report *report;
+    QHash<QString, TableStatistics::Table> tables;
+    QHash<QString, QHash<QString, QString>> columns;
+    QHash<QString, QString> aliases;    // MySQL: alias -> table
+    qint64 workMemBytes;
+};
+
+const QHash<QString, QString> &Advisor::columnsOf(const QString &table) {
+    if (!columns.contains(table)) {
+        QHash<QString, QString> names;
+        QSqlRecord record = connection.database().record(table);
+        for (int i = 0; i < record.count(); ++i) {
+            names.insert(record.fieldName(i).toLower(), record.fieldName(i));
+        }
+        columns.insert(table, names);
+    }
+    return columns[table];
+}
+
+QStringList Advisor::indexColumns(const QString &table, const QString &alias, const QVector<ColumnRef> &refs,
+                                  bool unqualified) {
+    const QHash<QString, QString> &known = columnsOf(table);
+    QStringList equality;
+    QStringList others;
+    for (const ColumnRef &ref : refs) {
+        bool mine = ref.qualifier.isEmpty() ? unqualified
+                                            : ref.qualifier.compare(alias, Qt::CaseInsensitive) == 0;
+        QString column = known.value(ref.column.toLower());
+        if (!mine || column.isEmpty()) continue;
+        QStringList &target = ref.equality ? equality : others;
+        if (!equality.contains(column) && !others.contains(column)) {
+            target << column;
+        }
+    }
+    // Past the first range column an index only narrows by filtering.
+    if (!others.isEmpty()) {
+        equality << others.first();
+    }
+    return equality.mid(0, MaxIndexColumns);
+}
+
+void Advisor::addFinding(IndexAdvisor::Finding finding) {
+    for (const IndexAdvisor::Finding &existing : report->findings) {
+        if (existing.table == finding.table && existing.columns == finding.columns && !finding.columns.isEmpty()) {
+            return;
+        }
+    }
+    if (!finding.columns.isEmpty()) {
+        // An index leading with the same column would serve the condition;
+        // a planner passing it over points at statistics or types instead.
+        QString first = finding.columns.first().section(' ', 0, 0).toLower();
+        for (const TableStatistics::Index &index : tables.value(finding.table).indexes) {
+            QString leading = unquote(index.columns.section(',', 0, 0).trimmed().section(' ', 0, 0)).toLower();
+            if (leading == first) {
+                finding.existingIndex = index.name;
+                break;
+            }
+        }
+        if (finding.existingIndex.isEmpty()) {
+            QStringList nameParts;
+            for (const QString &column : finding.columns) {
+                nameParts << column.section(' ', 0, 0).toLower();
+            }
+            QString indexName = QString("idx_%1_%2").arg(finding.table.section('.', -1).toLower(),
+                                                         nameParts.join('_')).left(63);
+            finding.createIndex = QString("CREATE INDEX %1%2 %3;")
+                                      .arg(report->postgres ? "CONCURRENTLY " : "",
+                                           connection.quoteIdentifier(indexName),
+                                           indexTarget(connection, finding.table, finding.columns));
+        }
+    }
+    report->findings << finding;
+}
+
+void Advisor::walkPostgres(const QJsonObject &node, int depth) {
+    QLocale locale;
+    QString type = node["Node Type"].toString();
+    QString relation = node["Relation Name"].toString();
+    QString line = QString(depth * 2, ' ') + type;
+    if (!relation.isEmpty()) {
+        line += " on " + tableKey(node["Schema"].toString(), relation);
+        QString alias = node["Alias"].toString();
+        if (!alias.isEmpty() && alias != relation) {
+            line += " " + alias;
+        }
+    }
+    line += QString(" (cost=%1 rows=%2)").arg(node["Total Cost"].toDouble(), 0, 'f', 2)
+                                         .arg(locale.toString(qint64(node["Plan Rows"].toDouble())));
+    if (node.contains("Actual Rows")) {
+        line += QString(" (actual rows=%1 loops=%2)").arg(locale.toString(qint64(node["Actual Rows"].toDouble())))
+                                                     .arg(qint64(node["Actual Loops"].toDouble()));
+    }
+    report->plan += line + "\n";
+    for (const char *key : {"Index Cond", "Hash Cond", "Merge Cond", "Join Filter", "Filter"}) {
+        if (node.contains(key)) {
+            report->plan += QString(depth * 2 + 4, ' ') + key + ": " + node[key].toString() + "\n";
+        }
+    }
+    if (node.contains("Sort Key")) {
+        QStringList keys;
+        for (const QJsonValue &key : node["Sort Key"].toArray()) {
+            keys << key.toString();
+        }
+        report->plan += QString(depth * 2 + 4, ' ') + "Sort Key: " + keys.join(", ") + "\n";
+    }
+    if (node.contains("Sort Space Type")) {
+        report->plan += QString(depth * 2 + 4, ' ')
+                        + QString("Sort Method: %1, %2: %3 kB\n").arg(node["Sort Method"].toString(),
+                                                                       node["Sort Space Type"].toString())
+                                                                  .arg(qint64(node["Sort Space Used"].toDouble()));
+    }
+
+    if (type == "Seq Scan") {
+        checkSeqScan(node);
+    } else if (type == "Sort" || type == "Incremental Sort") {
+        checkSort(node);
+    } else if (type == "Nested Loop") {
+        checkNestedLoop(node);
+    }
+    for (const QJsonValue &child : node["Plans"].toArray()) {
+        walkPostgres(child.toObject(), depth + 1);
+    }
+}
+
+void Advisor::checkSeqScan(const QJsonObject &node) {
+    QString filter = node["Filter"].toString();
+    if (filter.isEmpty()) return;
+    QString table = tableKey(node["Schema"].toString(), node["Relation Name"].toString());
+    QString alias = node["Alias"].toString();
+
+    double kept;
+    double scanned;
+    if (report->analyzed && node.contains("Actual Rows")) {
+        kept = node["Actual Rows"].toDouble();
+        scanned = kept + node["Rows Removed by Filter"].toDouble();
+    } else {
+        kept = node["Plan Rows"].toDouble();
+        scanned = tableRows(table);
+    }
+    if (scanned < MinTableRows || kept > scanned * MaxSelectivity) return;
+
+    IndexAdvisor::Finding finding;
+    finding.kind = IndexAdvisor::SeqScan;
+    finding.table = table;
+    finding.rows = kept;
+    finding.tableRows = tableRows(table);
+    finding.columns = indexColumns(table, alias, columnRefs(filter, false), true);
+    finding.detail = QObject::tr("A full scan of %1 keeps %2 of %3 rows (%4%) with the filter %5")
+                         .arg(table, QLocale().toString(qint64(kept)), QLocale().toString(qint64(scanned)))
+                         .arg(scanned > 0 ? kept * 100 / scanned : 0, 0, 'f', 2)
+                         .arg(filter);
+    addFinding(finding);
+}
+
+void Advisor::checkSort(const QJsonObject &node) {
+    QLocale locale;
+    double rows = node.contains("Actual Rows") ? node["Actual Rows"].toDouble() : node["Plan Rows"].toDouble();
+    QString detail;
+    if (node.contains("Sort Space Type")) {
+        if (node["Sort Space Type"].toString() != "Disk") return;
+        detail = QObject::tr("A sort of %1 rows spilled %2 to disk (work_mem is %3)")
+                     .arg(locale.toString(qint64(rows)),
+                          TableStatistics::formatBytes(qint64(node["Sort Space Used"].toDouble()) * 1024),
+                          TableStatistics::formatBytes(workMemBytes));
+    } else {
+        qint64 bytes = qint64(node["Plan Rows"].toDouble() * node["Plan Width"].toDouble());
+        if (workMemBytes <= 0 || bytes <= workMemBytes) return;
+        detail = QObject::tr("A sort of about %1 rows (%2) will not fit in work_mem (%3) and spill to disk")
+                     .arg(locale.toString(qint64(rows)), TableStatistics::formatBytes(bytes),
+                          TableStatistics::formatBytes(workMemBytes));
+    }
+
+    IndexAdvisor::Finding finding;
+    finding.kind = IndexAdvisor::SortSpill;
+    finding.rows = rows;
+    QJsonArray children = node["Plans"].toArray();
+    QJsonObject input = children.isEmpty() ? QJsonObject() : children.first().toObject();
+    QStringList keys;
+    for (const QJsonValue &key : node["Sort Key"].toArray()) {
+        keys << key.toString();
+    }
+    detail += QObject::tr("; sort key %1").arg(keys.join(", "));
+
+    // Only a sort straight over one table's scan can be replaced by reading
+    // an index in order: its equality filter columns, then the sort keys.
+    if (input["Node Type"].toString() == "Seq Scan") {
+        QString table = tableKey(input["Schema"].toString(), input["Relation Name"].toString());
+        QString alias = input["Alias"].toString();
+        const QHash<QString, QString> &known = columnsOf(table);
+        static const QRegularExpression keyPattern("^(?:(\"[^\"]+\"|\\w+)\\.)?(\"[^\"]+\"|\\w+)((?: DESC)?(?: NULLS (?:FIRST|LAST))?)$");
+        QStringList sortColumns;
+        for (const QString &key : keys) {
+            QRegularExpressionMatch match = keyPattern.match(key.trimmed());
+            QString column = match.hasMatch() ? known.value(unquote(match.captured(2)).toLower()) : QString();
+            bool mine = match.captured(1).isEmpty() || unquote(match.captured(1)) == alias;
+            if (column.isEmpty() || !mine) {
+                sortColumns.clear();
+                break;
+            }
+            sortColumns << column + match.captured(3);
+        }
+        if (!sortColumns.isEmpty()) {
+            QStringList leading;
+            for (const ColumnRef &ref : columnRefs(input["Filter"].toString(), false)) {
+                QString column = known.value(ref.column.toLower());
+                if (ref.equality && !column.isEmpty() && !leading.contains(column)) {
+                    leading << column;
+                }
+            }
+            finding.table = table;
+            finding.tableRows = tableRows(table);
+            finding.columns = (leading + sortColumns).mid(0, MaxIndexColumns + 1);
+        }
+    }
+    finding.detail = detail;
+    addFinding(finding);
+}
+
+void Advisor::checkNestedLoop(const QJsonObject &node) {
+    QJsonObject outer;
+    QJsonObject inner;
+    for (const QJsonValue &value : node["Plans"].toArray()) {
+        QJsonObject child = value.toObject();
+        (child["Parent Relationship"].toString() == "Inner" ? inner : outer) = child;
+    }
+    if (inner["Node Type"].toString() == "Materialize" && !inner["Plans"].toArray().isEmpty()) {
+        inner = inner["Plans"].toArray().first().toObject();
+    }
+    if (inner["Node Type"].toString() != "Seq Scan") return;
+
+    double outerRows = outer.contains("Actual Rows")
+                           ? outer["Actual Rows"].toDouble() * qMax(1.0, outer["Actual Loops"].toDouble())
+                           : outer["Plan Rows"].toDouble();
+    QString table = tableKey(inner["Schema"].toString(), inner["Relation Name"].toString());
+    double rows = tableRows(table);
+    if (outerRows < MinOuterRows || rows < MinTableRows) return;
+
+    QString condition = node["Join Filter"].toString();
+    if (condition.isEmpty()) {
+        condition = inner["Filter"].toString();
+    }
+    IndexAdvisor::Finding finding;
+    finding.kind = IndexAdvisor::UnindexedJoin;
+    finding.table = table;
+    finding.rows = outerRows;
+    finding.tableRows = rows;
+    finding.columns = indexColumns(table, inner["Alias"].toString(), columnRefs(condition, false), false);
+    finding.detail = QObject::tr("A nested loop reads all of %1 (%2 rows) for each of %3 outer rows; "
+                                 "join condition %4")
+                         .arg(table, QLocale().toString(qint64(rows)), QLocale().toString(qint64(outerRows)),
+                              condition.isEmpty() ? QObject::tr("none") : condition);
+    addFinding(finding);
+}
+
+void Advisor::readAliases() {
+    // The JSON plan names tables by their alias in the statement.
+    static const QRegularExpression pattern(
+        "\\b(?:FROM|JOIN)\\s+(`[^`]+`|[\\w$.]+)(?:\\s+(?:AS\\s+)?(`[^`]+`|\\w+))?",
+        QRegularExpression::CaseInsensitiveOption);
+    static const QStringList keywords = {"WHERE", "JOIN", "ON", "USING", "LEFT", "RIGHT", "INNER", "OUTER", "CROSS",
+                                         "NATURAL", "STRAIGHT_JOIN", "GROUP", "ORDER", "LIMIT", "HAVING", "UNION",
+                                         "FOR", "SET", "WINDOW", "FORCE", "IGNORE", "USE", "LOCK"};
+    QRegularExpressionMatchIterator it = pattern.globalMatch(options.sql);
+    while (it.hasNext()) {
+        QRegularExpressionMatch match = it.next();
+        QString table = unquote(match.captured(1).section('.', -1));
+        QString alias = unquote(match.captured(2));
+        if (!alias.isEmpty() && !keywords.contains(alias.toUpper())) {
+            aliases.insert(alias.toLower(), table);
+        }
+    }
+}
+
+void Advisor::walkMysql(const QJsonValue &value, int nestedPosition) {
+    if (value.isArray()) {
+        QJsonArray array = value.toArray();
+        for (int i = 0; i < array.size(); ++i) {
+            walkMysql(array.at(i), i);
+        }
+        return;
+    }
+    if (!value.isObject()) return;
+    QJsonObject object = value.toObject();
+    if (object["using_filesort"].toBool()) {
+        double rows = 0;
+        QJsonDocument inner(object);
+        static const QRegularExpression produced("\"rows_produced_per_join\":\\s*\"?(\\d+)");
+        QRegularExpressionMatchIterator it = produced.globalMatch(QString::fromUtf8(inner.toJson()));
+        while (it.hasNext()) {
+            rows = qMax(rows, it.next().captured(1).toDouble());
+        }
+        if (rows >= MinFilesortRows) {
+            IndexAdvisor::Finding finding;
+            finding.kind = IndexAdvisor::SortSpill;
+            finding.rows = rows;
+            finding.detail = QObject::tr("A filesort of about %1 rows; sorts larger than sort_buffer_size are "
+                                         "merged through temporary files. An index in ORDER BY order avoids it.")
+                                 .arg(QLocale().toString(qint64(rows)));
+            addFinding(finding);
+        }
+    }
+    for (auto it = object.constBegin(); it != object.constEnd(); ++it) {
+        if (it.key() == "table" && it.value().isObject()) {
+            checkMysqlTable(it.value().toObject(), nestedPosition);
+        }
+        if (it.value().isObject() || it.value().isArray()) {
+            walkMysql(it.value(), it.key() == "nested_loop" ? 0 : nestedPosition);
+        }
+    }
+}
+
+void Advisor::checkMysqlTable(const QJsonObject &node, int nestedPosition) {
+    if (node["access_type"].toString() != "ALL") return;
+    QString alias = node["table_name"].toString();
+    QString table = resolveTable(alias);
+    QString condition = node["attached_condition"].toString();
+    double examined = number(node["rows_examined_per_scan"]);
+    double filtered = number(node["filtered"]);
+    bool joinBuffer = node.contains("using_join_buffer");
+    if (examined < MinTableRows || condition.isEmpty()) return;
+
+    IndexAdvisor::Finding finding;
+    finding.table = table;
+    finding.tableRows = tableRows(table);
+    QVector<ColumnRef> refs = columnRefs(condition, true);
+    finding.columns = indexColumns(table, alias, refs, false);
+    if (nestedPosition > 0 && joinBuffer) {
+        finding.kind = IndexAdvisor::UnindexedJoin;
+        finding.rows = examined;
+        finding.detail = QObject::tr("%1 is joined through a join buffer (%2), a full scan of %3 rows, "
+                                     "on %4")
+                             .arg(table, node["using_join_buffer"].toString(),
+                                  QLocale().toString(qint64(examined)), condition);
+    } else if (filtered >= 0 && filtered <= MaxSelectivity * 100) {
+        finding.kind = IndexAdvisor::SeqScan;
+        finding.rows = examined * filtered / 100;
+        finding.detail = QObject::tr("A full scan of %1 reads %2 rows and keeps about %3% with %4")
+                             .arg(table, QLocale().toString(qint64(examined)))
+                             .arg(filtered, 0, 'f', 2)
+                             .arg(condition);
+    } else {
+        return;
+    }
+    addFinding(finding);
+}
+
+// Planner cost of the statement; with hypopg, hypothetical indexes count.
+bool planCost(QSqlQuery &query, const QString &sql, double *cost, QString *planJson) {
+    if (!query.exec("EXPLAIN (FORMAT JSON) " + sql) || !query.next()) {
+        return false;
+    }
+    *planJson = query.value(0).toString();
+    QJsonArray plans = QJsonDocument::fromJson(planJson->toUtf8()).array();
+    *cost = plans.isEmpty() ? -1 : plans.first().toObject()["Plan"].toObject()["Total Cost"].toDouble(-1);
+    return *cost >= 0;
+}
+
+void verifyHypothetical(DatabaseConnection &connection, const QString &sql, IndexAdvisor::Report *report,
+                        IndexAdvisor::Progress *progress) {
+    QSqlQuery query(connection.database());
+    if (!query.exec("SELECT 1 FROM pg_extension WHERE extname = 'hypopg'") || !query.next()) {
+        report->note = QObject::tr("hypopg is not installed in this database; costs are not verified");
+        return;
+    }
+    double before;
+    QString plan;
+    if (!planCost(query, sql, &before, &plan)) {
+        report->note = QObject::tr("The statement could not be planned again: %1").arg(query.lastError().text());
+        return;
+    }
+    for (IndexAdvisor::Finding &finding : report->findings) {
+        if (finding.createIndex.isEmpty() || progress->canceled.loadRelaxed()) continue;
+        // hypopg takes a plain CREATE INDEX and names the index itself.
+        QString definition = "CREATE INDEX " + indexTarget(connection, finding.table, finding.columns);
+        QSqlQuery create(connection.database());
+        create.prepare("SELECT indexrelid FROM hypopg_create_index(?)");
+        create.addBindValue(definition);
+        if (!create.exec() || !create.next()) {
+            report->note = QObject::tr("hypopg could not create %1: %2").arg(definition, create.lastError().text());
+            continue;
+        }
+        QString oid = create.value(0).toString();
+        double after;
+        if (planCost(query, sql, &after, &plan)) {
+            finding.costBefore = before;
+            finding.costAfter = after;
+            // Hypothetical indexes are named <oid>btree_...
+            finding.used = plan.contains("<" + oid + ">");
+        }
+        query.exec("SELECT hypopg_reset()");
+    }
+}
+
+} // namespace
+
+QString IndexAdvisor::kindName(Kind kind) {
+    switch (kind) {
+    case SeqScan: return QObject::tr("Selective full scan");
+    case SortSpill: return QObject::tr("Sort spilling to disk");
+    case UnindexedJoin: return QObject::tr("Unindexed join");
+    }
+    return QString();
+}
+
+IndexAdvisor::Report IndexAdvisor::advise(const Options &options, Progress *progress) {
+    Report report;
+    QString sql = options.sql.trimmed();
+    while (sql.endsWith(';')) {
+        sql.chop(1);
+    }
+    if (sql.isEmpty()) {
+        report.error = QObject::tr("There is no statement to explain");
+        return report;
+    }
+    bool write = DatabaseConnection::isWriteStatement(sql);
+
+    DatabaseConnection connection;
+    if (!connection.connect(options.params)) {
+        report.error = connection.lastError().text();
+        return report;
+    }
+    report.postgres = connection.database().driverName() == "QPSQL";
+    {
+        QSqlQuery query(connection.database());
+        if (query.exec(report.postgres ? "SELECT pg_backend_pid()" : "SELECT CONNECTION_ID()") && query.next()) {
+            progress->backend.storeRelaxed(query.value(0).toLongLong());
+        }
+
+        Advisor advisor(connection, options, &report);
+        if (!advisor.loadCatalog(&report.error)) {
+            connection.disconnect();
+            return report;
+        }
+
+        // ANALYZE runs the statement, so never for one that plainly changes
+        // data, and otherwise inside a transaction that is rolled back:
+        // data-modifying CTEs and functions are not told by the first word.
+        report.analyzed = options.analyze && report.postgres && !write;
+        QString prefix = report.postgres
+                             ? (report.analyzed ? "EXPLAIN (ANALYZE, VERBOSE, FORMAT JSON) " : "EXPLAIN (VERBOSE, FORMAT JSON) ")
+                             : "EXPLAIN FORMAT=JSON ";
+        if (report.analyzed && !connection.database().transaction()) {
+            report.error = QObject::tr("Could not start the transaction to roll the statement back in: %1")
+                               .arg(connection.database().lastError().text());
+            connection.disconnect();
+            return report;
+        }
+        bool explained = query.exec(prefix + sql) && query.next();
+        QString planText = explained ? query.value(0).toString() : QString();
+        QString explainError = query.lastError().text();
+        query.finish();
+        if (report.analyzed && !connection.database().rollback()) {
+            report.error = QObject::tr("The statement ran but could not be rolled back: %1")
+                               .arg(connection.database().lastError().text());
+            connection.disconnect();
+            return report;
+        }
+        if (!explained) {
+            report.error = progress->canceled.loadRelaxed() ? QObject::tr("Canceled") : explainError;
+            connection.disconnect();
+            return report;
+        }
+        QJsonDocument document = QJsonDocument::fromJson(planText.toUtf8());
+        if (report.postgres) {
+            QJsonObject root = document.array().first().toObject();
+            QJsonObject plan = root["Plan"].toObject();
+            report.totalCost = plan["Total Cost"].toDouble(-1);
+            advisor.walkPostgres(plan, 0);
+        } else {
+            QJsonObject block = document.object()["query_block"].toObject();
+            report.totalCost = number(block["cost_info"].toObject()["query_cost"]);
+            report.plan = QString::fromUtf8(document.toJson(QJsonDocument::Indented));
+            advisor.walkMysql(block, 0);
+            if (options.analyze) {
+                report.note = QObject::tr("MySQL gives no JSON plan with actual figures; these are estimates");
+            }
+        }
+        if (options.analyze && write) {
+            report.note = QObject::tr("The statement changes data, so it was not run; these are estimates");
+        }
+    }
+
+    if (options.hypothetical && report.postgres && !progress->canceled.loadRelaxed()) {
+        verifyHypothetical(connection, sql, &report, progress);
+    } else if (options.hypothetical && !report.postgres) {
+        report.note = QObject::tr("Hypothetical indexes need PostgreSQL with hypopg");
+    }
+    connection.disconnect();
+    report.ok = true;
+    return report;
+}
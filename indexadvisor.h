@@ -0,0 +1,68 @@
+#ifndef INDEXADVISOR_H
+#define INDEXADVISOR_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QAtomicInt>
+#include <QAtomicInteger>
+#include "databaseconnection.h"
+
+// Index hints for one statement, read from its plan: full scans that keep
+// few of the rows they read, sorts that spill (or would spill) to disk, and
+// nested loops that scan their inner table once per outer row. Columns are
+// taken from the plan's conditions and checked against the table, and the
+// table's indexes from the catalog are checked before an index is proposed.
+//
+// On PostgreSQL with the hypopg extension, each proposal can be created as
+// a hypothetical index and the statement planned again, giving the
+// estimated cost with and without it; nothing is built on the server.
+class IndexAdvisor {
+public:
+    enum Kind { SeqScan, SortSpill, UnindexedJoin };
+
+    struct Options {
+        Options() : analyze(false), hypothetical(false) {}
+        DatabaseConnection::ConnectionParams params;
+        QString sql;
+        bool analyze;            // EXPLAIN ANALYZE: runs the statement
+        bool hypothetical;       // verify proposals with hypopg
+    };
+
+    struct Progress {
+        QAtomicInteger<qint64> backend;   // for QuerySession::cancel()
+        QAtomicInt canceled;
+    };
+
+    struct Finding {
+        Finding() : kind(SeqScan), rows(-1), tableRows(-1), costBefore(-1), costAfter(-1), used(false) {}
+        Kind kind;
+        QString table;
+        QStringList columns;     // of the proposed index, equality columns first
+        QString detail;          // the plan node and why it was flagged
+        double rows;             // rows the node returned
+        double tableRows;        // rows in the table, from the catalog
+        QString existingIndex;   // already leads with the first column
+        QString createIndex;     // empty when nothing is proposed
+        double costBefore;       // whole statement, -1 until verified
+        double costAfter;
+        bool used;               // the plan picked the hypothetical index
+    };
+
+    struct Report {
+        Report() : ok(false), postgres(false), analyzed(false), totalCost(-1) {}
+        bool ok;
+        QString error;
+        bool postgres;
+        bool analyzed;
+        double totalCost;        // planner estimate for the statement
+        QString plan;            // readable plan tree
+        QString note;            // e.g. why hypopg was not used
+        QVector<Finding> findings;
+    };
+
+    static Report advise(const Options &options, Progress *progress);
+    static QString kindName(Kind kind);
+};
+
+#endif // INDEXADVISOR_H
@@ -0,0 +1,273 @@
+#include "indexadvisordialog.h"
+#include "querysession.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QSplitter>
+#include <QHeaderView>
+#include <QFontDatabase>
+#include <QLocale>
+#include <QtConcurrent>
+
+namespace {
+
+enum FindingColumn {
+    ProblemColumn,
+    TableColumn,
+    ColumnsColumn,
+    RowsColumn,
+    ProposalColumn,
+    CostColumn,
+    ColumnCount
+};
+
+QString formatCost(double cost) {
+    return cost < 0 ? QString() : QLocale().toString(cost, 'f', 0);
+}
+
+// Asks the server to stop the advisor's statement, from the global pool so
+// the dialog does not wait for a connection. The future holds the error.
+QFuture<QString> cancelOnServer(const DatabaseConnection::ConnectionParams &params,
+                                IndexAdvisor::Progress *progress) {
+    progress->canceled.storeRelaxed(1);
+    qint64 backendId = progress->backend.loadRelaxed();
+    return QtConcurrent::run([params, backendId]() {
+        QString error;
+        if (backendId > 0 && !QuerySession::cancel(params, backendId, &error)) {
+            return error;
+        }
+        return QString();
+    });
+}
+
+} // namespace
+
+IndexAdvisorDialog::IndexAdvisorDialog(QWidget *parent, const QString &serverName,
+                                       const DatabaseConnection::ConnectionParams &params, const QString &sql)
+    : QDialog(parent), params(params), settings("DBManager", "Settings")
+{
+    setWindowTitle(tr("Index Advisor on %1/%2").arg(serverName, params.dbName));
+    resize(1000, 700);
+
+    auto layout = new QVBoxLayout(this);
+    sqlEdit = new QPlainTextEdit(sql, this);
+    sqlEdit->setMaximumHeight(120);
+    layout->addWidget(sqlEdit);
+
+    auto optionsLayout = new QHBoxLayout;
+    analyzeCheckBox = new QCheckBox(tr("Run the statement (EXPLAIN ANALYZE)"), this);
+    analyzeCheckBox->setToolTip(tr("Actual row counts and sort spills instead of estimates. "
+                                   "Statements that change data are only explained; others run "
+                                   "in a transaction that is rolled back."));
+    analyzeCheckBox->setChecked(settings.value("indexAdvisor/analyze", false).toBool());
+    optionsLayout->addWidget(analyzeCheckBox);
+    hypotheticalCheckBox = new QCheckBox(tr("Verify with hypothetical indexes (hypopg)"), this);
+    hypotheticalCheckBox->setToolTip(tr("Plans the statement again with each proposed index, "
+                                        "without building it. Needs the hypopg extension."));
+    hypotheticalCheckBox->setChecked(settings.value("indexAdvisor/hypothetical", true).toBool());
+    hypotheticalCheckBox->setEnabled(params.driver == "QPSQL");
+    optionsLayout->addWidget(hypotheticalCheckBox);
+    optionsLayout->addStretch();
+    adviseButton = new QPushButton(tr("Advise"), this);
+    adviseButton->setDefault(true);
+    optionsLayout->addWidget(adviseButton);
+    layout->addLayout(optionsLayout);
+
+    summaryLabel = new QLabel(this);
+    summaryLabel->setWordWrap(true);
+    layout->addWidget(summaryLabel);
+
+    auto splitter = new QSplitter(Qt::Vertical, this);
+    findingsTable = new QTableWidget(0, ColumnCount, splitter);
+    findingsTable->setHorizontalHeaderLabels({tr("Problem"), tr("Table"), tr("Columns"), tr("Rows"),
+                                              tr("Proposal"), tr("Estimated Cost")});
+    findingsTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    findingsTable->setSelectionMode(QAbstractItemView::SingleSelection);
+    findingsTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    findingsTable->verticalHeader()->hide();
+    findingsTable->horizontalHeader()->setStretchLastSection(true);
+    detailEdit = new QPlainTextEdit(splitter);
+    detailEdit->setReadOnly(true);
+    detailEdit->setLineWrapMode(QPlainTextEdit::NoWrap);
+    detailEdit->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    splitter->setStretchFactor(0, 1);
+    splitter->setStretchFactor(1, 2);
+    layout->addWidget(splitter, 1);
+
+    auto bottomLayout = new QHBoxLayout;
+    statusLabel = new QLabel(this);
+    statusLabel->setWordWrap(true);
+    statusLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
+    bottomLayout->addWidget(statusLabel, 1);
+    openButton = new QPushButton(tr("Open in Editor"), this);
+    openButton->setEnabled(false);
+    bottomLayout->addWidget(openButton);
+    layout->addLayout(bottomLayout);
+
+    connect(adviseButton, &QPushButton::clicked, this, &IndexAdvisorDialog::startOrCancel);
+    connect(openButton, &QPushButton::clicked, this, &IndexAdvisorDialog::openProposals);
+    connect(findingsTable, &QTableWidget::itemSelectionChanged, this, &IndexAdvisorDialog::showFinding);
+    connect(&watcher, &QFutureWatcher<IndexAdvisor::Report>::finished, this, &IndexAdvisorDialog::showReport);
+
+    statusLabel->setText(tr("The statement is explained on a connection of its own; nothing is created on the server."));
+}
+
+IndexAdvisorDialog::~IndexAdvisorDialog()
+{
+    // The worker uses this dialog's progress counters.
+    if (watcher.isRunning()) {
+        cancelOnServer(params, &progress);
+    }
+    watcher.waitForFinished();
+}
+
+void IndexAdvisorDialog::startOrCancel()
+{
+    if (watcher.isRunning()) {
+        auto cancelWatcher = new QFutureWatcher<QString>(this);
+        connect(cancelWatcher, &QFutureWatcher<QString>::finished, this, [this, cancelWatcher]() {
+            QString error = cancelWatcher->result();
+            cancelWatcher->deleteLater();
+            if (!error.isEmpty() && watcher.isRunning()) {
+                adviseButton->setEnabled(true);
+                statusLabel->setText(tr("Failed to cancel the statement: %1").arg(error));
+            }
+        });
+        cancelWatcher->setFuture(cancelOnServer(params, &progress));
+        adviseButton->setEnabled(false);
+        statusLabel->setText(tr("Canceling..."));
+        return;
+    }
+
+    IndexAdvisor::Options options;
+    options.params = params;
+    options.sql = sqlEdit->toPlainText().trimmed();
+    options.analyze = analyzeCheckBox->isChecked();
+    options.hypothetical = hypotheticalCheckBox->isEnabled() && hypotheticalCheckBox->isChecked();
+    if (options.sql.isEmpty()) {
+        statusLabel->setText(tr("Enter a statement to advise on."));
+        return;
+    }
+    settings.setValue("indexAdvisor/analyze", analyzeCheckBox->isChecked());
+    settings.setValue("indexAdvisor/hypothetical", hypotheticalCheckBox->isChecked());
+
+    progress.backend.storeRelaxed(0);
+    progress.canceled.storeRelaxed(0);
+    IndexAdvisor::Progress *shared = &progress;
+    watcher.setFuture(QtConcurrent::run([options, shared]() {
+        return IndexAdvisor::advise(options, shared);
+    }));
+    adviseButton->setText(tr("Cancel"));
+    sqlEdit->setReadOnly(true);
+    statusLabel->setText(options.analyze ? tr("Running the statement...") : tr("Explaining the statement..."));
+}
+
+void IndexAdvisorDialog::showReport()
+{
+    adviseButton->setText(tr("Advise"));
+    adviseButton->setEnabled(true);
+    sqlEdit->setReadOnly(false);
+    report = watcher.result();
+    findingsTable->setRowCount(0);
+    detailEdit->clear();
+    if (!report.ok) {
+        summaryLabel->clear();
+        openButton->setEnabled(false);
+        statusLabel->setText(progress.canceled.loadRelaxed() ? tr("Canceled.") : report.error);
+        return;
+    }
+
+    QLocale locale;
+    int proposals = 0;
+    findingsTable->setRowCount(report.findings.size());
+    for (int row = 0; row < report.findings.size(); ++row) {
+        const IndexAdvisor::Finding &finding = report.findings.at(row);
+        QString proposal = finding.createIndex;
+        if (!finding.existingIndex.isEmpty()) {
+            proposal = tr("Covered by %1").arg(finding.existingIndex);
+        } else if (proposal.isEmpty()) {
+            proposal = tr("No index proposed");
+        } else {
+            ++proposals;
+        }
+        QString cost;
+        if (finding.costAfter >= 0) {
+            cost = QString::fromUtf8("%1 → %2").arg(formatCost(finding.costBefore), formatCost(finding.costAfter));
+            if (finding.costBefore > 0) {
+                cost += QString(" (%1%)").arg((finding.costAfter - finding.costBefore) * 100 / finding.costBefore,
+                                               0, 'f', 0);
+            }
+            if (!finding.used) {
+                cost += tr(", not used");
+            }
+        }
+        QString rows = finding.rows < 0 ? QString() : locale.toString(qint64(finding.rows));
+        if (finding.tableRows >= 0) {
+            rows = tr("%1 of %2").arg(rows, locale.toString(qint64(finding.tableRows)));
+        }
+        QStringList cells = {IndexAdvisor::kindName(finding.kind), finding.table, finding.columns.join(", "),
+                             rows, proposal, cost};
+        for (int column = 0; column < ColumnCount; ++column) {
+            auto item = new QTableWidgetItem(cells.at(column));
+            item->setToolTip(column == ProblemColumn ? finding.detail : cells.at(column));
+            if (column == RowsColumn || column == CostColumn) {
+                item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+            }
+            findingsTable->setItem(row, column, item);
+        }
+    }
+    findingsTable->resizeColumnsToContents();
+    openButton->setEnabled(proposals > 0);
+
+    QString summary = report.findings.isEmpty()
+                          ? tr("Nothing in the plan points at a missing index.")
+                          : tr("%n finding(s), %1 index(es) proposed.", "", report.findings.size()).arg(proposals);
+    if (report.totalCost >= 0) {
+        summary += " " + tr("Estimated cost of the statement: %1.").arg(formatCost(report.totalCost));
+    }
+    summaryLabel->setText(summary);
+    detailEdit->setPlainText(report.plan);
+    statusLabel->setText(!report.note.isEmpty() ? report.note
+                         : report.analyzed      ? tr("Actual figures from EXPLAIN ANALYZE.")
+                                                : tr("Planner estimates."));
+    if (!report.findings.isEmpty()) {
+        findingsTable->selectRow(0);
+    }
+}
+
+void IndexAdvisorDialog::showFinding()
+{
+    int row = findingsTable->currentRow();
+    if (row < 0 || row >= report.findings.size()) {
+        detailEdit->setPlainText(report.plan);
+        return;
+    }
+    const IndexAdvisor::Finding &finding = report.findings.at(row);
+    QString text = finding.detail + "\n";
+    if (!finding.existingIndex.isEmpty()) {
+        text += tr("\nThe index %1 already leads with %2; the planner did not use it, which points at stale "
+                   "statistics or a type or collation mismatch in the condition.\n")
+                    .arg(finding.existingIndex, finding.columns.value(0));
+    } else if (!finding.createIndex.isEmpty()) {
+        text += "\n" + finding.createIndex + "\n";
+    }
+    detailEdit->setPlainText(text + "\n" + report.plan);
+}
+
+void IndexAdvisorDialog::openProposals()
+{
+    QStringList statements;
+    for (const IndexAdvisor::Finding &finding : report.findings) {
+        if (finding.createIndex.isEmpty()) continue;
+        QString comment = finding.detail;
+        comment.replace('\n', ' ');
+        QString statement = "-- " + comment + "\n";
+        if (finding.costAfter >= 0) {
+            statement += tr("-- Estimated cost %1 -> %2%3\n")
+                             .arg(formatCost(finding.costBefore), formatCost(finding.costAfter),
+                                  finding.used ? QString() : tr(" (the plan did not use it)"));
+        }
+        statements << statement + finding.createIndex;
+    }
+    if (statements.isEmpty()) return;
+    emit openStatement(statements.join("\n\n"));
+}
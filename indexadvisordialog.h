@@ -0,0 +1,53 @@
+#ifndef INDEXADVISORDIALOG_H
+#define INDEXADVISORDIALOG_H
+
+#include <QDialog>
+#include <QPlainTextEdit>
+#include <QCheckBox>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QLabel>
+#include <QFutureWatcher>
+#include <QSettings>
+#include "indexadvisor.h"
+
+// Explains a statement and lists the plan nodes an index would help, with
+// the CREATE INDEX statements proposed for them and, with hypopg, the
+// estimated cost of the statement before and after each one.
+class IndexAdvisorDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    IndexAdvisorDialog(QWidget *parent, const QString &serverName,
+                       const DatabaseConnection::ConnectionParams &params, const QString &sql);
+    ~IndexAdvisorDialog();
+
+signals:
+    // Editor text: the proposals, each after a comment saying why.
+    void openStatement(const QString &sql);
+
+private slots:
+    void startOrCancel();
+    void showReport();
+    void showFinding();
+    void openProposals();
+
+private:
+    DatabaseConnection::ConnectionParams params;
+    IndexAdvisor::Report report;
+
+    QPlainTextEdit *sqlEdit;
+    QCheckBox *analyzeCheckBox;
+    QCheckBox *hypotheticalCheckBox;
+    QPushButton *adviseButton;
+    QLabel *summaryLabel;
+    QTableWidget *findingsTable;
+    QPlainTextEdit *detailEdit;
+    QPushButton *openButton;
+    QLabel *statusLabel;
+    QFutureWatcher<IndexAdvisor::Report> watcher;
+    IndexAdvisor::Progress progress;
+    QSettings settings;
+};
+
+#endif // INDEXADVISORDIALOG_H
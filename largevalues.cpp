@@ -0,0 +1,214 @@
+#include "largevalues.h"
+#include "tablecopier.h"
+#include <QSqlQuery>
+#include <QSqlIndex>
+#include <QSqlError>
+#include <QObject>
+#include <algorithm>
+
+namespace {
+
+bool isLargeType(const TableCopier::Column &column, bool postgres, bool *binary, bool *json) {
+    const QString &type = column.baseType;
+    if (postgres) {
+        *binary = type == "bytea";
+        *json = type == "json" || type == "jsonb";
+        // varchar without a length is as unbounded as text
+        return *binary || *json || type == "text" || type == "xml" || column.type == "character varying";
+    }
+    static const QStringList mysqlText = {"text", "mediumtext", "longtext"};
+    static const QStringList mysqlBinary = {"blob", "mediumblob", "longblob"};
+    *binary = mysqlBinary.contains(type);
+    *json = type == "json";
+    return *binary || *json || mysqlText.contains(type);
+}
+
+// The column as text (or bytes), which previews and chunks are cut from.
+QString valueExpression(DatabaseConnection &connection, const QString &column, bool binary, bool json) {
+    QString name = connection.quoteIdentifier(column);
+    if (connection.database().driverName() == "QPSQL") {
+        return binary ? name : name + "::text";
+    }
+    return json ? QString("CAST(%1 AS CHAR)").arg(name) : name;
+}
+
+// Runs `SELECT <select> FROM table WHERE <locator>` positioned on the row;
+// `leading` binds the placeholders of the select list. A locator matching
+// more than one row fails rather than show another row's value.
+bool locate(DatabaseConnection &connection, const LargeValues::ValueRef &ref, const QString &select,
+            const QVariantList &leading, QSqlQuery *query, QString *error) {
+    if (ref.locatorColumns.isEmpty()) {
+        *error = QObject::tr("The row cannot be identified");
+        return false;
+    }
+    bool postgres = connection.database().driverName() == "QPSQL";
+    QStringList conditions;
+    QVariantList values = leading;
+    for (int i = 0; i < ref.locatorColumns.size(); ++i) {
+        QString name = connection.quoteIdentifier(ref.locatorColumns.at(i));
+        const QString &value = ref.locatorValues.at(i);
+        if (value.isEmpty()) {
+            // The grid shows NULL and '' alike.
+            conditions << QString("(%1 IS NULL OR %2 = '')").arg(name, postgres ? name + "::text" : name);
+        } else {
+            conditions << name + " = ?";
+            values << value;
+        }
+    }
+    query->prepare(QString("SELECT %1 FROM %2 WHERE %3 LIMIT 2")
+                       .arg(select, connection.quoteIdentifier(ref.table), conditions.join(" AND ")));
+    for (const QVariant &value : values) {
+        query->addBindValue(value);
+    }
+    if (!query->exec()) {
+        *error = query->lastError().text();
+        return false;
+    }
+    if (!query->next()) {
+        *error = QObject::tr("The row no longer exists");
+        return false;
+    }
+    if (query->next()) {
+        *error = QObject::tr("The row cannot be told apart from others like it");
+        return false;
+    }
+    return query->first();
+}
+
+} // namespace
+
+LargeValues::Browse LargeValues::browse(DatabaseConnection &connection, const QString &table,
+                                       const QStringList &projection) {
+    Browse result;
+    result.table = table;
+    QString quotedTable = connection.quoteIdentifier(table);
+    result.sql = "SELECT * FROM " + quotedTable;
+
+    QVector<TableCopier::Column> sourceColumns;
+    QString error;
+    if (!TableCopier::readColumns(connection, table, &sourceColumns, &error)) {
+        return result;
+    }
+    bool postgres = connection.database().driverName() == "QPSQL";
+    for (const TableCopier::Column &source : sourceColumns) {
+        Column column;
+        column.name = source.name;
+        column.baseType = source.baseType;
+        column.large = isLargeType(source, postgres, &column.binary, &column.json);
+        result.tableColumns << column;
+    }
+    // Browsing pages by the key as well; see BrowseQuery.
+    QSqlIndex primary = connection.database().primaryIndex(table);
+    for (int i = 0; i < primary.count(); ++i) {
+        result.keyColumns << primary.fieldName(i);
+    }
+
+    // The key is always selected: edits, paging and the value viewer find
+    // rows by it.
+    auto find = [&result](const QString &name) {
+        return std::find_if(result.tableColumns.cbegin(), result.tableColumns.cend(),
+                            [&name](const Column &column) { return column.name == name; });
+    };
+    QStringList chosen;
+    for (const QString &key : result.keyColumns) {
+        if (!projection.contains(key) && find(key) != result.tableColumns.cend()) {
+            chosen << key;
+        }
+    }
+    for (const Column &column : result.tableColumns) {
+        if (projection.isEmpty() && !column.large && !chosen.contains(column.name)) {
+            chosen << column.name;
+        }
+    }
+    for (const QString &name : projection) {
+        if (find(name) != result.tableColumns.cend() && !chosen.contains(name)) {
+            chosen << name;
+        }
+    }
+    if (chosen.isEmpty()) {
+        for (const Column &column : result.tableColumns) {
+            chosen << column.name;
+        }
+    }
+
+    QStringList selectList;
+    QStringList sizeList;
+    TableUtils::PreviewLayout layout;
+    layout.columns = chosen.size();
+    for (const QString &name : chosen) {
+        const Column &column = *find(name);
+        result.columns << column;
+
+        QString quoted = connection.quoteIdentifier(column.name);
+        if (!column.large) {
+            selectList << quoted;
+            layout.sizeField << -1;
+            layout.binary << false;
+            continue;
+        }
+        QString value = valueExpression(connection, column.name, column.binary, column.json);
+        int previewLength = column.binary ? PreviewBytes : PreviewChars;
+        QString preview = postgres && column.binary ? QString("substr(%1, 1, %2)") : QString("LEFT(%1, %2)");
+        selectList << preview.arg(value).arg(previewLength) + " AS " + quoted;
+        layout.sizeField << chosen.size() + sizeList.size();
+        layout.binary << column.binary;
+        sizeList << QString(postgres ? "octet_length(%1)" : "LENGTH(%1)").arg(value);
+    }
+    result.sql = QString("SELECT %1 FROM %2").arg((selectList + sizeList).join(", "), quotedTable);
+    if (!sizeList.isEmpty()) {
+        result.layout = layout;
+    }
+    return result;
+}
+
+LargeValues::ValueRef LargeValues::valueRef(const Browse &browse, int column, const QStringList &rowTexts) {
+    ValueRef ref;
+    ref.table = browse.table;
+    if (column < 0 || column >= browse.columns.size()) {
+        return ref;
+    }
+    const Column &target = browse.columns.at(column);
+    ref.column = target.name;
+    ref.binary = target.binary;
+    ref.json = target.json;
+
+    // Without a primary key the row is matched on its small columns, and
+    // only when the grid has all of them; otherwise there is no locator.
+    if (browse.keyColumns.isEmpty() && browse.columns.size() != browse.tableColumns.size()) {
+        return ref;
+    }
+    for (int i = 0; i < browse.columns.size(); ++i) {
+        const Column &candidate = browse.columns.at(i);
+        bool locator = browse.keyColumns.isEmpty() ? !candidate.large : browse.keyColumns.contains(candidate.name);
+        if (locator) {
+            ref.locatorColumns << candidate.name;
+            ref.locatorValues << rowTexts.value(i);
+        }
+    }
+    return ref;
+}
+
+bool LargeValues::valueLength(DatabaseConnection &connection, const ValueRef &ref, qint64 *length, QString *error) {
+    bool postgres = connection.database().driverName() == "QPSQL";
+    QString function = ref.binary ? (postgres ? "octet_length" : "LENGTH") : (postgres ? "char_length" : "CHAR_LENGTH");
+    QString select = QString("%1(%2)").arg(function, valueExpression(connection, ref.column, ref.binary, ref.json));
+    QSqlQuery query(connection.database());
+    if (!locate(connection, ref, select, QVariantList(), &query, error)) {
+        return false;
+    }
+    *length = query.value(0).isNull() ? -1 : query.value(0).toLongLong();
+    return true;
+}
+
+bool LargeValues::readChunk(DatabaseConnection &connection, const ValueRef &ref, qint64 offset, int length,
+                            QVariant *chunk, QString *error) {
+    bool postgres = connection.database().driverName() == "QPSQL";
+    QString select = QString(postgres ? "substr(%1, ?, ?)" : "SUBSTRING(%1, ?, ?)")
+                         .arg(valueExpression(connection, ref.column, ref.binary, ref.json));
+    QSqlQuery query(connection.database());
+    if (!locate(connection, ref, select, QVariantList() << offset + 1 << length, &query, error)) {
+        return false;
+    }
+    *chunk = query.value(0);
+    return true;
+}
@@ -0,0 +1,66 @@
+#ifndef LARGEVALUES_H
+#define LARGEVALUES_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QVariant>
+#include "databaseconnection.h"
+#include "tableutils.h"
+
+// Browsing tables with large TEXT/BLOB/JSON columns. Such columns are found
+// from the catalog and selected as bounded previews plus their full size, so
+// the grid never holds whole documents; the value viewer then reads a single
+// value back in chunks, locating its row by primary key.
+class LargeValues {
+public:
+    struct Column {
+        Column() : large(false), binary(false), json(false) {}
+        QString name;
+        QString baseType;   // lower-case, without modifiers; see TableCopier::Column
+        bool large;
+        bool binary;
+        bool json;
+    };
+
+    // SELECT for browsing one table, and what is needed to re-read a cell.
+    struct Browse {
+        QString table;
+        QVector<Column> columns;        // as selected, in grid order
+        QVector<Column> tableColumns;   // all of the table's, in table order
+        QStringList keyColumns;   // primary key; empty when the table has none
+        QString sql;
+        TableUtils::PreviewLayout layout;
+    };
+
+    // One value of one row, identified by the grid texts of locator columns.
+    struct ValueRef {
+        ValueRef() : binary(false), json(false) {}
+        QString table;
+        QString column;
+        bool binary;
+        bool json;
+        QStringList locatorColumns;
+        QStringList locatorValues;
+    };
+
+    static const int PreviewChars = 200;
+    static const int PreviewBytes = 32;
+
+    // Selects the `projection` columns in its order, plus the primary key;
+    // an empty projection leaves out the large columns. Falls back to
+    // SELECT * (and an empty layout) when the columns cannot be read.
+    static Browse browse(DatabaseConnection &connection, const QString &table,
+                         const QStringList &projection = QStringList());
+    // Located by the primary key; without one, by the small columns when
+    // the grid has every column, else not at all (reading then fails).
+    static ValueRef valueRef(const Browse &browse, int column, const QStringList &rowTexts);
+
+    // Size in characters for text, in bytes for binary values.
+    static bool valueLength(DatabaseConnection &connection, const ValueRef &ref, qint64 *length, QString *error);
+    // `offset` is 0-based, in the same unit as valueLength().
+    static bool readChunk(DatabaseConnection &connection, const ValueRef &ref, qint64 offset, int length,
+                          QVariant *chunk, QString *error);
+};
+
+#endif // LARGEVALUES_H
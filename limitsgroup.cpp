@@ -0,0 +1,47 @@
+#include "limitsgroup.h"
+#include <QFormLayout>
+
+LimitsGroup::LimitsGroup(const QString &title, const QString &readOnlyText, QWidget *parent)
+    : QGroupBox(title, parent)
+{
+    auto limitsLayout = new QFormLayout(this);
+
+    statementTimeoutSpinBox = new QSpinBox(this);
+    statementTimeoutSpinBox->setRange(0, 86400);
+    statementTimeoutSpinBox->setSuffix(tr(" s"));
+    statementTimeoutSpinBox->setSpecialValueText(tr("No limit"));
+
+    maxRowsSpinBox = new QSpinBox(this);
+    maxRowsSpinBox->setRange(0, 100000000);
+    maxRowsSpinBox->setSingleStep(10000);
+    maxRowsSpinBox->setSpecialValueText(tr("No limit"));
+
+    maxMemorySpinBox = new QSpinBox(this);
+    maxMemorySpinBox->setRange(0, 1024 * 1024);
+    maxMemorySpinBox->setSingleStep(128);
+    maxMemorySpinBox->setSuffix(tr(" MB"));
+    maxMemorySpinBox->setSpecialValueText(tr("No limit"));
+
+    readOnlyCheckBox = new QCheckBox(readOnlyText, this);
+
+    limitsLayout->addRow(tr("Statement timeout:"), statementTimeoutSpinBox);
+    limitsLayout->addRow(tr("Max rows fetched:"), maxRowsSpinBox);
+    limitsLayout->addRow(tr("Max result memory:"), maxMemorySpinBox);
+    limitsLayout->addRow(readOnlyCheckBox);
+}
+
+void LimitsGroup::setLimits(const DatabaseConnection::ConnectionParams &params)
+{
+    statementTimeoutSpinBox->setValue(params.statementTimeout);
+    maxRowsSpinBox->setValue(params.maxRows);
+    maxMemorySpinBox->setValue(params.maxResultMemoryMb);
+    readOnlyCheckBox->setChecked(params.readOnly);
+}
+
+void LimitsGroup::applyTo(DatabaseConnection::ConnectionParams *params) const
+{
+    params->statementTimeout = statementTimeoutSpinBox->value();
+    params->maxRows = maxRowsSpinBox->value();
+    params->maxResultMemoryMb = maxMemorySpinBox->value();
+    params->readOnly = readOnlyCheckBox->isChecked();
+}
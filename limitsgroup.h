@@ -0,0 +1,29 @@
+#ifndef LIMITSGROUP_H
+#define LIMITSGROUP_H
+
+#include <QGroupBox>
+#include <QSpinBox>
+#include <QCheckBox>
+#include "databaseconnection.h"
+
+// The execution limits of a session: statement timeout, rows and memory
+// fetched, read-only. Shared by the server dialog and the defaults in the
+// settings; a zero means no limit.
+class LimitsGroup : public QGroupBox {
+    Q_OBJECT
+
+public:
+    LimitsGroup(const QString &title, const QString &readOnlyText, QWidget *parent = nullptr);
+
+    void setLimits(const DatabaseConnection::ConnectionParams &params);
+    // Sets only the limit fields of params.
+    void applyTo(DatabaseConnection::ConnectionParams *params) const;
+
+private:
+    QSpinBox *statementTimeoutSpinBox;
+    QSpinBox *maxRowsSpinBox;
+    QSpinBox *maxMemorySpinBox;
+    QCheckBox *readOnlyCheckBox;
+};
+
+#endif // LIMITSGROUP_H
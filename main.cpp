@@ -1,9 +1,17 @@
 #include "mainwindow.h"
+#include "commandlinerunner.h"
 
 #include <QApplication>
+#include <QCoreApplication>
 
 int main(int argc, char *argv[])
 {
+    if (CommandLineRunner::isHeadlessInvocation(argc, argv)) {
+        QCoreApplication app(argc, argv);
+        CommandLineRunner runner;
+        return runner.run(app.arguments());
+    }
+
     QApplication a(argc, argv);
     MainWindow w;
     w.show();
@@ -2,19 +2,111 @@
 #include "ui_mainwindow.h"
 #include "serversdialog.h"
 #include "settingsdialog.h"
+#include "resultexporter.h"
+#include "tableutils.h"
+#include "sampledialog.h"
+#include "tablesampler.h"
+#include "comparetablesdialog.h"
+#include "copytabledialog.h"
+#include "dumpdatabasedialog.h"
+#include "activitymonitordialog.h"
+#include "topqueriesdialog.h"
+#include "profiletabledialog.h"
+#include "benchmarkdialog.h"
+#include "indexadvisordialog.h"
+#include "resultmemory.h"
+#include "sessionstore.h"
+#include "tracer.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QToolBar>
 #include <QMessageBox>
 #include <QFileDialog>
+#include <QAction>
 #include <QClipboard>
 #include <QDateTime>
 #include <QSqlRecord>
 #include <QApplication>
+#include <QProgressDialog>
+#include <QFutureWatcher>
+#include <QSharedPointer>
+#include <QTimer>
+#include <QtConcurrent>
+#include <QHeaderView>
+#include <QLocale>
+#include <QInputDialog>
+#include <QCloseEvent>
+#include <algorithm>
+
+namespace {
+
+// Selections below this size are copied synchronously.
+const int BackgroundCopyCells = 50000;
+const int MemoryStatusMs = 1000;
+
+// The servers tree as read again by a worker after a session restore.
+struct TreeRefresh {
+    TreeRefresh() : schemaLoaded(false) {}
+    QVector<SessionStore::Server> servers;
+    QHash<QString, QString> errors;     // per server that could not be read
+    SchemaIndex schemaIndex;
+    bool schemaLoaded;
+};
+
+// Reads the databases of every restored server, and the tables of the
+// databases that were opened, each through a connection of its own. The
+// completion index follows the selected database, as it would have.
+TreeRefresh refreshTree(const QVector<SessionStore::Server> &restored, const QStringList &selectedPath)
+{
+    TreeRefresh refresh;
+    for (const SessionStore::Server &cached : restored) {
+        DatabaseConnection connection;
+        DatabaseConnection::ConnectionParams params = connection.loadConnectionSettings(cached.name);
+        if (!connection.connect(params)) {
+            refresh.errors.insert(cached.name, connection.lastError().text());
+            continue;
+        }
+        SessionStore::Server server;
+        server.name = cached.name;
+        server.expanded = cached.expanded;
+        QHash<QString, SessionStore::Database> previous;
+        for (const SessionStore::Database &database : cached.databases) {
+            previous.insert(database.name, database);
+        }
+        for (const QString &name : connection.getDatabases()) {
+            SessionStore::Database database;
+            database.name = name;
+            database.expanded = previous.value(name).expanded;
+            bool selected = selectedPath.size() > 1 && selectedPath.at(0) == server.name && selectedPath.at(1) == name;
+            if (!previous.value(name).tables.isEmpty() && connection.changeDatabase(name)) {
+                database.tables = connection.tables();
+                if (selected) {
+                    QString error;
+                    refresh.schemaLoaded = refresh.schemaIndex.load(connection, &error);
+                }
+            }
+            server.databases << database;
+        }
+        refresh.servers << server;
+        connection.disconnect();
+    }
+    return refresh;
+}
+
+// The completion index of one database, read by a worker.
+struct SchemaLoad {
+    SchemaLoad() : ok(false) {}
+    SchemaIndex schemaIndex;
+    QString error;
+    bool ok;
+};
+
+} // namespace
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
+    , schemaGeneration(0)
     , settings("DBManager", "MainWindow")
 {
     ui->setupUi(this);
@@ -23,6 +115,9 @@ MainWindow::MainWindow(QWidget *parent)
     setupToolbar();
     setupStatusBar();
     loadServers();
+    if (!restoreSession()) {
+        newQueryTab();
+    }
 }
 
 MainWindow::~MainWindow()
@@ -35,39 +130,44 @@ void MainWindow::setupUI()
     mainSplitter = new QSplitter(Qt::Horizontal, this);
     setCentralWidget(mainSplitter);
 
-    serversTree = new QTreeWidget(mainSplitter);
-    serversTree->setHeaderLabels({tr("Servers")});
-    serversTree->setContextMenuPolicy(Qt::CustomContextMenu);
-
-    auto rightPanel = new QWidget(mainSplitter);
-    auto rightLayout = new QVBoxLayout(rightPanel);
+    auto leftSplitter = new QSplitter(Qt::Vertical, mainSplitter);
 
-    queryEdit = new QTextEdit(rightPanel);
-    queryEdit->setPlaceholderText(tr("Enter SQL query..."));
-    rightLayout->addWidget(queryEdit);
+    serversTree = new QTreeWidget(leftSplitter);
+    serversTree->setHeaderLabels({tr("Servers"), tr("Size")});
+    serversTree->header()->setStretchLastSection(false);
+    serversTree->header()->setSectionResizeMode(0, QHeaderView::Stretch);
+    serversTree->header()->setSectionResizeMode(1, QHeaderView::ResizeToContents);
+    serversTree->setContextMenuPolicy(Qt::CustomContextMenu);
 
-    auto executeButton = new QPushButton(tr("Execute"), rightPanel);
-    rightLayout->addWidget(executeButton);
+    statsPanel = new TableStatisticsPanel(leftSplitter);
+    leftSplitter->setStretchFactor(0, 3);
+    leftSplitter->setStretchFactor(1, 1);
 
-    dataTable = new QTableWidget(rightPanel);
-    dataTable->setEditTriggers(QAbstractItemView::DoubleClicked | QAbstractItemView::EditKeyPressed);
-    dataTable->setSortingEnabled(false);
-    dataTable->horizontalHeader()->setSectionsClickable(true);
-    rightLayout->addWidget(dataTable);
+    queryTabs = new QTabWidget(mainSplitter);
+    queryTabs->setTabsClosable(true);
+    queryTabs->setMovable(true);
+    queryTabs->setDocumentMode(true);
 
-    dataTable->setContextMenuPolicy(Qt::CustomContextMenu);
     tableContextMenu = new QMenu(this);
-    tableContextMenu->addAction(tr("Copy"), this, &MainWindow::copySelectedCells);
+    copyAction = tableContextMenu->addAction(tr("Copy"), this, &MainWindow::copySelectedCells);
+    copyAction->setShortcut(QKeySequence::Copy);
+    copyAction->setShortcutContext(Qt::WidgetWithChildrenShortcut);
+    auto copyAsMenu = tableContextMenu->addMenu(tr("Copy As"));
+    for (ClipboardFormatter::Format format : {ClipboardFormatter::Tsv, ClipboardFormatter::Csv,
+                                              ClipboardFormatter::Markdown, ClipboardFormatter::Json,
+                                              ClipboardFormatter::SqlInsert, ClipboardFormatter::SqlInList}) {
+        copyAsMenu->addAction(ClipboardFormatter::formatName(format),
+                              [this, format]() { copySelection(format); });
+    }
+    tableContextMenu->addAction(tr("View Value..."), [this]() { currentTab()->viewCurrentValue(); });
     tableContextMenu->addAction(tr("Export"), this, &MainWindow::exportToFile);
 
     connect(serversTree, &QTreeWidget::itemDoubleClicked, this, &MainWindow::handleTreeItemDoubleClick);
     connect(serversTree, &QTreeWidget::customContextMenuRequested, this, &MainWindow::showContextMenu);
-    connect(dataTable, &QTableWidget::customContextMenuRequested,
-            [this](const QPoint &pos) { tableContextMenu->exec(dataTable->mapToGlobal(pos)); });
-    connect(executeButton, &QPushButton::clicked, this, &MainWindow::executeQuery);
-    connect(dataTable, &QTableWidget::cellChanged, this, &MainWindow::onCellChanged);
-    connect(dataTable->horizontalHeader(), SIGNAL(sectionClicked(int)),
-            this, SLOT(onHeaderClicked(int)));
+    connect(serversTree, &QTreeWidget::currentItemChanged, this, &MainWindow::onTreeSelectionChanged);
+    connect(statsPanel, &TableStatisticsPanel::refreshRequested, this, &MainWindow::refreshTableStatistics);
+    connect(queryTabs, &QTabWidget::tabCloseRequested, this, &MainWindow::closeQueryTab);
+    connect(queryTabs, &QTabWidget::currentChanged, [this]() { showTabStatus(currentTab()); });
 
     QByteArray splitterState = settings.value("splitterState").toByteArray();
     if (!splitterState.isEmpty()) {
@@ -83,7 +183,24 @@ void MainWindow::setupMenus()
     fileMenu->addAction(tr("Add Server"), this, &MainWindow::addServer);
     fileMenu->addAction(tr("Settings"), this, &MainWindow::showSettings);
     fileMenu->addSeparator();
+    fileMenu->addAction(tr("New Query Tab"), this, &MainWindow::newQueryTab, QKeySequence::AddTab);
+    fileMenu->addAction(tr("Close Query Tab"), [this]() { closeQueryTab(queryTabs->currentIndex()); });
+    fileMenu->addAction(tr("Open SQL Script..."), this, &MainWindow::openSqlScript);
+    fileMenu->addAction(tr("Save SQL Script..."), this, &MainWindow::saveSqlScript);
+    fileMenu->addSeparator();
     fileMenu->addAction(tr("Exit"), this, &QWidget::close);
+
+    auto toolsMenu = menuBar()->addMenu(tr("Tools"));
+    toolsMenu->addAction(tr("Compare Tables..."), [this]() { compareTables(nullptr); });
+    toolsMenu->addAction(tr("Copy Table..."), [this]() { copyTable(nullptr); });
+    toolsMenu->addAction(tr("Dump Database..."), [this]() { dumpDatabase(nullptr); });
+    toolsMenu->addAction(tr("Activity Monitor..."), [this]() { showActivityMonitor(nullptr); });
+    toolsMenu->addAction(tr("Top Queries..."), [this]() { showTopQueries(nullptr); });
+    toolsMenu->addAction(tr("Open Table Profile..."), this, &MainWindow::openTableProfile);
+    toolsMenu->addAction(tr("Benchmark Statement..."), this, &MainWindow::benchmarkStatement);
+    toolsMenu->addAction(tr("Advise Indexes..."), this, &MainWindow::adviseIndexes);
+    toolsMenu->addSeparator();
+    toolsMenu->addAction(tr("Export Trace..."), this, &MainWindow::exportTrace);
 }
 
 void MainWindow::setupToolbar()
@@ -96,9 +213,80 @@ void MainWindow::setupToolbar()
 void MainWindow::setupStatusBar()
 {
     statusLabel = new QLabel(this);
+    memoryLabel = new QLabel(this);
     executionTimeLabel = new QLabel(this);
     statusBar()->addWidget(statusLabel);
+    statusBar()->addPermanentWidget(memoryLabel);
     statusBar()->addPermanentWidget(executionTimeLabel);
+
+    auto memoryTimer = new QTimer(this);
+    connect(memoryTimer, &QTimer::timeout, this, &MainWindow::updateMemoryStatus);
+    memoryTimer->start(MemoryStatusMs);
+    updateMemoryStatus();
+
+    metricsTimer = new QTimer(this);
+    connect(metricsTimer, &QTimer::timeout, this, &MainWindow::writeMetrics);
+    applyTraceSettings();
+}
+
+void MainWindow::applyTraceSettings()
+{
+    Tracer::Settings trace = Tracer::settings();
+    if (trace.enabled && !trace.metricsFile.isEmpty()) {
+        metricsTimer->start(qMax(1, trace.metricsIntervalSec) * 1000);
+        writeMetrics();
+    } else {
+        metricsTimer->stop();
+    }
+}
+
+void MainWindow::writeMetrics()
+{
+    QString error;
+    if (!Tracer::writePrometheus(Tracer::settings().metricsFile, &error)) {
+        // Once, rather than every interval.
+        metricsTimer->stop();
+        statusLabel->setText(tr("Metrics are no longer written: %1").arg(error));
+    }
+}
+
+void MainWindow::exportTrace()
+{
+    if (!Tracer::isEnabled()) {
+        QMessageBox::information(this, tr("Export Trace"),
+                                 tr("Tracing is off. Turn it on in the settings, repeat what you want to "
+                                    "look at, then export the trace."));
+        return;
+    }
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Export Trace"), "db_manager-trace.json",
+                                                    tr("Chrome trace files (*.json)"));
+    if (fileName.isEmpty()) return;
+
+    QString error;
+    if (!Tracer::writeChromeTrace(fileName, &error)) {
+        QMessageBox::critical(this, tr("Error"), tr("Failed to write file: %1").arg(error));
+        return;
+    }
+    statusLabel->setText(tr("Trace exported to %1").arg(fileName));
+}
+
+void MainWindow::updateMemoryStatus()
+{
+    QLocale locale;
+    ResultMemory::Settings memory = ResultMemory::settings();
+    QString text = tr("Results: %1 of %2").arg(locale.formattedDataSize(ResultMemory::resident()),
+                                              locale.formattedDataSize(memory.budgetBytes));
+    if (ResultMemory::spilled() > 0) {
+        text += tr(", %1 on disk").arg(locale.formattedDataSize(ResultMemory::spilled()));
+    }
+    QueryTab *tab = currentTab();
+    if (tab) {
+        text += tr(" | Tab: %1").arg(locale.formattedDataSize(tab->residentBytes()));
+        if (tab->spilledBytes() > 0) {
+            text += tr(", %1 on disk").arg(locale.formattedDataSize(tab->spilledBytes()));
+        }
+    }
+    memoryLabel->setText(text);
 }
 
 void MainWindow::loadServers()
@@ -117,6 +305,191 @@ void MainWindow::saveServers()
     settings.setValue("splitterState", mainSplitter->saveState());
 }
 
+void MainWindow::closeEvent(QCloseEvent *event)
+{
+    saveServers();
+    QString error;
+    if (!saveSession(&error)) {
+        auto answer = QMessageBox::warning(this, tr("Warning"),
+                                           tr("Failed to save the session: %1\n\nClose anyway? "
+                                              "Open tabs will not be restored.").arg(error),
+                                           QMessageBox::Yes | QMessageBox::No, QMessageBox::No);
+        if (answer != QMessageBox::Yes) {
+            event->ignore();
+            return;
+        }
+    }
+    QMainWindow::closeEvent(event);
+}
+
+bool MainWindow::saveSession(QString *error)
+{
+    SessionStore::Session session;
+    session.saved = QDateTime::currentDateTime();
+    session.currentTab = queryTabs->currentIndex();
+    for (int i = 0; i < queryTabs->count(); ++i) {
+        auto tab = qobject_cast<QueryTab *>(queryTabs->widget(i));
+        if (tab) {
+            session.tabs << tab->sessionState();
+        }
+    }
+    for (int i = 0; i < serversTree->topLevelItemCount(); ++i) {
+        QTreeWidgetItem *serverItem = serversTree->topLevelItem(i);
+        if (serverItem->childCount() == 0) continue;
+        SessionStore::Server server;
+        server.name = serverItem->text(0);
+        server.expanded = serverItem->isExpanded();
+        for (int j = 0; j < serverItem->childCount(); ++j) {
+            QTreeWidgetItem *dbItem = serverItem->child(j);
+            SessionStore::Database database;
+            database.name = dbItem->text(0);
+            database.expanded = dbItem->isExpanded();
+            for (int k = 0; k < dbItem->childCount(); ++k) {
+                database.tables << dbItem->child(k)->text(0);
+            }
+            server.databases << database;
+        }
+        session.servers << server;
+    }
+    session.selectedPath = treePath(serversTree->currentItem());
+
+    return SessionStore::save(session, error);
+}
+
+bool MainWindow::restoreSession()
+{
+    SessionStore::Session session;
+    QString error;
+    if (!SessionStore::load(&session, &error)) {
+        if (!error.isEmpty()) {
+            statusLabel->setText(tr("Session not restored: %1").arg(error));
+        }
+        return false;
+    }
+    if (session.tabs.isEmpty()) return false;
+
+    // Everything here is local: the tree and the results come from the
+    // saved session, and nothing connects until refreshRestoredSession().
+    QStringList servers = dbConnection.getSavedServers();
+    for (const SessionStore::Server &server : session.servers) {
+        QTreeWidgetItem *serverItem = treeItem({server.name});
+        if (!serverItem) continue;
+        fillServerItem(serverItem, server, true);
+        restoredServers << server;
+    }
+    for (const SessionStore::Tab &state : session.tabs) {
+        QueryTab *tab = newQueryTab();
+        if (!state.serverName.isEmpty() && servers.contains(state.serverName)
+            && !tab->isBoundTo(state.serverName, state.database)) {
+            bindTab(tab, state.serverName, state.database);
+        }
+        tab->restoreState(state, session.saved);
+    }
+    serversTree->setCurrentItem(treeItem(session.selectedPath));
+    queryTabs->setCurrentIndex(qBound(0, session.currentTab, queryTabs->count() - 1));
+    statusLabel->setText(tr("Session of %1 restored; refreshing tables in the background")
+                         .arg(QLocale().toString(session.saved, QLocale::ShortFormat)));
+
+    // After the window is shown.
+    QTimer::singleShot(0, this, &MainWindow::refreshRestoredSession);
+    return true;
+}
+
+void MainWindow::refreshRestoredSession()
+{
+    // Tabs browsing a table read it again on their own workers; query
+    // results stay as restored until they are run again.
+    for (int i = 0; i < queryTabs->count(); ++i) {
+        auto tab = qobject_cast<QueryTab *>(queryTabs->widget(i));
+        if (tab) {
+            tab->refreshResult();
+        }
+    }
+    if (restoredServers.isEmpty()) return;
+
+    QVector<SessionStore::Server> restored = restoredServers;
+    QStringList selectedPath = treePath(serversTree->currentItem());
+    auto watcher = new QFutureWatcher<TreeRefresh>(this);
+    connect(watcher, &QFutureWatcher<TreeRefresh>::finished, this, [this, watcher]() {
+        TreeRefresh refresh = watcher->result();
+        watcher->deleteLater();
+        restoredServers.clear();
+
+        QStringList selectedPath = treePath(serversTree->currentItem());
+        for (const SessionStore::Server &server : refresh.servers) {
+            QTreeWidgetItem *serverItem = treeItem({server.name});
+            if (serverItem) {
+                fillServerItem(serverItem, server, false);
+            }
+        }
+        for (auto it = refresh.errors.constBegin(); it != refresh.errors.constEnd(); ++it) {
+            QTreeWidgetItem *serverItem = treeItem({it.key()});
+            if (serverItem) {
+                serverItem->setIcon(0, QIcon::fromTheme("network-offline"));
+                serverItem->setToolTip(0, tr("Restored from the last session; reconnecting failed: %1").arg(it.value()));
+            }
+        }
+        serversTree->setCurrentItem(treeItem(selectedPath));
+        if (refresh.schemaLoaded) {
+            schemaIndex = refresh.schemaIndex;
+        }
+    });
+    watcher->setFuture(QtConcurrent::run([restored, selectedPath]() { return refreshTree(restored, selectedPath); }));
+}
+
+void MainWindow::fillServerItem(QTreeWidgetItem *serverItem, const SessionStore::Server &server, bool stale)
+{
+    // Restored items are grey until the server was read again.
+    QBrush foreground = stale ? QBrush(Qt::gray) : QBrush();
+    QString toolTip = stale ? tr("Restored from the last session") : QString();
+    qDeleteAll(serverItem->takeChildren());
+    for (const SessionStore::Database &database : server.databases) {
+        auto dbItem = new QTreeWidgetItem(serverItem);
+        dbItem->setText(0, database.name);
+        dbItem->setIcon(0, QIcon::fromTheme("folder-database"));
+        dbItem->setForeground(0, foreground);
+        dbItem->setToolTip(0, toolTip);
+        for (const QString &table : database.tables) {
+            auto tableItem = new QTreeWidgetItem(dbItem);
+            tableItem->setText(0, table);
+            tableItem->setIcon(0, QIcon::fromTheme("text-x-generic"));
+            tableItem->setForeground(0, foreground);
+        }
+        dbItem->setExpanded(database.expanded);
+    }
+    serverItem->setIcon(0, QIcon::fromTheme("network-server"));
+    serverItem->setForeground(0, foreground);
+    serverItem->setToolTip(0, toolTip);
+    serverItem->setExpanded(server.expanded);
+}
+
+QStringList MainWindow::treePath(QTreeWidgetItem *item) const
+{
+    QStringList path;
+    for (; item; item = item->parent()) {
+        path.prepend(item->text(0));
+    }
+    return path;
+}
+
+QTreeWidgetItem *MainWindow::treeItem(const QStringList &path) const
+{
+    QTreeWidgetItem *found = nullptr;
+    for (const QString &name : path) {
+        QTreeWidgetItem *next = nullptr;
+        int count = found ? found->childCount() : serversTree->topLevelItemCount();
+        for (int i = 0; i < count && !next; ++i) {
+            QTreeWidgetItem *child = found ? found->child(i) : serversTree->topLevelItem(i);
+            if (child->text(0) == name) {
+                next = child;
+            }
+        }
+        if (!next) break;
+        found = next;
+    }
+    return found;
+}
+
 void MainWindow::addServer()
 {
     ServersDialog dialog(this);
@@ -177,12 +550,10 @@ void MainWindow::connectToServer(QTreeWidgetItem *item)
     }
     
     if (dbConnection.connect(params)) {
+        connectedServer = serverName;
         updateServerStatus(item, true);
         
         item->takeChildren();
-        dataTable->clear();
-        dataTable->setRowCount(0);
-        dataTable->setColumnCount(0);
         
         QStringList databases = dbConnection.getDatabases();
         for (const QString &dbName : databases) {
@@ -192,7 +563,9 @@ void MainWindow::connectToServer(QTreeWidgetItem *item)
         }
         
         item->setExpanded(true);
+        reloadSchemaIndex();
     } else {
+        connectedServer.clear();
         updateServerStatus(item, false);
         QMessageBox::critical(this, tr("Error"),
                             tr("Failed to connect to server: %1")
@@ -200,10 +573,35 @@ void MainWindow::connectToServer(QTreeWidgetItem *item)
     }
 }
 
+bool MainWindow::ensureServerConnection(QTreeWidgetItem *serverItem)
+{
+    // Databases of a server restored from the session, or of another server
+    // than the one connected, are opened without rebuilding the tree.
+    QString serverName = serverItem->text(0);
+    if (connectedServer == serverName && dbConnection.isConnected()) return true;
+
+    if (dbConnection.isConnected()) {
+        dbConnection.disconnect();
+    }
+    if (!dbConnection.connect(dbConnection.loadConnectionSettings(serverName))) {
+        connectedServer.clear();
+        updateServerStatus(serverItem, false);
+        QMessageBox::critical(this, tr("Error"),
+                            tr("Failed to connect to server: %1")
+                            .arg(dbConnection.lastError().text()));
+        return false;
+    }
+    connectedServer = serverName;
+    updateServerStatus(serverItem, true);
+    return true;
+}
+
 void MainWindow::updateServerStatus(QTreeWidgetItem *serverItem, bool connected)
 {
     if (connected) {
         serverItem->setIcon(0, QIcon::fromTheme("network-server"));
+        serverItem->setForeground(0, QBrush());
+        serverItem->setToolTip(0, QString());
         statusLabel->setText(tr("Connected to %1").arg(serverItem->text(0)));
     } else {
         serverItem->setIcon(0, QIcon::fromTheme("network-offline"));
@@ -211,44 +609,166 @@ void MainWindow::updateServerStatus(QTreeWidgetItem *serverItem, bool connected)
     }
 }
 
-void MainWindow::executeQuery()
+QueryTab *MainWindow::currentTab() const
+{
+    return qobject_cast<QueryTab *>(queryTabs->currentWidget());
+}
+
+QueryTab *MainWindow::newQueryTab()
+{
+    auto tab = new QueryTab(queryTabs, &schemaIndex);
+    QTableWidget *grid = tab->grid();
+    grid->addAction(copyAction);
+    connect(grid, &QTableWidget::customContextMenuRequested, [this, tab, grid](const QPoint &pos) {
+        // The shared actions, then the foreign keys of the row under the pointer.
+        QMenu menu;
+        menu.addActions(tableContextMenu->actions());
+        tab->addReferenceActions(&menu);
+        menu.exec(grid->mapToGlobal(pos));
+    });
+    QTableView *spooledView = tab->spooledView();
+    spooledView->addAction(copyAction);
+    connect(spooledView, &QTableView::customContextMenuRequested, [this, spooledView](const QPoint &pos) {
+        tableContextMenu->exec(spooledView->viewport()->mapToGlobal(pos));
+    });
+    connect(tab, &QueryTab::bindingNeeded, this, &MainWindow::bindToCurrentDatabase);
+    connect(tab, &QueryTab::statusChanged, this, &MainWindow::showTabStatus);
+    connect(tab, &QueryTab::stateChanged, this, &MainWindow::updateTabTitle);
+    connect(tab, &QueryTab::schemaChanged, this, &MainWindow::reloadSchemaIndex);
+
+    // New tabs start on the database selected in the tree.
+    bindToCurrentDatabase(tab);
+    queryTabs->setCurrentIndex(queryTabs->addTab(tab, tab->title()));
+    updateTabTitle(tab);
+    tab->editor()->setFocus();
+    return tab;
+}
+
+void MainWindow::closeQueryTab(int index)
 {
-    QString query = queryEdit->toPlainText().trimmed();
-    if (query.isEmpty()) {
-        QMessageBox::warning(this, tr("Warning"), tr("Enter SQL query"));
+    auto tab = qobject_cast<QueryTab *>(queryTabs->widget(index));
+    if (!tab) return;
+
+    if (tab->isBusy() &&
+        QMessageBox::question(this, tr("Close Tab"), tr("A statement is still running in %1. Cancel it?")
+                              .arg(tab->title())) != QMessageBox::Yes) {
         return;
     }
+    if (tab->inTransaction() &&
+        QMessageBox::question(this, tr("Close Tab"), tr("Roll back the open transaction in %1?")
+                              .arg(tab->title())) != QMessageBox::Yes) {
+        return;
+    }
+    if (queryTabs->count() == 1) {
+        newQueryTab();
+    }
+    queryTabs->removeTab(queryTabs->indexOf(tab));
+    // The destructor cancels a running statement and waits for the worker.
+    tab->deleteLater();
+}
 
-    QSqlQuery result;
-    if (dbConnection.executeQuery(query, result)) {
-        dataTable->clear();
-        dataTable->setRowCount(0);
-        
-        QStringList headers;
-        QSqlRecord record = result.record();
-        int columnCount = record.count();
-        for (int i = 0; i < columnCount; ++i) {
-            headers << record.fieldName(i);
+void MainWindow::bindToCurrentDatabase(QueryTab *tab)
+{
+    QString serverName;
+    QString database;
+    auto item = serversTree->currentItem();
+    if (item && item->parent()) {
+        QTreeWidgetItem *dbItem = item->parent()->parent() ? item->parent() : item;
+        serverName = dbItem->parent()->text(0);
+        database = dbItem->text(0);
+    } else if (!connectedServer.isEmpty() && dbConnection.isConnected()) {
+        serverName = connectedServer;
+        database = dbConnection.connectionParams().dbName;
+    }
+    if (!serverName.isEmpty()) {
+        bindTab(tab, serverName, database);
+    }
+}
+
+void MainWindow::bindTab(QueryTab *tab, const QString &serverName, const QString &database)
+{
+    DatabaseConnection::ConnectionParams params = dbConnection.loadConnectionSettings(serverName);
+    params.dbName = database;
+    tab->bind(serverName, params);
+}
+
+QueryTab *MainWindow::tabFor(const QString &serverName, const QString &database)
+{
+    // The current tab if it can take the request, then another idle tab on
+    // the same database, then a new one.
+    QueryTab *tab = currentTab();
+    if (tab && !tab->isBusy() && (tab->isBoundTo(serverName, database) || !tab->isBound())) {
+        if (!tab->isBound()) {
+            bindTab(tab, serverName, database);
         }
-        dataTable->setColumnCount(columnCount);
-        dataTable->setHorizontalHeaderLabels(headers);
-
-        while (result.next()) {
-            int row = dataTable->rowCount();
-            dataTable->insertRow(row);
-            for (int col = 0; col < columnCount; ++col) {
-                auto item = new QTableWidgetItem(result.value(col).toString());
-                dataTable->setItem(row, col, item);
-            }
+        return tab;
+    }
+    for (int i = 0; i < queryTabs->count(); ++i) {
+        auto other = qobject_cast<QueryTab *>(queryTabs->widget(i));
+        if (other && !other->isBusy() && other->isBoundTo(serverName, database)) {
+            queryTabs->setCurrentIndex(i);
+            return other;
         }
+    }
+    tab = newQueryTab();
+    if (!tab->isBoundTo(serverName, database)) {
+        bindTab(tab, serverName, database);
+    }
+    return tab;
+}
 
-        statusLabel->setText(tr("Query executed successfully"));
-        executionTimeLabel->setText(dbConnection.getLastExecutionTime());
-    } else {
-        QMessageBox::critical(this, tr("Error"),
-                            tr("Query execution error: %1")
-                            .arg(dbConnection.lastError().text()));
+void MainWindow::updateTabTitle(QueryTab *tab)
+{
+    int index = queryTabs->indexOf(tab);
+    if (index < 0) return;
+    QString title = tab->title();
+    if (tab->inTransaction()) {
+        title += " *";
+    }
+    if (tab->isBusy()) {
+        title += QString::fromUtf8(" \u2026");
     }
+    queryTabs->setTabText(index, title);
+    queryTabs->setTabToolTip(index, tab->isBusy() ? tr("%1 (running)").arg(tab->title()) : tab->title());
+}
+
+void MainWindow::showTabStatus(QueryTab *tab)
+{
+    if (!tab || tab != currentTab()) return;
+    statusLabel->setText(tab->status());
+    executionTimeLabel->setText(tab->executionTime());
+    updateMemoryStatus();
+}
+
+void MainWindow::openSqlScript()
+{
+    SqlEditor *queryEdit = currentTab()->editor();
+    if (queryEdit->isLoading()) return;
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Open SQL Script"), QString(),
+                                                    tr("SQL files (*.sql);;All files (*)"));
+    if (fileName.isEmpty()) return;
+
+    QString error;
+    if (!queryEdit->openFile(fileName, &error)) {
+        QMessageBox::critical(this, tr("Error"), tr("Cannot open %1: %2").arg(fileName, error));
+    }
+}
+
+void MainWindow::saveSqlScript()
+{
+    SqlEditor *queryEdit = currentTab()->editor();
+    if (queryEdit->isLoading()) return;
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Save SQL Script"), QString(),
+                                                    tr("SQL files (*.sql);;All files (*)"));
+    if (fileName.isEmpty()) return;
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        QMessageBox::critical(this, tr("Error"), tr("Cannot save %1: %2").arg(fileName, file.errorString()));
+        return;
+    }
+    file.write(queryEdit->toPlainText().toUtf8());
+    statusLabel->setText(tr("Script saved to %1").arg(fileName));
 }
 
 void MainWindow::loadDatabaseTables(QTreeWidgetItem *dbItem)
@@ -256,8 +776,9 @@ void MainWindow::loadDatabaseTables(QTreeWidgetItem *dbItem)
     if (!dbItem || !dbItem->parent()) return;
     
     QString dbName = dbItem->text(0);
+    if (!ensureServerConnection(dbItem->parent())) return;
     if (dbConnection.changeDatabase(dbName)) {
-        dbItem->takeChildren();
+        qDeleteAll(dbItem->takeChildren());
         
         QStringList tables = dbConnection.tables();
         for (const QString &table : tables) {
@@ -265,7 +786,11 @@ void MainWindow::loadDatabaseTables(QTreeWidgetItem *dbItem)
             tableItem->setText(0, table);
             tableItem->setIcon(0, QIcon::fromTheme("text-x-generic"));
         }
+        loadTableStatistics(dbItem);
+        reloadSchemaIndex();
         
+        dbItem->setForeground(0, QBrush());
+        dbItem->setToolTip(0, QString());
         dbItem->setExpanded(true);
         statusLabel->setText(tr("Data loaded"));
     } else {
@@ -278,57 +803,288 @@ void MainWindow::loadDatabaseTables(QTreeWidgetItem *dbItem)
 void MainWindow::showTableData(QTreeWidgetItem *item)
 {
     if (!item || !item->parent() || !item->parent()->parent()) return;
-    
+
+    QTreeWidgetItem *dbItem = item->parent();
+    tabFor(dbItem->parent()->text(0), dbItem->text(0))->openTable(item->text(0));
+}
+
+void MainWindow::sampleTableData(QTreeWidgetItem *item)
+{
+    if (!item || !item->parent() || !item->parent()->parent()) return;
+
     QString tableName = item->text(0);
-    QString query;
-    
-    if (dbConnection.database().driverName() == "QPSQL") {
-        query = QString("SELECT * FROM \"%1\"").arg(tableName);
-    } else {
-        query = QString("SELECT * FROM `%1`").arg(tableName);
+    QTreeWidgetItem *dbItem = item->parent();
+    QString serverName = dbItem->parent()->text(0);
+    bool postgres = dbConnection.loadConnectionSettings(serverName).driver == "QPSQL";
+    SampleDialog dialog(this, tableName, postgres);
+    if (dialog.exec() != QDialog::Accepted) return;
+
+    tabFor(serverName, dbItem->text(0))->sampleTable(tableName, dialog.getOptions());
+}
+
+void MainWindow::compareTables(QTreeWidgetItem *item)
+{
+    QString serverName;
+    QString database;
+    QString table;
+    if (item && item->parent() && item->parent()->parent()) {
+        table = item->text(0);
+        database = item->parent()->text(0);
+        serverName = item->parent()->parent()->text(0);
     }
-    
-    QSqlQuery result;
-    if (dbConnection.executeQuery(query, result)) {
-        dataTable->setUpdatesEnabled(false);
-        
-        dataTable->clear();
-        dataTable->setRowCount(0);
-        
-        QStringList headers;
-        QSqlRecord record = result.record();
-        int columnCount = record.count();
-        for (int i = 0; i < columnCount; ++i) {
-            headers << record.fieldName(i);
+    CompareTablesDialog dialog(this, serverName, database, table);
+    dialog.exec();
+}
+
+void MainWindow::copyTable(QTreeWidgetItem *item)
+{
+    QString serverName;
+    QString database;
+    QString table;
+    if (item && item->parent() && item->parent()->parent()) {
+        table = item->text(0);
+        database = item->parent()->text(0);
+        serverName = item->parent()->parent()->text(0);
+    }
+    CopyTableDialog dialog(this, serverName, database, table);
+    dialog.exec();
+}
+
+void MainWindow::dumpDatabase(QTreeWidgetItem *dbItem)
+{
+    QString serverName;
+    QString database;
+    if (dbItem && dbItem->parent()) {
+        database = dbItem->text(0);
+        serverName = dbItem->parent()->text(0);
+    }
+    DumpDatabaseDialog dialog(this, serverName, database);
+    dialog.exec();
+}
+
+QString MainWindow::serverForTool(QTreeWidgetItem *item, const QString &title)
+{
+    while (item && item->parent()) {
+        item = item->parent();
+    }
+    if (item) {
+        return item->text(0);
+    }
+    QStringList servers = dbConnection.getSavedServers();
+    if (servers.isEmpty()) return QString();
+    bool ok = false;
+    QString serverName = QInputDialog::getItem(this, title, tr("Server:"), servers, 0, false, &ok);
+    return ok ? serverName : QString();
+}
+
+void MainWindow::showActivityMonitor(QTreeWidgetItem *item)
+{
+    QString serverName = serverForTool(item, tr("Activity Monitor"));
+    if (serverName.isEmpty()) return;
+
+    DatabaseConnection::ConnectionParams params = dbConnection.loadConnectionSettings(serverName);
+    // A monitor query stuck behind a lock must not hang the next refresh.
+    params.statementTimeout = 10;
+    auto dialog = new ActivityMonitorDialog(this, serverName, params);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    dialog->show();
+}
+
+void MainWindow::showTopQueries(QTreeWidgetItem *item)
+{
+    QString serverName = serverForTool(item, tr("Top Queries"));
+    if (serverName.isEmpty()) return;
+
+    DatabaseConnection::ConnectionParams params = dbConnection.loadConnectionSettings(serverName);
+    params.statementTimeout = 30;
+    auto dialog = new TopQueriesDialog(this, serverName, params);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    connect(dialog, &TopQueriesDialog::openStatement, this, &MainWindow::openStatement);
+    dialog->show();
+}
+
+void MainWindow::profileTable(QTreeWidgetItem *item)
+{
+    if (!item || !item->parent() || !item->parent()->parent()) return;
+
+    QTreeWidgetItem *dbItem = item->parent();
+    QString serverName = dbItem->parent()->text(0);
+    DatabaseConnection::ConnectionParams params = dbConnection.loadConnectionSettings(serverName);
+    params.dbName = dbItem->text(0);
+    auto dialog = new ProfileTableDialog(this, serverName, params, item->text(0));
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    dialog->show();
+}
+
+void MainWindow::openTableProfile()
+{
+    QString path = QFileDialog::getOpenFileName(this, tr("Open Profile Report"), TableProfiler::reportsDirectory(),
+                                                tr("Profile reports (*.json)"));
+    if (path.isEmpty()) return;
+
+    auto dialog = new ProfileTableDialog(this);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    dialog->openReport(path);
+    dialog->show();
+}
+
+// The current tab, bound to the selected database if it was not, and the
+// selection in its editor, or else the statement under the cursor.
+QueryTab *MainWindow::statementTab(const QString &purpose, QString *sql)
+{
+    QueryTab *tab = currentTab();
+    if (!tab) return nullptr;
+    if (!tab->isBound()) {
+        bindToCurrentDatabase(tab);
+    }
+    if (!tab->isBound()) {
+        QMessageBox::warning(this, tr("Warning"), tr("Select a database to %1 on").arg(purpose));
+        return nullptr;
+    }
+
+    SqlEditor *queryEdit = tab->editor();
+    *sql = queryEdit->textCursor().selectedText().replace(QChar::ParagraphSeparator, '\n').trimmed();
+    if (sql->isEmpty()) {
+        *sql = queryEdit->statementUnderCursor();
+    }
+    return tab;
+}
+
+void MainWindow::benchmarkStatement()
+{
+    QString sql;
+    QueryTab *tab = statementTab(tr("benchmark"), &sql);
+    if (!tab) return;
+    auto dialog = new BenchmarkDialog(this, tab->serverName(), tab->connectionParams(), sql);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    dialog->show();
+}
+
+void MainWindow::adviseIndexes()
+{
+    QString sql;
+    QueryTab *tab = statementTab(tr("advise indexes"), &sql);
+    if (!tab) return;
+    auto dialog = new IndexAdvisorDialog(this, tab->serverName(), tab->connectionParams(), sql);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    connect(dialog, &IndexAdvisorDialog::openStatement, this, &MainWindow::openStatement);
+    dialog->show();
+}
+
+void MainWindow::openStatement(const QString &sql)
+{
+    SqlEditor *queryEdit = currentTab()->editor();
+    QTextCursor cursor = queryEdit->textCursor();
+    cursor.movePosition(QTextCursor::End);
+    if (!queryEdit->document()->isEmpty()) {
+        cursor.insertText("\n\n");
+    }
+    cursor.insertText(sql);
+    queryEdit->setTextCursor(cursor);
+    queryEdit->ensureCursorVisible();
+    activateWindow();
+    queryEdit->setFocus();
+}
+
+void MainWindow::reloadSchemaIndex()
+{
+    // The catalog scan runs on a connection of its own; only the latest
+    // request replaces the index.
+    DatabaseConnection::ConnectionParams params = dbConnection.connectionParams();
+    int generation = ++schemaGeneration;
+    auto watcher = new QFutureWatcher<SchemaLoad>(this);
+    connect(watcher, &QFutureWatcher<SchemaLoad>::finished, this, [this, watcher, generation]() {
+        SchemaLoad load = watcher->result();
+        watcher->deleteLater();
+        if (generation != schemaGeneration) return;
+        if (!load.ok) {
+            statusLabel->setText(tr("Completion index not loaded: %1").arg(load.error));
+            return;
         }
-        dataTable->setColumnCount(columnCount);
-        dataTable->setHorizontalHeaderLabels(headers);
+        schemaIndex = load.schemaIndex;
+    });
+    watcher->setFuture(QtConcurrent::run([params]() {
+        SchemaLoad load;
+        DatabaseConnection connection;
+        if (!connection.connect(params)) {
+            load.error = connection.lastError().text();
+            return load;
+        }
+        load.ok = load.schemaIndex.load(connection, &load.error);
+        connection.disconnect();
+        return load;
+    }));
+}
 
-        result.last();
-        int totalRows = result.at() + 1;
-        result.first();
-        result.previous();
-        
-        dataTable->setRowCount(totalRows);
+QString MainWindow::databaseKey(QTreeWidgetItem *dbItem) const
+{
+    return dbItem->parent()->text(0) + "/" + dbItem->text(0);
+}
+
+void MainWindow::loadTableStatistics(QTreeWidgetItem *dbItem)
+{
+    if (!dbItem || !dbItem->parent()) return;
+
+    // The connection follows the last expanded database.
+    if (dbConnection.connectionParams().dbName != dbItem->text(0)) {
+        statsPanel->showMessage(tr("Open %1 to load its statistics").arg(dbItem->text(0)));
+        return;
+    }
+
+    QString error;
+    tableStatsDatabase = databaseKey(dbItem);
+    if (!TableStatistics::load(dbConnection, &tableStats, &error)) {
+        statsPanel->showMessage(tr("Statistics unavailable: %1").arg(error));
+        return;
+    }
 
-        int row = 0;
-        while (result.next()) {
-            for (int col = 0; col < columnCount; ++col) {
-                auto item = new QTableWidgetItem(result.value(col).toString());
-                dataTable->setItem(row, col, item);
+    for (int i = 0; i < dbItem->childCount(); ++i) {
+        QTreeWidgetItem *tableItem = dbItem->child(i);
+        auto it = tableStats.constFind(tableItem->text(0));
+        if (it == tableStats.constEnd()) continue;
+        tableItem->setText(1, TableStatistics::formatBytes(it->totalBytes()));
+        tableItem->setTextAlignment(1, Qt::AlignRight | Qt::AlignVCenter);
+        tableItem->setToolTip(0, tr("~%1 rows").arg(QLocale().toString(it->estimatedRows)));
+    }
+    onTreeSelectionChanged(serversTree->currentItem());
+}
+
+void MainWindow::refreshTableStatistics()
+{
+    auto item = serversTree->currentItem();
+    if (item && item->parent() && item->parent()->parent()) {
+        loadTableStatistics(item->parent());
+    }
+}
+
+void MainWindow::sortDatabaseTables(QTreeWidgetItem *dbItem, bool bySize)
+{
+    QList<QTreeWidgetItem *> children = dbItem->takeChildren();
+    bool haveStats = tableStatsDatabase == databaseKey(dbItem);
+    std::stable_sort(children.begin(), children.end(),
+        [this, bySize, haveStats](QTreeWidgetItem *a, QTreeWidgetItem *b) {
+            if (bySize && haveStats) {
+                qint64 sizeA = tableStats.value(a->text(0)).totalBytes();
+                qint64 sizeB = tableStats.value(b->text(0)).totalBytes();
+                if (sizeA != sizeB) return sizeA > sizeB;
             }
-            row++;
-        }
+            return a->text(0).localeAwareCompare(b->text(0)) < 0;
+        });
+    dbItem->addChildren(children);
+}
 
-        dataTable->setUpdatesEnabled(true);
-        dataTable->viewport()->update();
-        statusLabel->setText(tr("Data loaded"));
-        executionTimeLabel->setText(dbConnection.getLastExecutionTime());
-    } else {
-        QMessageBox::critical(this, tr("Error"),
-                            tr("Failed to load data: %1")
-                            .arg(dbConnection.lastError().text()));
+void MainWindow::onTreeSelectionChanged(QTreeWidgetItem *current)
+{
+    if (!current || !current->parent() || !current->parent()->parent()) {
+        statsPanel->showMessage(tr("Select a table to see its statistics"));
+        return;
     }
+    auto it = tableStats.constFind(current->text(0));
+    if (tableStatsDatabase != databaseKey(current->parent()) || it == tableStats.constEnd()) {
+        statsPanel->showMessage(tr("No statistics for %1").arg(current->text(0)));
+        return;
+    }
+    statsPanel->showTable(*it);
 }
 
 void MainWindow::showContextMenu(const QPoint &pos)
@@ -341,229 +1097,194 @@ void MainWindow::showContextMenu(const QPoint &pos)
         menu.addAction(tr("Connect"), [this, item]() { connectToServer(item); });
         menu.addAction(tr("Edit"), this, &MainWindow::editServer);
         menu.addAction(tr("Delete"), this, &MainWindow::removeServer);
+        menu.addSeparator();
+        menu.addAction(tr("Activity Monitor..."), [this, item]() { showActivityMonitor(item); });
+        menu.addAction(tr("Top Queries..."), [this, item]() { showTopQueries(item); });
+    } else if (!item->parent()->parent()) {
+        if (item->childCount() > 0) {
+            menu.addAction(tr("Sort Tables by Name"), [this, item]() { sortDatabaseTables(item, false); });
+            menu.addAction(tr("Sort Tables by Size"), [this, item]() { sortDatabaseTables(item, true); });
+            menu.addAction(tr("Refresh Statistics"), [this, item]() { loadTableStatistics(item); });
+            menu.addSeparator();
+        }
+        menu.addAction(tr("Dump Database..."), [this, item]() { dumpDatabase(item); });
+    } else {
+        menu.addAction(tr("Open"), [this, item]() { showTableData(item); });
+        menu.addAction(tr("Sample..."), [this, item]() { sampleTableData(item); });
+        menu.addAction(tr("Profile..."), [this, item]() { profileTable(item); });
+        menu.addAction(tr("Compare With..."), [this, item]() { compareTables(item); });
+        menu.addAction(tr("Copy To..."), [this, item]() { copyTable(item); });
     }
+    if (menu.isEmpty()) return;
     menu.exec(serversTree->mapToGlobal(pos));
 }
 
 void MainWindow::showSettings()
 {
     SettingsDialog dialog(this);
-    dialog.exec();
+    if (dialog.exec() == QDialog::Accepted) {
+        ResultMemory::reload();
+        updateMemoryStatus();
+        Tracer::reload();
+        applyTraceSettings();
+    }
 }
 
 void MainWindow::copySelectedCells()
 {
-    if (dataTable->selectedRanges().isEmpty()) return;
-    
-    QString text;
-    QTableWidgetSelectionRange range = dataTable->selectedRanges().at(0);
-    
-    for (int i = range.topRow(); i <= range.bottomRow(); ++i) {
-        for (int j = range.leftColumn(); j <= range.rightColumn(); ++j) {
-            if (j > range.leftColumn()) text += "\t";
-            text += dataTable->item(i, j)->text();
-        }
-        text += "\n";
-    }
-    
-    QApplication::clipboard()->setText(text);
+    copySelection(ClipboardFormatter::Tsv);
 }
 
-void MainWindow::exportToFile()
+void MainWindow::copySelection(ClipboardFormatter::Format format)
 {
-    QString fileName = QFileDialog::getSaveFileName(this, tr("Export Data"),
-                                                  QString(), tr("CSV files (*.csv)"));
-    if (fileName.isEmpty()) return;
+    QueryTab *tab = currentTab();
+    QTableWidget *dataTable = tab->grid();
+    if (!tab->spooledResult() && dataTable->selectedRanges().isEmpty()) return;
 
-    QFile file(fileName);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        QMessageBox::critical(this, tr("Error"), tr("Failed to open file for writing"));
-        return;
+    QChar quote = tab->connectionParams().driver == "QMYSQL" ? QChar('`') : QChar('"');
+    QString tableName = tab->tableName().isEmpty() ? getCurrentTableName() : tab->tableName();
+    ClipboardFormatter::Snapshot snapshot;
+    if (tab->spooledResult()) {
+        QString error;
+        snapshot = tab->captureSpooledSelection(tableName, quote, &error);
+        if (!error.isEmpty()) {
+            statusLabel->setText(error);
+            return;
+        }
+        if (snapshot.cellCount() == 0) return;
+    } else {
+        snapshot = ClipboardFormatter::capture(dataTable, tableName, quote);
     }
+    int cellCount = snapshot.cellCount();
 
-    QTextStream stream(&file);
-    
-    for (int i = 0; i < dataTable->columnCount(); ++i) {
-        if (i > 0) stream << ",";
-        stream << "\"" << dataTable->horizontalHeaderItem(i)->text() << "\"";
-    }
-    stream << "\n";
-
-    for (int row = 0; row < dataTable->rowCount(); ++row) {
-        for (int col = 0; col < dataTable->columnCount(); ++col) {
-            if (col > 0) stream << ",";
-            QString value = dataTable->item(row, col)->text();
-            value.replace("\"", "\"\"");
-            stream << "\"" << value << "\"";
-        }
-        stream << "\n";
+    if (cellCount < BackgroundCopyCells) {
+        QApplication::clipboard()->setText(ClipboardFormatter::format(snapshot, format));
+        statusLabel->setText(tr("Copied %1 cells as %2").arg(cellCount).arg(ClipboardFormatter::formatName(format)));
+        return;
     }
 
-    file.close();
-    statusLabel->setText(tr("Data exported to %1").arg(fileName));
-}
+    // Large selections are formatted in a worker; the snapshot owns shared
+    // copies of the cell strings, so the grid can change in the meantime.
+    QSharedPointer<QAtomicInt> rowsDone(new QAtomicInt(0));
+    QSharedPointer<QAtomicInt> canceled(new QAtomicInt(0));
 
-QString MainWindow::getCurrentTableName() const
-{
-    auto item = serversTree->currentItem();
-    if (!item || !item->parent()) return QString();
-    return item->text(0);
+    auto progress = new QProgressDialog(tr("Copying %1 cells...").arg(cellCount), tr("Cancel"),
+                                        0, snapshot.rowCount, this);
+    progress->setMinimumDuration(300);
+    progress->setAutoClose(false);
+    progress->setAutoReset(false);
+    auto progressTimer = new QTimer(progress);
+    connect(progressTimer, &QTimer::timeout, progress,
+            [progress, rowsDone]() { progress->setValue(rowsDone->loadRelaxed()); });
+    progressTimer->start(100);
+    connect(progress, &QProgressDialog::canceled, progress,
+            [canceled]() { canceled->storeRelaxed(1); });
+
+    auto watcher = new QFutureWatcher<QString>(this);
+    connect(watcher, &QFutureWatcher<QString>::finished, this,
+            [this, watcher, progress, canceled, cellCount, format]() {
+        if (!canceled->loadRelaxed()) {
+            QApplication::clipboard()->setText(watcher->result());
+            statusLabel->setText(tr("Copied %1 cells as %2").arg(cellCount).arg(ClipboardFormatter::formatName(format)));
+        } else {
+            statusLabel->setText(tr("Copy canceled"));
+        }
+        progress->deleteLater();
+        watcher->deleteLater();
+    });
+    watcher->setFuture(QtConcurrent::run([snapshot, format, rowsDone, canceled]() {
+        return ClipboardFormatter::format(snapshot, format, rowsDone.data(), canceled.data());
+    }));
 }
 
-void MainWindow::onCellChanged(int row, int column)
+void MainWindow::exportToFile()
 {
-    dataTable->blockSignals(true);
-    
-    QString tableName = getCurrentTableName();
-    if (tableName.isEmpty()) {
-        dataTable->blockSignals(false);
-        return;
+    QString selectedFilter;
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Export Data"), QString(),
+                                                  tr("CSV files (*.csv);;TSV files (*.tsv);;JSON files (*.json)"),
+                                                  &selectedFilter);
+    if (fileName.isEmpty()) return;
+
+    ResultExporter::Format format = ResultExporter::Csv;
+    if (selectedFilter.contains("*.tsv")) {
+        format = ResultExporter::Tsv;
+    } else if (selectedFilter.contains("*.json")) {
+        format = ResultExporter::Json;
     }
-    
-    QTableWidgetItem *item = dataTable->item(row, column);
-    if (!item) {
-        dataTable->blockSignals(false);
+
+    QSharedPointer<ResultStore> spooled = currentTab()->spooledResult();
+    if (spooled) {
+        exportSpooled(spooled, fileName, format);
         return;
     }
-    
-    QString oldValue = item->data(Qt::UserRole).toString();
-    if (oldValue.isEmpty()) {
-        oldValue = item->text();
-    }
-    
-    QStringList columnNames;
-    for (int i = 0; i < dataTable->columnCount(); ++i) {
-        QString headerText = dataTable->horizontalHeaderItem(i)->text();
-        headerText.remove(" ▲").remove(" ▼");
-        columnNames << headerText;
-    }
-    
-    QString whereClause;
-    QString quotedFormat = dbConnection.database().driverName() == "QPSQL" ? "\"%1\" = '%2'" : "`%1` = '%2'";
-    
-    QMap<QString, QString> rowValues;
-    for (int i = 0; i < dataTable->columnCount(); ++i) {
-        QTableWidgetItem *rowItem = dataTable->item(row, i);
-        if (!rowItem) continue;
-        
-        QString value = (i == column) ? oldValue : rowItem->text();
-        rowValues[columnNames[i]] = value;
-        
-        if (!whereClause.isEmpty()) whereClause += " AND ";
-        whereClause += quotedFormat
-            .arg(columnNames[i])
-            .arg(value.replace("'", "''"));
-    }
-    
-    QString updateQuery;
-    if (dbConnection.database().driverName() == "QPSQL") {
-        updateQuery = QString("UPDATE \"%1\" SET \"%2\" = '%3' WHERE %4")
-            .arg(tableName)
-            .arg(columnNames[column])
-            .arg(item->text().replace("'", "''"))
-            .arg(whereClause);
-    } else {
-        updateQuery = QString("UPDATE `%1` SET `%2` = '%3' WHERE %4")
-            .arg(tableName)
-            .arg(columnNames[column])
-            .arg(item->text().replace("'", "''"))
-            .arg(whereClause);
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        QMessageBox::critical(this, tr("Error"), tr("Failed to open file for writing"));
+        return;
     }
-    
-    qDebug() << "Executing query:" << updateQuery;
-    
-    QSqlQuery result;
-    if (!dbConnection.executeQuery(updateQuery, result)) {
+
+    QString errorMessage;
+    if (!TableUtils::exportTable(currentTab()->grid(), &file, format, &errorMessage)) {
         QMessageBox::critical(this, tr("Error"),
-                            tr("Failed to update data: %1")
-                            .arg(dbConnection.lastError().text()));
-        item->setText(oldValue);
-    } else {
-        item->setData(Qt::UserRole, item->text());
-        statusLabel->setText(tr("Data successfully updated"));
+                            tr("Failed to write file: %1").arg(errorMessage));
+        return;
     }
-    
-    dataTable->blockSignals(false);
-}
 
-void MainWindow::onHeaderClicked(int logicalIndex)
-{
-    static Qt::SortOrder currentOrder = Qt::AscendingOrder;
-    static int lastColumn = -1;
-    
-    if (lastColumn == logicalIndex) {
-        currentOrder = (currentOrder == Qt::AscendingOrder) ? Qt::DescendingOrder : Qt::AscendingOrder;
-    } else {
-        currentOrder = Qt::AscendingOrder;
-        lastColumn = logicalIndex;
-    }
-    
-    sortTable(logicalIndex, currentOrder);
+    file.close();
+    statusLabel->setText(tr("Data exported to %1").arg(fileName));
 }
 
-void MainWindow::sortTable(int column, Qt::SortOrder order)
+void MainWindow::exportSpooled(const QSharedPointer<ResultStore> &store, const QString &fileName,
+                               ResultExporter::Format format)
 {
-    dataTable->setUpdatesEnabled(false);
-    
-    int rowCount = dataTable->rowCount();
-    int colCount = dataTable->columnCount();
-    
-    QVector<QPair<QStringList, int>> data;
-    data.reserve(rowCount);
-    
-    for (int row = 0; row < rowCount; ++row) {
-        QStringList rowData;
-        rowData.reserve(colCount);
-        
-        for (int col = 0; col < colCount; ++col) {
-            QTableWidgetItem *item = dataTable->item(row, col);
-            rowData << (item ? item->text() : QString());
-        }
-        data.append({rowData, row});
-    }
-    
-    std::sort(data.begin(), data.end(), 
-        [column, order](const QPair<QStringList, int> &a, const QPair<QStringList, int> &b) {
-            QString val1 = a.first.value(column);
-            QString val2 = b.first.value(column);
-            
-            bool ok1, ok2;
-            double num1 = val1.toDouble(&ok1);
-            double num2 = val2.toDouble(&ok2);
-            
-            if (ok1 && ok2) {
-                return order == Qt::AscendingOrder ? num1 < num2 : num1 > num2;
-            } else {
-                return order == Qt::AscendingOrder ? 
-                    val1.localeAwareCompare(val2) < 0 : 
-                    val1.localeAwareCompare(val2) > 0;
-            }
+    // A spooled result may be far larger than memory; it is streamed from
+    // the store in a worker, chunk by chunk.
+    QSharedPointer<QAtomicInt> rowsDone(new QAtomicInt(0));
+    QSharedPointer<QAtomicInt> canceled(new QAtomicInt(0));
+    int rowCount = store->rowCount();
+
+    auto progress = new QProgressDialog(tr("Exporting %1 rows...").arg(QLocale().toString(rowCount)),
+                                        tr("Cancel"), 0, rowCount, this);
+    progress->setMinimumDuration(300);
+    progress->setAutoClose(false);
+    progress->setAutoReset(false);
+    auto progressTimer = new QTimer(progress);
+    connect(progressTimer, &QTimer::timeout, progress,
+            [progress, rowsDone]() { progress->setValue(rowsDone->loadRelaxed()); });
+    progressTimer->start(100);
+    connect(progress, &QProgressDialog::canceled, progress,
+            [canceled]() { canceled->storeRelaxed(1); });
+
+    auto watcher = new QFutureWatcher<QString>(this);
+    connect(watcher, &QFutureWatcher<QString>::finished, this, [this, watcher, progress, fileName]() {
+        QString error = watcher->result();
+        progress->deleteLater();
+        watcher->deleteLater();
+        if (!error.isEmpty()) {
+            QMessageBox::critical(this, tr("Error"), tr("Failed to write file: %1").arg(error));
+            return;
         }
-    );
-    
-    QVector<QVector<QTableWidgetItem*>> sortedData(rowCount, QVector<QTableWidgetItem*>(colCount));
-    
-    for (int row = 0; row < rowCount; ++row) {
-        for (int col = 0; col < colCount; ++col) {
-            sortedData[row][col] = dataTable->takeItem(row, col);
+        statusLabel->setText(tr("Data exported to %1").arg(fileName));
+    });
+    watcher->setFuture(QtConcurrent::run([store, fileName, format, rowsDone, canceled]() {
+        QFile file(fileName);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            return QObject::tr("Failed to open file for writing");
         }
-    }
-    
-    for (int newRow = 0; newRow < data.size(); ++newRow) {
-        int oldRow = data[newRow].second;
-        for (int col = 0; col < colCount; ++col) {
-            dataTable->setItem(newRow, col, sortedData[oldRow][col]);
+        QString error;
+        if (!store->exportTo(&file, format, &error, rowsDone.data(), canceled.data())) {
+            return error;
         }
-    }
-    
-    QHeaderView* header = dataTable->horizontalHeader();
-    header->setSortIndicator(column, order);
-    header->setSortIndicatorShown(true);
-    
-    dataTable->setUpdatesEnabled(true);
-    dataTable->viewport()->update();
-    
-    statusLabel->setText(tr("Data sorted"));
+        return QString();
+    }));
+}
+
+QString MainWindow::getCurrentTableName() const
+{
+    auto item = serversTree->currentItem();
+    if (!item || !item->parent()) return QString();
+    return item->text(0);
 }
 
 void MainWindow::handleTreeItemDoubleClick(QTreeWidgetItem *item, int /*column*/)
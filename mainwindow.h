@@ -11,7 +11,17 @@
 #include <QMenu>
 #include <QPushButton>
 #include <QHeaderView>
+#include <QTabWidget>
+#include <QAction>
+#include <QTimer>
 #include "databaseconnection.h"
+#include "tableutils.h"
+#include "clipboardformatter.h"
+#include "tablestatistics.h"
+#include "tablestatisticspanel.h"
+#include "schemaindex.h"
+#include "querytab.h"
+#include "sessionstore.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
@@ -30,38 +40,89 @@ private slots:
     void editServer();
     void removeServer();
     void connectToServer(QTreeWidgetItem *item);
-    void executeQuery();
+    void openSqlScript();
+    void saveSqlScript();
     void showSettings();
     void handleTreeItemDoubleClick(QTreeWidgetItem *item, int column);
     void showContextMenu(const QPoint &pos);
     void copySelectedCells();
     void exportToFile();
-    void onCellChanged(int row, int column);
-    void onHeaderClicked(int logicalIndex);
+    QueryTab *newQueryTab();
+    void closeQueryTab(int index);
+    void bindToCurrentDatabase(QueryTab *tab);
+    void updateTabTitle(QueryTab *tab);
+    void showTabStatus(QueryTab *tab);
+    void updateMemoryStatus();
+    void writeMetrics();
+    void exportTrace();
+    void onTreeSelectionChanged(QTreeWidgetItem *current);
+    void refreshTableStatistics();
+
+protected:
+    void closeEvent(QCloseEvent *event) override;
 
 private:
     void setupUI();
     void setupMenus();
     void setupToolbar();
     void setupStatusBar();
+    void applyTraceSettings();
     void loadServers();
     void saveServers();
     void updateServerStatus(QTreeWidgetItem *serverItem, bool connected);
     QString getDefaultDriver();
     QString getCurrentTableName() const;
-    void sortTable(int column, Qt::SortOrder order);
+    QueryTab *currentTab() const;
+    QueryTab *tabFor(const QString &serverName, const QString &database);
+    void bindTab(QueryTab *tab, const QString &serverName, const QString &database);
     void loadDatabaseTables(QTreeWidgetItem *dbItem);
     void showTableData(QTreeWidgetItem *item);
+    void sampleTableData(QTreeWidgetItem *item);
+    void compareTables(QTreeWidgetItem *item);
+    void copyTable(QTreeWidgetItem *item);
+    void dumpDatabase(QTreeWidgetItem *dbItem);
+    QString serverForTool(QTreeWidgetItem *item, const QString &title);
+    void showActivityMonitor(QTreeWidgetItem *item);
+    void showTopQueries(QTreeWidgetItem *item);
+    void profileTable(QTreeWidgetItem *item);
+    void openTableProfile();
+    QueryTab *statementTab(const QString &purpose, QString *sql);
+    void benchmarkStatement();
+    void adviseIndexes();
+    void openStatement(const QString &sql);
+    void exportSpooled(const QSharedPointer<ResultStore> &store, const QString &fileName,
+                       ResultExporter::Format format);
+    void copySelection(ClipboardFormatter::Format format);
+    void loadTableStatistics(QTreeWidgetItem *dbItem);
+    void reloadSchemaIndex();
+    void sortDatabaseTables(QTreeWidgetItem *dbItem, bool bySize);
+    QString databaseKey(QTreeWidgetItem *dbItem) const;
+    bool ensureServerConnection(QTreeWidgetItem *serverItem);
+    bool saveSession(QString *error);
+    bool restoreSession();
+    void refreshRestoredSession();
+    void fillServerItem(QTreeWidgetItem *serverItem, const SessionStore::Server &server, bool stale);
+    QStringList treePath(QTreeWidgetItem *item) const;
+    QTreeWidgetItem *treeItem(const QStringList &path) const;
 
     Ui::MainWindow *ui;
     QSplitter *mainSplitter;
     QTreeWidget *serversTree;
-    QTableWidget *dataTable;
-    QTextEdit *queryEdit;
+    TableStatisticsPanel *statsPanel;
+    QTabWidget *queryTabs;
     QLabel *statusLabel;
+    QLabel *memoryLabel;
     QLabel *executionTimeLabel;
-    DatabaseConnection dbConnection;
+    DatabaseConnection dbConnection;   // schema browsing in the tree; queries run in the tabs
+    QString connectedServer;
+    QHash<QString, TableStatistics::Table> tableStats;
+    QString tableStatsDatabase;
+    SchemaIndex schemaIndex;
+    int schemaGeneration;              // bumped by each reloadSchemaIndex()
     QSettings settings;
     QMenu *tableContextMenu;
+    QAction *copyAction;
+    QTimer *metricsTimer;
+    QVector<SessionStore::Server> restoredServers;   // the tree as restored, until refreshed
 };
 #endif // MAINWINDOW_H
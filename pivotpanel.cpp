@@ -0,0 +1,282 @@
+#include "pivotpanel.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QFormLayout>
+#include <QHeaderView>
+#include <QSignalBlocker>
+#include <QLocale>
+#include <QSet>
+#include <QThread>
+#include <QtConcurrent>
+
+namespace {
+
+const int ColumnRole = Qt::UserRole;
+const int FunctionRole = Qt::UserRole + 1;
+
+} // namespace
+
+PivotPanel::PivotPanel(QTableWidget *source, QWidget *parent)
+    : QWidget(parent), source(source), changedWhileRunning(false)
+{
+    auto layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+
+    layout->addWidget(new QLabel(tr("Group by:"), this));
+    groupList = new QListWidget(this);
+    groupList->setMaximumHeight(120);
+    layout->addWidget(groupList);
+
+    auto formLayout = new QFormLayout;
+    pivotComboBox = new QComboBox(this);
+    formLayout->addRow(tr("Pivot column:"), pivotComboBox);
+    layout->addLayout(formLayout);
+
+    layout->addWidget(new QLabel(tr("Aggregates:"), this));
+    auto aggregateLayout = new QHBoxLayout;
+    functionComboBox = new QComboBox(this);
+    for (ResultPivot::Function function : {ResultPivot::Count, ResultPivot::Sum, ResultPivot::Avg, ResultPivot::Min,
+                                           ResultPivot::Max, ResultPivot::CountDistinct}) {
+        functionComboBox->addItem(ResultPivot::functionName(function), function);
+    }
+    columnComboBox = new QComboBox(this);
+    auto addButton = new QPushButton(tr("Add"), this);
+    aggregateLayout->addWidget(functionComboBox);
+    aggregateLayout->addWidget(columnComboBox, 1);
+    aggregateLayout->addWidget(addButton);
+    layout->addLayout(aggregateLayout);
+    aggregateList = new QListWidget(this);
+    aggregateList->setMaximumHeight(90);
+    layout->addWidget(aggregateList);
+
+    auto buttonLayout = new QHBoxLayout;
+    auto removeButton = new QPushButton(tr("Remove"), this);
+    computeButton = new QPushButton(tr("Compute"), this);
+    buttonLayout->addWidget(removeButton);
+    buttonLayout->addStretch();
+    buttonLayout->addWidget(computeButton);
+    layout->addLayout(buttonLayout);
+
+    resultTable = new QTableWidget(this);
+    resultTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    resultTable->verticalHeader()->setDefaultSectionSize(resultTable->fontMetrics().height() + 6);
+    layout->addWidget(resultTable, 1);
+    statusLabel = new QLabel(this);
+    statusLabel->setWordWrap(true);
+    layout->addWidget(statusLabel);
+
+    connect(addButton, &QPushButton::clicked, this, &PivotPanel::addAggregate);
+    connect(removeButton, &QPushButton::clicked, this, &PivotPanel::removeAggregate);
+    connect(computeButton, &QPushButton::clicked, this, &PivotPanel::compute);
+    connect(&watcher, &QFutureWatcher<Computation>::finished, this, &PivotPanel::showResult);
+
+    refreshColumns();
+    auto countRows = new QListWidgetItem(ResultPivot::aggregateName(ResultPivot::Aggregate(), headers), aggregateList);
+    countRows->setData(FunctionRole, ResultPivot::Count);
+    countRows->setData(ColumnRole, -1);
+}
+
+PivotPanel::~PivotPanel()
+{
+    watcher.waitForFinished();
+}
+
+QStringList PivotPanel::sourceHeaders() const
+{
+    QStringList names;
+    for (int column = 0; column < source->columnCount(); ++column) {
+        QTableWidgetItem *header = source->horizontalHeaderItem(column);
+        QString name = header ? header->text() : QString::number(column + 1);
+        names << name.remove(" ▲").remove(" ▼");
+    }
+    return names;
+}
+
+void PivotPanel::sourceChanged()
+{
+    encoded.clear();
+    if (watcher.isRunning()) {
+        changedWhileRunning = true;
+    }
+    refreshColumns();
+}
+
+void PivotPanel::refreshColumns()
+{
+    QStringList names = sourceHeaders();
+    if (names == headers && pivotComboBox->count() > 0) return;
+
+    // Keep the choices whose columns are still there, by name.
+    QSet<QString> grouped;
+    for (int row = 0; row < groupList->count(); ++row) {
+        if (groupList->item(row)->checkState() == Qt::Checked) {
+            grouped.insert(groupList->item(row)->text());
+        }
+    }
+    QString pivot = pivotComboBox->currentIndex() > 0 ? pivotComboBox->currentText() : QString();
+    headers = names;
+
+    groupList->clear();
+    pivotComboBox->clear();
+    pivotComboBox->addItem(tr("(none)"), -1);
+    columnComboBox->clear();
+    columnComboBox->addItem(tr("* (rows)"), -1);
+    for (int column = 0; column < headers.size(); ++column) {
+        auto item = new QListWidgetItem(headers.at(column), groupList);
+        item->setData(ColumnRole, column);
+        item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
+        item->setCheckState(grouped.contains(headers.at(column)) ? Qt::Checked : Qt::Unchecked);
+        pivotComboBox->addItem(headers.at(column), column);
+        columnComboBox->addItem(headers.at(column), column);
+    }
+    pivotComboBox->setCurrentIndex(qMax(0, pivotComboBox->findText(pivot)));
+
+    for (int row = aggregateList->count() - 1; row >= 0; --row) {
+        QListWidgetItem *item = aggregateList->item(row);
+        ResultPivot::Aggregate aggregate;
+        aggregate.function = static_cast<ResultPivot::Function>(item->data(FunctionRole).toInt());
+        aggregate.column = item->data(ColumnRole).toInt();
+        if (aggregate.column >= headers.size()) {
+            delete item;
+        } else {
+            item->setText(ResultPivot::aggregateName(aggregate, headers));
+        }
+    }
+}
+
+void PivotPanel::addAggregate()
+{
+    ResultPivot::Aggregate aggregate;
+    aggregate.function = static_cast<ResultPivot::Function>(functionComboBox->currentData().toInt());
+    aggregate.column = columnComboBox->currentData().toInt();
+    if (aggregate.column < 0) {
+        aggregate.function = ResultPivot::Count;
+    }
+    auto item = new QListWidgetItem(ResultPivot::aggregateName(aggregate, headers), aggregateList);
+    item->setData(FunctionRole, aggregate.function);
+    item->setData(ColumnRole, aggregate.column);
+}
+
+void PivotPanel::removeAggregate()
+{
+    delete aggregateList->currentItem();
+}
+
+void PivotPanel::compute()
+{
+    if (watcher.isRunning()) return;
+    refreshColumns();
+
+    ResultPivot::Spec spec;
+    QSet<int> used;
+    for (int row = 0; row < groupList->count(); ++row) {
+        if (groupList->item(row)->checkState() == Qt::Checked) {
+            spec.groupColumns << groupList->item(row)->data(ColumnRole).toInt();
+        }
+    }
+    spec.pivotColumn = pivotComboBox->currentData().toInt();
+    for (int row = 0; row < aggregateList->count(); ++row) {
+        ResultPivot::Aggregate aggregate;
+        aggregate.function = static_cast<ResultPivot::Function>(aggregateList->item(row)->data(FunctionRole).toInt());
+        aggregate.column = aggregateList->item(row)->data(ColumnRole).toInt();
+        spec.aggregates << aggregate;
+        used.insert(aggregate.column);
+    }
+    if (spec.aggregates.isEmpty()) {
+        statusLabel->setText(tr("Add at least one aggregate"));
+        return;
+    }
+    for (int column : spec.groupColumns) {
+        used.insert(column);
+    }
+    used.insert(spec.pivotColumn);
+    used.remove(-1);
+
+    // Cells are read here, on the GUI thread; the copies share their text
+    // with the grid, so this is a pointer copy per cell.
+    const int rows = source->rowCount();
+    encoded.resize(headers.size());
+    QVector<QPair<int, QVector<QString>>> missing;
+    for (int column : used) {
+        if (encoded.at(column)) continue;
+        QVector<QString> texts(rows);
+        for (int row = 0; row < rows; ++row) {
+            QTableWidgetItem *item = source->item(row, column);
+            if (item) {
+                texts[row] = item->text();
+            }
+        }
+        missing << qMakePair(column, texts);
+    }
+
+    QVector<ResultPivot::ColumnPtr> columns = encoded;
+    QStringList names = headers;
+    int threads = QThread::idealThreadCount();
+    changedWhileRunning = false;
+    computeButton->setEnabled(false);
+    statusLabel->setText(missing.isEmpty() ? tr("Aggregating %1 rows...").arg(QLocale().toString(rows))
+                                           : tr("Encoding %1 columns of %2 rows...")
+                                                 .arg(missing.size()).arg(QLocale().toString(rows)));
+    watcher.setFuture(QtConcurrent::run([missing, columns, names, rows, spec, threads]() {
+        Computation computation;
+        QVector<ResultPivot::ColumnPtr> bound = columns;
+        for (const auto &entry : missing) {
+            ResultPivot::ColumnPtr column = ResultPivot::encode(entry.second, threads);
+            bound[entry.first] = column;
+            computation.encoded << qMakePair(entry.first, column);
+        }
+        computation.result = ResultPivot::aggregate(bound, names, rows, spec, threads);
+        return computation;
+    }));
+}
+
+void PivotPanel::showResult()
+{
+    computeButton->setEnabled(true);
+    Computation computation = watcher.result();
+    if (!changedWhileRunning) {
+        for (const auto &entry : computation.encoded) {
+            if (entry.first < encoded.size()) {
+                encoded[entry.first] = entry.second;
+            }
+        }
+    }
+    const ResultPivot::Result &result = computation.result;
+    if (!result.ok) {
+        statusLabel->setText(result.error);
+        return;
+    }
+
+    {
+        const QSignalBlocker blocker(resultTable);
+        resultTable->setUpdatesEnabled(false);
+        resultTable->clear();
+        resultTable->setColumnCount(result.headers.size());
+        resultTable->setHorizontalHeaderLabels(result.headers);
+        resultTable->setRowCount(result.rows.size());
+        for (int row = 0; row < result.rows.size(); ++row) {
+            const QStringList &cells = result.rows.at(row);
+            for (int column = 0; column < cells.size(); ++column) {
+                auto item = new QTableWidgetItem(cells.at(column));
+                if (column >= result.keyColumns) {
+                    item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+                }
+                resultTable->setItem(row, column, item);
+            }
+        }
+        resultTable->setUpdatesEnabled(true);
+    }
+    resultTable->resizeColumnsToContents();
+
+    QLocale locale;
+    QString status = tr("%1 groups from %2 rows in %3 ms")
+                         .arg(locale.toString(result.groups), locale.toString(result.inputRows))
+                         .arg(result.elapsedMs);
+    if (result.droppedPivotValues > 0) {
+        status += tr("; %1 less frequent pivot values left out").arg(result.droppedPivotValues);
+    }
+    if (changedWhileRunning) {
+        status += tr("; the grid changed meanwhile, compute again for the current rows");
+    }
+    statusLabel->setText(status);
+}
@@ -0,0 +1,58 @@
+#ifndef PIVOTPANEL_H
+#define PIVOTPANEL_H
+
+#include <QWidget>
+#include <QTableWidget>
+#include <QListWidget>
+#include <QComboBox>
+#include <QPushButton>
+#include <QLabel>
+#include <QFutureWatcher>
+#include "resultpivot.h"
+
+// Side panel of a query tab that groups and pivots the rows loaded in its
+// grid without going back to the server. Encoded columns are cached until
+// the grid changes, so trying other aggregates over the same result only
+// repeats the aggregation.
+class PivotPanel : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit PivotPanel(QTableWidget *source, QWidget *parent = nullptr);
+    ~PivotPanel();
+
+public slots:
+    // The grid was refilled, extended, sorted or edited.
+    void sourceChanged();
+
+private slots:
+    void addAggregate();
+    void removeAggregate();
+    void compute();
+    void showResult();
+
+private:
+    struct Computation {
+        ResultPivot::Result result;
+        QVector<QPair<int, ResultPivot::ColumnPtr>> encoded;
+    };
+
+    void refreshColumns();
+    QStringList sourceHeaders() const;
+
+    QTableWidget *source;
+    QListWidget *groupList;
+    QComboBox *pivotComboBox;
+    QComboBox *functionComboBox;
+    QComboBox *columnComboBox;
+    QListWidget *aggregateList;
+    QPushButton *computeButton;
+    QTableWidget *resultTable;
+    QLabel *statusLabel;
+    QStringList headers;
+    QVector<ResultPivot::ColumnPtr> encoded;   // per grid column, until the grid changes
+    bool changedWhileRunning;
+    QFutureWatcher<Computation> watcher;
+};
+
+#endif // PIVOTPANEL_H
@@ -0,0 +1,415 @@
+#include "profiletabledialog.h"
+#include "sampledialog.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QSplitter>
+#include <QHeaderView>
+#include <QFileDialog>
+#include <QDir>
+#include <QSignalBlocker>
+#include <QPainter>
+#include <QHelpEvent>
+#include <QToolTip>
+#include <QLocale>
+#include <QThread>
+#include <QtConcurrent>
+#include <cmath>
+
+namespace {
+
+enum SummaryColumn {
+    NameColumn,
+    KindColumn,
+    NullsColumn,
+    DistinctColumn,
+    MinColumn,
+    MaxColumn,
+    MedianColumn,
+    P95Column
+};
+
+QString percent(qint64 part, qint64 whole) {
+    return whole > 0 ? QString("%1%").arg(part * 100.0 / whole, 0, 'f', part == whole || part == 0 ? 0 : 1)
+                     : QString();
+}
+
+QString quantileAt(const TableProfiler::Column &column, double rank) {
+    int index = TableProfiler::quantileRanks().indexOf(rank);
+    if (index < 0 || index >= column.quantiles.size()) return QString();
+    return TableProfiler::formatMeasure(column.kind, column.quantiles.at(index));
+}
+
+} // namespace
+
+HistogramWidget::HistogramWidget(QWidget *parent)
+    : QWidget(parent)
+{
+    setMinimumSize(300, 160);
+}
+
+void HistogramWidget::setColumn(const TableProfiler::Column &column)
+{
+    this->column = column;
+    update();
+}
+
+QRect HistogramWidget::plotArea() const
+{
+    int text = fontMetrics().height();
+    return rect().adjusted(8, text + 8, -8, -(text + 8));
+}
+
+void HistogramWidget::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    painter.fillRect(rect(), palette().base());
+    painter.setPen(palette().text().color());
+
+    if (column.histogram.isEmpty()) {
+        QString message = column.name.isEmpty() ? tr("Select a column")
+                        : column.kind == TableProfiler::Boolean ? tr("See the value counts")
+                        : tr("No values to chart");
+        painter.drawText(rect(), Qt::AlignCenter, message);
+        return;
+    }
+
+    qint64 highest = 1;
+    for (qint64 count : column.histogram) {
+        highest = qMax(highest, count);
+    }
+    QString measured = column.kind == TableProfiler::Text || column.kind == TableProfiler::Binary
+                           ? tr("%1: length").arg(column.name) : column.name;
+    painter.drawText(rect().adjusted(8, 4, -8, 0), Qt::AlignLeft | Qt::AlignTop,
+                     tr("%1, up to %2 per bar").arg(measured, QLocale().toString(highest)));
+
+    QRect area = plotArea();
+    int bins = column.histogram.size();
+    double width = static_cast<double>(area.width()) / bins;
+    for (int bin = 0; bin < bins; ++bin) {
+        int height = static_cast<int>(std::ceil(area.height() * column.histogram.at(bin) / static_cast<double>(highest)));
+        QRectF bar(area.left() + bin * width + 1, area.bottom() - height + 1, qMax(1.0, width - 2), height);
+        painter.fillRect(bar, palette().highlight());
+    }
+    painter.drawLine(area.bottomLeft(), area.bottomRight());
+
+    QRect labels = rect().adjusted(8, 0, -8, -4);
+    painter.drawText(labels, Qt::AlignLeft | Qt::AlignBottom,
+                     TableProfiler::formatMeasure(column.kind, column.histogramLow));
+    painter.drawText(labels, Qt::AlignRight | Qt::AlignBottom,
+                     TableProfiler::formatMeasure(column.kind, column.histogramHigh));
+}
+
+bool HistogramWidget::event(QEvent *event)
+{
+    if (event->type() != QEvent::ToolTip || column.histogram.isEmpty()) {
+        return QWidget::event(event);
+    }
+    auto help = static_cast<QHelpEvent *>(event);
+    QRect area = plotArea();
+    int bins = column.histogram.size();
+    int bin = (help->pos().x() - area.left()) * bins / qMax(1, area.width());
+    if (bin < 0 || bin >= bins) {
+        QToolTip::hideText();
+        return true;
+    }
+    double step = (column.histogramHigh - column.histogramLow) / bins;
+    QToolTip::showText(help->globalPos(),
+                       tr("%1 .. %2: %3 rows")
+                           .arg(TableProfiler::formatMeasure(column.kind, column.histogramLow + bin * step),
+                                TableProfiler::formatMeasure(column.kind, column.histogramLow + (bin + 1) * step),
+                                QLocale().toString(column.histogram.at(bin))),
+                       this);
+    return true;
+}
+
+ProfileTableDialog::ProfileTableDialog(QWidget *parent, const QString &serverName,
+                                       const DatabaseConnection::ConnectionParams &params, const QString &table)
+    : QDialog(parent), serverName(serverName), params(params), table(table), settings("DBManager", "Settings")
+{
+    setWindowTitle(table.isEmpty() ? tr("Table Profile") : tr("Profile %1").arg(table));
+    resize(1000, 700);
+
+    auto layout = new QVBoxLayout(this);
+    auto controlsLayout = new QHBoxLayout;
+    sampleCheckBox = new QCheckBox(tr("Profile a sample"), this);
+    controlsLayout->addWidget(sampleCheckBox);
+    controlsLayout->addWidget(new QLabel(tr("Workers:"), this));
+    workersSpinBox = new QSpinBox(this);
+    workersSpinBox->setRange(1, 64);
+    workersSpinBox->setValue(settings.value("profile/workers", QThread::idealThreadCount()).toInt());
+    controlsLayout->addWidget(workersSpinBox);
+    profileButton = new QPushButton(tr("Profile"), this);
+    profileButton->setDefault(true);
+    controlsLayout->addWidget(profileButton);
+    controlsLayout->addStretch();
+    auto openButton = new QPushButton(tr("Open Report..."), this);
+    controlsLayout->addWidget(openButton);
+    layout->addLayout(controlsLayout);
+
+    reportLabel = new QLabel(this);
+    reportLabel->setWordWrap(true);
+    layout->addWidget(reportLabel);
+
+    auto splitter = new QSplitter(Qt::Vertical, this);
+    columnsTable = new QTableWidget(0, 8, splitter);
+    columnsTable->setHorizontalHeaderLabels({tr("Column"), tr("Type"), tr("NULLs"), tr("Distinct (approx.)"),
+                                             tr("Min"), tr("Max"), tr("Median"), tr("95th pct.")});
+    columnsTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    columnsTable->setSelectionMode(QAbstractItemView::SingleSelection);
+    columnsTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    columnsTable->verticalHeader()->hide();
+    columnsTable->horizontalHeader()->setStretchLastSection(true);
+
+    auto detail = new QWidget(splitter);
+    auto detailLayout = new QHBoxLayout(detail);
+    detailLayout->setContentsMargins(0, 0, 0, 0);
+    auto chartLayout = new QVBoxLayout;
+    histogram = new HistogramWidget(detail);
+    chartLayout->addWidget(histogram, 1);
+    quantilesLabel = new QLabel(detail);
+    quantilesLabel->setWordWrap(true);
+    quantilesLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
+    chartLayout->addWidget(quantilesLabel);
+    detailLayout->addLayout(chartLayout, 3);
+    topValuesTable = new QTableWidget(0, 3, detail);
+    topValuesTable->setHorizontalHeaderLabels({tr("Most frequent"), tr("Rows"), tr("Share")});
+    topValuesTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    topValuesTable->verticalHeader()->hide();
+    topValuesTable->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    detailLayout->addWidget(topValuesTable, 2);
+    splitter->setStretchFactor(0, 3);
+    splitter->setStretchFactor(1, 2);
+    layout->addWidget(splitter, 1);
+
+    progressBar = new QProgressBar(this);
+    progressBar->setRange(0, 1);
+    progressBar->setValue(0);
+    layout->addWidget(progressBar);
+    statusLabel = new QLabel(this);
+    statusLabel->setWordWrap(true);
+    layout->addWidget(statusLabel);
+
+    progressTimer.setInterval(500);
+    connect(&progressTimer, &QTimer::timeout, this, &ProfileTableDialog::updateProgress);
+    connect(&watcher, &QFutureWatcher<TableProfiler::Result>::finished, this, &ProfileTableDialog::showResult);
+    connect(profileButton, &QPushButton::clicked, this, &ProfileTableDialog::startOrCancel);
+    connect(sampleCheckBox, &QCheckBox::toggled, this, &ProfileTableDialog::chooseSample);
+    connect(openButton, &QPushButton::clicked, this, &ProfileTableDialog::browseReports);
+    connect(columnsTable, &QTableWidget::itemSelectionChanged, this, &ProfileTableDialog::showColumn);
+
+    bool canProfile = !table.isEmpty();
+    sampleCheckBox->setEnabled(canProfile);
+    workersSpinBox->setEnabled(canProfile);
+    profileButton->setEnabled(canProfile);
+
+    QString latest = canProfile ? TableProfiler::latestReport(serverName, params.dbName, table) : QString();
+    if (latest.isEmpty() || !openReport(latest)) {
+        reportLabel->setText(canProfile ? tr("%1 has not been profiled yet.").arg(table)
+                                        : tr("Open a saved report."));
+    }
+}
+
+ProfileTableDialog::~ProfileTableDialog()
+{
+    // The worker uses this dialog's progress counters.
+    progress.canceled.storeRelaxed(1);
+    watcher.waitForFinished();
+}
+
+bool ProfileTableDialog::openReport(const QString &path)
+{
+    TableProfiler::Report loaded;
+    QString error;
+    if (!TableProfiler::load(path, &loaded, &error)) {
+        statusLabel->setText(tr("Cannot open %1: %2").arg(path, error));
+        return false;
+    }
+    showReport(loaded);
+    statusLabel->setText(tr("Opened %1").arg(QDir::toNativeSeparators(path)));
+    return true;
+}
+
+void ProfileTableDialog::browseReports()
+{
+    QString path = QFileDialog::getOpenFileName(this, tr("Open Profile Report"), TableProfiler::reportsDirectory(),
+                                                tr("Profile reports (*.json)"));
+    if (!path.isEmpty()) {
+        openReport(path);
+    }
+}
+
+void ProfileTableDialog::chooseSample(bool checked)
+{
+    if (!checked) return;
+    SampleDialog dialog(this, table, params.driver == "QPSQL");
+    if (dialog.exec() == QDialog::Accepted) {
+        sampleOptions = dialog.getOptions();
+    } else {
+        QSignalBlocker blocker(sampleCheckBox);
+        sampleCheckBox->setChecked(false);
+    }
+}
+
+void ProfileTableDialog::startOrCancel()
+{
+    if (watcher.isRunning()) {
+        progress.canceled.storeRelaxed(1);
+        profileButton->setEnabled(false);
+        return;
+    }
+
+    TableProfiler::Options options;
+    options.params = params;
+    // A full scan outlives any interactive statement timeout.
+    options.params.statementTimeout = 0;
+    options.params.readOnly = true;
+    options.serverName = serverName;
+    options.table = table;
+    options.sample = sampleCheckBox->isChecked();
+    options.sampleOptions = sampleOptions;
+    options.workers = workersSpinBox->value();
+    settings.setValue("profile/workers", options.workers);
+
+    progress.rowsRead.storeRelaxed(0);
+    progress.estimatedRows.storeRelaxed(0);
+    progress.canceled.storeRelaxed(0);
+    runTimer.start();
+    statusLabel->setText(tr("Reading %1...").arg(table));
+
+    TableProfiler::Progress *shared = &progress;
+    watcher.setFuture(QtConcurrent::run([options, shared]() {
+        return TableProfiler::profile(options, shared);
+    }));
+    setRunning(true);
+}
+
+void ProfileTableDialog::setRunning(bool running)
+{
+    profileButton->setText(running ? tr("Cancel") : tr("Profile"));
+    profileButton->setEnabled(true);
+    sampleCheckBox->setEnabled(!running);
+    workersSpinBox->setEnabled(!running);
+    if (running) {
+        progressBar->setRange(0, 0);
+        progressTimer.start();
+    } else {
+        progressTimer.stop();
+    }
+}
+
+void ProfileTableDialog::updateProgress()
+{
+    QLocale locale;
+    qint64 rows = progress.rowsRead.loadRelaxed();
+    qint64 estimate = progress.estimatedRows.loadRelaxed();
+    qint64 rowsPerSecond = rows * 1000 / qMax<qint64>(1, runTimer.elapsed());
+    if (estimate > 0) {
+        // Catalog estimates can be low; the bar stops short of full instead.
+        progressBar->setRange(0, 1000);
+        progressBar->setValue(static_cast<int>(qMin<qint64>(999, rows * 1000 / estimate)));
+        statusLabel->setText(tr("%1 of ~%2 rows (%3 rows/s)")
+                                 .arg(locale.toString(rows), locale.toString(estimate), locale.toString(rowsPerSecond)));
+    } else {
+        statusLabel->setText(tr("%1 rows (%2 rows/s)").arg(locale.toString(rows), locale.toString(rowsPerSecond)));
+    }
+}
+
+void ProfileTableDialog::showResult()
+{
+    setRunning(false);
+    TableProfiler::Result result = watcher.result();
+    progressBar->setRange(0, 1);
+    progressBar->setValue(result.ok ? 1 : 0);
+    if (!result.ok) {
+        statusLabel->setText(tr("Profiling failed: %1").arg(result.error));
+        return;
+    }
+
+    showReport(result.report);
+    QString path;
+    QString error;
+    if (TableProfiler::save(result.report, &path, &error)) {
+        statusLabel->setText(tr("Saved to %1").arg(QDir::toNativeSeparators(path)));
+    } else {
+        statusLabel->setText(tr("The report could not be saved: %1").arg(error));
+    }
+}
+
+void ProfileTableDialog::showReport(const TableProfiler::Report &report)
+{
+    this->report = report;
+    QLocale locale;
+    setWindowTitle(tr("Profile %1").arg(report.table));
+    QString source = report.sampled ? tr("a sample of %1").arg(report.table) : report.table;
+    QString summary = tr("%1 on %2/%3: %4 rows, %5 columns in %6 s, profiled %7")
+                          .arg(source, report.serverName, report.database, locale.toString(report.rows))
+                          .arg(report.columns.size())
+                          .arg(report.elapsedMs / 1000.0, 0, 'f', 1)
+                          .arg(locale.toString(report.created, QLocale::ShortFormat));
+    if (!report.sampleNote.isEmpty()) {
+        summary += " (" + report.sampleNote + ")";
+    }
+    reportLabel->setText(summary);
+
+    columnsTable->setRowCount(report.columns.size());
+    for (int row = 0; row < report.columns.size(); ++row) {
+        const TableProfiler::Column &column = report.columns.at(row);
+        qint64 total = column.values + column.nulls;
+        QStringList cells = {column.name,
+                             TableProfiler::kindName(column.kind),
+                             percent(column.nulls, total),
+                             column.values > 0 ? locale.toString(qRound64(column.distinct)) : QString(),
+                             column.min,
+                             column.max,
+                             quantileAt(column, 0.5),
+                             quantileAt(column, 0.95)};
+        for (int cell = 0; cell < cells.size(); ++cell) {
+            auto item = new QTableWidgetItem(cells.at(cell));
+            if (cell == NullsColumn || cell == DistinctColumn) {
+                item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+            }
+            columnsTable->setItem(row, cell, item);
+        }
+    }
+    columnsTable->resizeColumnsToContents();
+    if (!report.columns.isEmpty()) {
+        columnsTable->selectRow(0);
+    }
+    showColumn();
+}
+
+void ProfileTableDialog::showColumn()
+{
+    int row = columnsTable->currentRow();
+    TableProfiler::Column column;
+    if (row >= 0 && row < report.columns.size()) {
+        column = report.columns.at(row);
+    }
+    histogram->setColumn(column);
+
+    QStringList quantiles;
+    const QVector<double> &ranks = TableProfiler::quantileRanks();
+    for (int i = 1; i + 1 < ranks.size() && i < column.quantiles.size(); ++i) {
+        quantiles << QString("p%1 %2").arg(ranks.at(i) * 100).arg(TableProfiler::formatMeasure(column.kind,
+                                                                                               column.quantiles.at(i)));
+    }
+    quantilesLabel->setText(quantiles.join("   "));
+
+    QLocale locale;
+    qint64 total = column.values + column.nulls;
+    topValuesTable->setRowCount(column.topValues.size());
+    for (int i = 0; i < column.topValues.size(); ++i) {
+        const TableProfiler::TopValue &value = column.topValues.at(i);
+        // Space-Saving may overcount a value by its error bound.
+        QString count = value.error > 0 ? tr("%1 (±%2)").arg(locale.toString(value.count),
+                                                                   locale.toString(value.error))
+                                        : locale.toString(value.count);
+        topValuesTable->setItem(i, 0, new QTableWidgetItem(value.value));
+        auto countItem = new QTableWidgetItem(count);
+        countItem->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+        topValuesTable->setItem(i, 1, countItem);
+        auto shareItem = new QTableWidgetItem(percent(value.count, total));
+        shareItem->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+        topValuesTable->setItem(i, 2, shareItem);
+    }
+}
@@ -0,0 +1,84 @@
+#ifndef PROFILETABLEDIALOG_H
+#define PROFILETABLEDIALOG_H
+
+#include <QDialog>
+#include <QWidget>
+#include <QTableWidget>
+#include <QCheckBox>
+#include <QSpinBox>
+#include <QPushButton>
+#include <QProgressBar>
+#include <QLabel>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+#include <QSettings>
+#include "tableprofiler.h"
+
+// Bar chart of one profiled column's histogram; hover a bar for its range.
+class HistogramWidget : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit HistogramWidget(QWidget *parent = nullptr);
+
+    void setColumn(const TableProfiler::Column &column);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    bool event(QEvent *event) override;
+
+private:
+    QRect plotArea() const;
+
+    TableProfiler::Column column;
+};
+
+class ProfileTableDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    // Without a table the dialog only shows saved reports.
+    ProfileTableDialog(QWidget *parent, const QString &serverName = QString(),
+                       const DatabaseConnection::ConnectionParams &params = DatabaseConnection::ConnectionParams(),
+                       const QString &table = QString());
+    ~ProfileTableDialog();
+
+    bool openReport(const QString &path);
+
+private slots:
+    void startOrCancel();
+    void chooseSample(bool checked);
+    void browseReports();
+    void updateProgress();
+    void showResult();
+    void showColumn();
+
+private:
+    void setRunning(bool running);
+    void showReport(const TableProfiler::Report &report);
+
+    QString serverName;
+    DatabaseConnection::ConnectionParams params;
+    QString table;
+    TableSampler::Options sampleOptions;
+    TableProfiler::Report report;
+
+    QCheckBox *sampleCheckBox;
+    QSpinBox *workersSpinBox;
+    QPushButton *profileButton;
+    QLabel *reportLabel;
+    QTableWidget *columnsTable;
+    HistogramWidget *histogram;
+    QLabel *quantilesLabel;
+    QTableWidget *topValuesTable;
+    QProgressBar *progressBar;
+    QLabel *statusLabel;
+    QTimer progressTimer;
+    QElapsedTimer runTimer;
+    QFutureWatcher<TableProfiler::Result> watcher;
+    TableProfiler::Progress progress;
+    QSettings settings;
+};
+
+#endif // PROFILETABLEDIALOG_H
@@ -0,0 +1,368 @@
+#include "querybenchmark.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QThreadPool>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QStandardPaths>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLocale>
+#include <QObject>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const int MaxSavedRuns = 100;
+
+struct ClientResult {
+    ClientResult() : errors(0) {}
+    QVector<qint64> latencies;
+    int errors;
+    QString firstError;
+};
+
+// Releases the clients into the timed phase together, once every one of
+// them connected and warmed up (or failed to).
+class StartLine {
+public:
+    explicit StartLine(int clients) : waiting(clients) {}
+
+    void arrive(QElapsedTimer *clock) {
+        QMutexLocker locker(&mutex);
+        if (--waiting == 0) {
+            clock->start();
+            released.wakeAll();
+            return;
+        }
+        while (waiting > 0) {
+            released.wait(&mutex);
+        }
+    }
+
+private:
+    QMutex mutex;
+    QWaitCondition released;
+    int waiting;
+};
+
+ClientResult runClient(const QueryBenchmark::Options &options, QueryBenchmark::Progress *progress,
+                       QAtomicInt *next, StartLine *startLine, QElapsedTimer *clock) {
+    ClientResult result;
+    auto fail = [&result, progress](const QString &error) {
+        if (result.firstError.isEmpty()) {
+            result.firstError = error;
+        }
+        result.errors++;
+        progress->errors.ref();
+    };
+
+    DatabaseConnection connection;
+    if (!connection.connect(options.params)) {
+        fail(connection.lastError().text());
+        startLine->arrive(clock);
+        return result;
+    }
+    QSqlQuery query(connection.database());
+    query.setForwardOnly(true);
+    bool prepared = options.parameterSets.isEmpty() || query.prepare(options.sql);
+    if (!prepared) {
+        fail(query.lastError().text());
+        startLine->arrive(clock);
+        return result;
+    }
+    auto execute = [&](int iteration, bool timed) {
+        bool ok;
+        if (options.parameterSets.isEmpty()) {
+            ok = query.exec(options.sql);
+        } else {
+            const QVariantList &values = options.parameterSets.at(iteration % options.parameterSets.size());
+            for (int i = 0; i < values.size(); ++i) {
+                query.bindValue(i, values.at(i));
+            }
+            ok = query.exec();
+        }
+        if (ok && query.isSelect()) {
+            while (query.next()) {
+            }
+        }
+        // A statement failing in the warm-up fails in the timed phase too.
+        if (!ok && timed) {
+            fail(query.lastError().text());
+        }
+        query.finish();
+        return ok;
+    };
+
+    for (int i = 0; i < options.warmup && !progress->canceled.loadRelaxed(); ++i) {
+        execute(i, false);
+    }
+    startLine->arrive(clock);
+
+    QElapsedTimer timer;
+    while (!progress->canceled.loadRelaxed()) {
+        int iteration = next->fetchAndAddRelaxed(1);
+        if (iteration >= options.iterations) break;
+        timer.start();
+        bool ok = execute(iteration, true);
+        qint64 us = timer.nsecsElapsed() / 1000;
+        if (ok) {
+            result.latencies << us;
+        }
+        progress->done.ref();
+    }
+    connection.disconnect();
+    return result;
+}
+
+qint64 percentile(const QVector<qint64> &sorted, double rank) {
+    if (sorted.isEmpty()) return 0;
+    int index = qBound(0, static_cast<int>(std::ceil(rank * sorted.size())) - 1, sorted.size() - 1);
+    return sorted.at(index);
+}
+
+QStringList splitFields(const QString &line) {
+    QChar separator = line.contains('\t') ? QChar('\t') : QChar(',');
+    QStringList fields;
+    QString field;
+    bool quoted = false;
+    bool wasQuoted = false;
+    for (int i = 0; i < line.size(); ++i) {
+        QChar c = line.at(i);
+        if (quoted) {
+            if (c == '"' && i + 1 < line.size() && line.at(i + 1) == '"') {
+                field += c;
+                ++i;
+            } else if (c == '"') {
+                quoted = false;
+            } else {
+                field += c;
+            }
+        } else if (c == '"') {
+            quoted = true;
+            wasQuoted = true;
+        } else if (c == separator) {
+            fields << (wasQuoted ? field : field.trimmed());
+            field.clear();
+            wasQuoted = false;
+        } else {
+            field += c;
+        }
+    }
+    fields << (wasQuoted ? field : field.trimmed());
+    // Unquoted NULL marks a null value.
+    for (QString &value : fields) {
+        if (value == "NULL") {
+            value = QString();
+        }
+    }
+    return fields;
+}
+
+QJsonObject runToJson(const QueryBenchmark::Run &run) {
+    QJsonObject object;
+    object["label"] = run.label;
+    object["started"] = run.started.toString(Qt::ISODate);
+    object["server"] = run.serverName;
+    object["database"] = run.database;
+    object["sql"] = run.sql;
+    object["clients"] = run.clients;
+    object["warmup"] = run.warmup;
+    object["iterations"] = run.iterations;
+    object["parameterSets"] = run.parameterSets;
+    object["executed"] = run.executed;
+    object["errors"] = run.errors;
+    object["firstError"] = run.firstError;
+    object["elapsedMs"] = double(run.elapsedMs);
+    object["throughput"] = run.throughput;
+    object["minUs"] = double(run.minUs);
+    object["p50Us"] = double(run.p50Us);
+    object["p95Us"] = double(run.p95Us);
+    object["p99Us"] = double(run.p99Us);
+    object["maxUs"] = double(run.maxUs);
+    object["meanUs"] = run.meanUs;
+    QJsonArray histogram;
+    for (int count : run.histogram) {
+        histogram.append(count);
+    }
+    object["histogram"] = histogram;
+    return object;
+}
+
+QueryBenchmark::Run runFromJson(const QJsonObject &object) {
+    QueryBenchmark::Run run;
+    run.label = object["label"].toString();
+    run.started = QDateTime::fromString(object["started"].toString(), Qt::ISODate);
+    run.serverName = object["server"].toString();
+    run.database = object["database"].toString();
+    run.sql = object["sql"].toString();
+    run.clients = object["clients"].toInt();
+    run.warmup = object["warmup"].toInt();
+    run.iterations = object["iterations"].toInt();
+    run.parameterSets = object["parameterSets"].toInt();
+    run.executed = object["executed"].toInt();
+    run.errors = object["errors"].toInt();
+    run.firstError = object["firstError"].toString();
+    run.elapsedMs = static_cast<qint64>(object["elapsedMs"].toDouble());
+    run.throughput = object["throughput"].toDouble();
+    run.minUs = static_cast<qint64>(object["minUs"].toDouble());
+    run.p50Us = static_cast<qint64>(object["p50Us"].toDouble());
+    run.p95Us = static_cast<qint64>(object["p95Us"].toDouble());
+    run.p99Us = static_cast<qint64>(object["p99Us"].toDouble());
+    run.maxUs = static_cast<qint64>(object["maxUs"].toDouble());
+    run.meanUs = object["meanUs"].toDouble();
+    run.histogram.fill(0, QueryBenchmark::HistogramBins);
+    QJsonArray histogram = object["histogram"].toArray();
+    for (int bin = 0; bin < histogram.size() && bin < QueryBenchmark::HistogramBins; ++bin) {
+        run.histogram[bin] = histogram.at(bin).toInt();
+    }
+    return run;
+}
+
+QString runsPath() {
+    return QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)).filePath("benchmarks.json");
+}
+
+} // namespace
+
+QueryBenchmark::Run QueryBenchmark::run(const Options &options, Progress *progress) {
+    Run run;
+    run.label = options.label;
+    run.started = QDateTime::currentDateTime();
+    run.serverName = options.serverName;
+    run.database = options.params.dbName;
+    run.sql = options.sql;
+    run.clients = qMax(1, options.clients);
+    run.warmup = options.warmup;
+    run.iterations = options.iterations;
+    run.parameterSets = options.parameterSets.size();
+    run.histogram.fill(0, HistogramBins);
+
+    if (options.params.readOnly && DatabaseConnection::isWriteStatement(options.sql)) {
+        run.errors = 1;
+        run.firstError = QObject::tr("Server is configured as read-only");
+        return run;
+    }
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(run.clients);
+    QAtomicInt next(0);
+    StartLine startLine(run.clients);
+    QElapsedTimer clock;
+    QVector<QFuture<ClientResult>> clients;
+    for (int client = 0; client < run.clients; ++client) {
+        clients << QtConcurrent::run(&pool, [&options, progress, &next, &startLine, &clock]() {
+            return runClient(options, progress, &next, &startLine, &clock);
+        });
+    }
+
+    QVector<qint64> latencies;
+    latencies.reserve(options.iterations);
+    for (QFuture<ClientResult> &client : clients) {
+        ClientResult result = client.result();
+        latencies += result.latencies;
+        run.errors += result.errors;
+        if (run.firstError.isEmpty()) {
+            run.firstError = result.firstError;
+        }
+    }
+    run.elapsedMs = clock.isValid() ? clock.elapsed() : 0;
+
+    std::sort(latencies.begin(), latencies.end());
+    run.executed = latencies.size();
+    if (run.executed > 0) {
+        double total = 0;
+        for (qint64 us : latencies) {
+            total += us;
+            run.histogram[histogramBin(us)]++;
+        }
+        run.meanUs = total / run.executed;
+        run.minUs = latencies.first();
+        run.p50Us = percentile(latencies, 0.50);
+        run.p95Us = percentile(latencies, 0.95);
+        run.p99Us = percentile(latencies, 0.99);
+        run.maxUs = latencies.last();
+        run.throughput = run.executed * 1000.0 / qMax<qint64>(1, run.elapsedMs);
+    }
+    return run;
+}
+
+bool QueryBenchmark::loadParameters(const QString &path, QVector<QVariantList> *sets, QString *error) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        *error = file.errorString();
+        return false;
+    }
+    sets->clear();
+    QTextStream in(&file);
+    while (!in.atEnd()) {
+        QString line = in.readLine();
+        if (line.trimmed().isEmpty()) continue;
+        QVariantList values;
+        for (const QString &field : splitFields(line)) {
+            values << (field.isNull() ? QVariant() : QVariant(field));
+        }
+        sets->append(values);
+    }
+    if (sets->isEmpty()) {
+        *error = QObject::tr("%1 has no parameter sets").arg(QFileInfo(path).fileName());
+        return false;
+    }
+    return true;
+}
+
+int QueryBenchmark::histogramBin(qint64 us) {
+    if (us <= 1) return 0;
+    return qMin(HistogramBins - 1, static_cast<int>(std::floor(4 * std::log2(static_cast<double>(us)))));
+}
+
+qint64 QueryBenchmark::binLowerUs(int bin) {
+    return static_cast<qint64>(std::ceil(std::pow(2.0, bin / 4.0)));
+}
+
+QString QueryBenchmark::formatLatency(qint64 us) {
+    QLocale locale;
+    if (us < 1000) return QObject::tr("%1 us").arg(us);
+    if (us < 1000000) return QObject::tr("%1 ms").arg(locale.toString(us / 1000.0, 'f', 2));
+    return QObject::tr("%1 s").arg(locale.toString(us / 1000000.0, 'f', 2));
+}
+
+QVector<QueryBenchmark::Run> QueryBenchmark::loadRuns() {
+    QVector<Run> runs;
+    QFile file(runsPath());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return runs;
+    }
+    for (const QJsonValue &value : QJsonDocument::fromJson(file.readAll()).array()) {
+        runs << runFromJson(value.toObject());
+    }
+    return runs;
+}
+
+bool QueryBenchmark::saveRuns(const QVector<Run> &runs, QString *error) {
+    QString path = runsPath();
+    if (!QDir().mkpath(QFileInfo(path).path())) {
+        *error = QObject::tr("Cannot create %1").arg(QFileInfo(path).path());
+        return false;
+    }
+    QJsonArray array;
+    for (int i = qMax(0, runs.size() - MaxSavedRuns); i < runs.size(); ++i) {
+        array.append(runToJson(runs.at(i)));
+    }
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) ||
+        file.write(QJsonDocument(array).toJson(QJsonDocument::Compact)) < 0) {
+        *error = file.errorString();
+        return false;
+    }
+    return true;
+}
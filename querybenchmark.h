@@ -0,0 +1,84 @@
+#ifndef QUERYBENCHMARK_H
+#define QUERYBENCHMARK_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QVariant>
+#include <QDateTime>
+#include <QAtomicInt>
+#include "databaseconnection.h"
+
+// Runs one statement many times and measures its latency. Each client has
+// a connection of its own, warms up untimed, then all clients start the
+// timed iterations together and claim them from a shared counter, so the
+// throughput is that of N concurrent sessions. A latency runs from sending
+// the statement until its last row was read.
+//
+// Latencies go into a histogram with fixed log-scale bins, four per
+// doubling, so runs can be compared bin by bin.
+class QueryBenchmark {
+public:
+    static const int HistogramBins = 112;   // up to 2^28 us, about 4.5 min
+
+    struct Options {
+        Options() : warmup(5), iterations(100), clients(1) {}
+        DatabaseConnection::ConnectionParams params;
+        QString serverName;
+        QString sql;
+        int warmup;                    // per client
+        int iterations;                // in total
+        int clients;
+        // Bound to `?` placeholders; iteration i uses set i modulo count.
+        QVector<QVariantList> parameterSets;
+        QString label;
+    };
+
+    struct Progress {
+        QAtomicInt done;
+        QAtomicInt errors;
+        QAtomicInt canceled;
+    };
+
+    struct Run {
+        Run() : clients(0), warmup(0), iterations(0), parameterSets(0), executed(0), errors(0), elapsedMs(0),
+                throughput(0), minUs(0), p50Us(0), p95Us(0), p99Us(0), maxUs(0), meanUs(0) {}
+        QString label;
+        QDateTime started;
+        QString serverName;
+        QString database;
+        QString sql;
+        int clients;
+        int warmup;
+        int iterations;
+        int parameterSets;
+        int executed;                  // successful timed iterations
+        int errors;
+        QString firstError;
+        qint64 elapsedMs;              // of the timed phase
+        double throughput;             // statements per second
+        qint64 minUs;
+        qint64 p50Us;
+        qint64 p95Us;
+        qint64 p99Us;
+        qint64 maxUs;
+        double meanUs;
+        QVector<int> histogram;        // HistogramBins counts
+    };
+
+    static Run run(const Options &options, Progress *progress);
+
+    // One parameter set per line, fields separated by commas or tabs, CSV
+    // quoting; an unquoted NULL is a null value.
+    static bool loadParameters(const QString &path, QVector<QVariantList> *sets, QString *error);
+
+    static int histogramBin(qint64 us);
+    static qint64 binLowerUs(int bin);
+    static QString formatLatency(qint64 us);
+
+    // The comparison list kept between runs of the dialog.
+    static QVector<Run> loadRuns();
+    static bool saveRuns(const QVector<Run> &runs, QString *error);
+};
+
+#endif // QUERYBENCHMARK_H
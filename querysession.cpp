@@ -0,0 +1,469 @@
+#include "querysession.h"
+#include "serveractivity.h"
+#include "tracer.h"
+#include <QSqlError>
+#include <QElapsedTimer>
+#include <QRegularExpression>
+#include <QObject>
+
+namespace {
+
+// A browse reads pages of its own size; the session's row cap is for queries.
+TableUtils::FetchLimits pageLimits(TableUtils::FetchLimits limits) {
+    limits.maxRows = BrowseQuery::PageRows;
+    return limits;
+}
+
+// Transaction control typed as SQL; ROLLBACK TO SAVEPOINT is left alone.
+bool transactionStatement(const QString &sql, QuerySession::Transaction *operation) {
+    static const QRegularExpression begin("^\\s*(BEGIN|START\\s+TRANSACTION)\\b[\\s;]*$",
+                                          QRegularExpression::CaseInsensitiveOption);
+    static const QRegularExpression commit("^\\s*(COMMIT|END)\\b[\\s;]*$",
+                                           QRegularExpression::CaseInsensitiveOption);
+    static const QRegularExpression rollback("^\\s*ROLLBACK\\b[\\s;]*$", QRegularExpression::CaseInsensitiveOption);
+    if (begin.match(sql).hasMatch()) {
+        *operation = QuerySession::Begin;
+    } else if (commit.match(sql).hasMatch()) {
+        *operation = QuerySession::Commit;
+    } else if (rollback.match(sql).hasMatch()) {
+        *operation = QuerySession::Rollback;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+QuerySession::QuerySession(const DatabaseConnection::ConnectionParams &params)
+    : params(params), inTransaction(false), seeking(false), backend(0) {
+}
+
+qint64 QuerySession::backendId() const {
+    return backend.loadRelaxed();
+}
+
+bool QuerySession::ensureConnected(QString *error) {
+    if (connection.isConnected()) {
+        return true;
+    }
+    if (!connection.connect(params)) {
+        *error = connection.lastError().text();
+        return false;
+    }
+    QSqlQuery query(connection.database());
+    bool postgres = connection.database().driverName() == "QPSQL";
+    if (query.exec(postgres ? "SELECT pg_backend_pid()" : "SELECT CONNECTION_ID()") && query.next()) {
+        backend.storeRelaxed(query.value(0).toLongLong());
+    }
+    inTransaction = false;
+    return true;
+}
+
+QuerySession::Outcome QuerySession::execute(const QString &sql, const TableUtils::FetchLimits &limits) {
+    Transaction operation;
+    if (transactionStatement(sql, &operation)) {
+        return transaction(operation);
+    }
+    stopBrowsing();
+    return run(sql, limits);
+}
+
+QuerySession::Outcome QuerySession::updateCell(const QString &table, const QString &column, const QString &value,
+                                               const QStringList &rowColumns, const QStringList &rowValues) {
+    Outcome outcome;
+    if (!ensureConnected(&outcome.error)) {
+        return outcome;
+    }
+    outcome.inTransaction = inTransaction;
+    if (params.readOnly) {
+        outcome.error = QObject::tr("Server is configured as read-only");
+        return outcome;
+    }
+    if (rowColumns.isEmpty()) {
+        outcome.error = QObject::tr("The row cannot be identified");
+        return outcome;
+    }
+
+    bool postgres = connection.database().driverName() == "QPSQL";
+    QStringList conditions;
+    QVariantList values;
+    values << value;
+    for (int i = 0; i < rowColumns.size(); ++i) {
+        QString name = connection.quoteIdentifier(rowColumns.at(i));
+        if (rowValues.value(i).isEmpty()) {
+            // The grid shows NULL and '' alike.
+            conditions << QString("(%1 IS NULL OR %2 = '')").arg(name, postgres ? name + "::text" : name);
+        } else {
+            conditions << name + " = ?";
+            values << rowValues.at(i);
+        }
+    }
+    QString where = conditions.join(" AND ");
+    QString quotedTable = connection.quoteIdentifier(table);
+
+    // In the user's transaction a savepoint undoes the edit alone.
+    QSqlDatabase &db = connection.database();
+    QSqlQuery control(db);
+    bool started = inTransaction ? control.exec("SAVEPOINT grid_edit") : db.transaction();
+    if (!started) {
+        outcome.error = inTransaction ? control.lastError().text() : db.lastError().text();
+        return outcome;
+    }
+    auto undo = [&]() {
+        if (inTransaction) {
+            control.exec("ROLLBACK TO SAVEPOINT grid_edit");
+        } else {
+            db.rollback();
+        }
+    };
+
+    QElapsedTimer timer;
+    timer.start();
+    Tracer::Scope span(Tracer::Execute);
+    Tracer::count(Tracer::Statements);
+    // Counted first: MySQL reports changed rows, not matched ones.
+    QSqlQuery query(db);
+    query.prepare(QString("SELECT COUNT(*) FROM %1 WHERE %2").arg(quotedTable, where));
+    for (int i = 1; i < values.size(); ++i) {
+        query.addBindValue(values.at(i));
+    }
+    qint64 matched = -1;
+    if (query.exec() && query.next()) {
+        matched = query.value(0).toLongLong();
+        query.prepare(QString("UPDATE %1 SET %2 = ? WHERE %3")
+                          .arg(quotedTable, connection.quoteIdentifier(column), where));
+        for (const QVariant &bound : values) {
+            query.addBindValue(bound);
+        }
+    }
+    if (matched < 0 || (matched == 1 && !query.exec())) {
+        outcome.error = query.lastError().text();
+        Tracer::count(Tracer::StatementErrors);
+        undo();
+    } else if (matched != 1) {
+        outcome.error = matched == 0 ? QObject::tr("The row no longer exists; nothing was changed")
+                                     : QObject::tr("The edit matches %1 rows; nothing was changed").arg(matched);
+        undo();
+    } else if (inTransaction) {
+        outcome.ok = control.exec("RELEASE SAVEPOINT grid_edit");
+        if (!outcome.ok) outcome.error = control.lastError().text();
+    } else {
+        outcome.ok = db.commit();
+        if (!outcome.ok) {
+            outcome.error = db.lastError().text();
+            db.rollback();
+        }
+    }
+    outcome.rowsAffected = outcome.ok ? 1 : 0;
+    outcome.elapsedMs = timer.elapsed();
+    return outcome;
+}
+
+QuerySession::Outcome QuerySession::browseTable(const BrowseQuery::Request &request,
+                                                const TableUtils::FetchLimits &limits) {
+    Outcome outcome;
+    if (!ensureConnected(&outcome.error)) {
+        return outcome;
+    }
+    stopBrowsing();
+    LargeValues::Browse browse = LargeValues::browse(connection, request.table, request.columns);
+    // Without them the grid only loses key navigation.
+    ForeignKeys::TableKeys keys;
+    QString keysError;
+    ForeignKeys::load(connection, request.table, &keys, &keysError);
+    QString indexUse = BrowseQuery::indexUse(connection, request);
+
+    browsing = request;
+    browseLayout = browse;
+    // Seeking binds the last row's key (and sort value) back, so they must
+    // come from the driver exactly; see BrowseQuery::seekable().
+    bool postgres = connection.database().driverName() == "QPSQL";
+    for (const LargeValues::Column &column : browse.tableColumns) {
+        bool position = browse.keyColumns.contains(column.name) || column.name == request.sortColumn;
+        if (position && !BrowseQuery::seekable(column, postgres)) {
+            browseLayout.keyColumns.clear();
+        }
+    }
+    seeking = !browseLayout.keyColumns.isEmpty();
+    outcome = browsePage(pageLimits(limits));
+    outcome.browse = browse;
+    outcome.foreignKeys = keys;
+    outcome.foreignKeysError = keysError;
+    outcome.note = indexUse;
+    return outcome;
+}
+
+QuerySession::Outcome QuerySession::browsePage(const TableUtils::FetchLimits &limits) {
+    Outcome outcome;
+    outcome.inTransaction = inTransaction;
+    BrowseQuery::Statement statement;
+    // One row past the page tells whether another page follows.
+    int limit = seeking ? int(limits.maxRows) + 1 : 0;
+    if (!BrowseQuery::build(connection, browseLayout, browsing, position, limit, &statement, &outcome.error)) {
+        return outcome;
+    }
+    pending = QSqlQuery();
+    outcome = run(statement.sql, limits, statement.values);
+    if (!seeking || !outcome.ok) {
+        return outcome;
+    }
+    outcome.totalRows = -1;   // the server counted this page only
+    if (!outcome.batch.rows.isEmpty()) {
+        const TableUtils::RowBatch &batch = outcome.batch;
+        const QVector<QVariant> &last = batch.rows.last();
+        position.valid = true;
+        position.sortValue = browsing.sortColumn.isEmpty() ? QVariant()
+                                                           : last.value(batch.columns.indexOf(browsing.sortColumn));
+        position.keyValues.clear();
+        for (const QString &key : browseLayout.keyColumns) {
+            position.keyValues << last.value(batch.columns.indexOf(key));
+        }
+    }
+    return outcome;
+}
+
+void QuerySession::stopBrowsing() {
+    pending = QSqlQuery();
+    seeking = false;
+    browsing = BrowseQuery::Request();
+    position = BrowseQuery::Position();
+}
+
+QuerySession::Outcome QuerySession::sampleTable(const QString &table, const TableSampler::Options &options,
+                                                const TableUtils::FetchLimits &limits) {
+    Outcome outcome;
+    if (!ensureConnected(&outcome.error)) {
+        return outcome;
+    }
+    QString sql;
+    QString note;
+    if (!TableSampler::buildQuery(connection, table, options, &sql, &note)) {
+        outcome.error = note;
+        outcome.inTransaction = inTransaction;
+        return outcome;
+    }
+    stopBrowsing();
+    outcome = run(sql, limits);
+    outcome.note = note;
+    return outcome;
+}
+
+QuerySession::Outcome QuerySession::run(const QString &sql, const TableUtils::FetchLimits &limits,
+                                        const QVariantList &values) {
+    Outcome outcome;
+    if (!ensureConnected(&outcome.error)) {
+        return outcome;
+    }
+    outcome.inTransaction = inTransaction;
+
+    QElapsedTimer timer;
+    timer.start();
+    QSqlQuery query;
+    if (!inTransaction && values.isEmpty()) {
+        // Outside an explicit transaction, executeQuery() wraps DML in one.
+        outcome.ok = connection.executeQuery(sql, query, true);
+        if (!outcome.ok) {
+            outcome.error = connection.lastError().text();
+        }
+    } else if (params.readOnly && DatabaseConnection::isWriteStatement(sql)) {
+        outcome.error = QObject::tr("Server is configured as read-only");
+    } else {
+        Tracer::Scope span(Tracer::Execute);
+        Tracer::count(Tracer::Statements);
+        // Bound values only come with browse SELECTs, which need no wrapping.
+        query = QSqlQuery(connection.database());
+        query.setForwardOnly(true);
+        if (values.isEmpty()) {
+            outcome.ok = query.exec(sql);
+        } else {
+            outcome.ok = query.prepare(sql);
+            for (const QVariant &value : values) {
+                query.addBindValue(value);
+            }
+            outcome.ok = outcome.ok && query.exec();
+        }
+        if (!outcome.ok) {
+            outcome.error = query.lastError().text();
+            Tracer::count(Tracer::StatementErrors);
+        }
+    }
+    if (!outcome.ok) {
+        outcome.elapsedMs = timer.elapsed();
+        return outcome;
+    }
+
+    outcome.select = query.isSelect();
+    if (outcome.select) {
+        TableUtils::FetchResult fetched = TableUtils::readBatch(query, limits, false, &outcome.batch);
+        outcome.truncated = fetched.truncated;
+        outcome.totalRows = query.size();
+        outcome.bytes = fetched.bytes;
+        if (fetched.truncated) {
+            pending = query;
+        }
+    } else {
+        outcome.rowsAffected = query.numRowsAffected();
+    }
+    outcome.elapsedMs = timer.elapsed();
+    return outcome;
+}
+
+QuerySession::Outcome QuerySession::fetchMore(const TableUtils::FetchLimits &limits) {
+    if (seeking) {
+        return browsePage(pageLimits(limits));
+    }
+    Outcome outcome;
+    outcome.inTransaction = inTransaction;
+    if (!pending.isActive()) {
+        pending = QSqlQuery();
+        outcome.error = QObject::tr("The result is no longer available");
+        return outcome;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    // A browse without a usable key reads on from the cursor, page by page.
+    TableUtils::FetchLimits batchLimits = browsing.table.isEmpty() ? limits : pageLimits(limits);
+    TableUtils::FetchResult fetched = TableUtils::readBatch(pending, batchLimits, true, &outcome.batch);
+    outcome.ok = true;
+    outcome.select = true;
+    outcome.truncated = fetched.truncated;
+    outcome.totalRows = pending.size();
+    outcome.bytes = fetched.bytes;
+    if (!fetched.truncated) {
+        pending = QSqlQuery();
+    }
+    outcome.elapsedMs = timer.elapsed();
+    return outcome;
+}
+
+QuerySession::Outcome QuerySession::spool(ResultStore *store, const TableUtils::PreviewLayout &layout) {
+    Outcome outcome;
+    outcome.inTransaction = inTransaction;
+    if (seeking) {
+        // The rest of the table after the last row read, as one result.
+        BrowseQuery::Statement statement;
+        if (!BrowseQuery::build(connection, browseLayout, browsing, position, 0, &statement, &outcome.error)) {
+            return outcome;
+        }
+        seeking = false;
+        pending = QSqlQuery(connection.database());
+        pending.setForwardOnly(true);
+        bool ok = pending.prepare(statement.sql);
+        for (const QVariant &value : statement.values) {
+            pending.addBindValue(value);
+        }
+        if (!ok || !pending.exec()) {
+            outcome.error = pending.lastError().text();
+            pending = QSqlQuery();
+            return outcome;
+        }
+        if (!pending.next()) {
+            pending = QSqlQuery();
+            outcome.ok = true;
+            outcome.select = true;
+            outcome.totalRows = store->rowCount();
+            return outcome;
+        }
+    }
+    if (!pending.isActive()) {
+        pending = QSqlQuery();
+        outcome.error = QObject::tr("The result is no longer available");
+        return outcome;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    TableUtils::FetchLimits limits;
+    limits.maxRows = ResultStore::ChunkRows;
+    const int columns = store->headers().size();
+    TableUtils::RowBatch batch;
+    QVector<QStringList> rows;
+    bool more = true;
+    while (more && !store->isCanceled()) {
+        TableUtils::FetchResult fetched = TableUtils::readBatch(pending, limits, true, &batch);
+        rows.clear();
+        rows.reserve(batch.rows.size());
+        {
+            Tracer::Scope span(Tracer::Decode);
+            span.setValue(batch.rows.size());
+            for (const QVector<QVariant> &values : batch.rows) {
+                QStringList cells;
+                cells.reserve(columns);
+                for (int col = 0; col < columns; ++col) {
+                    cells << TableUtils::cellText(values, col, layout);
+                }
+                rows << cells;
+            }
+        }
+        if (!store->append(rows, &outcome.error)) {
+            pending = QSqlQuery();
+            outcome.elapsedMs = timer.elapsed();
+            return outcome;
+        }
+        more = fetched.truncated;
+    }
+    if (more) {
+        outcome.note = QObject::tr("Canceled after %1 rows").arg(store->rowCount());
+    }
+    pending = QSqlQuery();
+    outcome.ok = true;
+    outcome.select = true;
+    outcome.totalRows = store->rowCount();
+    outcome.elapsedMs = timer.elapsed();
+    return outcome;
+}
+
+QuerySession::Outcome QuerySession::transaction(Transaction operation) {
+    Outcome outcome;
+    outcome.transactionControl = true;
+    stopBrowsing();
+    if (!ensureConnected(&outcome.error)) {
+        return outcome;
+    }
+    QSqlDatabase &db = connection.database();
+    if (operation == Begin) {
+        if (inTransaction) {
+            outcome.error = QObject::tr("A transaction is already open");
+        } else if (!db.transaction()) {
+            outcome.error = db.lastError().text();
+        } else {
+            inTransaction = true;
+            outcome.ok = true;
+        }
+    } else if (!inTransaction) {
+        outcome.error = QObject::tr("No transaction is open");
+    } else {
+        outcome.ok = operation == Commit ? db.commit() : db.rollback();
+        if (!outcome.ok) {
+            outcome.error = db.lastError().text();
+        }
+        // A failed COMMIT still ends the transaction: PostgreSQL rolls it
+        // back, MySQL keeps running in autocommit.
+        if (outcome.ok || operation == Commit) {
+            inTransaction = false;
+        }
+    }
+    outcome.inTransaction = inTransaction;
+    return outcome;
+}
+
+void QuerySession::close() {
+    stopBrowsing();
+    if (inTransaction) {
+        connection.database().rollback();
+        inTransaction = false;
+    }
+    connection.disconnect();
+    backend.storeRelaxed(0);
+}
+
+bool QuerySession::cancel(const DatabaseConnection::ConnectionParams &params, qint64 backendId, QString *error) {
+    if (backendId == 0) {
+        *error = QObject::tr("The session is not connected yet");
+        return false;
+    }
+    ServerActivity activity(params);
+    bool ok = activity.cancel(QString::number(backendId), false, error);
+    activity.close();
+    return ok;
+}
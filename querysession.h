@@ -0,0 +1,92 @@
+#ifndef QUERYSESSION_H
+#define QUERYSESSION_H
+
+#include <QString>
+#include <QSqlQuery>
+#include <QAtomicInteger>
+#include "databaseconnection.h"
+#include "tableutils.h"
+#include "tablesampler.h"
+#include "largevalues.h"
+#include "resultstore.h"
+#include "foreignkeys.h"
+#include "browsequery.h"
+
+// The connection behind one query tab. Every call except backendId() and
+// cancel() must come from the same thread, the tab's worker; results come
+// back as row batches for the grid to show on the GUI thread.
+class QuerySession {
+public:
+    enum Transaction { Begin, Commit, Rollback };
+
+    struct Outcome {
+        Outcome() : ok(false), select(false), truncated(false), rowsAffected(-1), totalRows(-1), bytes(0),
+                    elapsedMs(0), transactionControl(false), inTransaction(false) {}
+        bool ok;
+        QString error;
+        QString note;
+        bool select;                 // the statement returned rows
+        bool truncated;              // more rows wait in the session
+        int rowsAffected;
+        int totalRows;               // rows in the whole result, -1 when the driver cannot tell
+        qint64 bytes;                // estimated grid memory of the batch
+        qint64 elapsedMs;
+        bool transactionControl;     // BEGIN, COMMIT or ROLLBACK
+        bool inTransaction;          // state after the call
+        TableUtils::RowBatch batch;
+        LargeValues::Browse browse;  // set by browseTable()
+        ForeignKeys::TableKeys foreignKeys;
+        QString foreignKeysError;    // the browse works without them
+    };
+
+    explicit QuerySession(const DatabaseConnection::ConnectionParams &params);
+
+    // BEGIN, START TRANSACTION, COMMIT and ROLLBACK typed in the editor go
+    // through transaction(), so the session always knows its state.
+    Outcome execute(const QString &sql, const TableUtils::FetchLimits &limits);
+    // Sets one cell of the row whose `rowColumns` hold `rowValues` (grid
+    // texts; empty matches NULL or ''), keeping the pending result. The
+    // change is rolled back unless exactly one row matched.
+    Outcome updateCell(const QString &table, const QString &column, const QString &value,
+                       const QStringList &rowColumns, const QStringList &rowValues);
+    // A filtered, sorted browse; with a primary key, fetchMore() and spool()
+    // continue by key from the last row read (see BrowseQuery).
+    Outcome browseTable(const BrowseQuery::Request &request, const TableUtils::FetchLimits &limits);
+    Outcome sampleTable(const QString &table, const TableSampler::Options &options,
+                        const TableUtils::FetchLimits &limits);
+    Outcome fetchMore(const TableUtils::FetchLimits &limits);
+    // Reads the rest of the pending result into the store, as the grid
+    // would show it, until the result ends or the store is canceled.
+    Outcome spool(ResultStore *store, const TableUtils::PreviewLayout &layout);
+    Outcome transaction(Transaction operation);
+    // Rolls back an open transaction and disconnects.
+    void close();
+
+    const DatabaseConnection::ConnectionParams &connectionParams() const { return params; }
+    // Server-side id of the connection (backend pid or connection id), 0
+    // until connected. Safe from any thread.
+    qint64 backendId() const;
+    // Stops the statement running on that backend, through a connection of
+    // its own; call it from any thread but the session's.
+    static bool cancel(const DatabaseConnection::ConnectionParams &params, qint64 backendId, QString *error);
+
+private:
+    bool ensureConnected(QString *error);
+    // Runs one statement; a truncated result becomes the pending one.
+    Outcome run(const QString &sql, const TableUtils::FetchLimits &limits,
+                const QVariantList &values = QVariantList());
+    Outcome browsePage(const TableUtils::FetchLimits &limits);
+    void stopBrowsing();
+
+    DatabaseConnection::ConnectionParams params;
+    DatabaseConnection connection;
+    QSqlQuery pending;
+    bool inTransaction;
+    bool seeking;                        // the pending result is a page read by key
+    BrowseQuery::Request browsing;
+    LargeValues::Browse browseLayout;
+    BrowseQuery::Position position;      // after the last row read
+    QAtomicInteger<qint64> backend;
+};
+
+#endif // QUERYSESSION_H
@@ -0,0 +1,259 @@
+#include "querystatistics.h"
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QSqlError>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QRegularExpression>
+#include <QStringList>
+#include <QObject>
+
+namespace {
+
+// Up to this many unseen statements are fetched by id; beyond that (the
+// first sample, or after a reset) one pass over all texts is cheaper.
+const int MaxTextLookups = 500;
+
+QString missingSourceError(const QSqlError &error, bool postgres) {
+    if (postgres) {
+        return QObject::tr("pg_stat_statements is not available (it must be in shared_preload_libraries "
+                           "and created with CREATE EXTENSION pg_stat_statements): %1").arg(error.text());
+    }
+    return QObject::tr("performance_schema statement digests are not available: %1").arg(error.text());
+}
+
+} // namespace
+
+QueryStatistics::QueryStatistics(const DatabaseConnection::ConnectionParams &params)
+    : params(params), serverVersion(0) {
+}
+
+bool QueryStatistics::ensureConnected(QString *error) {
+    if (connection.isConnected()) {
+        return true;
+    }
+    if (!connection.connect(params)) {
+        *error = connection.lastError().text();
+        return false;
+    }
+    if (connection.database().driverName() == "QPSQL") {
+        QSqlQuery query(connection.database());
+        if (query.exec("SHOW server_version_num") && query.next()) {
+            serverVersion = query.value(0).toInt();
+        }
+    }
+    return true;
+}
+
+void QueryStatistics::close() {
+    connection.disconnect();
+}
+
+QueryStatistics::Sample QueryStatistics::sample() {
+    Sample sample;
+    QElapsedTimer timer;
+    timer.start();
+    if (!ensureConnected(&sample.error)) {
+        return sample;
+    }
+    sample.postgres = connection.database().driverName() == "QPSQL";
+    sample.takenMs = QDateTime::currentMSecsSinceEpoch();
+    sample.ok = sample.postgres ? samplePostgres(&sample) : sampleMysql(&sample);
+    if (!sample.ok) {
+        // Reconnect on the next sample if the connection was lost.
+        connection.disconnect();
+    }
+    sample.elapsedMs = timer.elapsed();
+    return sample;
+}
+
+bool QueryStatistics::samplePostgres(Sample *sample) {
+    // pg_stat_statements(false) skips reading the query text file, which is
+    // most of the cost of the view.
+    QString totalTime = serverVersion >= 130000 ? "total_exec_time" : "total_time";
+    QSqlQuery query(connection.database());
+    query.setForwardOnly(true);
+    if (!query.exec(QString("SELECT queryid, userid, dbid, calls, %1, rows, shared_blks_hit, shared_blks_read "
+                            "FROM pg_stat_statements(false) WHERE queryid IS NOT NULL").arg(totalTime))) {
+        sample->error = missingSourceError(query.lastError(), true);
+        return false;
+    }
+    QStringList unseen;
+    while (query.next()) {
+        QString id = QString("%1:%2:%3").arg(query.value(0).toString(), query.value(1).toString(),
+                                             query.value(2).toString());
+        Counters counters;
+        counters.calls = query.value(3).toLongLong();
+        counters.totalMs = query.value(4).toDouble();
+        counters.rows = query.value(5).toLongLong();
+        counters.blocksHit = query.value(6).toLongLong();
+        counters.blocksRead = query.value(7).toLongLong();
+        sample->counters.insert(id, counters);
+        if (!knownIds.contains(id)) {
+            unseen << query.value(0).toString();
+        }
+    }
+    if (unseen.isEmpty()) {
+        return true;
+    }
+
+    QString sql = "SELECT s.queryid, s.userid, s.dbid, COALESCE(d.datname, ''), s.query "
+                  "FROM pg_stat_statements(true) s LEFT JOIN pg_database d ON d.oid = s.dbid "
+                  "WHERE s.queryid IS NOT NULL";
+    if (unseen.size() <= MaxTextLookups) {
+        unseen.removeDuplicates();
+        sql += QString(" AND s.queryid IN (%1)").arg(unseen.join(','));
+    }
+    if (!query.exec(sql)) {
+        // Counters are still useful; texts are retried with the next sample.
+        return true;
+    }
+    while (query.next()) {
+        QString id = QString("%1:%2:%3").arg(query.value(0).toString(), query.value(1).toString(),
+                                             query.value(2).toString());
+        if (knownIds.contains(id) || !sample->counters.contains(id)) continue;
+        Text text;
+        text.database = query.value(3).toString();
+        text.query = query.value(4).toString();
+        sample->texts.insert(id, text);
+        knownIds.insert(id);
+    }
+    return true;
+}
+
+bool QueryStatistics::sampleMysql(Sample *sample) {
+    // SUM_TIMER_WAIT is in picoseconds.
+    QSqlQuery query(connection.database());
+    query.setForwardOnly(true);
+    if (!query.exec("SELECT COALESCE(SCHEMA_NAME, ''), DIGEST, COUNT_STAR, SUM_TIMER_WAIT / 1000000000, "
+                    "SUM_ROWS_SENT + SUM_ROWS_AFFECTED, SUM_ROWS_EXAMINED "
+                    "FROM performance_schema.events_statements_summary_by_digest WHERE DIGEST IS NOT NULL")) {
+        sample->error = missingSourceError(query.lastError(), false);
+        return false;
+    }
+    QStringList unseen;
+    while (query.next()) {
+        QString id = query.value(0).toString() + ":" + query.value(1).toString();
+        Counters counters;
+        counters.calls = query.value(2).toLongLong();
+        counters.totalMs = query.value(3).toDouble();
+        counters.rows = query.value(4).toLongLong();
+        counters.rowsExamined = query.value(5).toLongLong();
+        sample->counters.insert(id, counters);
+        if (!knownIds.contains(id)) {
+            unseen << "'" + query.value(1).toString() + "'";
+        }
+    }
+    if (unseen.isEmpty()) {
+        return true;
+    }
+
+    QString sql = "SELECT COALESCE(SCHEMA_NAME, ''), DIGEST, DIGEST_TEXT "
+                  "FROM performance_schema.events_statements_summary_by_digest WHERE DIGEST IS NOT NULL";
+    if (unseen.size() <= MaxTextLookups) {
+        unseen.removeDuplicates();
+        sql += QString(" AND DIGEST IN (%1)").arg(unseen.join(','));
+    }
+    if (!query.exec(sql)) {
+        return true;
+    }
+    while (query.next()) {
+        QString id = query.value(0).toString() + ":" + query.value(1).toString();
+        if (knownIds.contains(id) || !sample->counters.contains(id)) continue;
+        Text text;
+        text.database = query.value(0).toString();
+        text.query = query.value(2).toString();
+        sample->texts.insert(id, text);
+        knownIds.insert(id);
+    }
+    return true;
+}
+
+QVector<QueryStatistics::Statement> QueryStatistics::delta(const Sample &from, const Sample &to) {
+    QVector<Statement> statements;
+    for (auto it = to.counters.constBegin(); it != to.counters.constEnd(); ++it) {
+        Counters before = from.counters.value(it.key());
+        const Counters &after = it.value();
+        if (after.calls < before.calls) {
+            before = Counters();
+        }
+        if (after.calls == before.calls) continue;
+
+        Statement statement;
+        statement.id = it.key();
+        statement.delta.calls = after.calls - before.calls;
+        statement.delta.totalMs = qMax(0.0, after.totalMs - before.totalMs);
+        statement.delta.rows = qMax<qint64>(0, after.rows - before.rows);
+        statement.delta.blocksHit = qMax<qint64>(0, after.blocksHit - before.blocksHit);
+        statement.delta.blocksRead = qMax<qint64>(0, after.blocksRead - before.blocksRead);
+        statement.delta.rowsExamined = qMax<qint64>(0, after.rowsExamined - before.rowsExamined);
+        statements << statement;
+    }
+    return statements;
+}
+
+bool QueryStatistics::explain(const DatabaseConnection::ConnectionParams &params, const QString &database,
+                              const QString &sql, QString *plan, QString *error) {
+    DatabaseConnection::ConnectionParams target = params;
+    if (!database.isEmpty()) {
+        target.dbName = database;
+    }
+    DatabaseConnection connection;
+    if (!connection.connect(target)) {
+        *error = connection.lastError().text();
+        return false;
+    }
+
+    bool ok = false;
+    {
+        QSqlQuery query(connection.database());
+        query.setForwardOnly(true);
+        QStringList lines;
+        if (connection.database().driverName() == "QPSQL") {
+            QString prefix = "EXPLAIN ";
+            if (sql.contains(QRegularExpression("\\$\\d+"))) {
+                int version = 0;
+                if (query.exec("SHOW server_version_num") && query.next()) {
+                    version = query.value(0).toInt();
+                }
+                prefix = "EXPLAIN (GENERIC_PLAN) ";
+                if (version < 160000) {
+                    *error = QObject::tr("The statement has parameters; a generic plan needs PostgreSQL 16 or later");
+                }
+            }
+            if (error->isEmpty() && query.exec(prefix + sql)) {
+                while (query.next()) {
+                    lines << query.value(0).toString();
+                }
+                ok = true;
+            }
+        } else if (sql.contains('?') || sql.endsWith("...")) {
+            *error = QObject::tr("The digest has placeholders or was truncated; fill in values to explain it");
+        } else if (query.exec("EXPLAIN FORMAT=TREE " + sql)) {
+            while (query.next()) {
+                lines << query.value(0).toString();
+            }
+            ok = true;
+        } else if (query.exec("EXPLAIN " + sql)) {
+            // Before 8.0.16: one row per table access.
+            QSqlRecord record = query.record();
+            while (query.next()) {
+                QStringList fields;
+                for (int i = 0; i < record.count(); ++i) {
+                    if (!query.isNull(i)) {
+                        fields << record.fieldName(i) + "=" + query.value(i).toString();
+                    }
+                }
+                lines << fields.join(", ");
+            }
+            ok = true;
+        }
+        if (ok) {
+            *plan = lines.join('\n');
+        } else if (error->isEmpty()) {
+            *error = query.lastError().text();
+        }
+    }
+    connection.disconnect();
+    return ok;
+}
@@ -0,0 +1,75 @@
+#ifndef QUERYSTATISTICS_H
+#define QUERYSTATISTICS_H
+
+#include <QString>
+#include <QHash>
+#include <QSet>
+#include <QVector>
+#include "databaseconnection.h"
+
+// Cumulative per-statement counters from pg_stat_statements or
+// performance_schema.events_statements_summary_by_digest. The server only
+// keeps totals since its last reset; rates over a window come from the
+// difference of two samples taken by the client.
+class QueryStatistics {
+public:
+    struct Counters {
+        Counters() : calls(0), totalMs(0), rows(0), blocksHit(0), blocksRead(0), rowsExamined(0) {}
+        qint64 calls;
+        double totalMs;
+        qint64 rows;
+        qint64 blocksHit;      // shared buffer hits (PostgreSQL)
+        qint64 blocksRead;     // shared blocks read (PostgreSQL)
+        qint64 rowsExamined;   // MySQL
+    };
+
+    struct Text {
+        QString database;
+        QString query;
+    };
+
+    struct Sample {
+        Sample() : ok(false), postgres(false), takenMs(0), elapsedMs(0) {}
+        bool ok;
+        QString error;
+        bool postgres;
+        qint64 takenMs;                    // client clock, ms since epoch
+        qint64 elapsedMs;
+        QHash<QString, Counters> counters;
+        // Texts of statements this collector has not reported before; the
+        // caller keeps them, so each text crosses the network once.
+        QHash<QString, Text> texts;
+    };
+
+    struct Statement {
+        QString id;
+        QString database;
+        QString query;
+        Counters delta;
+    };
+
+    explicit QueryStatistics(const DatabaseConnection::ConnectionParams &params);
+
+    Sample sample();
+    void close();
+
+    // Statements that ran between the two samples. A counter that went
+    // backwards means the statistics were reset, and counts from zero.
+    static QVector<Statement> delta(const Sample &from, const Sample &to);
+    // Plan of a normalized statement, from a short-lived connection to the
+    // statement's database. Never runs the statement.
+    static bool explain(const DatabaseConnection::ConnectionParams &params, const QString &database,
+                        const QString &sql, QString *plan, QString *error);
+
+private:
+    bool ensureConnected(QString *error);
+    bool samplePostgres(Sample *sample);
+    bool sampleMysql(Sample *sample);
+
+    DatabaseConnection::ConnectionParams params;
+    DatabaseConnection connection;
+    int serverVersion;
+    QSet<QString> knownIds;
+};
+
+#endif // QUERYSTATISTICS_H
@@ -0,0 +1,1271 @@
+#include "querytab.h"
+#include "valueviewerdialog.h"
+#include "schemaindex.h"
+#include "resultmemory.h"
+#include "columnchooserdialog.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QSplitter>
+#include <QHeaderView>
+#include <QScrollBar>
+#include <QGuiApplication>
+#include <QMessageBox>
+#include <QMenu>
+#include <QAction>
+#include <QSet>
+#include <QLocale>
+#include <QtConcurrent>
+#include <algorithm>
+
+namespace {
+
+const int MaxHistory = 100;
+const int HistoryLabelChars = 80;
+const int SpoolRefreshMs = 500;
+// Copying from a spooled result builds the text in memory; beyond this,
+// exporting is the way out.
+const qint64 MaxSpooledCopyCells = 1000000;
+// Scrolling settles before referenced rows are looked up.
+const int PrefetchDelayMs = 150;
+// Referenced rows in tooltips: this many columns, values cut at this length.
+const int MaxReferenceColumns = 20;
+const int MaxReferenceChars = 80;
+
+} // namespace
+
+QueryTab::QueryTab(QWidget *parent, const SchemaIndex *schemaIndex)
+    : QWidget(parent)
+    , request(NoRequest)
+    , refreshing(false)
+    , transactionOpen(false)
+    , editRow(-1)
+    , editColumn(-1)
+    , sortColumn(-1)
+    , gridBytes(0)
+    , resultRows(-1)
+    , sortOrder(Qt::AscendingOrder)
+    , referenceGeneration(0)
+    , lookupGeneration(0)
+    , lookupFirst(0)
+    , lookupLast(-1)
+    , prefetchAgain(false)
+{
+    // The session's connection lives on this one thread for the tab's lifetime.
+    pool.setMaxThreadCount(1);
+    pool.setExpiryTimeout(-1);
+    // So does the connection looking up referenced rows.
+    lookupPool.setMaxThreadCount(1);
+    lookupPool.setExpiryTimeout(-1);
+
+    auto layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+
+    auto sessionLayout = new QHBoxLayout;
+    targetLabel = new QLabel(this);
+    sessionLayout->addWidget(targetLabel);
+    sessionLayout->addStretch();
+    historyButton = new QToolButton(this);
+    historyButton->setText(tr("History"));
+    sessionLayout->addWidget(historyButton);
+    pivotButton = new QToolButton(this);
+    pivotButton->setText(tr("Pivot"));
+    pivotButton->setCheckable(true);
+    sessionLayout->addWidget(pivotButton);
+    beginButton = new QPushButton(tr("Begin"), this);
+    commitButton = new QPushButton(tr("Commit"), this);
+    rollbackButton = new QPushButton(tr("Rollback"), this);
+    sessionLayout->addWidget(beginButton);
+    sessionLayout->addWidget(commitButton);
+    sessionLayout->addWidget(rollbackButton);
+    layout->addLayout(sessionLayout);
+
+    queryEdit = new SqlEditor(this);
+    queryEdit->setPlaceholderText(tr("Enter SQL query..."));
+    queryEdit->setSchemaIndex(schemaIndex);
+    layout->addWidget(queryEdit);
+
+    auto executeLayout = new QHBoxLayout;
+    executeButton = new QPushButton(tr("Execute"), this);
+    stopButton = new QPushButton(tr("Stop"), this);
+    executeLayout->addWidget(executeButton, 1);
+    executeLayout->addWidget(stopButton);
+    layout->addLayout(executeLayout);
+
+    auto executeStatementAction = new QAction(tr("Execute Statement"), queryEdit);
+    executeStatementAction->setShortcut(QKeySequence(Qt::CTRL | Qt::Key_Return));
+    executeStatementAction->setShortcutContext(Qt::WidgetShortcut);
+    queryEdit->addAction(executeStatementAction);
+
+    dataTable = new QTableWidget(this);
+    dataTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    dataTable->setSortingEnabled(false);
+    dataTable->horizontalHeader()->setSectionsClickable(true);
+    dataTable->setContextMenuPolicy(Qt::CustomContextMenu);
+    spoolView = new QTableView(this);
+    spoolModel = new ResultStoreModel(spoolView);
+    connect(spoolModel, &ResultStoreModel::readFailed, this, [this](const QString &error) {
+        setStatus(tr("Reading the result back failed: %1").arg(error));
+    });
+    spoolView->setModel(spoolModel);
+    spoolView->setContextMenuPolicy(Qt::CustomContextMenu);
+    // Fixed row heights keep the view from measuring rows it does not show.
+    spoolView->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    spoolView->verticalHeader()->setDefaultSectionSize(spoolView->fontMetrics().height() + 6);
+    resultStack = new QStackedWidget(this);
+    resultStack->addWidget(dataTable);
+    resultStack->addWidget(spoolView);
+    auto resultSplitter = new QSplitter(Qt::Horizontal, this);
+    resultSplitter->addWidget(resultStack);
+    pivotPanel = new PivotPanel(dataTable, resultSplitter);
+    pivotPanel->hide();
+    resultSplitter->addWidget(pivotPanel);
+    resultSplitter->setStretchFactor(0, 3);
+    resultSplitter->setStretchFactor(1, 2);
+    staleLabel = new QLabel(this);
+    staleLabel->setStyleSheet("color: #d08000;");
+    staleLabel->setWordWrap(true);
+    staleLabel->hide();
+    layout->addWidget(staleLabel);
+    filterBar = new FilterBar(this);
+    filterBar->hide();
+    layout->addWidget(filterBar);
+    layout->addWidget(resultSplitter);
+
+    truncationBar = new QWidget(this);
+    auto truncationLayout = new QHBoxLayout(truncationBar);
+    truncationLayout->setContentsMargins(0, 0, 0, 0);
+    truncationLabel = new QLabel(truncationBar);
+    truncationLabel->setStyleSheet("color: #d08000;");
+    auto fetchMoreButton = new QPushButton(tr("Fetch more"), truncationBar);
+    auto fetchAllButton = new QPushButton(tr("Fetch all"), truncationBar);
+    truncationLayout->addWidget(truncationLabel);
+    truncationLayout->addStretch();
+    truncationLayout->addWidget(fetchMoreButton);
+    truncationLayout->addWidget(fetchAllButton);
+    truncationBar->hide();
+    layout->addWidget(truncationBar);
+
+    spoolTimer.setInterval(SpoolRefreshMs);
+    prefetchTimer.setInterval(PrefetchDelayMs);
+    prefetchTimer.setSingleShot(true);
+
+    connect(&watcher, &QFutureWatcher<QuerySession::Outcome>::finished, this, &QueryTab::showOutcome);
+    connect(&spoolTimer, &QTimer::timeout, this, &QueryTab::showSpoolProgress);
+    connect(executeButton, &QPushButton::clicked, this, &QueryTab::executeQuery);
+    connect(executeStatementAction, &QAction::triggered, this, &QueryTab::executeStatement);
+    connect(stopButton, &QPushButton::clicked, this, &QueryTab::cancelQuery);
+    connect(beginButton, &QPushButton::clicked, this, &QueryTab::beginTransaction);
+    connect(commitButton, &QPushButton::clicked, this, &QueryTab::commitTransaction);
+    connect(rollbackButton, &QPushButton::clicked, this, &QueryTab::rollbackTransaction);
+    connect(historyButton, &QToolButton::clicked, this, &QueryTab::showHistoryMenu);
+    connect(pivotButton, &QToolButton::toggled, pivotPanel, &QWidget::setVisible);
+    connect(fetchMoreButton, &QPushButton::clicked, this, &QueryTab::fetchMoreRows);
+    connect(fetchAllButton, &QPushButton::clicked, this, &QueryTab::fetchAllRows);
+    connect(filterBar, &FilterBar::applied, [this]() {
+        if (browse.table.isEmpty()) return;
+        browseRequest.conditions = filterBar->conditions();
+        runBrowse(tr("Filtering %1...").arg(browseRequest.table));
+    });
+    connect(filterBar, &FilterBar::columnsRequested, this, &QueryTab::chooseColumns);
+    connect(dataTable, &QTableWidget::cellChanged, this, &QueryTab::onCellChanged);
+    connect(dataTable, &QTableWidget::cellDoubleClicked, [this](int row, int column) {
+        // Preview cells are read-only; double-click opens them instead.
+        QTableWidgetItem *item = dataTable->item(row, column);
+        if (item && item->data(TableUtils::FullSizeRole).isValid()) {
+            viewCellValue(row, column);
+        }
+    });
+    connect(dataTable->horizontalHeader(), &QHeaderView::sectionClicked, this, &QueryTab::onHeaderClicked);
+    connect(dataTable, &QTableWidget::cellClicked, [this](int row, int column) {
+        // Ctrl+click follows a foreign key, as links do in editors.
+        if (!(QGuiApplication::keyboardModifiers() & Qt::ControlModifier)) return;
+        for (int key = 0; key < keyColumns.size(); ++key) {
+            if (keyColumns.at(key).contains(column)) {
+                openReferencedRow(key, row);
+                return;
+            }
+        }
+    });
+    connect(dataTable->verticalScrollBar(), &QScrollBar::valueChanged, [this]() { prefetchTimer.start(); });
+    connect(&prefetchTimer, &QTimer::timeout, this, &QueryTab::prefetchReferences);
+    connect(&lookupWatcher, &QFutureWatcher<QVector<ForeignKeys::Lookup>>::finished, this, &QueryTab::showReferences);
+    connect(queryEdit, &SqlEditor::loadProgress, [this](qint64 bytesRead, qint64 bytesTotal) {
+        setStatus(tr("Loading script... %1%").arg(bytesTotal > 0 ? bytesRead * 100 / bytesTotal : 100));
+    });
+    connect(queryEdit, &SqlEditor::loadFinished, [this]() {
+        setStatus(tr("Script loaded: %n line(s)", nullptr, queryEdit->blockCount()));
+    });
+
+    updateControls();
+}
+
+QueryTab::~QueryTab()
+{
+    if (spooled) {
+        spooled->cancel();
+    }
+    if (isBusy() && session) {
+        // Do not wait for a long statement to finish on its own.
+        QString error;
+        QuerySession::cancel(params, session->backendId(), &error);
+    }
+    watcher.waitForFinished();
+    if (session) {
+        QuerySession *source = session.data();
+        QtConcurrent::run(&pool, [source]() { source->close(); }).waitForFinished();
+    }
+    closeLookup();
+    setGridBytes(0);
+}
+
+void QueryTab::bind(const QString &serverName, const DatabaseConnection::ConnectionParams &connectionParams)
+{
+    if (isBusy() || transactionOpen) return;
+    if (session) {
+        QuerySession *source = session.data();
+        QtConcurrent::run(&pool, [source]() { source->close(); }).waitForFinished();
+    }
+    closeLookup();
+    server = serverName;
+    params = connectionParams;
+    session.reset(new QuerySession(params));
+    lookupConnection.reset(new DatabaseConnection);
+    queryEdit->setDialect(params.driver == "QMYSQL" ? SqlHighlighter::MySql : SqlHighlighter::PostgreSql);
+    browse = LargeValues::Browse();
+    resetReferences(ForeignKeys::TableKeys());
+    updateControls();
+    emit stateChanged(this);
+}
+
+bool QueryTab::isBound() const
+{
+    return !session.isNull();
+}
+
+bool QueryTab::isBoundTo(const QString &serverName, const QString &database) const
+{
+    return isBound() && server == serverName && params.dbName == database;
+}
+
+QString QueryTab::title() const
+{
+    if (!isBound()) return tr("Query");
+    return QString("%1 / %2").arg(server, params.dbName);
+}
+
+bool QueryTab::isBusy() const
+{
+    return request != NoRequest;
+}
+
+TableUtils::FetchLimits QueryTab::fetchLimits() const
+{
+    TableUtils::FetchLimits limits;
+    limits.maxRows = params.maxRows;
+    limits.maxBytes = qint64(params.maxResultMemoryMb) * 1024 * 1024;
+    return limits;
+}
+
+bool QueryTab::prepareRun()
+{
+    if (queryEdit->isLoading()) return false;
+    if (isBusy()) {
+        setStatus(tr("A statement is still running in this tab"));
+        return false;
+    }
+    if (!isBound()) {
+        emit bindingNeeded(this);
+    }
+    if (!isBound()) {
+        QMessageBox::warning(this, tr("Warning"), tr("Connect to a server and choose a database first"));
+        return false;
+    }
+    return true;
+}
+
+void QueryTab::start(Request kind, const QFuture<QuerySession::Outcome> &future, const QString &message)
+{
+    request = kind;
+    watcher.setFuture(future);
+    setStatus(message);
+    updateControls();
+    emit stateChanged(this);
+}
+
+void QueryTab::executeQuery()
+{
+    // With a selection only the selected text runs.
+    QString query = queryEdit->textCursor().selectedText();
+    query.replace(QChar::ParagraphSeparator, '\n');
+    if (query.trimmed().isEmpty()) {
+        query = queryEdit->toPlainText();
+    }
+    runQuery(query.trimmed());
+}
+
+void QueryTab::executeStatement()
+{
+    runQuery(queryEdit->statementUnderCursor());
+}
+
+void QueryTab::runQuery(const QString &query)
+{
+    if (query.isEmpty()) {
+        QMessageBox::warning(this, tr("Warning"), tr("Enter SQL query"));
+        return;
+    }
+    if (!prepareRun()) return;
+
+    addToHistory(query);
+    requestQuery = query;
+    QuerySession *source = session.data();
+    TableUtils::FetchLimits limits = fetchLimits();
+    start(QueryRequest, QtConcurrent::run(&pool, [source, query, limits]() {
+        return source->execute(query, limits);
+    }), tr("Running..."));
+}
+
+void QueryTab::openTable(const QString &table)
+{
+    browseRequest = BrowseQuery::Request();
+    browseRequest.table = table;
+    browseRequest.columns = ColumnChooserDialog::savedColumns(server, params.dbName, table);
+    filterBar->setConditions(QVector<BrowseQuery::Condition>());
+    runBrowse(tr("Loading %1...").arg(table));
+}
+
+void QueryTab::runBrowse(const QString &message)
+{
+    if (!prepareRun()) return;
+
+    requestQuery = browseRequest.table;
+    QuerySession *source = session.data();
+    BrowseQuery::Request browsing = browseRequest;
+    TableUtils::FetchLimits limits = fetchLimits();
+    // Large TEXT/BLOB/JSON columns come back as previews; see LargeValues.
+    start(TableRequest, QtConcurrent::run(&pool, [source, browsing, limits]() {
+        return source->browseTable(browsing, limits);
+    }), message);
+}
+
+void QueryTab::sampleTable(const QString &table, const TableSampler::Options &options)
+{
+    if (!prepareRun()) return;
+
+    requestQuery = table;
+    QuerySession *source = session.data();
+    TableUtils::FetchLimits limits = fetchLimits();
+    start(SampleRequest, QtConcurrent::run(&pool, [source, table, options, limits]() {
+        return source->sampleTable(table, options, limits);
+    }), tr("Sampling %1...").arg(table));
+}
+
+void QueryTab::cancelQuery()
+{
+    if (!isBusy() || !session) return;
+    if (request == SpoolRequest) {
+        // The statement is done; the worker stops at the next chunk.
+        spooled->cancel();
+        setStatus(tr("Canceling..."));
+        return;
+    }
+    // Runs on the global pool: the tab's own thread is busy with the statement.
+    DatabaseConnection::ConnectionParams cancelParams = params;
+    qint64 backendId = session->backendId();
+    auto cancelWatcher = new QFutureWatcher<QString>(this);
+    connect(cancelWatcher, &QFutureWatcher<QString>::finished, this, [this, cancelWatcher]() {
+        QString error = cancelWatcher->result();
+        cancelWatcher->deleteLater();
+        if (!error.isEmpty() && isBusy()) {
+            setStatus(tr("Failed to cancel the statement: %1").arg(error));
+        }
+    });
+    cancelWatcher->setFuture(QtConcurrent::run([cancelParams, backendId]() {
+        QString error;
+        return QuerySession::cancel(cancelParams, backendId, &error) ? QString() : error;
+    }));
+    setStatus(tr("Canceling..."));
+}
+
+void QueryTab::beginTransaction()
+{
+    transaction(QuerySession::Begin);
+}
+
+void QueryTab::commitTransaction()
+{
+    transaction(QuerySession::Commit);
+}
+
+void QueryTab::rollbackTransaction()
+{
+    transaction(QuerySession::Rollback);
+}
+
+void QueryTab::transaction(QuerySession::Transaction operation)
+{
+    if (!prepareRun()) return;
+
+    QuerySession *source = session.data();
+    start(TransactionRequest, QtConcurrent::run(&pool, [source, operation]() {
+        return source->transaction(operation);
+    }), tr("Waiting for the server..."));
+}
+
+void QueryTab::showOutcome()
+{
+    Request finished = request;
+    request = NoRequest;
+    QuerySession::Outcome outcome = watcher.result();
+    transactionOpen = outcome.inTransaction;
+    QString elapsed = tr("%1 ms").arg(outcome.elapsedMs);
+
+    switch (finished) {
+    case EditRequest: {
+        QTableWidgetItem *item = dataTable->item(editRow, editColumn);
+        const QSignalBlocker blocker(dataTable);
+        if (!outcome.ok) {
+            if (item) item->setText(editOldValue);
+            setStatus(tr("Update failed"));
+            QMessageBox::critical(this, tr("Error"), tr("Failed to update data: %1").arg(outcome.error));
+        } else {
+            if (item) item->setData(Qt::UserRole, item->text());
+            setStatus(tr("Data successfully updated"), elapsed);
+            prefetchTimer.start();
+        }
+        pivotPanel->sourceChanged();
+        break;
+    }
+    case FetchRequest:
+        if (!outcome.ok) {
+            updateTruncationBar(false);
+            setStatus(outcome.error);
+            break;
+        }
+        TableUtils::appendBatch(dataTable, outcome.batch, browse.layout);
+        setGridBytes(gridBytes + outcome.bytes);
+        prefetchTimer.start();
+        pivotPanel->sourceChanged();
+        updateTruncationBar(outcome.truncated);
+        setStatus(tr("Fetched %1 more rows").arg(outcome.batch.rows.size()), elapsed);
+        break;
+    case SpoolRequest:
+        spoolTimer.stop();
+        spoolModel->refresh();
+        if (!outcome.ok) {
+            setStatus(tr("Fetch failed: %1").arg(outcome.error));
+            break;
+        }
+        setStatus(tr("Fetched %1 rows; %2 in memory, %3 spilled to disk%4")
+                      .arg(QLocale().toString(spooled->rowCount()),
+                           QLocale().formattedDataSize(spooled->residentBytes()),
+                           QLocale().formattedDataSize(spooled->spilledBytes()),
+                           outcome.note.isEmpty() ? QString() : QString(" (%1)").arg(outcome.note)),
+                  elapsed);
+        break;
+    case TransactionRequest:
+        if (!outcome.ok) {
+            setStatus(tr("Transaction error"));
+            QMessageBox::critical(this, tr("Error"), outcome.error);
+            break;
+        }
+        setStatus(transactionOpen ? tr("Transaction started") : tr("Transaction finished"), elapsed);
+        break;
+    default:
+        if (!outcome.ok && refreshing) {
+            // Restored results are refreshed on startup; no dialog per tab.
+            refreshing = false;
+            staleLabel->setText(tr("Result restored from the session of %1; refreshing it failed: %2")
+                                .arg(QLocale().toString(staleSince, QLocale::ShortFormat), outcome.error));
+            setStatus(tr("Refresh failed"), elapsed);
+            break;
+        }
+        if (!outcome.ok) {
+            setStatus(tr("Query failed"), elapsed);
+            QString message = finished == TableRequest ? tr("Failed to load data: %1")
+                            : finished == SampleRequest ? tr("Failed to sample table: %1")
+                            : tr("Query execution error: %1");
+            QMessageBox::critical(this, tr("Error"), message.arg(outcome.error));
+            break;
+        }
+        if (!outcome.transactionControl) {
+            resultQuery = finished == QueryRequest ? requestQuery : QString();
+            resultTable = finished == TableRequest ? requestQuery : QString();
+            refreshing = false;
+            staleSince = QDateTime();
+            staleLabel->hide();
+            leaveSpoolMode();
+            browse = outcome.browse;
+            sortColumn = -1;
+            dataTable->horizontalHeader()->setSortIndicatorShown(false);
+            TableUtils::fillFromBatch(dataTable, outcome.batch, browse.layout);
+            resetReferences(outcome.foreignKeys);
+            setGridBytes(outcome.bytes);
+            resultRows = outcome.totalRows;
+            filterBar->setVisible(finished == TableRequest);
+            if (finished == TableRequest) {
+                QStringList columns;
+                for (const LargeValues::Column &column : browse.tableColumns) {
+                    columns << column.name;
+                }
+                filterBar->setColumns(columns);
+                filterBar->setIndexUse(outcome.note);
+                // The server sorted; the header only says by what.
+                sortColumn = gridColumn(browseRequest.sortColumn);
+                sortOrder = browseRequest.descending ? Qt::DescendingOrder : Qt::AscendingOrder;
+                if (sortColumn >= 0) {
+                    dataTable->horizontalHeader()->setSortIndicator(sortColumn, sortOrder);
+                    dataTable->horizontalHeader()->setSortIndicatorShown(true);
+                }
+            }
+            pivotPanel->sourceChanged();
+            // Only tables opened from the tree can be edited in place.
+            dataTable->setEditTriggers(browse.table.isEmpty()
+                                       ? QAbstractItemView::NoEditTriggers
+                                       : QAbstractItemView::DoubleClicked | QAbstractItemView::EditKeyPressed);
+            updateTruncationBar(outcome.truncated);
+        }
+        if (finished == TableRequest && !outcome.foreignKeysError.isEmpty()) {
+            setStatus(tr("Data loaded; its foreign keys could not be read: %1").arg(outcome.foreignKeysError),
+                      elapsed);
+        } else if (finished == TableRequest) {
+            setStatus(tr("Data loaded"), elapsed);
+        } else if (finished == SampleRequest) {
+            setStatus(tr("Sample of %1: %2").arg(requestQuery, outcome.note), elapsed);
+        } else if (outcome.transactionControl) {
+            setStatus(transactionOpen ? tr("Transaction started") : tr("Transaction finished"), elapsed);
+        } else {
+            setStatus(tr("Query executed successfully"), elapsed);
+            if (SchemaIndex::isSchemaChange(requestQuery)) {
+                emit schemaChanged();
+            }
+        }
+        break;
+    }
+    updateControls();
+    emit stateChanged(this);
+}
+
+void QueryTab::fetchMoreRows()
+{
+    if (isBusy() || !session) return;
+    QuerySession *source = session.data();
+    TableUtils::FetchLimits limits = fetchLimits();
+    start(FetchRequest, QtConcurrent::run(&pool, [source, limits]() { return source->fetchMore(limits); }),
+          tr("Fetching..."));
+}
+
+void QueryTab::fetchAllRows()
+{
+    if (isBusy() || !session) return;
+    if (shouldSpool()) {
+        startSpool();
+        return;
+    }
+    QuerySession *source = session.data();
+    start(FetchRequest, QtConcurrent::run(&pool, [source]() {
+        return source->fetchMore(TableUtils::FetchLimits());
+    }), tr("Fetching all rows..."));
+}
+
+bool QueryTab::shouldSpool() const
+{
+    ResultMemory::Settings memory = ResultMemory::settings();
+    if (!memory.spill || memory.budgetBytes <= 0) return false;
+    // Drivers streaming the result cannot tell its size; assume the worst.
+    int loaded = dataTable->rowCount();
+    if (resultRows < 0) return true;
+    if (loaded == 0) return false;
+    qint64 remaining = gridBytes / loaded * qMax(0, resultRows - loaded);
+    return ResultMemory::resident() + remaining > memory.budgetBytes;
+}
+
+void QueryTab::startSpool()
+{
+    QStringList headers;
+    for (int column = 0; column < dataTable->columnCount(); ++column) {
+        QTableWidgetItem *header = dataTable->horizontalHeaderItem(column);
+        QString name = header ? header->text() : QString::number(column + 1);
+        headers << name.remove(" ▲").remove(" ▼");
+    }
+    QSharedPointer<ResultStore> store(new ResultStore(headers));
+
+    // The rows already loaded go first, then the grid lets go of them.
+    QString error;
+    QVector<QStringList> rows;
+    for (int row = 0; row < dataTable->rowCount(); ++row) {
+        QStringList cells;
+        for (int column = 0; column < dataTable->columnCount(); ++column) {
+            QTableWidgetItem *item = dataTable->item(row, column);
+            cells << (item ? item->text() : QString());
+        }
+        rows << cells;
+        if (rows.size() == ResultStore::ChunkRows || row == dataTable->rowCount() - 1) {
+            if (!store->append(rows, &error)) {
+                setStatus(tr("Fetch failed: %1").arg(error));
+                return;
+            }
+            rows.clear();
+        }
+    }
+    {
+        const QSignalBlocker blocker(dataTable);
+        dataTable->clear();
+        dataTable->setRowCount(0);
+        dataTable->setColumnCount(0);
+    }
+    setGridBytes(0);
+    pivotButton->setChecked(false);
+    pivotPanel->sourceChanged();
+    updateTruncationBar(false);
+
+    spooled = store;
+    spoolModel->setStore(store);
+    resultStack->setCurrentWidget(spoolView);
+    spoolView->resizeColumnsToContents();
+
+    QuerySession *source = session.data();
+    TableUtils::PreviewLayout layout = browse.layout;
+    start(SpoolRequest, QtConcurrent::run(&pool, [source, store, layout]() {
+        return source->spool(store.data(), layout);
+    }), tr("Fetching all rows..."));
+    spoolTimer.start();
+}
+
+void QueryTab::showSpoolProgress()
+{
+    if (!spooled) return;
+    spoolModel->refresh();
+    setStatus(tr("Fetching all rows... %1 so far, %2 spilled to disk")
+                  .arg(QLocale().toString(spooled->rowCount()),
+                       QLocale().formattedDataSize(spooled->spilledBytes())));
+}
+
+void QueryTab::leaveSpoolMode()
+{
+    if (!spooled) return;
+    spoolModel->setStore(QSharedPointer<ResultStore>());
+    spooled.reset();
+    resultStack->setCurrentWidget(dataTable);
+}
+
+void QueryTab::setGridBytes(qint64 bytes)
+{
+    ResultMemory::add(bytes - gridBytes, 0);
+    gridBytes = bytes;
+}
+
+qint64 QueryTab::residentBytes() const
+{
+    return gridBytes + (spooled ? spooled->residentBytes() : 0);
+}
+
+qint64 QueryTab::spilledBytes() const
+{
+    return spooled ? spooled->spilledBytes() : 0;
+}
+
+ClipboardFormatter::Snapshot QueryTab::captureSpooledSelection(const QString &tableName, QChar identifierQuote,
+                                                               QString *error) const
+{
+    ClipboardFormatter::Snapshot snapshot;
+    snapshot.tableName = tableName;
+    snapshot.identifierQuote = identifierQuote;
+    const QItemSelection selection = spoolView->selectionModel()->selection();
+    if (!spooled || selection.isEmpty()) return snapshot;
+
+    qint64 selectedCells = 0;
+    for (const QItemSelectionRange &range : selection) {
+        selectedCells += qint64(range.height()) * range.width();
+    }
+    QSet<int> rowSet;
+    QSet<int> columnSet;
+    if (selectedCells <= MaxSpooledCopyCells) {
+        for (const QItemSelectionRange &range : selection) {
+            for (int row = range.top(); row <= range.bottom(); ++row) {
+                rowSet.insert(row);
+            }
+            for (int column = range.left(); column <= range.right(); ++column) {
+                columnSet.insert(column);
+            }
+        }
+    }
+    if (selectedCells > MaxSpooledCopyCells || qint64(rowSet.size()) * columnSet.size() > MaxSpooledCopyCells) {
+        *error = tr("The selection is too large to copy; export the result instead");
+        return snapshot;
+    }
+
+    QList<int> rows = rowSet.values();
+    QList<int> columns = columnSet.values();
+    std::sort(rows.begin(), rows.end());
+    std::sort(columns.begin(), columns.end());
+    for (int column : columns) {
+        snapshot.headers << spooled->headers().value(column);
+    }
+    snapshot.rowCount = rows.size();
+    snapshot.cells.resize(rows.size() * columns.size());
+    snapshot.nulls.resize(snapshot.cells.size());
+    snapshot.nulls.fill(true);
+    for (int i = 0; i < rows.size(); ++i) {
+        QStringList cells = spooled->row(rows.at(i), error);
+        if (!error->isEmpty()) return snapshot;
+        for (int j = 0; j < columns.size(); ++j) {
+            if (!selection.contains(spoolModel->index(rows.at(i), columns.at(j)))) continue;
+            int position = i * columns.size() + j;
+            snapshot.cells[position] = cells.value(columns.at(j));
+            snapshot.nulls.clearBit(position);
+            snapshot.totalChars += snapshot.cells.at(position).size();
+        }
+    }
+    return snapshot;
+}
+
+SessionStore::Tab QueryTab::sessionState() const
+{
+    SessionStore::Tab state;
+    if (isBound()) {
+        state.serverName = server;
+        state.database = params.dbName;
+    }
+    state.editorText = queryEdit->toPlainText();
+    state.history = queryHistory;
+    state.resultQuery = resultQuery;
+    state.resultTable = resultTable;
+
+    // The first rows only, as the grid or the spooled view shows them.
+    SessionStore::ResultSnapshot &result = state.result;
+    int columns = spooled ? spooled->headers().size() : dataTable->columnCount();
+    if (spooled) {
+        result.headers = spooled->headers();
+        result.totalRows = spooled->rowCount();
+    } else {
+        for (int column = 0; column < columns; ++column) {
+            QTableWidgetItem *header = dataTable->horizontalHeaderItem(column);
+            QString name = header ? header->text() : QString::number(column + 1);
+            result.headers << name.remove(" ▲").remove(" ▼");
+        }
+        result.totalRows = dataTable->rowCount();
+    }
+    qint64 bytes = 0;
+    for (int row = 0; row < result.totalRows && row < SessionStore::MaxSnapshotRows
+                      && bytes < SessionStore::MaxSnapshotBytes; ++row) {
+        QStringList cells;
+        if (spooled) {
+            // A chunk that cannot be read back ends the snapshot there.
+            QString error;
+            cells = spooled->row(row, &error);
+            if (!error.isEmpty()) break;
+        } else {
+            for (int column = 0; column < columns; ++column) {
+                QTableWidgetItem *item = dataTable->item(row, column);
+                cells << (item ? item->text() : QString());
+            }
+        }
+        for (const QString &cell : cells) {
+            bytes += cell.size() * qint64(sizeof(QChar));
+        }
+        result.rows << cells;
+    }
+    return state;
+}
+
+void QueryTab::restoreState(const SessionStore::Tab &state, const QDateTime &saved)
+{
+    // The caller binds the tab first.
+    queryEdit->setPlainText(state.editorText);
+    queryHistory = state.history;
+    resultQuery = state.resultQuery;
+    resultTable = state.resultTable;
+    // A browsed table is read again even if it had no rows when saved.
+    if (state.result.isEmpty()) {
+        if (!resultTable.isEmpty()) staleSince = saved;
+        return;
+    }
+
+    TableUtils::RowBatch batch;
+    batch.columns = state.result.headers;
+    batch.rows.reserve(state.result.rows.size());
+    for (const QStringList &cells : state.result.rows) {
+        QVector<QVariant> values;
+        values.reserve(batch.columns.size());
+        for (int column = 0; column < batch.columns.size(); ++column) {
+            values << QVariant(cells.value(column));
+        }
+        batch.rows << values;
+    }
+    TableUtils::fillFromBatch(dataTable, batch);
+    resetReferences(ForeignKeys::TableKeys());
+    dataTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    pivotPanel->sourceChanged();
+
+    staleSince = saved;
+    QString text = tr("Result restored from the session of %1").arg(QLocale().toString(saved, QLocale::ShortFormat));
+    if (state.result.totalRows > state.result.rows.size()) {
+        text += tr(", first %1 of %2 rows").arg(state.result.rows.size()).arg(state.result.totalRows);
+    }
+    if (isBound() && !resultTable.isEmpty()) {
+        text += tr("; refreshing...");
+    } else {
+        text += tr("; run the statement again to refresh it");
+    }
+    staleLabel->setText(text);
+    staleLabel->show();
+    setStatus(tr("Restored"));
+}
+
+void QueryTab::refreshResult()
+{
+    // Only a browsed table is re-read. A query is not run again unasked:
+    // no look at its text tells that it has no side effects.
+    if (staleSince.isNull() || !isBound() || isBusy() || resultTable.isEmpty()) return;
+    openTable(resultTable);
+    refreshing = true;
+}
+
+void QueryTab::chooseColumns()
+{
+    if (browse.table.isEmpty() || isBusy()) return;
+    ColumnChooserDialog dialog(this, browse, browseRequest.columns.isEmpty());
+    if (dialog.exec() != QDialog::Accepted) return;
+
+    QStringList columns = dialog.columns();
+    ColumnChooserDialog::saveColumns(server, params.dbName, browse.table, columns);
+    browseRequest.columns = columns;
+    if (!columns.isEmpty() && !columns.contains(browseRequest.sortColumn)
+        && !browse.keyColumns.contains(browseRequest.sortColumn)) {
+        browseRequest.sortColumn.clear();
+        browseRequest.descending = false;
+    }
+    runBrowse(tr("Loading %1...").arg(browseRequest.table));
+}
+
+void QueryTab::updateTruncationBar(bool truncated)
+{
+    if (truncated) {
+        truncationLabel->setText(tr("Truncated at %1 rows by the server limits; more rows are available.")
+                                 .arg(dataTable->rowCount()));
+    }
+    truncationBar->setVisible(truncated);
+}
+
+void QueryTab::viewCellValue(int row, int column)
+{
+    QTableWidgetItem *item = dataTable->item(row, column);
+    if (!item) return;
+
+    QString header = dataTable->horizontalHeaderItem(column)->text();
+    header.remove(" ▲").remove(" ▼");
+    // Full values are read through a short-lived connection of their own,
+    // so the viewer works while the tab's session is busy.
+    DatabaseConnection connection;
+    ValueViewerDialog dialog(this, tr("%1, row %2").arg(header).arg(row + 1));
+    if (item->data(TableUtils::FullSizeRole).isValid() && !browse.layout.isEmpty()) {
+        if (!connection.connect(params)) {
+            QMessageBox::critical(this, tr("Error"), connection.lastError().text());
+            return;
+        }
+        QStringList rowTexts;
+        for (int col = 0; col < dataTable->columnCount(); ++col) {
+            QTableWidgetItem *cell = dataTable->item(row, col);
+            rowTexts << (cell ? cell->text() : QString());
+        }
+        dialog.load(&connection, LargeValues::valueRef(browse, column, rowTexts));
+    } else {
+        dialog.showValue(item->text());
+    }
+    dialog.exec();
+}
+
+void QueryTab::viewCurrentValue()
+{
+    if (!spooled) {
+        viewCellValue(dataTable->currentRow(), dataTable->currentColumn());
+        return;
+    }
+    // Spooled cells hold what the grid would show, previews included.
+    QModelIndex index = spoolView->currentIndex();
+    if (!index.isValid()) return;
+    ValueViewerDialog dialog(this, tr("%1, row %2").arg(spooled->headers().value(index.column())).arg(index.row() + 1));
+    dialog.showValue(index.data().toString());
+    dialog.exec();
+}
+
+void QueryTab::onCellChanged(int row, int column)
+{
+    QTableWidgetItem *item = dataTable->item(row, column);
+    if (!item || browse.table.isEmpty()) return;
+
+    QString oldValue = item->data(Qt::UserRole).toString();
+    if (oldValue.isEmpty()) {
+        oldValue = item->text();
+    }
+    if (isBusy()) {
+        const QSignalBlocker blocker(dataTable);
+        item->setText(oldValue);
+        setStatus(tr("A statement is still running in this tab"));
+        return;
+    }
+
+    // The row is found by its primary key. Without one it is matched on
+    // every column, so all of them must be in the grid whole; the session
+    // still refuses an edit that matches more than one row.
+    bool whole = browse.keyColumns.isEmpty() && browse.columns.size() == browse.tableColumns.size();
+    for (const LargeValues::Column &candidate : browse.columns) {
+        whole = whole && !candidate.large;
+    }
+    if (column >= browse.columns.size() || (browse.keyColumns.isEmpty() && !whole)) {
+        const QSignalBlocker blocker(dataTable);
+        item->setText(oldValue);
+        setStatus(tr("%1 has no primary key: its cells can be edited only with all of its columns shown, "
+                     "and none of them large").arg(browse.table));
+        return;
+    }
+    QStringList rowColumns;
+    QStringList rowValues;
+    for (int i = 0; i < browse.columns.size(); ++i) {
+        const QString &name = browse.columns.at(i).name;
+        if (!browse.keyColumns.isEmpty() && !browse.keyColumns.contains(name)) continue;
+        QTableWidgetItem *cell = dataTable->item(row, i);
+        rowColumns << name;
+        rowValues << (i == column ? oldValue : cell ? cell->text() : QString());
+    }
+
+    QString table = browse.table;
+    QString columnName = browse.columns.at(column).name;
+    QString value = item->text();
+    editRow = row;
+    editColumn = column;
+    editOldValue = oldValue;
+    QuerySession *source = session.data();
+    start(EditRequest, QtConcurrent::run(&pool, [source, table, columnName, value, rowColumns, rowValues]() {
+        return source->updateCell(table, columnName, value, rowColumns, rowValues);
+    }), tr("Updating..."));
+}
+
+void QueryTab::onHeaderClicked(int logicalIndex)
+{
+    Qt::SortOrder order = sortColumn == logicalIndex && sortOrder == Qt::AscendingOrder ? Qt::DescendingOrder
+                                                                                       : Qt::AscendingOrder;
+    // A browsed table is sorted by the server, so later pages follow the
+    // order; previews of large values are not sortable there.
+    if (!browse.table.isEmpty()) {
+        QTableWidgetItem *header = dataTable->horizontalHeaderItem(logicalIndex);
+        QString name = header ? QString(header->text()).remove(" ▲").remove(" ▼") : QString();
+        bool large = false;
+        for (const LargeValues::Column &column : browse.columns) {
+            if (column.name == name) {
+                large = column.large;
+            }
+        }
+        if (!name.isEmpty() && !large) {
+            if (isBusy()) return;
+            browseRequest.sortColumn = name;
+            browseRequest.descending = order == Qt::DescendingOrder;
+            runBrowse(tr("Sorting %1...").arg(browseRequest.table));
+            return;
+        }
+    }
+    sortOrder = order;
+    sortColumn = logicalIndex;
+    TableUtils::sortRows(dataTable, sortColumn, sortOrder);
+    pivotPanel->sourceChanged();
+    // Sorting moves the texts, not the tooltips.
+    applyReferences(0, dataTable->rowCount() - 1);
+    prefetchTimer.start();
+    setStatus(tr("Data sorted"));
+}
+
+void QueryTab::addToHistory(const QString &query)
+{
+    queryHistory.removeAll(query);
+    queryHistory.prepend(query);
+    while (queryHistory.size() > MaxHistory) {
+        queryHistory.removeLast();
+    }
+}
+
+void QueryTab::showHistoryMenu()
+{
+    QMenu menu(this);
+    if (queryHistory.isEmpty()) {
+        menu.addAction(tr("No queries yet"))->setEnabled(false);
+    }
+    for (const QString &query : queryHistory) {
+        QString label = query.simplified();
+        if (label.size() > HistoryLabelChars) {
+            label = label.left(HistoryLabelChars) + QString::fromUtf8("…");
+        }
+        QAction *action = menu.addAction(label);
+        action->setToolTip(query);
+        connect(action, &QAction::triggered, [this, query]() {
+            // Through the cursor, so the replacement can be undone.
+            QTextCursor cursor = queryEdit->textCursor();
+            cursor.select(QTextCursor::Document);
+            cursor.insertText(query);
+            queryEdit->setTextCursor(cursor);
+            queryEdit->setFocus();
+        });
+    }
+    menu.exec(historyButton->mapToGlobal(QPoint(0, historyButton->height())));
+}
+
+void QueryTab::closeLookup()
+{
+    lookupWatcher.waitForFinished();
+    if (lookupConnection) {
+        DatabaseConnection *connection = lookupConnection.data();
+        QtConcurrent::run(&lookupPool, [connection]() { connection->disconnect(); }).waitForFinished();
+    }
+}
+
+int QueryTab::gridColumn(const QString &name) const
+{
+    for (int column = 0; column < dataTable->columnCount(); ++column) {
+        QTableWidgetItem *header = dataTable->horizontalHeaderItem(column);
+        if (header && QString(header->text()).remove(" ▲").remove(" ▼") == name) {
+            return column;
+        }
+    }
+    return -1;
+}
+
+QStringList QueryTab::rowValues(int row, const QVector<int> &columns) const
+{
+    QStringList values;
+    for (int column : columns) {
+        QTableWidgetItem *item = dataTable->item(row, column);
+        // The grid shows NULL as empty; such a value references nothing.
+        if (!item || item->text().isEmpty() || item->data(TableUtils::FullSizeRole).isValid()) {
+            return QStringList();
+        }
+        values << item->text();
+    }
+    return values;
+}
+
+void QueryTab::resetReferences(const ForeignKeys::TableKeys &keys)
+{
+    ++referenceGeneration;
+    prefetchAgain = false;
+    foreignKeys = keys;
+    keyColumns.clear();
+    referencedRows.clear();
+    referencedRows.resize(keys.outgoing.size());
+    failedReferences.clear();
+    QColor link = palette().color(QPalette::Link);
+    for (const ForeignKeys::Key &key : keys.outgoing) {
+        QVector<int> columns;
+        for (const QString &name : key.columns) {
+            columns << gridColumn(name);
+        }
+        if (columns.contains(-1)) {
+            columns.clear();
+        }
+        for (int column : columns) {
+            QTableWidgetItem *header = dataTable->horizontalHeaderItem(column);
+            header->setForeground(link);
+            header->setToolTip(tr("References %1 (%2); hover a value to see the row, Ctrl+click to open it")
+                                   .arg(key.referencedTable, key.referencedColumns.join(", ")));
+        }
+        keyColumns << columns;
+    }
+    prefetchTimer.start();
+}
+
+void QueryTab::prefetchReferences()
+{
+    if (keyColumns.isEmpty() || spooled || !lookupConnection || dataTable->rowCount() == 0) return;
+    if (lookupWatcher.isRunning()) {
+        prefetchAgain = true;
+        return;
+    }
+
+    // The rows in view and a screen either side, so short scrolls find them ready.
+    int first = dataTable->rowAt(0);
+    int last = dataTable->rowAt(dataTable->viewport()->height() - 1);
+    if (first < 0) first = 0;
+    if (last < 0) last = dataTable->rowCount() - 1;
+    int page = last - first + 1;
+    first = qMax(0, first - page);
+    last = qMin(dataTable->rowCount() - 1, last + page);
+
+    QVector<ForeignKeys::Lookup> lookups;
+    for (int key = 0; key < keyColumns.size(); ++key) {
+        if (keyColumns.at(key).isEmpty() ||
+            failedReferences.contains(foreignKeys.outgoing.at(key).referencedTable)) continue;
+        ForeignKeys::Lookup lookup;
+        lookup.key = key;
+        QSet<QString> seen;
+        for (int row = first; row <= last; ++row) {
+            QStringList values = rowValues(row, keyColumns.at(key));
+            if (values.isEmpty()) continue;
+            QString value = ForeignKeys::valueKey(values);
+            if (referencedRows.at(key).contains(value) || seen.contains(value)) continue;
+            seen.insert(value);
+            lookup.values << values;
+        }
+        if (!lookup.values.isEmpty()) {
+            lookups << lookup;
+        }
+    }
+    if (lookups.isEmpty()) {
+        applyReferences(first, last);
+        return;
+    }
+
+    lookupGeneration = referenceGeneration;
+    lookupFirst = first;
+    lookupLast = last;
+    // A connection of its own: the session may be busy or hold a pending result.
+    DatabaseConnection *connection = lookupConnection.data();
+    DatabaseConnection::ConnectionParams lookupParams = params;
+    QVector<ForeignKeys::Key> keys = foreignKeys.outgoing;
+    lookupWatcher.setFuture(QtConcurrent::run(&lookupPool, [connection, lookupParams, keys, lookups]() mutable {
+        if (!connection->isConnected() && !connection->connect(lookupParams)) {
+            for (ForeignKeys::Lookup &lookup : lookups) {
+                lookup.error = connection->lastError().text();
+            }
+            return lookups;
+        }
+        for (ForeignKeys::Lookup &lookup : lookups) {
+            ForeignKeys::fetchReferenced(*connection, keys.at(lookup.key), &lookup, &lookup.error);
+        }
+        return lookups;
+    }));
+}
+
+void QueryTab::showReferences()
+{
+    if (lookupGeneration == referenceGeneration) {
+        for (const ForeignKeys::Lookup &lookup : lookupWatcher.result()) {
+            if (!lookup.error.isEmpty()) {
+                // Not asked again on every scroll; opening the table again retries.
+                const QString &table = foreignKeys.outgoing.at(lookup.key).referencedTable;
+                failedReferences.insert(table);
+                setStatus(tr("Rows of %1 could not be looked up: %2").arg(table, lookup.error));
+                continue;
+            }
+            QHash<QString, ForeignKeys::Row> &cache = referencedRows[lookup.key];
+            for (const QStringList &values : lookup.values) {
+                QString value = ForeignKeys::valueKey(values);
+                // A value without a row is cached too, as a row without columns.
+                cache.insert(value, lookup.rows.value(value));
+            }
+        }
+        applyReferences(lookupFirst, lookupLast);
+    }
+    if (prefetchAgain) {
+        prefetchAgain = false;
+        prefetchReferences();
+    }
+}
+
+void QueryTab::applyReferences(int first, int last)
+{
+    const QSignalBlocker blocker(dataTable);
+    last = qMin(last, dataTable->rowCount() - 1);
+    for (int key = 0; key < keyColumns.size(); ++key) {
+        const ForeignKeys::Key &foreignKey = foreignKeys.outgoing.at(key);
+        const QHash<QString, ForeignKeys::Row> &cache = referencedRows.at(key);
+        for (int row = first; row <= last; ++row) {
+            QStringList values = rowValues(row, keyColumns.at(key));
+            QString text;
+            auto found = cache.constFind(ForeignKeys::valueKey(values));
+            if (!values.isEmpty() && found != cache.constEnd()) {
+                const ForeignKeys::Row &referenced = found.value();
+                if (referenced.columns.isEmpty()) {
+                    text = tr("No row in %1 with %2 = %3")
+                               .arg(foreignKey.referencedTable, foreignKey.referencedColumns.join(", "),
+                                    values.join(", ")).toHtmlEscaped();
+                } else {
+                    QStringList lines;
+                    for (int i = 0; i < referenced.columns.size() && i < MaxReferenceColumns; ++i) {
+                        QString value = referenced.values.at(i);
+                        if (value.size() > MaxReferenceChars) {
+                            value = value.left(MaxReferenceChars) + QString::fromUtf8("…");
+                        }
+                        lines << QString("%1: %2").arg(referenced.columns.at(i).toHtmlEscaped(),
+                                                       value.toHtmlEscaped());
+                    }
+                    if (referenced.columns.size() > MaxReferenceColumns) {
+                        lines << QString::fromUtf8("…");
+                    }
+                    text = QString("<b>%1</b><br>%2").arg(foreignKey.referencedTable.toHtmlEscaped(),
+                                                          lines.join("<br>"));
+                }
+            }
+            for (int column : keyColumns.at(key)) {
+                QTableWidgetItem *item = dataTable->item(row, column);
+                if (item && item->toolTip() != text) {
+                    item->setToolTip(text);
+                }
+            }
+        }
+    }
+}
+
+void QueryTab::openReferencedRow(int key, int row)
+{
+    QStringList values = rowValues(row, keyColumns.value(key));
+    if (values.isEmpty()) return;
+    const ForeignKeys::Key &foreignKey = foreignKeys.outgoing.at(key);
+    runQuery(ForeignKeys::rowsSql(foreignKey.referencedTable, foreignKey.referencedColumns, values,
+                                  params.driver == "QPSQL"));
+}
+
+void QueryTab::addReferenceActions(QMenu *menu)
+{
+    int row = dataTable->currentRow();
+    if (spooled || foreignKeys.isEmpty() || row < 0) return;
+
+    menu->addSeparator();
+    for (int key = 0; key < keyColumns.size(); ++key) {
+        const ForeignKeys::Key &foreignKey = foreignKeys.outgoing.at(key);
+        QAction *action = menu->addAction(tr("Open Referenced Row in %1 (%2)")
+                                              .arg(foreignKey.referencedTable, foreignKey.columns.join(", ")),
+                                          [this, key, row]() { openReferencedRow(key, row); });
+        action->setEnabled(!rowValues(row, keyColumns.at(key)).isEmpty());
+    }
+    if (foreignKeys.incoming.isEmpty()) return;
+    QMenu *referencing = menu->addMenu(tr("Show Referencing Rows"));
+    bool postgres = params.driver == "QPSQL";
+    for (const ForeignKeys::Key &foreignKey : foreignKeys.incoming) {
+        QVector<int> columns;
+        for (const QString &name : foreignKey.referencedColumns) {
+            columns << gridColumn(name);
+        }
+        QStringList values = columns.contains(-1) ? QStringList() : rowValues(row, columns);
+        QString sql = ForeignKeys::rowsSql(foreignKey.table, foreignKey.columns, values, postgres);
+        QAction *action = referencing->addAction(QString("%1 (%2)").arg(foreignKey.table,
+                                                                        foreignKey.columns.join(", ")),
+                                                 [this, sql]() { runQuery(sql); });
+        action->setEnabled(!values.isEmpty());
+    }
+}
+
+void QueryTab::setStatus(const QString &message, const QString &elapsed)
+{
+    lastStatus = message;
+    if (!elapsed.isEmpty()) {
+        lastExecutionTime = elapsed;
+    }
+    emit statusChanged(this);
+}
+
+void QueryTab::updateControls()
+{
+    bool busy = isBusy();
+    executeButton->setEnabled(!busy);
+    stopButton->setEnabled(busy && request != EditRequest);
+    beginButton->setEnabled(!busy && !transactionOpen);
+    commitButton->setEnabled(!busy && transactionOpen);
+    rollbackButton->setEnabled(!busy && transactionOpen);
+    pivotButton->setEnabled(!spooled);
+
+    QString target = isBound() ? title() : tr("Not connected: runs against the database open in the tree");
+    if (transactionOpen) {
+        target += tr(" (transaction open)");
+    }
+    targetLabel->setText(target);
+    targetLabel->setStyleSheet(transactionOpen ? "color: #d08000; font-weight: bold;" : QString());
+}
@@ -0,0 +1,202 @@
+#ifndef QUERYTAB_H
+#define QUERYTAB_H
+
+#include <QWidget>
+#include <QTableWidget>
+#include <QPushButton>
+#include <QToolButton>
+#include <QTableView>
+#include <QStackedWidget>
+#include <QTimer>
+#include <QLabel>
+#include <QThreadPool>
+#include <QFutureWatcher>
+#include <QScopedPointer>
+#include <QMenu>
+#include <QStringList>
+#include <QSet>
+#include "querysession.h"
+#include "sqleditor.h"
+#include "pivotpanel.h"
+#include "resultstoremodel.h"
+#include "clipboardformatter.h"
+#include "sessionstore.h"
+#include "filterbar.h"
+
+// One query tab: an editor, a result grid and a session bound to a server
+// and database. Statements run on the tab's own worker thread, so a long
+// query in one tab leaves the window and the other tabs responsive.
+//
+// A table opened from the tree knows its foreign keys: referenced rows are
+// looked up for the rows in view on a connection of the tab's own, batched
+// per key and cached, and shown as tooltips on the key's cells. Its filter
+// bar and header clicks filter and sort on the server instead of in the grid.
+//
+// "Fetch all" on a result that would not fit the result memory budget
+// spools it into a ResultStore instead of the grid; the tab then shows a
+// read-only view over the store until the next statement.
+class QueryTab : public QWidget {
+    Q_OBJECT
+
+public:
+    QueryTab(QWidget *parent, const SchemaIndex *schemaIndex);
+    ~QueryTab();
+
+    // A tab may be rebound while it is idle and has no open transaction.
+    void bind(const QString &serverName, const DatabaseConnection::ConnectionParams &params);
+    bool isBound() const;
+    bool isBoundTo(const QString &serverName, const QString &database) const;
+    QString serverName() const { return server; }
+    const DatabaseConnection::ConnectionParams &connectionParams() const { return params; }
+    QString title() const;
+
+    bool isBusy() const;
+    bool inTransaction() const { return transactionOpen; }
+    SqlEditor *editor() const { return queryEdit; }
+    QTableWidget *grid() const { return dataTable; }
+    // Set while the tab shows a spooled result instead of the grid.
+    QSharedPointer<ResultStore> spooledResult() const { return spooled; }
+    QTableView *spooledView() const { return spoolView; }
+    ClipboardFormatter::Snapshot captureSpooledSelection(const QString &tableName, QChar identifierQuote,
+                                                         QString *error) const;
+    // Memory held by the tab's result, and what it spilled to disk.
+    qint64 residentBytes() const;
+    qint64 spilledBytes() const;
+    // The table shown in the grid when it was opened from the tree.
+    QString tableName() const { return browse.table; }
+    QString status() const { return lastStatus; }
+    QString executionTime() const { return lastExecutionTime; }
+    // Following the foreign keys of the current row, for the grid's menu.
+    void addReferenceActions(QMenu *menu);
+    const QStringList &history() const { return queryHistory; }
+
+    // For the saved session; see SessionStore. A restored result is shown
+    // as stale until it is read again.
+    SessionStore::Tab sessionState() const;
+    void restoreState(const SessionStore::Tab &state, const QDateTime &saved);
+
+public slots:
+    void executeQuery();
+    void executeStatement();
+    void runQuery(const QString &query);
+    void openTable(const QString &table);
+    void sampleTable(const QString &table, const TableSampler::Options &options);
+    void cancelQuery();
+    void beginTransaction();
+    void commitTransaction();
+    void rollbackTransaction();
+    void viewCellValue(int row, int column);
+    void viewCurrentValue();
+    // Re-reads the table a restored result browsed. A restored query result
+    // stays stale until the user runs the query.
+    void refreshResult();
+    // Picks the columns a browsed table selects; see ColumnChooserDialog.
+    void chooseColumns();
+
+signals:
+    // Emitted before running in an unbound tab; a direct connection may
+    // call bind() to pick the target.
+    void bindingNeeded(QueryTab *tab);
+    void statusChanged(QueryTab *tab);
+    void stateChanged(QueryTab *tab);
+    void schemaChanged();
+
+private slots:
+    void showOutcome();
+    void fetchMoreRows();
+    void fetchAllRows();
+    void showSpoolProgress();
+    void onCellChanged(int row, int column);
+    void onHeaderClicked(int logicalIndex);
+    void showHistoryMenu();
+    void prefetchReferences();
+    void showReferences();
+
+private:
+    enum Request {
+        NoRequest, QueryRequest, TableRequest, SampleRequest, FetchRequest, SpoolRequest, EditRequest,
+        TransactionRequest
+    };
+
+    bool prepareRun();
+    void start(Request request, const QFuture<QuerySession::Outcome> &future, const QString &message);
+    void transaction(QuerySession::Transaction operation);
+    void setStatus(const QString &message, const QString &elapsed = QString());
+    void updateControls();
+    void updateTruncationBar(bool truncated);
+    void addToHistory(const QString &query);
+    TableUtils::FetchLimits fetchLimits() const;
+    bool shouldSpool() const;
+    void startSpool();
+    void leaveSpoolMode();
+    void setGridBytes(qint64 bytes);
+    void runBrowse(const QString &message);
+    void resetReferences(const ForeignKeys::TableKeys &keys);
+    void applyReferences(int first, int last);
+    int gridColumn(const QString &name) const;
+    // Texts of the columns in `row`; empty when one of them is NULL.
+    QStringList rowValues(int row, const QVector<int> &columns) const;
+    void openReferencedRow(int key, int row);
+    void closeLookup();
+
+    SqlEditor *queryEdit;
+    QTableWidget *dataTable;
+    QStackedWidget *resultStack;
+    QTableView *spoolView;
+    ResultStoreModel *spoolModel;
+    QLabel *targetLabel;
+    QPushButton *executeButton;
+    QPushButton *stopButton;
+    QPushButton *beginButton;
+    QPushButton *commitButton;
+    QPushButton *rollbackButton;
+    QToolButton *historyButton;
+    QToolButton *pivotButton;
+    PivotPanel *pivotPanel;
+    QWidget *truncationBar;
+    QLabel *truncationLabel;
+    QLabel *staleLabel;
+    FilterBar *filterBar;
+
+    QString server;
+    DatabaseConnection::ConnectionParams params;
+    QThreadPool pool;
+    QScopedPointer<QuerySession> session;
+    QFutureWatcher<QuerySession::Outcome> watcher;
+    Request request;
+    QString requestQuery;
+    QString resultQuery;            // what produced the grid, for the session
+    QString resultTable;
+    QDateTime staleSince;           // set while the grid shows a restored result
+    bool refreshing;
+    bool transactionOpen;
+    LargeValues::Browse browse;     // layout of the grid when it shows a table
+    BrowseQuery::Request browseRequest;
+    int editRow;
+    int editColumn;
+    QString editOldValue;
+    int sortColumn;
+    qint64 gridBytes;               // estimate, reported to ResultMemory
+    int resultRows;                 // rows of the whole result, -1 when unknown
+    QSharedPointer<ResultStore> spooled;
+    QTimer spoolTimer;
+    Qt::SortOrder sortOrder;
+    ForeignKeys::TableKeys foreignKeys;             // of the browsed table
+    QVector<QVector<int>> keyColumns;               // grid columns per outgoing key
+    QVector<QHash<QString, ForeignKeys::Row>> referencedRows;   // per outgoing key, by value
+    QSet<QString> failedReferences;                 // referenced tables whose lookup failed
+    QThreadPool lookupPool;
+    QScopedPointer<DatabaseConnection> lookupConnection;
+    QFutureWatcher<QVector<ForeignKeys::Lookup>> lookupWatcher;
+    QTimer prefetchTimer;
+    int referenceGeneration;        // bumped when the grid shows another table
+    int lookupGeneration;
+    int lookupFirst;
+    int lookupLast;
+    bool prefetchAgain;
+    QStringList queryHistory;
+    QString lastStatus;
+    QString lastExecutionTime;
+};
+
+#endif // QUERYTAB_H
@@ -51,7 +51,7 @@ build_windows() {
         $MXE_PATH/x86_64-w64-mingw32.static-make -j$(nproc)
         
         mkdir -p release/windows
-        mv release/db_manager.exe release/windows/
+        mv db_manager.exe release/windows/
         
         # Deploy Qt dependencies
         $MXE_PATH/x86_64-w64-mingw32.static-windeployqt.exe release/windows/db_manager.exe
@@ -60,7 +60,7 @@ build_windows() {
         nmake
         
         mkdir -p release/windows
-        mv release/db_manager.exe release/windows/
+        mv db_manager.exe release/windows/
         windeployqt.exe release/windows/db_manager.exe
     fi
 }
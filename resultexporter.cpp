@@ -0,0 +1,218 @@
+#include "resultexporter.h"
+#include <QMetaType>
+#include <cmath>
+
+namespace {
+
+const int FlushThreshold = 64 * 1024;
+
+void appendJsonString(QByteArray &out, const QString &value) {
+    out += '"';
+    int runStart = 0;
+    for (int i = 0; i < value.size(); ++i) {
+        const ushort c = value.at(i).unicode();
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        out += value.mid(runStart, i - runStart).toUtf8();
+        runStart = i + 1;
+        switch (c) {
+        case '"':  out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        case '\b': out += "\\b"; break;
+        case '\f': out += "\\f"; break;
+        default:
+            out += "\\u00";
+            out += QByteArray::number(c, 16).rightJustified(2, '0');
+        }
+    }
+    out += value.mid(runStart).toUtf8();
+    out += '"';
+}
+
+void appendJsonValue(QByteArray &out, const QVariant &value) {
+    if (value.isNull()) {
+        out += "null";
+        return;
+    }
+    switch (value.userType()) {
+    case QMetaType::Bool:
+        out += value.toBool() ? "true" : "false";
+        break;
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::Long:
+    case QMetaType::ULong:
+    case QMetaType::LongLong:
+    case QMetaType::ULongLong:
+    case QMetaType::Short:
+    case QMetaType::UShort:
+        out += value.toString().toUtf8();
+        break;
+    case QMetaType::Double:
+    case QMetaType::Float: {
+        double d = value.toDouble();
+        if (std::isfinite(d)) {
+            out += QByteArray::number(d, 'g', 17);
+        } else {
+            out += "null";
+        }
+        break;
+    }
+    default:
+        appendJsonString(out, value.toString());
+    }
+}
+
+} // namespace
+
+ResultExporter::ResultExporter(QIODevice *device, Format format)
+    : device(device), format(format), headerEnabled(true), failed(false), rows(0), bytes(0) {
+    buffer.reserve(FlushThreshold * 2);
+}
+
+ResultExporter::~ResultExporter() {
+    flushBuffer(true);
+}
+
+bool ResultExporter::formatFromName(const QString &name, Format *format) {
+    QString lower = name.trimmed().toLower();
+    if (lower == "csv") {
+        *format = Csv;
+    } else if (lower == "tsv" || lower == "tab") {
+        *format = Tsv;
+    } else if (lower == "json") {
+        *format = Json;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+QString ResultExporter::formatName(Format format) {
+    switch (format) {
+    case Csv: return "csv";
+    case Tsv: return "tsv";
+    case Json: return "json";
+    }
+    return QString();
+}
+
+void ResultExporter::setWriteHeader(bool enabled) {
+    headerEnabled = enabled;
+}
+
+void ResultExporter::writeHeader(const QStringList &columnNames) {
+    columns = columnNames;
+    if (!headerEnabled || format == Json) {
+        return;
+    }
+
+    for (int i = 0; i < columns.size(); ++i) {
+        if (format == Csv) {
+            if (i > 0) buffer += ',';
+            appendCsvField(columns.at(i));
+        } else {
+            if (i > 0) buffer += '\t';
+            appendTsvField(columns.at(i));
+        }
+    }
+    buffer += '\n';
+    flushBuffer();
+}
+
+void ResultExporter::writeRow(const QVariantList &values) {
+    if (format == Json) {
+        buffer += rows == 0 ? "[\n" : ",\n";
+        buffer += '{';
+        for (int i = 0; i < values.size(); ++i) {
+            if (i > 0) buffer += ',';
+            appendJsonString(buffer, columns.value(i, QString("column%1").arg(i + 1)));
+            buffer += ':';
+            appendJsonValue(buffer, values.at(i));
+        }
+        buffer += '}';
+    } else {
+        for (int i = 0; i < values.size(); ++i) {
+            const QVariant &value = values.at(i);
+            if (format == Csv) {
+                if (i > 0) buffer += ',';
+                appendCsvField(value.toString());
+            } else {
+                if (i > 0) buffer += '\t';
+                if (value.isNull()) {
+                    buffer += "\\N";
+                } else {
+                    appendTsvField(value.toString());
+                }
+            }
+        }
+        buffer += '\n';
+    }
+
+    ++rows;
+    flushBuffer();
+}
+
+bool ResultExporter::finish() {
+    if (format == Json) {
+        buffer += rows == 0 ? "[]\n" : "\n]\n";
+    }
+    flushBuffer(true);
+    return !failed;
+}
+
+qint64 ResultExporter::rowsWritten() const {
+    return rows;
+}
+
+qint64 ResultExporter::bytesWritten() const {
+    return bytes + buffer.size();
+}
+
+QString ResultExporter::errorString() const {
+    return device ? device->errorString() : QString();
+}
+
+void ResultExporter::appendCsvField(const QString &value) {
+    buffer += '"';
+    if (value.contains('"')) {
+        QString escaped = value;
+        escaped.replace("\"", "\"\"");
+        buffer += escaped.toUtf8();
+    } else {
+        buffer += value.toUtf8();
+    }
+    buffer += '"';
+}
+
+void ResultExporter::appendTsvField(const QString &value) {
+    QByteArray utf8 = value.toUtf8();
+    for (char c : utf8) {
+        switch (c) {
+        case '\t': buffer += "\\t"; break;
+        case '\n': buffer += "\\n"; break;
+        case '\r': buffer += "\\r"; break;
+        case '\\': buffer += "\\\\"; break;
+        default: buffer += c;
+        }
+    }
+}
+
+void ResultExporter::flushBuffer(bool force) {
+    if (buffer.isEmpty() || (!force && buffer.size() < FlushThreshold)) {
+        return;
+    }
+    if (!failed && device) {
+        qint64 written = device->write(buffer);
+        if (written != buffer.size()) {
+            failed = true;
+        } else {
+            bytes += written;
+        }
+    }
+    buffer.resize(0);
+}
@@ -0,0 +1,53 @@
+#ifndef RESULTEXPORTER_H
+#define RESULTEXPORTER_H
+
+#include <QIODevice>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include <QByteArray>
+
+// Writes a result set row by row to a device. Rows are encoded straight into
+// a UTF-8 buffer that is flushed in large blocks, so the same code path serves
+// the GUI export and the headless command-line mode without holding the whole
+// result in memory.
+class ResultExporter {
+public:
+    enum Format {
+        Csv,
+        Tsv,
+        Json
+    };
+
+    explicit ResultExporter(QIODevice *device, Format format = Csv);
+    ~ResultExporter();
+
+    static bool formatFromName(const QString &name, Format *format);
+    static QString formatName(Format format);
+
+    void setWriteHeader(bool enabled);
+
+    void writeHeader(const QStringList &columns);
+    void writeRow(const QVariantList &values);
+    bool finish();
+
+    qint64 rowsWritten() const;
+    qint64 bytesWritten() const;
+    QString errorString() const;
+
+private:
+    void appendCsvField(const QString &value);
+    void appendTsvField(const QString &value);
+    void flushBuffer(bool force = false);
+
+    QIODevice *device;
+    Format format;
+    bool headerEnabled;
+    bool failed;
+    QStringList columns;
+    QByteArray buffer;
+    qint64 rows;
+    qint64 bytes;
+};
+
+#endif // RESULTEXPORTER_H
@@ -0,0 +1,71 @@
+#include "resultmemory.h"
+#include <QSettings>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QAtomicInteger>
+
+namespace {
+
+const int DefaultBudgetMb = 2048;
+
+QMutex settingsMutex;
+bool settingsLoaded = false;
+ResultMemory::Settings cachedSettings;
+QAtomicInteger<qint64> residentBytes(0);
+QAtomicInteger<qint64> spilledBytes(0);
+QAtomicInteger<qint64> budgetBytes(qint64(DefaultBudgetMb) * 1024 * 1024);
+
+ResultMemory::Settings readSettings() {
+    QSettings stored("DBManager", "Settings");
+    ResultMemory::Settings settings;
+    settings.budgetBytes = qint64(stored.value("resultMemoryBudgetMb", DefaultBudgetMb).toInt()) * 1024 * 1024;
+    settings.spill = stored.value("resultSpillEnabled", true).toBool();
+    settings.directory = stored.value("resultSpillDirectory").toString();
+    return settings;
+}
+
+} // namespace
+
+ResultMemory::Settings ResultMemory::settings() {
+    QMutexLocker locker(&settingsMutex);
+    if (!settingsLoaded) {
+        cachedSettings = readSettings();
+        budgetBytes.storeRelaxed(cachedSettings.budgetBytes);
+        settingsLoaded = true;
+    }
+    return cachedSettings;
+}
+
+void ResultMemory::reload() {
+    setSettings(readSettings());
+}
+
+void ResultMemory::setSettings(const Settings &settings) {
+    QMutexLocker locker(&settingsMutex);
+    cachedSettings = settings;
+    budgetBytes.storeRelaxed(cachedSettings.budgetBytes);
+    settingsLoaded = true;
+}
+
+void ResultMemory::add(qint64 residentDelta, qint64 spilledDelta) {
+    if (residentDelta != 0) {
+        residentBytes.fetchAndAddRelaxed(residentDelta);
+    }
+    if (spilledDelta != 0) {
+        spilledBytes.fetchAndAddRelaxed(spilledDelta);
+    }
+}
+
+qint64 ResultMemory::resident() {
+    return residentBytes.loadRelaxed();
+}
+
+qint64 ResultMemory::spilled() {
+    return spilledBytes.loadRelaxed();
+}
+
+bool ResultMemory::overBudget() {
+    settings();
+    qint64 budget = budgetBytes.loadRelaxed();
+    return budget > 0 && residentBytes.loadRelaxed() > budget;
+}
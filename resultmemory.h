@@ -0,0 +1,32 @@
+#ifndef RESULTMEMORY_H
+#define RESULTMEMORY_H
+
+#include <QString>
+
+// Process-wide account of the memory held by results. Grids report an
+// estimate of their cells; spooled results (see ResultStore) report the
+// chunks they keep in memory and the ones they wrote to disk, and spill
+// their older chunks while the total is over the budget.
+class ResultMemory {
+public:
+    struct Settings {
+        Settings() : budgetBytes(0), spill(true) {}
+        qint64 budgetBytes;
+        bool spill;            // "Fetch all" spools the rest of a result
+        QString directory;     // for spill files; empty for the system temp dir
+    };
+
+    // Cached; reload() after the settings dialog saved them.
+    static Settings settings();
+    static void reload();
+    // Overrides them for this process only, as the benchmark suite does.
+    static void setSettings(const Settings &settings);
+
+    // Deltas may be negative; call from any thread.
+    static void add(qint64 residentDelta, qint64 spilledDelta);
+    static qint64 resident();
+    static qint64 spilled();
+    static bool overBudget();
+};
+
+#endif // RESULTMEMORY_H
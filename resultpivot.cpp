@@ -0,0 +1,500 @@
+#include "resultpivot.h"
+#include <QHash>
+#include <QSet>
+#include <QThreadPool>
+#include <QElapsedTimer>
+#include <QObject>
+#include <QtConcurrent>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+// Below this many rows per worker, starting threads costs more than it saves.
+const int MinRowsPerWorker = 16384;
+
+int workerCount(int rows, int threads) {
+    return qBound(1, threads, qMax(1, rows / MinRowsPerWorker));
+}
+
+// Runs fn(begin, end, worker) over `workers` equal row ranges. The ranges
+// only depend on rows and workers, so two passes see the same split.
+template <typename Fn>
+void forRanges(int rows, int workers, Fn fn) {
+    if (workers <= 1) {
+        fn(0, rows, 0);
+        return;
+    }
+    QThreadPool pool;
+    pool.setMaxThreadCount(workers);
+    QVector<QFuture<void>> futures;
+    for (int worker = 0; worker < workers; ++worker) {
+        int begin = static_cast<int>(qint64(rows) * worker / workers);
+        int end = static_cast<int>(qint64(rows) * (worker + 1) / workers);
+        futures << QtConcurrent::run(&pool, [&fn, begin, end, worker]() { fn(begin, end, worker); });
+    }
+    for (QFuture<void> &future : futures) {
+        future.waitForFinished();
+    }
+}
+
+// Replaces composite keys by dense ids when the next column would overflow
+// the mixed-radix key; returns the number of ids.
+quint64 densify(QVector<quint64> *keys) {
+    QHash<quint64, quint64> ids;
+    for (quint64 &key : *keys) {
+        auto found = ids.constFind(key);
+        if (found != ids.constEnd()) {
+            key = found.value();
+        } else {
+            quint64 id = ids.size();
+            ids.insert(key, id);
+            key = id;
+        }
+    }
+    return qMax<quint64>(1, ids.size());
+}
+
+// An aggregate bound to its column's buffers.
+struct Binding {
+    ResultPivot::Function function;
+    const ResultPivot::Column *column;   // null counts rows
+};
+
+// Accumulators of one worker. Per group, `state` holds the row count and
+// then (value, count) for every aggregate: the sum for Sum and Avg, the
+// value rank for Min and Max. Distinct codes are kept in sets.
+struct Partial {
+    QHash<quint64, int> slots;
+    QVector<quint64> keys;
+    QVector<int> firstRows;
+    QVector<double> state;
+    QVector<QSet<quint32>> distinct;
+};
+
+QString formatNumber(double value) {
+    if (std::floor(value) == value && std::fabs(value) < 1e15) {
+        return QString::number(static_cast<qint64>(value));
+    }
+    return QString::number(value, 'g', 12);
+}
+
+QString formatCell(const Binding &binding, const double *cell, const QSet<quint32> &distinct) {
+    double count = cell[1];
+    switch (binding.function) {
+    case ResultPivot::Count:
+        return formatNumber(count);
+    case ResultPivot::CountDistinct:
+        return QString::number(distinct.size());
+    case ResultPivot::Sum:
+        return count > 0 ? formatNumber(cell[0]) : QString();
+    case ResultPivot::Avg:
+        return count > 0 ? formatNumber(cell[0] / count) : QString();
+    default:
+        if (count <= 0) return QString();
+        return binding.column->values.at(binding.column->sorted.at(static_cast<int>(cell[0])));
+    }
+}
+
+} // namespace
+
+ResultPivot::ColumnPtr ResultPivot::encode(const QVector<QString> &texts, int threads) {
+    QSharedPointer<Column> column(new Column);
+    const int rows = texts.size();
+    const int workers = workerCount(rows, threads);
+    column->codes.resize(rows);
+    quint32 *codes = column->codes.data();
+
+    // Each range gets a dictionary of its own, so workers never share a hash.
+    QVector<QVector<QString>> localValues(workers);
+    QVector<QString> *locals = localValues.data();
+    forRanges(rows, workers, [&texts, codes, locals](int begin, int end, int worker) {
+        QHash<QString, quint32> dictionary;
+        QVector<QString> &values = locals[worker];
+        values << QString();
+        for (int row = begin; row < end; ++row) {
+            const QString &text = texts.at(row);
+            if (text.isEmpty()) {
+                codes[row] = 0;
+                continue;
+            }
+            auto found = dictionary.constFind(text);
+            if (found != dictionary.constEnd()) {
+                codes[row] = found.value();
+            } else {
+                quint32 code = values.size();
+                dictionary.insert(text, code);
+                values << text;
+                codes[row] = code;
+            }
+        }
+    });
+
+    // Merge the local dictionaries, then translate local codes in parallel.
+    QHash<QString, quint32> dictionary;
+    QVector<QVector<quint32>> remap(workers);
+    column->values << QString();
+    for (int worker = 0; worker < workers; ++worker) {
+        const QVector<QString> &values = localValues.at(worker);
+        QVector<quint32> &map = remap[worker];
+        map.resize(values.size());
+        for (int local = 1; local < values.size(); ++local) {
+            auto found = dictionary.constFind(values.at(local));
+            if (found != dictionary.constEnd()) {
+                map[local] = found.value();
+            } else {
+                quint32 code = column->values.size();
+                dictionary.insert(values.at(local), code);
+                column->values << values.at(local);
+                map[local] = code;
+            }
+        }
+    }
+    if (workers > 1) {
+        const QVector<quint32> *maps = remap.constData();
+        forRanges(rows, workers, [codes, maps](int begin, int end, int worker) {
+            const quint32 *map = maps[worker].constData();
+            for (int row = begin; row < end; ++row) {
+                codes[row] = map[codes[row]];
+            }
+        });
+    }
+
+    const int count = column->values.size();
+    column->numbers.resize(count);
+    column->numbers[0] = std::numeric_limits<double>::quiet_NaN();
+    for (int code = 1; code < count; ++code) {
+        bool ok = false;
+        double number = column->values.at(code).toDouble(&ok);
+        ok = ok && !std::isnan(number);
+        column->numbers[code] = ok ? number : std::numeric_limits<double>::quiet_NaN();
+        column->numeric = column->numeric && ok;
+    }
+
+    // The empty cell (code 0) sorts first.
+    column->sorted.resize(count);
+    std::iota(column->sorted.begin(), column->sorted.end(), 0u);
+    const Column *encoded = column.data();
+    std::sort(column->sorted.begin() + 1, column->sorted.end(), [encoded](quint32 a, quint32 b) {
+        return encoded->numeric ? encoded->numbers.at(a) < encoded->numbers.at(b)
+                                : encoded->values.at(a) < encoded->values.at(b);
+    });
+    column->ranks.resize(count);
+    for (int rank = 0; rank < count; ++rank) {
+        column->ranks[column->sorted.at(rank)] = rank;
+    }
+    return column;
+}
+
+ResultPivot::Result ResultPivot::aggregate(const QVector<ColumnPtr> &columns, const QStringList &headers,
+                                           int rowCount, const Spec &spec, int threads) {
+    Result result;
+    QElapsedTimer timer;
+    timer.start();
+    result.inputRows = rowCount;
+
+    if (spec.aggregates.isEmpty()) {
+        result.error = QObject::tr("Choose at least one aggregate");
+        return result;
+    }
+    auto columnAt = [&columns, rowCount](int index) -> const Column * {
+        if (index < 0 || index >= columns.size() || !columns.at(index)) return nullptr;
+        const Column *column = columns.at(index).data();
+        return column->codes.size() == rowCount ? column : nullptr;
+    };
+
+    QVector<const Column *> groupColumns;
+    for (int index : spec.groupColumns) {
+        groupColumns << columnAt(index);
+    }
+    const Column *pivot = spec.pivotColumn >= 0 ? columnAt(spec.pivotColumn) : nullptr;
+    bool missing = groupColumns.contains(nullptr) || (spec.pivotColumn >= 0 && !pivot);
+    QVector<Binding> bindings;
+    for (const Aggregate &aggregate : spec.aggregates) {
+        Binding binding;
+        binding.function = aggregate.column < 0 ? Count : aggregate.function;
+        binding.column = aggregate.column < 0 ? nullptr : columnAt(aggregate.column);
+        missing = missing || (aggregate.column >= 0 && !binding.column);
+        bindings << binding;
+    }
+    if (missing) {
+        result.error = QObject::tr("The result changed; compute again");
+        return result;
+    }
+
+    const int workers = workerCount(rowCount, threads);
+
+    // Rows become one integer key: the key columns' codes in mixed radix.
+    QVector<const Column *> keyColumns = groupColumns;
+    if (pivot) {
+        keyColumns << pivot;
+    }
+    QVector<quint64> keys(rowCount, 0);
+    quint64 radix = 1;
+    for (const Column *key : keyColumns) {
+        quint64 cardinality = key->values.size();
+        if (radix > std::numeric_limits<quint64>::max() / cardinality) {
+            radix = densify(&keys);
+        }
+        quint64 *keyData = keys.data();
+        const quint32 *codes = key->codes.constData();
+        forRanges(rowCount, workers, [keyData, codes, cardinality](int begin, int end, int) {
+            for (int row = begin; row < end; ++row) {
+                keyData[row] = keyData[row] * cardinality + codes[row];
+            }
+        });
+        radix *= cardinality;
+    }
+
+    const int aggregates = bindings.size();
+    const int width = 1 + 2 * aggregates;
+    QVector<Partial> partials(workers);
+    Partial *partialData = partials.data();
+    const quint64 *keyData = keys.constData();
+    const Binding *bindingData = bindings.constData();
+    forRanges(rowCount, workers, [=](int begin, int end, int worker) {
+        Partial &partial = partialData[worker];
+        quint64 lastKey = 0;
+        int slot = -1;
+        for (int row = begin; row < end; ++row) {
+            quint64 key = keyData[row];
+            // Loaded results are often ordered by their groups.
+            if (slot < 0 || key != lastKey) {
+                auto found = partial.slots.constFind(key);
+                if (found != partial.slots.constEnd()) {
+                    slot = found.value();
+                } else {
+                    slot = partial.keys.size();
+                    partial.slots.insert(key, slot);
+                    partial.keys << key;
+                    partial.firstRows << row;
+                    partial.state.resize(partial.state.size() + width);
+                    partial.distinct.resize(partial.distinct.size() + aggregates);
+                }
+                lastKey = key;
+            }
+            double *state = partial.state.data() + qint64(slot) * width;
+            state[0] += 1;
+            for (int index = 0; index < aggregates; ++index) {
+                const Binding &binding = bindingData[index];
+                double *cell = state + 1 + 2 * index;
+                if (!binding.column) {
+                    cell[1] += 1;
+                    continue;
+                }
+                quint32 code = binding.column->codes.at(row);
+                if (code == 0) continue;
+                switch (binding.function) {
+                case Count:
+                    cell[1] += 1;
+                    break;
+                case Sum:
+                case Avg: {
+                    double number = binding.column->numbers.at(code);
+                    if (!std::isnan(number)) {
+                        cell[0] += number;
+                        cell[1] += 1;
+                    }
+                    break;
+                }
+                case Min:
+                case Max: {
+                    double rank = binding.column->ranks.at(code);
+                    bool better = binding.function == Min ? rank < cell[0] : rank > cell[0];
+                    if (cell[1] == 0 || better) {
+                        cell[0] = rank;
+                    }
+                    cell[1] += 1;
+                    break;
+                }
+                case CountDistinct:
+                    partial.distinct[qint64(slot) * aggregates + index].insert(code);
+                    break;
+                }
+            }
+        }
+    });
+
+    // Fold the other workers' tables into the first one.
+    Partial &merged = partials[0];
+    for (int worker = 1; worker < workers; ++worker) {
+        const Partial &partial = partials.at(worker);
+        for (int slot = 0; slot < partial.keys.size(); ++slot) {
+            const double *source = partial.state.constData() + qint64(slot) * width;
+            auto found = merged.slots.constFind(partial.keys.at(slot));
+            if (found == merged.slots.constEnd()) {
+                int target = merged.keys.size();
+                merged.slots.insert(partial.keys.at(slot), target);
+                merged.keys << partial.keys.at(slot);
+                merged.firstRows << partial.firstRows.at(slot);
+                for (int i = 0; i < width; ++i) {
+                    merged.state << source[i];
+                }
+                for (int index = 0; index < aggregates; ++index) {
+                    merged.distinct << partial.distinct.at(qint64(slot) * aggregates + index);
+                }
+                continue;
+            }
+            int target = found.value();
+            double *state = merged.state.data() + qint64(target) * width;
+            state[0] += source[0];
+            for (int index = 0; index < aggregates; ++index) {
+                double *cell = state + 1 + 2 * index;
+                const double *other = source + 1 + 2 * index;
+                Function function = bindings.at(index).function;
+                if (function == Min || function == Max) {
+                    bool better = function == Min ? other[0] < cell[0] : other[0] > cell[0];
+                    if (other[1] > 0 && (cell[1] == 0 || better)) {
+                        cell[0] = other[0];
+                    }
+                } else if (function == CountDistinct) {
+                    merged.distinct[qint64(target) * aggregates + index].unite(
+                        partial.distinct.at(qint64(slot) * aggregates + index));
+                } else {
+                    cell[0] += other[0];
+                }
+                cell[1] += other[1];
+            }
+        }
+    }
+
+    // Output rows are groups; with a pivot, every (group, pivot value) slot
+    // fills one block of aggregate columns in its group's row.
+    QVector<int> pivotColumnOf;
+    QVector<quint32> pivotCodes;
+    if (pivot) {
+        QHash<quint32, double> pivotRows;
+        for (int slot = 0; slot < merged.keys.size(); ++slot) {
+            pivotRows[pivot->codes.at(merged.firstRows.at(slot))] += merged.state.at(qint64(slot) * width);
+        }
+        pivotCodes = pivotRows.keys().toVector();
+        std::sort(pivotCodes.begin(), pivotCodes.end(), [&pivotRows, pivot](quint32 a, quint32 b) {
+            double rowsA = pivotRows.value(a);
+            double rowsB = pivotRows.value(b);
+            return rowsA != rowsB ? rowsA > rowsB : pivot->ranks.at(a) < pivot->ranks.at(b);
+        });
+        int keep = qMax(1, spec.maxPivotValues);
+        if (pivotCodes.size() > keep) {
+            result.droppedPivotValues = pivotCodes.size() - keep;
+            pivotCodes.resize(keep);
+        }
+        std::sort(pivotCodes.begin(), pivotCodes.end(),
+                  [pivot](quint32 a, quint32 b) { return pivot->ranks.at(a) < pivot->ranks.at(b); });
+        pivotColumnOf.fill(-1, pivot->values.size());
+        for (int i = 0; i < pivotCodes.size(); ++i) {
+            pivotColumnOf[pivotCodes.at(i)] = i;
+        }
+    }
+
+    for (int index : spec.groupColumns) {
+        result.headers << headers.value(index);
+    }
+    result.keyColumns = spec.groupColumns.size();
+    QStringList aggregateHeaders;
+    for (const Aggregate &aggregate : spec.aggregates) {
+        aggregateHeaders << aggregateName(aggregate, headers);
+    }
+    if (pivot) {
+        for (quint32 code : pivotCodes) {
+            QString value = code == 0 ? QObject::tr("(empty)") : pivot->values.at(code);
+            for (const QString &name : aggregateHeaders) {
+                result.headers << (aggregates == 1 ? value : QString("%1: %2").arg(value, name));
+            }
+        }
+    } else {
+        result.headers << aggregateHeaders;
+    }
+    const int blocks = pivot ? pivotCodes.size() : 1;
+
+    QHash<QVector<quint32>, int> rowOf;
+    QVector<QVector<quint32>> groupCodes;
+    for (int slot = 0; slot < merged.keys.size(); ++slot) {
+        int firstRow = merged.firstRows.at(slot);
+        int block = 0;
+        if (pivot) {
+            block = pivotColumnOf.at(pivot->codes.at(firstRow));
+            if (block < 0) continue;
+        }
+        QVector<quint32> group;
+        for (const Column *column : groupColumns) {
+            group << column->codes.at(firstRow);
+        }
+        auto found = rowOf.constFind(group);
+        int row;
+        if (found != rowOf.constEnd()) {
+            row = found.value();
+        } else {
+            row = result.rows.size();
+            rowOf.insert(group, row);
+            groupCodes << group;
+            QStringList cells;
+            for (int i = 0; i < groupColumns.size(); ++i) {
+                cells << groupColumns.at(i)->values.at(group.at(i));
+            }
+            for (int i = 0; i < blocks * aggregates; ++i) {
+                cells << QString();
+            }
+            result.rows << cells;
+        }
+        const double *state = merged.state.constData() + qint64(slot) * width;
+        QStringList &cells = result.rows[row];
+        for (int index = 0; index < aggregates; ++index) {
+            cells[groupColumns.size() + block * aggregates + index] =
+                formatCell(bindings.at(index), state + 1 + 2 * index,
+                           merged.distinct.at(qint64(slot) * aggregates + index));
+        }
+    }
+
+    // Groups in value order of their columns.
+    QVector<int> order(result.rows.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&groupCodes, &groupColumns](int a, int b) {
+        for (int i = 0; i < groupColumns.size(); ++i) {
+            quint32 rankA = groupColumns.at(i)->ranks.at(groupCodes.at(a).at(i));
+            quint32 rankB = groupColumns.at(i)->ranks.at(groupCodes.at(b).at(i));
+            if (rankA != rankB) return rankA < rankB;
+        }
+        return false;
+    });
+    QVector<QStringList> sortedRows;
+    sortedRows.reserve(order.size());
+    for (int row : order) {
+        sortedRows << result.rows.at(row);
+    }
+    result.rows = sortedRows;
+
+    result.groups = result.rows.size();
+    result.ok = true;
+    result.elapsedMs = timer.elapsed();
+    return result;
+}
+
+QString ResultPivot::functionName(Function function) {
+    switch (function) {
+    case Count:
+        return "count";
+    case Sum:
+        return "sum";
+    case Avg:
+        return "avg";
+    case Min:
+        return "min";
+    case Max:
+        return "max";
+    default:
+        return "count distinct";
+    }
+}
+
+QString ResultPivot::aggregateName(const Aggregate &aggregate, const QStringList &headers) {
+    if (aggregate.column < 0) {
+        return "count(*)";
+    }
+    QString column = headers.value(aggregate.column);
+    if (aggregate.function == CountDistinct) {
+        return QString("count(distinct %1)").arg(column);
+    }
+    return QString("%1(%2)").arg(functionName(aggregate.function), column);
+}
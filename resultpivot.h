@@ -0,0 +1,77 @@
+#ifndef RESULTPIVOT_H
+#define RESULTPIVOT_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QSharedPointer>
+
+// Group-by and pivot over a result already loaded in the grid, computed on
+// the client. Grid columns are copied once into column buffers and
+// dictionary-encoded: every distinct text gets a code, and numbers are
+// parsed once per distinct text instead of once per row. Aggregation hashes
+// integer group keys; the rows are split into ranges, each worker fills its
+// own flat accumulator table, and the partial tables are merged at the end.
+class ResultPivot {
+public:
+    enum Function {
+        Count,
+        Sum,
+        Avg,
+        Min,
+        Max,
+        CountDistinct
+    };
+
+    struct Aggregate {
+        Aggregate() : function(Count), column(-1) {}
+        Function function;
+        int column;    // -1 with Count counts rows
+    };
+
+    struct Spec {
+        Spec() : pivotColumn(-1), maxPivotValues(50) {}
+        QVector<int> groupColumns;
+        int pivotColumn;           // -1 for a plain group-by
+        QVector<Aggregate> aggregates;
+        int maxPivotValues;        // the most frequent pivot values become columns
+    };
+
+    // One grid column, dictionary-encoded. Code 0 is the empty cell, which
+    // is also how the grid shows NULL; aggregates over a column skip it.
+    struct Column {
+        Column() : numeric(true) {}
+        QVector<quint32> codes;    // per row
+        QVector<QString> values;   // per code
+        QVector<double> numbers;   // per code, NaN when not a number
+        QVector<quint32> ranks;    // per code, its position in value order
+        QVector<quint32> sorted;   // codes in value order
+        bool numeric;              // every non-empty value is a number
+    };
+    typedef QSharedPointer<const Column> ColumnPtr;
+
+    struct Result {
+        Result() : ok(false), keyColumns(0), inputRows(0), groups(0), droppedPivotValues(0), elapsedMs(0) {}
+        bool ok;
+        QString error;
+        QStringList headers;
+        QVector<QStringList> rows;
+        int keyColumns;            // leading group columns; the rest are aggregates
+        qint64 inputRows;
+        int groups;
+        int droppedPivotValues;
+        qint64 elapsedMs;
+    };
+
+    // Both run on the calling thread plus `threads` workers of their own.
+    static ColumnPtr encode(const QVector<QString> &texts, int threads);
+    // `columns` is indexed by grid column; only the ones the spec uses
+    // have to be encoded.
+    static Result aggregate(const QVector<ColumnPtr> &columns, const QStringList &headers, int rowCount,
+                            const Spec &spec, int threads);
+
+    static QString functionName(Function function);
+    static QString aggregateName(const Aggregate &aggregate, const QStringList &headers);
+};
+
+#endif // RESULTPIVOT_H
@@ -0,0 +1,260 @@
+#include "resultstore.h"
+#include "resultmemory.h"
+#include "tracer.h"
+#include <QDir>
+#include <QObject>
+#include <QVariant>
+#include <cstring>
+
+namespace {
+
+// Decoded chunks kept for a view scrolling back and forth.
+const int CachedChunks = 4;
+
+// Rough per-cell cost of a decoded QString, for the memory account.
+const qint64 DecodedCellOverhead = 24;
+
+void appendText(QByteArray *out, const QString &text) {
+    QByteArray utf8 = text.toUtf8();
+    quint32 size = static_cast<quint32>(utf8.size());
+    out->append(reinterpret_cast<const char *>(&size), sizeof(size));
+    out->append(utf8);
+}
+
+// Returns the estimated size of the decoded rows.
+qint64 decodeRows(const char *data, qint64 size, int columns, QVector<QStringList> *rows) {
+    qint64 bytes = 0;
+    const char *end = data + size;
+    while (data < end) {
+        QStringList row;
+        row.reserve(columns);
+        for (int col = 0; col < columns; ++col) {
+            quint32 length = 0;
+            if (end - data < qint64(sizeof(length))) {
+                return bytes;
+            }
+            std::memcpy(&length, data, sizeof(length));
+            data += sizeof(length);
+            length = static_cast<quint32>(qMin<qint64>(length, end - data));
+            row << QString::fromUtf8(data, static_cast<int>(length));
+            data += length;
+            bytes += DecodedCellOverhead + qint64(length) * qint64(sizeof(QChar));
+        }
+        rows->append(row);
+    }
+    return bytes;
+}
+
+} // namespace
+
+ResultStore::ResultStore(const QStringList &headers)
+    : columnNames(headers), spilledChunks(0), resident(0), spilled(0), rows(0), canceled(0) {
+}
+
+ResultStore::~ResultStore() {
+    ResultMemory::add(-resident, -spilled);
+}
+
+int ResultStore::rowCount() const {
+    return rows.loadAcquire();
+}
+
+qint64 ResultStore::residentBytes() const {
+    QMutexLocker locker(&mutex);
+    return resident;
+}
+
+qint64 ResultStore::spilledBytes() const {
+    QMutexLocker locker(&mutex);
+    return spilled;
+}
+
+void ResultStore::cancel() {
+    canceled.storeRelaxed(1);
+}
+
+bool ResultStore::isCanceled() const {
+    return canceled.loadRelaxed() != 0;
+}
+
+void ResultStore::account(qint64 residentDelta, qint64 spilledDelta) {
+    resident += residentDelta;
+    spilled += spilledDelta;
+    ResultMemory::add(residentDelta, spilledDelta);
+}
+
+bool ResultStore::append(const QVector<QStringList> &batch, QString *error) {
+    // Encoded before taking the lock, so readers wait only for the copy.
+    const int columns = columnNames.size();
+    QByteArray buffer;
+    QVector<int> rowEnds;
+    rowEnds.reserve(batch.size());
+    for (const QStringList &values : batch) {
+        for (int col = 0; col < columns; ++col) {
+            appendText(&buffer, col < values.size() ? values.at(col) : QString());
+        }
+        rowEnds << buffer.size();
+    }
+
+    QMutexLocker locker(&mutex);
+    int start = 0;
+    for (int next = 0; next < rowEnds.size();) {
+        if (chunks.isEmpty() || chunks.last().rows >= ChunkRows) {
+            chunks.append(Chunk());
+        }
+        Chunk &chunk = chunks.last();
+        int count = qMin(ChunkRows - chunk.rows, rowEnds.size() - next);
+        int stop = rowEnds.at(next + count - 1);
+        chunk.data.append(buffer.constData() + start, stop - start);
+        chunk.size += stop - start;
+        chunk.rows += count;
+        account(stop - start, 0);
+        start = stop;
+        next += count;
+    }
+    rows.storeRelease(rows.loadRelaxed() + rowEnds.size());
+
+    while (ResultMemory::overBudget()) {
+        QString spillError;
+        if (!spillOldest(&spillError)) {
+            if (spillError.isEmpty()) break;
+            *error = spillError;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ResultStore::spillOldest(QString *error) {
+    // The last chunk may still grow, so it stays in memory.
+    if (spilledChunks >= chunks.size() - 1) {
+        return false;
+    }
+    if (!spillFile) {
+        QString directory = ResultMemory::settings().directory;
+        if (directory.isEmpty()) {
+            directory = QDir::tempPath();
+        }
+        spillFile.reset(new QTemporaryFile(QDir(directory).filePath("db_manager-result-XXXXXX.spill")));
+        if (!spillFile->open()) {
+            *error = QObject::tr("Cannot create a spill file in %1: %2").arg(directory, spillFile->errorString());
+            spillFile.reset();
+            return false;
+        }
+    }
+
+    Tracer::Scope span(Tracer::Spill);
+    Chunk &chunk = chunks[spilledChunks];
+    span.setValue(chunk.size);
+    qint64 offset = spillFile->size();
+    if (!spillFile->seek(offset) || spillFile->write(chunk.data) != chunk.data.size() || !spillFile->flush()) {
+        *error = QObject::tr("Cannot write the spill file: %1").arg(spillFile->errorString());
+        return false;
+    }
+    chunk.offset = offset;
+    chunk.data = QByteArray();
+    account(-chunk.size, chunk.size);
+    ++spilledChunks;
+    return true;
+}
+
+bool ResultStore::decodeChunk(int index, QVector<QStringList> *decoded, qint64 *bytes, QString *error) {
+    Tracer::Scope span(Tracer::Decode);
+    const Chunk &chunk = chunks.at(index);
+    span.setValue(chunk.rows);
+    decoded->reserve(chunk.rows);
+    if (chunk.offset < 0) {
+        *bytes = decodeRows(chunk.data.constData(), chunk.data.size(), columnNames.size(), decoded);
+        return true;
+    }
+    uchar *mapped = spillFile->map(chunk.offset, chunk.size);
+    if (!mapped) {
+        *error = QObject::tr("Cannot read the spill file: %1").arg(spillFile->errorString());
+        return false;
+    }
+    *bytes = decodeRows(reinterpret_cast<const char *>(mapped), chunk.size, columnNames.size(), decoded);
+    spillFile->unmap(mapped);
+    return true;
+}
+
+QStringList ResultStore::row(int row, QString *error) {
+    QMutexLocker locker(&mutex);
+    int index = row / ChunkRows;
+    int offset = row % ChunkRows;
+    if (row < 0 || index >= chunks.size() || offset >= chunks.at(index).rows) {
+        return QStringList();
+    }
+    for (int i = 0; i < cache.size(); ++i) {
+        // The last chunk may have grown since it was decoded.
+        if (cache.at(i).chunk == index && cache.at(i).rows.size() > offset) {
+            if (i > 0) {
+                cache.move(i, 0);
+            }
+            Tracer::count(Tracer::CacheHits);
+            return cache.first().rows.at(offset);
+        }
+    }
+    Tracer::count(Tracer::CacheMisses);
+
+    Decoded decoded;
+    decoded.chunk = index;
+    if (!decodeChunk(index, &decoded.rows, &decoded.bytes, error)) {
+        return QStringList();
+    }
+    for (int i = cache.size() - 1; i >= 0; --i) {
+        if (cache.at(i).chunk == index) {
+            account(-cache.at(i).bytes, 0);
+            cache.remove(i);
+        }
+    }
+    cache.prepend(decoded);
+    account(decoded.bytes, 0);
+    while (cache.size() > CachedChunks) {
+        account(-cache.last().bytes, 0);
+        cache.removeLast();
+    }
+    return cache.first().rows.value(offset);
+}
+
+bool ResultStore::exportTo(QIODevice *device, ResultExporter::Format format, QString *error,
+                           QAtomicInt *rowsDone, const QAtomicInt *canceledFlag) {
+    Tracer::Scope span(Tracer::Export);
+    span.setValue(rowCount());
+    ResultExporter exporter(device, format);
+    exporter.writeHeader(columnNames);
+
+    // One chunk at a time; the decoded rows bypass the view's cache.
+    QVariantList values;
+    values.reserve(columnNames.size());
+    for (int index = 0;; ++index) {
+        if (canceledFlag && canceledFlag->loadRelaxed()) {
+            *error = QObject::tr("Export canceled");
+            return false;
+        }
+        QVector<QStringList> decoded;
+        {
+            QMutexLocker locker(&mutex);
+            if (index >= chunks.size()) break;
+            qint64 bytes;
+            if (!decodeChunk(index, &decoded, &bytes, error)) {
+                return false;
+            }
+        }
+        for (const QStringList &cells : decoded) {
+            values.clear();
+            for (const QString &cell : cells) {
+                values << QVariant(cell);
+            }
+            exporter.writeRow(values);
+        }
+        if (rowsDone) {
+            rowsDone->fetchAndAddRelaxed(decoded.size());
+        }
+    }
+
+    if (!exporter.finish()) {
+        *error = exporter.errorString();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,82 @@
+#ifndef RESULTSTORE_H
+#define RESULTSTORE_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QByteArray>
+#include <QMutex>
+#include <QAtomicInteger>
+#include <QScopedPointer>
+#include <QTemporaryFile>
+#include <QIODevice>
+#include "resultexporter.h"
+
+// The rows of a result too large for the grid. Rows are kept as the grid
+// would show them, UTF-8 encoded in chunks of ChunkRows rows. While the
+// results of all tabs are over the memory budget (see ResultMemory), older
+// chunks are written to a temporary file; reading a row of such a chunk maps
+// its part of the file and decodes the chunk into a small cache of recent
+// chunks, so a view scrolling through the result touches the disk once per
+// chunk.
+//
+// One thread appends while any number of threads read.
+class ResultStore {
+public:
+    static const int ChunkRows = 4096;
+
+    explicit ResultStore(const QStringList &headers);
+    ~ResultStore();
+
+    const QStringList &headers() const { return columnNames; }
+    int rowCount() const;
+    qint64 residentBytes() const;
+    qint64 spilledBytes() const;
+
+    // Rows shorter than the header are padded with empty cells.
+    bool append(const QVector<QStringList> &rows, QString *error);
+    // Empty, with the error set, when a spilled chunk cannot be read.
+    QStringList row(int row, QString *error);
+
+    // Stops a spool in progress; see QuerySession::spool().
+    void cancel();
+    bool isCanceled() const;
+
+    // Streams every row to the device; `rowsDone` and `canceled` may be null.
+    bool exportTo(QIODevice *device, ResultExporter::Format format, QString *error,
+                  QAtomicInt *rowsDone = nullptr, const QAtomicInt *canceled = nullptr);
+
+private:
+    struct Chunk {
+        Chunk() : rows(0), offset(-1), size(0) {}
+        int rows;
+        QByteArray data;       // encoded rows while in memory
+        qint64 offset;         // in the spill file, -1 while in memory
+        qint64 size;
+    };
+
+    struct Decoded {
+        Decoded() : chunk(-1), bytes(0) {}
+        int chunk;
+        QVector<QStringList> rows;
+        qint64 bytes;
+    };
+
+    // Call with the lock held.
+    bool decodeChunk(int index, QVector<QStringList> *decoded, qint64 *bytes, QString *error);
+    bool spillOldest(QString *error);
+    void account(qint64 residentDelta, qint64 spilledDelta);
+
+    QStringList columnNames;
+    mutable QMutex mutex;
+    QVector<Chunk> chunks;
+    QVector<Decoded> cache;            // most recently used first
+    QScopedPointer<QTemporaryFile> spillFile;
+    int spilledChunks;                 // chunks spill oldest first
+    qint64 resident;
+    qint64 spilled;
+    QAtomicInt rows;
+    QAtomicInt canceled;
+};
+
+#endif // RESULTSTORE_H
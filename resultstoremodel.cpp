@@ -0,0 +1,58 @@
+#include "resultstoremodel.h"
+
+ResultStoreModel::ResultStoreModel(QObject *parent)
+    : QAbstractTableModel(parent), rows(0)
+{
+}
+
+void ResultStoreModel::setStore(const QSharedPointer<ResultStore> &store)
+{
+    beginResetModel();
+    source = store;
+    rows = source ? source->rowCount() : 0;
+    lastError.clear();
+    endResetModel();
+}
+
+void ResultStoreModel::refresh()
+{
+    if (!source) return;
+    int available = source->rowCount();
+    if (available <= rows) return;
+    beginInsertRows(QModelIndex(), rows, available - 1);
+    rows = available;
+    endInsertRows();
+}
+
+int ResultStoreModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : rows;
+}
+
+int ResultStoreModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() || !source ? 0 : source->headers().size();
+}
+
+QVariant ResultStoreModel::data(const QModelIndex &index, int role) const
+{
+    if (!source || !index.isValid() || (role != Qt::DisplayRole && role != Qt::ToolTipRole)) {
+        return QVariant();
+    }
+    // The store keeps the chunk decoded, so the other cells of the row
+    // painted next are cache hits.
+    QString error;
+    QStringList cells = source->row(index.row(), &error);
+    if (!error.isEmpty() && error != lastError) {
+        lastError = error;
+        emit const_cast<ResultStoreModel *>(this)->readFailed(error);
+    }
+    return cells.value(index.column());
+}
+
+QVariant ResultStoreModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role != Qt::DisplayRole) return QVariant();
+    if (orientation == Qt::Vertical) return section + 1;
+    return source ? QVariant(source->headers().value(section)) : QVariant();
+}
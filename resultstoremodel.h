@@ -0,0 +1,35 @@
+#ifndef RESULTSTOREMODEL_H
+#define RESULTSTOREMODEL_H
+
+#include <QAbstractTableModel>
+#include <QSharedPointer>
+#include "resultstore.h"
+
+// Read-only view model over a spooled result. Rows are read from the store
+// only when the view paints them; refresh() picks up rows appended since.
+class ResultStoreModel : public QAbstractTableModel {
+    Q_OBJECT
+
+public:
+    explicit ResultStoreModel(QObject *parent = nullptr);
+
+    void setStore(const QSharedPointer<ResultStore> &store);
+    QSharedPointer<ResultStore> store() const { return source; }
+    void refresh();
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+signals:
+    // Once per distinct error, not per cell painted.
+    void readFailed(const QString &error);
+
+private:
+    QSharedPointer<ResultStore> source;
+    int rows;
+    mutable QString lastError;
+};
+
+#endif // RESULTSTOREMODEL_H
@@ -0,0 +1,105 @@
+#include "sampledialog.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QFormLayout>
+#include <QPushButton>
+#include <QLabel>
+
+SampleDialog::SampleDialog(QWidget *parent, const QString &tableName, bool postgres)
+    : QDialog(parent), settings("DBManager", "Settings")
+{
+    setWindowTitle(tr("Sample %1").arg(tableName));
+    setMinimumWidth(350);
+
+    auto layout = new QVBoxLayout(this);
+    auto formLayout = new QFormLayout;
+
+    methodComboBox = new QComboBox(this);
+    if (postgres) {
+        methodComboBox->addItem(tr("SYSTEM (blocks, constant time)"), TableSampler::System);
+        methodComboBox->addItem(tr("BERNOULLI (rows, reads whole table)"), TableSampler::Bernoulli);
+    } else {
+        methodComboBox->addItem(tr("Random primary key ranges"), TableSampler::System);
+        methodComboBox->setEnabled(false);
+    }
+    formLayout->addRow(tr("Method:"), methodComboBox);
+
+    percentRadio = new QRadioButton(tr("Percentage:"), this);
+    percentSpinBox = new QDoubleSpinBox(this);
+    percentSpinBox->setRange(0.0001, 100.0);
+    percentSpinBox->setDecimals(4);
+    percentSpinBox->setSuffix("%");
+    formLayout->addRow(percentRadio, percentSpinBox);
+
+    rowsRadio = new QRadioButton(tr("Row target:"), this);
+    rowsSpinBox = new QSpinBox(this);
+    rowsSpinBox->setRange(1, 10000000);
+    rowsSpinBox->setSingleStep(1000);
+    formLayout->addRow(rowsRadio, rowsSpinBox);
+
+    repeatableCheckBox = new QCheckBox(tr("Repeatable, seed:"), this);
+    seedSpinBox = new QSpinBox(this);
+    seedSpinBox->setRange(0, 2147483647);
+    formLayout->addRow(repeatableCheckBox, seedSpinBox);
+
+    layout->addLayout(formLayout);
+
+    auto buttonLayout = new QHBoxLayout;
+    auto sampleButton = new QPushButton(tr("Sample"), this);
+    auto cancelButton = new QPushButton(tr("Cancel"), this);
+    sampleButton->setDefault(true);
+    buttonLayout->addStretch();
+    buttonLayout->addWidget(sampleButton);
+    buttonLayout->addWidget(cancelButton);
+    layout->addLayout(buttonLayout);
+
+    methodComboBox->setCurrentIndex(qMax(0, methodComboBox->findData(settings.value("sample/method", 0).toInt())));
+    percentSpinBox->setValue(settings.value("sample/percent", 1.0).toDouble());
+    rowsSpinBox->setValue(settings.value("sample/rows", 1000).toInt());
+    if (settings.value("sample/byRows", true).toBool()) {
+        rowsRadio->setChecked(true);
+    } else {
+        percentRadio->setChecked(true);
+    }
+    repeatableCheckBox->setChecked(settings.value("sample/repeatable", false).toBool());
+    seedSpinBox->setValue(settings.value("sample/seed", 42).toInt());
+
+    connect(percentRadio, &QRadioButton::toggled, this, &SampleDialog::updateUI);
+    connect(repeatableCheckBox, &QCheckBox::toggled, this, &SampleDialog::updateUI);
+    connect(sampleButton, &QPushButton::clicked, this, &SampleDialog::saveAndAccept);
+    connect(cancelButton, &QPushButton::clicked, this, &QDialog::reject);
+
+    updateUI();
+}
+
+SampleDialog::~SampleDialog() {}
+
+void SampleDialog::updateUI()
+{
+    percentSpinBox->setEnabled(percentRadio->isChecked());
+    rowsSpinBox->setEnabled(rowsRadio->isChecked());
+    seedSpinBox->setEnabled(repeatableCheckBox->isChecked());
+}
+
+void SampleDialog::saveAndAccept()
+{
+    settings.setValue("sample/method", methodComboBox->currentData().toInt());
+    settings.setValue("sample/percent", percentSpinBox->value());
+    settings.setValue("sample/rows", rowsSpinBox->value());
+    settings.setValue("sample/byRows", rowsRadio->isChecked());
+    settings.setValue("sample/repeatable", repeatableCheckBox->isChecked());
+    settings.setValue("sample/seed", seedSpinBox->value());
+    accept();
+}
+
+TableSampler::Options SampleDialog::getOptions() const
+{
+    TableSampler::Options options;
+    options.method = static_cast<TableSampler::Method>(methodComboBox->currentData().toInt());
+    options.byRows = rowsRadio->isChecked();
+    options.percent = percentSpinBox->value();
+    options.rows = rowsSpinBox->value();
+    options.repeatable = repeatableCheckBox->isChecked();
+    options.seed = static_cast<quint32>(seedSpinBox->value());
+    return options;
+}
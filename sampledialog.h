@@ -0,0 +1,37 @@
+#ifndef SAMPLEDIALOG_H
+#define SAMPLEDIALOG_H
+
+#include <QDialog>
+#include <QComboBox>
+#include <QDoubleSpinBox>
+#include <QSpinBox>
+#include <QRadioButton>
+#include <QCheckBox>
+#include <QSettings>
+#include "tablesampler.h"
+
+class SampleDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    SampleDialog(QWidget *parent, const QString &tableName, bool postgres);
+    ~SampleDialog();
+
+    TableSampler::Options getOptions() const;
+
+private slots:
+    void updateUI();
+    void saveAndAccept();
+
+private:
+    QComboBox *methodComboBox;
+    QRadioButton *percentRadio;
+    QRadioButton *rowsRadio;
+    QDoubleSpinBox *percentSpinBox;
+    QSpinBox *rowsSpinBox;
+    QCheckBox *repeatableCheckBox;
+    QSpinBox *seedSpinBox;
+    QSettings settings;
+};
+
+#endif // SAMPLEDIALOG_H
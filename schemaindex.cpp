@@ -0,0 +1,399 @@
+#include "schemaindex.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QSet>
+#include <QObject>
+#include <QRegularExpression>
+#include <algorithm>
+
+namespace {
+
+// Fuzzy matching never scans more than this many names per lookup.
+const int MaxFuzzyScan = 20000;
+
+const QStringList &sqlKeywords() {
+    static const QStringList words = {
+        "SELECT", "FROM", "WHERE", "JOIN", "LEFT", "RIGHT", "INNER", "OUTER", "FULL", "CROSS",
+        "ON", "USING", "GROUP", "BY", "ORDER", "HAVING", "LIMIT", "OFFSET", "INSERT", "INTO",
+        "VALUES", "UPDATE", "SET", "DELETE", "CREATE", "TABLE", "INDEX", "VIEW", "ALTER", "DROP",
+        "ADD", "COLUMN", "PRIMARY", "KEY", "FOREIGN", "REFERENCES", "UNIQUE", "NOT", "NULL",
+        "DEFAULT", "AND", "OR", "IN", "IS", "LIKE", "BETWEEN", "EXISTS", "CASE", "WHEN", "THEN",
+        "ELSE", "END", "AS", "DISTINCT", "UNION", "ALL", "ASC", "DESC", "WITH", "EXPLAIN",
+        "ANALYZE", "TRUNCATE", "BEGIN", "COMMIT", "ROLLBACK", "TRUE", "FALSE"
+    };
+    return words;
+}
+
+const QStringList &sqlFunctions(bool postgres) {
+    static const QStringList common = {
+        "COUNT", "SUM", "AVG", "MIN", "MAX", "COALESCE", "NULLIF", "CAST", "ROUND", "ABS",
+        "LOWER", "UPPER", "LENGTH", "SUBSTRING", "TRIM", "CONCAT", "NOW", "CURRENT_DATE",
+        "CURRENT_TIMESTAMP", "EXTRACT", "GREATEST", "LEAST", "REPLACE"
+    };
+    static const QStringList postgresOnly = common + QStringList{
+        "DATE_TRUNC", "TO_CHAR", "TO_DATE", "STRING_AGG", "ARRAY_AGG", "JSON_AGG",
+        "JSONB_BUILD_OBJECT", "GENERATE_SERIES", "UNNEST", "REGEXP_REPLACE", "AGE"
+    };
+    static const QStringList mysqlOnly = common + QStringList{
+        "GROUP_CONCAT", "IFNULL", "IF", "DATE_FORMAT", "STR_TO_DATE", "DATE_ADD", "DATE_SUB",
+        "DATEDIFF", "JSON_EXTRACT", "JSON_OBJECT", "UNIX_TIMESTAMP", "FROM_UNIXTIME"
+    };
+    return postgres ? postgresOnly : mysqlOnly;
+}
+
+// Keywords after which a table name is expected.
+const QSet<QString> &tableKeywords() {
+    static const QSet<QString> words = {"FROM", "JOIN", "UPDATE", "INTO", "TABLE"};
+    return words;
+}
+
+// Keywords that end a table reference, so they are never taken as an alias.
+const QSet<QString> &clauseKeywords() {
+    static const QSet<QString> words = {
+        "WHERE", "JOIN", "LEFT", "RIGHT", "INNER", "OUTER", "FULL", "CROSS", "ON", "USING",
+        "GROUP", "ORDER", "HAVING", "LIMIT", "OFFSET", "SET", "VALUES", "UNION", "NATURAL",
+        "SELECT", "WINDOW", "RETURNING", "FOR"
+    };
+    return words;
+}
+
+bool isWordChar(QChar ch) {
+    return ch.isLetterOrNumber() || ch == '_' || ch == '$';
+}
+
+struct Token {
+    enum Type { Word, Quoted, Punct };
+    Type type;
+    QString text;
+};
+
+// Enough of a lexer to find identifiers: skips string literals and comments,
+// unquotes "identifiers" and `identifiers`.
+QVector<Token> tokenize(const QString &sql) {
+    QVector<Token> tokens;
+    const int length = sql.size();
+    int i = 0;
+    while (i < length) {
+        QChar ch = sql.at(i);
+        if (ch.isSpace()) {
+            ++i;
+        } else if (ch == '-' && i + 1 < length && sql.at(i + 1) == '-') {
+            while (i < length && sql.at(i) != '\n') ++i;
+        } else if (ch == '/' && i + 1 < length && sql.at(i + 1) == '*') {
+            int end = sql.indexOf("*/", i + 2);
+            i = end < 0 ? length : end + 2;
+        } else if (ch == '\'') {
+            ++i;
+            while (i < length && sql.at(i) != '\'') ++i;
+            ++i;
+        } else if (ch == '"' || ch == '`') {
+            int end = sql.indexOf(ch, i + 1);
+            if (end < 0) end = length;
+            tokens << Token{Token::Quoted, sql.mid(i + 1, end - i - 1)};
+            i = end + 1;
+        } else if (isWordChar(ch)) {
+            int start = i;
+            while (i < length && isWordChar(sql.at(i))) ++i;
+            tokens << Token{Token::Word, sql.mid(start, i - start)};
+        } else {
+            tokens << Token{Token::Punct, QString(ch)};
+            ++i;
+        }
+    }
+    return tokens;
+}
+
+bool isIdentifier(const Token &token) {
+    return token.type == Token::Quoted ||
+           (token.type == Token::Word && !clauseKeywords().contains(token.text.toUpper()));
+}
+
+bool lessLower(const SchemaIndex::Entry &entry, const QString &value) {
+    return entry.lower < value;
+}
+
+} // namespace
+
+SchemaIndex::SchemaIndex() : totalColumns(0) {
+    clear();
+}
+
+void SchemaIndex::clear() {
+    keywords.clear();
+    tables.clear();
+    functions.clear();
+    allColumns.clear();
+    tableColumns.clear();
+    totalColumns = 0;
+    for (const QString &word : sqlKeywords()) {
+        addEntry(keywords, word, Keyword);
+    }
+    finish();
+}
+
+bool SchemaIndex::isEmpty() const {
+    return tables.isEmpty();
+}
+
+int SchemaIndex::tableCount() const {
+    return tables.size();
+}
+
+int SchemaIndex::columnCount() const {
+    return totalColumns;
+}
+
+void SchemaIndex::addEntry(QVector<Entry> &entries, const QString &text, Kind kind) {
+    entries << Entry{text.toLower(), text, kind};
+}
+
+void SchemaIndex::finish() {
+    auto byLower = [](const Entry &a, const Entry &b) { return a.lower < b.lower; };
+    std::sort(keywords.begin(), keywords.end(), byLower);
+    std::sort(tables.begin(), tables.end(), byLower);
+    std::sort(functions.begin(), functions.end(), byLower);
+    std::sort(allColumns.begin(), allColumns.end(), byLower);
+    for (auto it = tableColumns.begin(); it != tableColumns.end(); ++it) {
+        std::sort(it->begin(), it->end(), byLower);
+    }
+}
+
+bool SchemaIndex::load(DatabaseConnection &connection, QString *error) {
+    clear();
+    if (!connection.isConnected()) {
+        *error = QObject::tr("Not connected");
+        return false;
+    }
+    bool postgres = connection.database().driverName() == "QPSQL";
+
+    QSqlQuery query(connection.database());
+    query.setForwardOnly(true);
+    bool ok;
+    if (postgres) {
+        // pg_attribute is much cheaper than information_schema.columns on big catalogs.
+        ok = query.exec("SELECT n.nspname, c.relname, a.attname "
+                        "FROM pg_attribute a "
+                        "JOIN pg_class c ON c.oid = a.attrelid "
+                        "JOIN pg_namespace n ON n.oid = c.relnamespace "
+                        "WHERE c.relkind IN ('r', 'v', 'm', 'p', 'f') AND a.attnum > 0 "
+                        "AND NOT a.attisdropped "
+                        "AND n.nspname NOT IN ('pg_catalog', 'information_schema') "
+                        "AND n.nspname NOT LIKE 'pg_toast%' "
+                        "ORDER BY n.nspname, c.relname, a.attnum");
+    } else {
+        ok = query.exec("SELECT '', TABLE_NAME, COLUMN_NAME FROM information_schema.COLUMNS "
+                        "WHERE TABLE_SCHEMA = DATABASE() ORDER BY TABLE_NAME, ORDINAL_POSITION");
+    }
+    if (!ok) {
+        *error = query.lastError().text();
+        return false;
+    }
+
+    QVector<QPair<QString, QString>> catalog;
+    while (query.next()) {
+        QString schema = query.value(0).toString();
+        QString table = schema.isEmpty() || schema == "public" ? query.value(1).toString()
+                                                              : schema + "." + query.value(1).toString();
+        catalog << qMakePair(table, query.value(2).toString());
+    }
+
+    QStringList functionNames = sqlFunctions(postgres);
+    QString routines = postgres
+        ? "SELECT DISTINCT p.proname FROM pg_proc p JOIN pg_namespace n ON n.oid = p.pronamespace "
+          "WHERE n.nspname NOT IN ('pg_catalog', 'information_schema')"
+        : "SELECT ROUTINE_NAME FROM information_schema.ROUTINES WHERE ROUTINE_SCHEMA = DATABASE()";
+    if (query.exec(routines)) {
+        while (query.next()) {
+            functionNames << query.value(0).toString();
+        }
+    }
+
+    load(catalog, functionNames);
+    return true;
+}
+
+void SchemaIndex::load(const QVector<QPair<QString, QString>> &catalog, const QStringList &functionNames) {
+    clear();
+    QSet<QString> columnNames;
+    QString currentTable;
+    QVector<Entry> columns;
+    for (const QPair<QString, QString> &row : catalog) {
+        const QString &table = row.first;
+        if (table != currentTable) {
+            if (!currentTable.isEmpty()) {
+                tableColumns.insert(currentTable.toLower(), columns);
+                columns.clear();
+            }
+            currentTable = table;
+            addEntry(tables, table, Table);
+        }
+        const QString &column = row.second;
+        addEntry(columns, column, Column);
+        ++totalColumns;
+        if (!columnNames.contains(column)) {
+            columnNames.insert(column);
+            addEntry(allColumns, column, Column);
+        }
+    }
+    if (!currentTable.isEmpty()) {
+        tableColumns.insert(currentTable.toLower(), columns);
+    }
+
+    for (const QString &function : functionNames) {
+        addEntry(functions, function, Function);
+    }
+    finish();
+}
+
+bool SchemaIndex::isSchemaChange(const QString &query) {
+    static const QStringList ddl = {"CREATE", "ALTER", "DROP", "RENAME"};
+    QString firstWord = query.trimmed().section(QRegularExpression("\\s+"), 0, 0).toUpper();
+    return ddl.contains(firstWord);
+}
+
+SchemaIndex::Scope SchemaIndex::statementScope(const QString &statement) const {
+    Scope scope;
+    QVector<Token> tokens = tokenize(statement);
+    for (int i = 0; i < tokens.size(); ++i) {
+        if (tokens.at(i).type != Token::Word) continue;
+        QString keyword = tokens.at(i).text.toUpper();
+        if (keyword != "FROM" && keyword != "JOIN" && keyword != "UPDATE" && keyword != "INTO") continue;
+
+        // table [AS] alias [, table [AS] alias ...]
+        int pos = i + 1;
+        while (pos < tokens.size() && isIdentifier(tokens.at(pos))) {
+            QStringList parts{tokens.at(pos).text};
+            ++pos;
+            while (pos + 1 < tokens.size() && tokens.at(pos).text == "." && isIdentifier(tokens.at(pos + 1))) {
+                parts << tokens.at(pos + 1).text;
+                pos += 2;
+            }
+            if (parts.size() > 1 && parts.first().toLower() == "public") {
+                parts.removeFirst();
+            }
+            QString table = parts.join(".");
+            QString key = table.toLower();
+            if (!tableColumns.contains(key)) {
+                // Skip subqueries and names not in the index, but keep going.
+                key.clear();
+            }
+            if (!key.isEmpty()) {
+                scope.tables << key;
+                scope.aliases.insert(key, key);
+                scope.aliases.insert(parts.last().toLower(), key);
+            }
+            if (pos < tokens.size() && tokens.at(pos).type == Token::Word && tokens.at(pos).text.toUpper() == "AS") {
+                ++pos;
+            }
+            if (pos < tokens.size() && isIdentifier(tokens.at(pos)) &&
+                !tableKeywords().contains(tokens.at(pos).text.toUpper())) {
+                if (!key.isEmpty()) scope.aliases.insert(tokens.at(pos).text.toLower(), key);
+                ++pos;
+            }
+            if (keyword != "FROM" || pos >= tokens.size() || tokens.at(pos).text != ",") break;
+            ++pos;
+        }
+        i = pos - 1;
+    }
+    return scope;
+}
+
+void SchemaIndex::prefixMatches(const QVector<Entry> &entries, const QString &prefix, int limit,
+                                QStringList *items, QHash<QString, bool> *seen) {
+    auto it = std::lower_bound(entries.constBegin(), entries.constEnd(), prefix, lessLower);
+    for (; it != entries.constEnd() && items->size() < limit && it->lower.startsWith(prefix); ++it) {
+        if (seen->contains(it->text)) continue;
+        seen->insert(it->text, true);
+        *items << it->text;
+    }
+}
+
+void SchemaIndex::fuzzyMatches(const QVector<Entry> &entries, const QString &pattern, int limit,
+                               QStringList *items, QHash<QString, bool> *seen) {
+    if (pattern.size() < 2) return;
+    // Only names with the same first letter; users rarely misremember that.
+    auto it = std::lower_bound(entries.constBegin(), entries.constEnd(), pattern.left(1), lessLower);
+    int scanned = 0;
+    for (; it != entries.constEnd() && items->size() < limit && scanned < MaxFuzzyScan; ++it, ++scanned) {
+        if (it->lower.isEmpty() || it->lower.at(0) != pattern.at(0)) break;
+        int matched = 0;
+        for (int i = 0; i < it->lower.size() && matched < pattern.size(); ++i) {
+            if (it->lower.at(i) == pattern.at(matched)) ++matched;
+        }
+        if (matched < pattern.size() || seen->contains(it->text)) continue;
+        seen->insert(it->text, true);
+        *items << it->text;
+    }
+}
+
+SchemaIndex::Completion SchemaIndex::complete(const QString &statement, int cursor, int limit) const {
+    Completion completion;
+    cursor = qBound(0, cursor, statement.size());
+
+    int start = cursor;
+    while (start > 0 && isWordChar(statement.at(start - 1))) --start;
+    completion.prefix = statement.mid(start, cursor - start);
+    QString prefix = completion.prefix.toLower();
+
+    QHash<QString, bool> seen;
+    QStringList &items = completion.items;
+
+    // alias.column or schema.table
+    if (start > 0 && statement.at(start - 1) == '.') {
+        int qualifierEnd = start - 1;
+        int qualifierStart = qualifierEnd;
+        while (qualifierStart > 0 && (isWordChar(statement.at(qualifierStart - 1)) ||
+                                      statement.at(qualifierStart - 1) == '"' ||
+                                      statement.at(qualifierStart - 1) == '`')) {
+            --qualifierStart;
+        }
+        QString qualifier = statement.mid(qualifierStart, qualifierEnd - qualifierStart).remove('"').remove('`').toLower();
+        Scope scope = statementScope(statement);
+        QString table = scope.aliases.value(qualifier, tableColumns.contains(qualifier) ? qualifier : QString());
+        if (!table.isEmpty()) {
+            const QVector<Entry> columns = tableColumns.value(table);
+            prefixMatches(columns, prefix, limit, &items, &seen);
+            fuzzyMatches(columns, prefix, limit, &items, &seen);
+            return completion;
+        }
+        QStringList qualified;
+        prefixMatches(tables, qualifier + "." + prefix, limit, &qualified, &seen);
+        for (const QString &name : qualified) {
+            items << name.mid(qualifier.size() + 1);
+        }
+        return completion;
+    }
+
+    // Right after FROM/JOIN/... (or a comma in a FROM list) only tables fit.
+    QVector<Token> before = tokenize(statement.left(start));
+    bool expectTable = false;
+    for (int i = before.size() - 1; i >= 0; --i) {
+        const Token &token = before.at(i);
+        if (token.type == Token::Word && tableKeywords().contains(token.text.toUpper())) {
+            expectTable = i == before.size() - 1 || before.constLast().text == ",";
+            break;
+        }
+        if (token.type == Token::Word && clauseKeywords().contains(token.text.toUpper())) break;
+    }
+    if (expectTable) {
+        prefixMatches(tables, prefix, limit, &items, &seen);
+        fuzzyMatches(tables, prefix, limit, &items, &seen);
+        return completion;
+    }
+
+    Scope scope = statementScope(statement);
+    for (const QString &table : scope.tables) {
+        prefixMatches(tableColumns.value(table), prefix, limit, &items, &seen);
+    }
+    prefixMatches(functions, prefix, limit, &items, &seen);
+    prefixMatches(keywords, prefix, limit, &items, &seen);
+    prefixMatches(tables, prefix, limit, &items, &seen);
+    if (scope.tables.isEmpty()) {
+        prefixMatches(allColumns, prefix, limit, &items, &seen);
+    }
+    for (const QString &table : scope.tables) {
+        fuzzyMatches(tableColumns.value(table), prefix, limit, &items, &seen);
+    }
+    fuzzyMatches(tables, prefix, limit, &items, &seen);
+    return completion;
+}
@@ -0,0 +1,76 @@
+#ifndef SCHEMAINDEX_H
+#define SCHEMAINDEX_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include <QPair>
+#include "databaseconnection.h"
+
+// In-memory completion index over the current database's tables, columns
+// and functions plus the SQL keywords. Names are kept in arrays sorted by
+// their lower-case form, so a prefix lookup is a binary search followed by
+// a short scan; fuzzy (subsequence) matches only scan names sharing the
+// first letter.
+class SchemaIndex {
+public:
+    enum Kind {
+        Keyword,
+        Table,
+        Column,
+        Function
+    };
+
+    struct Entry {
+        QString lower;
+        QString text;
+        Kind kind;
+    };
+
+    struct Completion {
+        QString prefix;      // text the completion replaces
+        QStringList items;
+    };
+
+    SchemaIndex();
+
+    bool load(DatabaseConnection &connection, QString *error);
+    // The same from catalog rows already read: (table, column) pairs
+    // grouped by table, in column order, plus the functions to offer.
+    void load(const QVector<QPair<QString, QString>> &catalog, const QStringList &functionNames);
+    void clear();
+    bool isEmpty() const;
+    int tableCount() const;
+    int columnCount() const;
+
+    // Completions for the cursor position inside one statement: columns of
+    // the tables it references (resolving aliases), tables after FROM/JOIN,
+    // otherwise everything.
+    Completion complete(const QString &statement, int cursor, int limit = 50) const;
+
+    static bool isSchemaChange(const QString &query);
+
+private:
+    struct Scope {
+        QHash<QString, QString> aliases;  // lower-case alias or table -> table key
+        QStringList tables;               // table keys, in statement order
+    };
+
+    void addEntry(QVector<Entry> &entries, const QString &text, Kind kind);
+    void finish();
+    Scope statementScope(const QString &statement) const;
+    static void prefixMatches(const QVector<Entry> &entries, const QString &prefix, int limit,
+                              QStringList *items, QHash<QString, bool> *seen);
+    static void fuzzyMatches(const QVector<Entry> &entries, const QString &pattern, int limit,
+                             QStringList *items, QHash<QString, bool> *seen);
+
+    QVector<Entry> keywords;
+    QVector<Entry> tables;
+    QVector<Entry> functions;
+    QVector<Entry> allColumns;                  // distinct column names
+    QHash<QString, QVector<Entry>> tableColumns;  // lower-case table key -> columns
+    int totalColumns;
+};
+
+#endif // SCHEMAINDEX_H
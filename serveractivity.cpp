@@ -0,0 +1,217 @@
+#include "serveractivity.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QHash>
+#include <QElapsedTimer>
+#include <QObject>
+
+namespace {
+
+// Statement texts are cut server-side; thousands of sessions with long
+// queries would otherwise dominate every poll.
+const int MaxQueryChars = 1024;
+
+void countBlocking(QVector<ServerActivity::Session> *sessions) {
+    QHash<QString, int> rowById;
+    for (int i = 0; i < sessions->size(); ++i) {
+        rowById.insert(sessions->at(i).id, i);
+    }
+    for (const ServerActivity::Session &session : *sessions) {
+        for (const QString &blocker : session.blockedBy) {
+            int row = rowById.value(blocker, -1);
+            if (row >= 0) {
+                (*sessions)[row].blocking++;
+            }
+        }
+    }
+}
+
+} // namespace
+
+bool ServerActivity::Session::operator==(const Session &other) const {
+    return id == other.id && runningMs == other.runningMs && state == other.state && wait == other.wait &&
+           blocking == other.blocking && blockedBy == other.blockedBy && query == other.query &&
+           user == other.user && database == other.database && client == other.client;
+}
+
+ServerActivity::ServerActivity(const DatabaseConnection::ConnectionParams &params)
+    : params(params), mysqlLockSource(0) {
+}
+
+bool ServerActivity::ensureConnected(QString *error) {
+    if (connection.isConnected()) {
+        return true;
+    }
+    if (!connection.connect(params)) {
+        *error = connection.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+void ServerActivity::close() {
+    connection.disconnect();
+}
+
+ServerActivity::Snapshot ServerActivity::poll(bool includeIdle) {
+    Snapshot snapshot;
+    QElapsedTimer timer;
+    timer.start();
+    if (!ensureConnected(&snapshot.error)) {
+        return snapshot;
+    }
+    bool postgres = connection.database().driverName() == "QPSQL";
+    snapshot.ok = postgres ? pollPostgres(includeIdle, &snapshot) : pollMysql(includeIdle, &snapshot);
+    if (!snapshot.ok) {
+        // Reconnect on the next poll if the connection was lost.
+        connection.disconnect();
+        return snapshot;
+    }
+    countBlocking(&snapshot.sessions);
+    snapshot.elapsedMs = timer.elapsed();
+    return snapshot;
+}
+
+bool ServerActivity::pollPostgres(bool includeIdle, Snapshot *snapshot) {
+    // pg_blocking_pids() takes the lock manager's locks, so it only runs for
+    // sessions that actually wait on a lock.
+    QString sql = QString(
+        "SELECT pid, COALESCE(usename, ''), COALESCE(datname, ''), COALESCE(client_addr::text, ''), "
+        "COALESCE(state, ''), COALESCE(wait_event_type || ': ' || wait_event, ''), left(query, %1), "
+        "(EXTRACT(EPOCH FROM clock_timestamp() - "
+        "CASE WHEN state = 'active' THEN query_start ELSE state_change END) * 1000)::bigint, "
+        "CASE WHEN wait_event_type = 'Lock' THEN pg_blocking_pids(pid)::text END "
+        "FROM pg_stat_activity WHERE pid <> pg_backend_pid()%2")
+        .arg(MaxQueryChars)
+        .arg(includeIdle ? QString() : QString(" AND state <> 'idle'"));
+    QSqlQuery query(connection.database());
+    query.setForwardOnly(true);
+    if (!query.exec(sql)) {
+        snapshot->error = query.lastError().text();
+        return false;
+    }
+    while (query.next()) {
+        Session session;
+        session.id = query.value(0).toString();
+        session.user = query.value(1).toString();
+        session.database = query.value(2).toString();
+        session.client = query.value(3).toString();
+        session.state = query.value(4).toString();
+        session.wait = query.value(5).toString();
+        session.query = query.value(6).toString();
+        session.runningMs = query.value(7).isNull() ? -1 : query.value(7).toLongLong();
+        QString blockers = query.value(8).toString();
+        if (blockers.size() > 2) {
+            // int[] as text: {123,456}
+            session.blockedBy = blockers.mid(1, blockers.size() - 2).split(',');
+        }
+        snapshot->sessions << session;
+    }
+    return true;
+}
+
+bool ServerActivity::pollMysql(bool includeIdle, Snapshot *snapshot) {
+    QString sql = QString(
+        "SELECT ID, COALESCE(USER, ''), COALESCE(DB, ''), COALESCE(HOST, ''), COMMAND, "
+        "COALESCE(STATE, ''), LEFT(COALESCE(INFO, ''), %1), TIME "
+        "FROM information_schema.PROCESSLIST WHERE ID <> CONNECTION_ID()%2")
+        .arg(MaxQueryChars)
+        .arg(includeIdle ? QString() : QString(" AND COMMAND <> 'Sleep'"));
+    QSqlQuery query(connection.database());
+    query.setForwardOnly(true);
+    if (!query.exec(sql)) {
+        snapshot->error = query.lastError().text();
+        return false;
+    }
+    while (query.next()) {
+        Session session;
+        session.id = query.value(0).toString();
+        session.user = query.value(1).toString();
+        session.database = query.value(2).toString();
+        session.client = query.value(3).toString();
+        session.state = query.value(4).toString();
+        session.wait = query.value(5).toString();
+        session.query = query.value(6).toString();
+        session.runningMs = query.value(7).isNull() ? -1 : query.value(7).toLongLong() * 1000;
+        snapshot->sessions << session;
+    }
+    readMysqlLockWaits(&snapshot->sessions);
+    return true;
+}
+
+void ServerActivity::readMysqlLockWaits(QVector<Session> *sessions) {
+    // MySQL 8 reports InnoDB lock waits in performance_schema; 5.7 and
+    // MariaDB in information_schema. The first source that works is kept.
+    static const QString sources[] = {
+        "SELECT rt.PROCESSLIST_ID, bt.PROCESSLIST_ID FROM performance_schema.data_lock_waits w "
+        "JOIN performance_schema.threads rt ON rt.THREAD_ID = w.REQUESTING_THREAD_ID "
+        "JOIN performance_schema.threads bt ON bt.THREAD_ID = w.BLOCKING_THREAD_ID",
+        "SELECT r.trx_mysql_thread_id, b.trx_mysql_thread_id FROM information_schema.INNODB_LOCK_WAITS w "
+        "JOIN information_schema.INNODB_TRX r ON r.trx_id = w.requesting_trx_id "
+        "JOIN information_schema.INNODB_TRX b ON b.trx_id = w.blocking_trx_id"
+    };
+    if (mysqlLockSource < 0) {
+        return;
+    }
+    QSqlQuery query(connection.database());
+    query.setForwardOnly(true);
+    bool ok = false;
+    for (int source = qMax(1, mysqlLockSource); source <= 2; ++source) {
+        if (query.exec(sources[source - 1])) {
+            mysqlLockSource = source;
+            ok = true;
+            break;
+        }
+        if (mysqlLockSource > 0) {
+            break;
+        }
+    }
+    if (!ok) {
+        if (mysqlLockSource == 0) mysqlLockSource = -1;
+        return;
+    }
+
+    QHash<QString, int> rowById;
+    for (int i = 0; i < sessions->size(); ++i) {
+        rowById.insert(sessions->at(i).id, i);
+    }
+    while (query.next()) {
+        int row = rowById.value(query.value(0).toString(), -1);
+        QString blocker = query.value(1).toString();
+        if (row >= 0 && !(*sessions)[row].blockedBy.contains(blocker)) {
+            (*sessions)[row].blockedBy << blocker;
+        }
+    }
+}
+
+bool ServerActivity::cancel(const QString &id, bool terminate, QString *error) {
+    if (!ensureConnected(error)) {
+        return false;
+    }
+    bool numeric = false;
+    qlonglong pid = id.toLongLong(&numeric);
+    if (!numeric) {
+        *error = QObject::tr("Invalid session id %1").arg(id);
+        return false;
+    }
+
+    QSqlQuery query(connection.database());
+    if (connection.database().driverName() == "QPSQL") {
+        query.prepare(terminate ? "SELECT pg_terminate_backend(?)" : "SELECT pg_cancel_backend(?)");
+        query.addBindValue(pid);
+        if (!query.exec() || !query.next()) {
+            *error = query.lastError().text();
+            return false;
+        }
+        if (!query.value(0).toBool()) {
+            *error = QObject::tr("Session %1 was not signalled (already gone, or not permitted)").arg(id);
+            return false;
+        }
+        return true;
+    }
+    if (!query.exec(QString(terminate ? "KILL %1" : "KILL QUERY %1").arg(pid))) {
+        *error = query.lastError().text();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,57 @@
+#ifndef SERVERACTIVITY_H
+#define SERVERACTIVITY_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "databaseconnection.h"
+
+// Sessions of one server from pg_stat_activity or the MySQL process list,
+// with lock waits. Owns its own connection, which is opened lazily by the
+// first poll(); every call must come from the same thread.
+class ServerActivity {
+public:
+    struct Session {
+        Session() : runningMs(-1), blocking(0) {}
+        QString id;
+        QString user;
+        QString database;
+        QString client;
+        QString state;
+        QString wait;
+        QString query;
+        qint64 runningMs;       // current statement (or state) age; -1 if unknown
+        QStringList blockedBy;  // sessions holding the locks this one waits for
+        int blocking;           // sessions waiting for this one
+
+        bool operator==(const Session &other) const;
+        bool operator!=(const Session &other) const { return !(*this == other); }
+    };
+
+    struct Snapshot {
+        Snapshot() : ok(false), elapsedMs(0) {}
+        bool ok;
+        QString error;
+        QVector<Session> sessions;
+        qint64 elapsedMs;
+    };
+
+    explicit ServerActivity(const DatabaseConnection::ConnectionParams &params);
+
+    Snapshot poll(bool includeIdle);
+    // Cancels the running statement, or ends the whole session.
+    bool cancel(const QString &id, bool terminate, QString *error);
+    void close();
+
+private:
+    bool ensureConnected(QString *error);
+    bool pollPostgres(bool includeIdle, Snapshot *snapshot);
+    bool pollMysql(bool includeIdle, Snapshot *snapshot);
+    void readMysqlLockWaits(QVector<Session> *sessions);
+
+    DatabaseConnection::ConnectionParams params;
+    DatabaseConnection connection;
+    int mysqlLockSource;   // 0 untried, 1 performance_schema, 2 information_schema, -1 none
+};
+
+#endif // SERVERACTIVITY_H
@@ -21,9 +21,11 @@ ServersDialog::ServersDialog(QWidget *parent, const QString &serverName)
         dbNameEdit->setText(params.dbName);
         userEdit->setText(params.user);
         passwordEdit->setText(params.password);
+        setLimits(params);
         
         setWindowTitle(tr("Edit Server"));
     } else {
+        setLimits(DatabaseConnection::defaultLimits());
         setWindowTitle(tr("Add Server"));
     }
 }
@@ -63,6 +65,9 @@ void ServersDialog::setupUI() {
     formLayout->addRow(tr("Password:"), passwordEdit);
     
     mainLayout->addLayout(formLayout);
+
+    limitsGroup = new LimitsGroup(tr("Execution Limits"), tr("Read-only session"), this);
+    mainLayout->addWidget(limitsGroup);
     
     statusLabel = new QLabel(this);
     mainLayout->addWidget(statusLabel);
@@ -88,6 +93,10 @@ void ServersDialog::setupUI() {
     setMinimumWidth(400);
 }
 
+void ServersDialog::setLimits(const DatabaseConnection::ConnectionParams &params) {
+    limitsGroup->setLimits(params);
+}
+
 void ServersDialog::updateUI() {
     if (driverComboBox->currentText().contains("MYSQL", Qt::CaseInsensitive)) {
         if (portSpinBox->value() == 5432) {
@@ -151,6 +160,7 @@ DatabaseConnection::ConnectionParams ServersDialog::getConnectionParams() const
     params.dbName = dbNameEdit->text();
     params.user = userEdit->text();
     params.password = passwordEdit->text();
+    limitsGroup->applyTo(&params);
     return params;
 }
 
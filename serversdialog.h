@@ -8,6 +8,7 @@
 #include <QPushButton>
 #include <QLabel>
 #include "databaseconnection.h"
+#include "limitsgroup.h"
 
 class ServersDialog : public QDialog {
     Q_OBJECT
@@ -26,6 +27,7 @@ private slots:
 
 private:
     void setupUI();
+    void setLimits(const DatabaseConnection::ConnectionParams &params);
     bool validateInputs();
 
     QLineEdit *serverNameEdit;
@@ -35,6 +37,7 @@ private:
     QLineEdit *dbNameEdit;
     QLineEdit *userEdit;
     QLineEdit *passwordEdit;
+    LimitsGroup *limitsGroup;
     QPushButton *testButton;
     QPushButton *saveButton;
     QPushButton *cancelButton;
@@ -0,0 +1,137 @@
+#include "sessionstore.h"
+#include <QStandardPaths>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QObject>
+
+namespace {
+
+const quint32 Magic = 0x44424d53;   // "DBMS"
+const quint32 Version = 1;
+
+void writeTab(QDataStream &out, const SessionStore::Tab &tab) {
+    out << tab.serverName << tab.database << tab.editorText << tab.history
+        << tab.resultQuery << tab.resultTable
+        << tab.result.headers << qint32(tab.result.totalRows) << qint32(tab.result.rows.size());
+    for (const QStringList &row : tab.result.rows) {
+        out << row;
+    }
+}
+
+void readTab(QDataStream &in, SessionStore::Tab *tab) {
+    qint32 totalRows = 0;
+    qint32 rows = 0;
+    in >> tab->serverName >> tab->database >> tab->editorText >> tab->history
+       >> tab->resultQuery >> tab->resultTable
+       >> tab->result.headers >> totalRows >> rows;
+    tab->result.totalRows = totalRows;
+    for (qint32 row = 0; row < rows && in.status() == QDataStream::Ok; ++row) {
+        QStringList cells;
+        in >> cells;
+        tab->result.rows << cells;
+    }
+}
+
+} // namespace
+
+QString SessionStore::sessionPath() {
+    return QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)).filePath("session.dat");
+}
+
+bool SessionStore::save(const Session &session, QString *error) {
+    QByteArray payload;
+    {
+        QDataStream out(&payload, QIODevice::WriteOnly);
+        out.setVersion(QDataStream::Qt_5_12);
+        out << session.saved << qint32(session.currentTab) << session.selectedPath;
+        out << qint32(session.servers.size());
+        for (const Server &server : session.servers) {
+            out << server.name << server.expanded << qint32(server.databases.size());
+            for (const Database &database : server.databases) {
+                out << database.name << database.expanded << database.tables;
+            }
+        }
+        out << qint32(session.tabs.size());
+        for (const Tab &tab : session.tabs) {
+            writeTab(out, tab);
+        }
+    }
+
+    QString path = sessionPath();
+    if (!QDir().mkpath(QFileInfo(path).path())) {
+        *error = QObject::tr("Cannot create %1").arg(QFileInfo(path).path());
+        return false;
+    }
+    // Written aside and renamed, so a crash while saving keeps the old session.
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        *error = file.errorString();
+        return false;
+    }
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_12);
+    out << Magic << Version << qCompress(payload, 1);
+    if (out.status() != QDataStream::Ok || !file.commit()) {
+        *error = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool SessionStore::load(Session *session, QString *error) {
+    QFile file(sessionPath());
+    if (!file.exists()) {
+        return false;
+    }
+    if (!file.open(QIODevice::ReadOnly)) {
+        *error = file.errorString();
+        return false;
+    }
+    QDataStream header(&file);
+    header.setVersion(QDataStream::Qt_5_12);
+    quint32 magic = 0;
+    quint32 version = 0;
+    QByteArray compressed;
+    header >> magic >> version;
+    if (magic != Magic || version != Version) {
+        *error = QObject::tr("The saved session has an unknown format");
+        return false;
+    }
+    header >> compressed;
+    QByteArray payload = qUncompress(compressed);
+
+    *session = Session();
+    QDataStream in(payload);
+    in.setVersion(QDataStream::Qt_5_12);
+    qint32 currentTab = 0;
+    qint32 servers = 0;
+    in >> session->saved >> currentTab >> session->selectedPath >> servers;
+    session->currentTab = currentTab;
+    for (qint32 i = 0; i < servers && in.status() == QDataStream::Ok; ++i) {
+        Server server;
+        qint32 databases = 0;
+        in >> server.name >> server.expanded >> databases;
+        for (qint32 j = 0; j < databases && in.status() == QDataStream::Ok; ++j) {
+            Database database;
+            in >> database.name >> database.expanded >> database.tables;
+            server.databases << database;
+        }
+        session->servers << server;
+    }
+    qint32 tabs = 0;
+    in >> tabs;
+    for (qint32 i = 0; i < tabs && in.status() == QDataStream::Ok; ++i) {
+        Tab tab;
+        readTab(in, &tab);
+        session->tabs << tab;
+    }
+    if (payload.isEmpty() || in.status() != QDataStream::Ok) {
+        *error = QObject::tr("The saved session is damaged");
+        *session = Session();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,69 @@
+#ifndef SESSIONSTORE_H
+#define SESSIONSTORE_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QDateTime>
+
+// The window's working state between runs: the open tabs with their editor
+// text, history and a snapshot of the last result, and the servers tree as
+// far as it was expanded. It is written on exit and read on startup before
+// anything connects, so the window comes back at once; restored results
+// and tree items are stale until they are refreshed in the background.
+class SessionStore {
+public:
+    // A result snapshot keeps the first rows only, within both caps.
+    static const int MaxSnapshotRows = 1000;
+    static const qint64 MaxSnapshotBytes = 4 * 1024 * 1024;
+
+    struct ResultSnapshot {
+        ResultSnapshot() : totalRows(0) {}
+        QStringList headers;
+        QVector<QStringList> rows;
+        int totalRows;             // rows the grid had
+        bool isEmpty() const { return headers.isEmpty(); }
+    };
+
+    struct Tab {
+        QString serverName;        // empty for an unbound tab
+        QString database;
+        QString editorText;
+        QStringList history;
+        // What produced the result: a query, or a table opened from the
+        // tree; neither for samples and other results that are not re-run.
+        QString resultQuery;
+        QString resultTable;
+        ResultSnapshot result;
+    };
+
+    struct Database {
+        Database() : expanded(false) {}
+        QString name;
+        bool expanded;
+        QStringList tables;        // empty until the database was opened
+    };
+
+    struct Server {
+        Server() : expanded(false) {}
+        QString name;
+        bool expanded;
+        QVector<Database> databases;
+    };
+
+    struct Session {
+        Session() : currentTab(0) {}
+        QVector<Tab> tabs;
+        int currentTab;
+        QVector<Server> servers;   // only servers that were connected
+        QStringList selectedPath;  // server, database, table, as far as selected
+        QDateTime saved;
+    };
+
+    static QString sessionPath();
+    static bool save(const Session &session, QString *error);
+    // False without an error when there is no saved session.
+    static bool load(Session *session, QString *error);
+};
+
+#endif // SESSIONSTORE_H
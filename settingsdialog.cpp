@@ -1,5 +1,11 @@
 #include "settingsdialog.h"
 #include "databaseconnection.h"
+#include "resultmemory.h"
+#include "tracer.h"
+#include "limitsgroup.h"
+#include <QGroupBox>
+#include <QFormLayout>
+#include <QDir>
 
 SettingsDialog::SettingsDialog(QWidget *parent)
     : QDialog(parent), settings("DBManager", "Settings")
@@ -22,6 +28,45 @@ SettingsDialog::SettingsDialog(QWidget *parent)
     }
     layout->addWidget(driverComboBox);
 
+    limitsGroup = new LimitsGroup(tr("Default Execution Limits"), tr("Read-only sessions"), this);
+    layout->addWidget(limitsGroup);
+
+    auto memoryGroup = new QGroupBox(tr("Result Memory"), this);
+    auto memoryLayout = new QFormLayout(memoryGroup);
+
+    memoryBudgetSpinBox = new QSpinBox(memoryGroup);
+    memoryBudgetSpinBox->setRange(0, 1024 * 1024);
+    memoryBudgetSpinBox->setSingleStep(256);
+    memoryBudgetSpinBox->setSuffix(tr(" MB"));
+    memoryBudgetSpinBox->setSpecialValueText(tr("No limit"));
+    memoryBudgetSpinBox->setToolTip(tr("Memory for the results of all tabs together"));
+
+    spillCheckBox = new QCheckBox(tr("Spill larger results to disk on Fetch all"), memoryGroup);
+    spillDirectoryEdit = new QLineEdit(memoryGroup);
+    spillDirectoryEdit->setPlaceholderText(QDir::tempPath());
+
+    memoryLayout->addRow(tr("Memory budget:"), memoryBudgetSpinBox);
+    memoryLayout->addRow(spillCheckBox);
+    memoryLayout->addRow(tr("Spill directory:"), spillDirectoryEdit);
+    layout->addWidget(memoryGroup);
+
+    auto traceGroup = new QGroupBox(tr("Tracing"), this);
+    auto traceLayout = new QFormLayout(traceGroup);
+
+    traceCheckBox = new QCheckBox(tr("Record trace spans and counters"), traceGroup);
+    traceCheckBox->setToolTip(tr("Export the spans with Tools > Export Trace..."));
+    metricsFileEdit = new QLineEdit(traceGroup);
+    metricsFileEdit->setPlaceholderText(tr("None"));
+    metricsFileEdit->setToolTip(tr("A Prometheus textfile, e.g. for node_exporter's textfile collector"));
+    metricsIntervalSpinBox = new QSpinBox(traceGroup);
+    metricsIntervalSpinBox->setRange(1, 3600);
+    metricsIntervalSpinBox->setSuffix(tr(" s"));
+
+    traceLayout->addRow(traceCheckBox);
+    traceLayout->addRow(tr("Metrics file:"), metricsFileEdit);
+    traceLayout->addRow(tr("Update every:"), metricsIntervalSpinBox);
+    layout->addWidget(traceGroup);
+
     auto buttonLayout = new QHBoxLayout;
     saveButton = new QPushButton(tr("Save"), this);
     cancelButton = new QPushButton(tr("Cancel"), this);
@@ -44,6 +89,18 @@ QString SettingsDialog::getDefaultDriver() const {
 
 void SettingsDialog::saveSettings() {
     settings.setValue("defaultDriver", driverComboBox->currentText());
+    DatabaseConnection::ConnectionParams limits;
+    limitsGroup->applyTo(&limits);
+    settings.setValue("defaultStatementTimeout", limits.statementTimeout);
+    settings.setValue("defaultMaxRows", limits.maxRows);
+    settings.setValue("defaultMaxResultMemoryMb", limits.maxResultMemoryMb);
+    settings.setValue("defaultReadOnly", limits.readOnly);
+    settings.setValue("resultMemoryBudgetMb", memoryBudgetSpinBox->value());
+    settings.setValue("resultSpillEnabled", spillCheckBox->isChecked());
+    settings.setValue("resultSpillDirectory", spillDirectoryEdit->text().trimmed());
+    settings.setValue("traceEnabled", traceCheckBox->isChecked());
+    settings.setValue("traceMetricsFile", metricsFileEdit->text().trimmed());
+    settings.setValue("traceMetricsIntervalSec", metricsIntervalSpinBox->value());
     accept();
 }
 
@@ -53,4 +110,16 @@ void SettingsDialog::loadSettings() {
     if (index != -1) {
         driverComboBox->setCurrentIndex(index);
     }
+
+    limitsGroup->setLimits(DatabaseConnection::defaultLimits());
+
+    ResultMemory::Settings memory = ResultMemory::settings();
+    memoryBudgetSpinBox->setValue(static_cast<int>(memory.budgetBytes / (1024 * 1024)));
+    spillCheckBox->setChecked(memory.spill);
+    spillDirectoryEdit->setText(memory.directory);
+
+    Tracer::Settings trace = Tracer::settings();
+    traceCheckBox->setChecked(trace.enabled);
+    metricsFileEdit->setText(trace.metricsFile);
+    metricsIntervalSpinBox->setValue(trace.metricsIntervalSec);
 }
@@ -7,6 +7,11 @@
 #include <QSettings>
 #include <QVBoxLayout>
 #include <QLabel>
+#include <QSpinBox>
+#include <QCheckBox>
+#include <QLineEdit>
+
+class LimitsGroup;
 
 class SettingsDialog : public QDialog {
     Q_OBJECT
@@ -23,6 +28,13 @@ private slots:
 
 private:
     QComboBox *driverComboBox;
+    LimitsGroup *limitsGroup;
+    QSpinBox *memoryBudgetSpinBox;
+    QCheckBox *spillCheckBox;
+    QLineEdit *spillDirectoryEdit;
+    QCheckBox *traceCheckBox;
+    QLineEdit *metricsFileEdit;
+    QSpinBox *metricsIntervalSpinBox;
     QPushButton *saveButton;
     QPushButton *cancelButton;
     QSettings settings;
@@ -0,0 +1,218 @@
+#include "sketches.h"
+#include <QtAlgorithms>
+#include <QMetaType>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+// splitmix64 finalizer: spreads nearby inputs over all 64 bits.
+quint64 mix(quint64 x) {
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+quint64 bytesHash(const char *data, qsizetype size) {
+    quint64 hash = 0xCBF29CE484222325ULL;
+    for (qsizetype i = 0; i < size; ++i) {
+        hash ^= static_cast<uchar>(data[i]);
+        hash *= 0x100000001B3ULL;
+    }
+    return mix(hash);
+}
+
+quint64 textHash(const QString &text) {
+    return bytesHash(reinterpret_cast<const char *>(text.constData()), text.size() * qsizetype(sizeof(QChar)));
+}
+
+} // namespace
+
+HyperLogLog::HyperLogLog(int precision)
+    : precision(qBound(4, precision, 18)), registers(1 << this->precision, '\0') {
+}
+
+void HyperLogLog::add(quint64 hash) {
+    int index = static_cast<int>(hash >> (64 - precision));
+    quint64 rest = hash << precision;
+    char rank = static_cast<char>(rest == 0 ? 64 - precision + 1 : qCountLeadingZeroBits(rest) + 1);
+    char *slot = registers.data() + index;
+    if (rank > *slot) {
+        *slot = rank;
+    }
+}
+
+double HyperLogLog::estimate() const {
+    const int m = registers.size();
+    double sum = 0;
+    int zeros = 0;
+    for (char rank : registers) {
+        sum += std::ldexp(1.0, -rank);
+        if (rank == 0) ++zeros;
+    }
+    double raw = 0.7213 / (1.0 + 1.079 / m) * m * m / sum;
+    // Small cardinalities: linear counting over the empty registers is
+    // more accurate than the harmonic mean.
+    if (raw <= 2.5 * m && zeros > 0) {
+        return m * std::log(static_cast<double>(m) / zeros);
+    }
+    return raw;
+}
+
+quint64 HyperLogLog::hash(const QVariant &value) {
+    switch (value.userType()) {
+    case QMetaType::Bool:
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::Long:
+    case QMetaType::ULong:
+    case QMetaType::LongLong:
+    case QMetaType::ULongLong:
+    case QMetaType::Short:
+    case QMetaType::UShort:
+        return mix(static_cast<quint64>(value.toLongLong()));
+    case QMetaType::Double:
+    case QMetaType::Float: {
+        double number = value.toDouble();
+        if (std::floor(number) == number && std::fabs(number) < 9.2e18) {
+            return mix(static_cast<quint64>(static_cast<qint64>(number)));
+        }
+        quint64 bits;
+        std::memcpy(&bits, &number, sizeof(bits));
+        return mix(bits ^ 0x5555555555555555ULL);
+    }
+    case QMetaType::QByteArray: {
+        QByteArray bytes = value.toByteArray();
+        return bytesHash(bytes.constData(), bytes.size());
+    }
+    default:
+        return textHash(value.toString());
+    }
+}
+
+QuantileSketch::QuantileSketch(int k)
+    : k(qMax(8, k)), n(0), coin(0x9E3779B97F4A7C15ULL), levels(1) {
+}
+
+int QuantileSketch::capacity(int level) const {
+    // Lower levels get geometrically smaller compactors.
+    int depth = levels.size() - 1 - level;
+    return qMax(2, static_cast<int>(std::ceil(k * std::pow(2.0 / 3.0, depth))));
+}
+
+void QuantileSketch::add(double value) {
+    if (std::isnan(value)) return;
+    levels[0].append(value);
+    ++n;
+    if (levels[0].size() >= capacity(0)) {
+        compress();
+    }
+}
+
+void QuantileSketch::compress() {
+    for (int level = 0; level < levels.size(); ++level) {
+        if (levels[level].size() < capacity(level)) continue;
+        if (level + 1 == levels.size()) {
+            levels.append(QVector<double>());
+        }
+        QVector<double> &items = levels[level];
+        QVector<double> &upper = levels[level + 1];
+        std::sort(items.begin(), items.end());
+        // A random offset keeps the promoted half unbiased.
+        coin = coin * 6364136223846793005ULL + 1442695040888963407ULL;
+        int offset = static_cast<int>(coin >> 63);
+        bool odd = items.size() % 2 != 0;
+        double kept = odd ? items.last() : 0;
+        int paired = items.size() - (odd ? 1 : 0);
+        for (int i = offset; i < paired; i += 2) {
+            upper.append(items.at(i));
+        }
+        items.clear();
+        if (odd) {
+            items.append(kept);
+        }
+    }
+}
+
+qint64 QuantileSketch::count() const {
+    return n;
+}
+
+double QuantileSketch::quantile(double rank) const {
+    QVector<QPair<double, qint64>> weighted;
+    for (int level = 0; level < levels.size(); ++level) {
+        for (double value : levels.at(level)) {
+            weighted.append(qMakePair(value, qint64(1) << level));
+        }
+    }
+    if (weighted.isEmpty()) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    std::sort(weighted.begin(), weighted.end(),
+              [](const QPair<double, qint64> &a, const QPair<double, qint64> &b) { return a.first < b.first; });
+    double target = qBound(0.0, rank, 1.0) * n;
+    qint64 cumulative = 0;
+    for (const auto &item : weighted) {
+        cumulative += item.second;
+        if (cumulative >= target) {
+            return item.first;
+        }
+    }
+    return weighted.last().first;
+}
+
+double QuantileSketch::countAtMost(double value) const {
+    double total = 0;
+    for (int level = 0; level < levels.size(); ++level) {
+        qint64 weight = qint64(1) << level;
+        for (double item : levels.at(level)) {
+            if (item <= value) total += weight;
+        }
+    }
+    return total;
+}
+
+TopValues::TopValues(int capacity)
+    : capacity(qMax(1, capacity)) {
+}
+
+void TopValues::add(const QString &value) {
+    QString key = value.size() > MaxValueLength ? value.left(MaxValueLength) : value;
+    auto found = entries.find(key);
+    if (found != entries.end()) {
+        ++found->count;
+        return;
+    }
+    Entry entry;
+    entry.value = key;
+    entry.count = 1;
+    if (entries.size() >= capacity) {
+        auto smallest = entries.begin();
+        for (auto candidate = entries.begin(); candidate != entries.end(); ++candidate) {
+            if (candidate->count < smallest->count) smallest = candidate;
+        }
+        entry.count = smallest->count + 1;
+        entry.error = smallest->count;
+        entries.erase(smallest);
+    }
+    entries.insert(key, entry);
+}
+
+QVector<TopValues::Entry> TopValues::top(int limit) const {
+    QVector<Entry> sorted;
+    sorted.reserve(entries.size());
+    for (const Entry &entry : entries) {
+        sorted.append(entry);
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const Entry &a, const Entry &b) {
+        return a.count != b.count ? a.count > b.count : a.value < b.value;
+    });
+    if (sorted.size() > limit) {
+        sorted.resize(limit);
+    }
+    return sorted;
+}
@@ -0,0 +1,80 @@
+#ifndef SKETCHES_H
+#define SKETCHES_H
+
+#include <QByteArray>
+#include <QVector>
+#include <QHash>
+#include <QString>
+#include <QVariant>
+
+// Fixed-size summaries of a value stream for the table profiler. Each one
+// keeps a bounded amount of memory however many values it is fed.
+
+// Approximate distinct count. 2^precision one-byte registers; the standard
+// error is 1.04 / sqrt(2^precision), about 0.8% at the default of 14.
+class HyperLogLog {
+public:
+    explicit HyperLogLog(int precision = 14);
+
+    void add(quint64 hash);
+    double estimate() const;
+
+    // 64-bit hash where equal values hash alike across drivers: integral
+    // numbers by value (5 and 5.0 match), everything else by its bytes.
+    static quint64 hash(const QVariant &value);
+
+private:
+    int precision;
+    QByteArray registers;
+};
+
+// Approximate quantiles (KLL). Values are kept in levels of compactors; a
+// full level is sorted and every other value moves up with twice the weight.
+// Rank error is about 1.7 / k; memory stays near 3 * k values.
+class QuantileSketch {
+public:
+    explicit QuantileSketch(int k = 200);
+
+    void add(double value);
+    qint64 count() const;
+    // Value at `rank` in [0, 1]; NaN when empty.
+    double quantile(double rank) const;
+    // Approximate number of values <= value.
+    double countAtMost(double value) const;
+
+private:
+    int capacity(int level) const;
+    void compress();
+
+    int k;
+    qint64 n;
+    quint64 coin;
+    QVector<QVector<double>> levels;
+};
+
+// Heavy hitters (Space-Saving). Tracks `capacity` candidates; a new value
+// replaces the least frequent one and inherits its count as the error bound,
+// so any value more frequent than count / capacity is guaranteed a slot.
+class TopValues {
+public:
+    struct Entry {
+        Entry() : count(0), error(0) {}
+        QString value;
+        qint64 count;
+        qint64 error;   // count may overstate the true frequency by this much
+    };
+
+    explicit TopValues(int capacity = 64);
+
+    // Values longer than MaxValueLength are counted by their prefix.
+    void add(const QString &value);
+    QVector<Entry> top(int limit) const;
+
+    static const int MaxValueLength = 200;
+
+private:
+    int capacity;
+    QHash<QString, Entry> entries;
+};
+
+#endif // SKETCHES_H
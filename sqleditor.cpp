@@ -0,0 +1,435 @@
+#include "sqleditor.h"
+#include <QKeyEvent>
+#include <QPainter>
+#include <QTextBlock>
+#include <QAbstractItemView>
+#include <QScrollBar>
+#include <QTextCursor>
+#include <QFontDatabase>
+#include <QTimer>
+#include <climits>
+
+namespace {
+
+// Below this many typed characters the popup only opens on Ctrl+Space or
+// after a qualifier dot.
+const int MinimumPrefix = 2;
+// Completion looks at most this many lines around the cursor for the
+// statement boundaries, so typing stays cheap in huge scripts.
+const int CompletionScanBlocks = 200;
+// Bracket matching gives up after this many lines.
+const int BracketScanBlocks = 5000;
+// Characters inserted per event-loop turn while opening a file.
+const qint64 LoadChunkChars = 1024 * 1024;
+
+bool isWordChar(QChar ch) {
+    return ch.isLetterOrNumber() || ch == '_' || ch == '$';
+}
+
+int blockStartState(const QTextBlock &block) {
+    QTextBlock previous = block.previous();
+    return previous.isValid() ? previous.userState() : -1;
+}
+
+class LineNumberArea : public QWidget {
+public:
+    explicit LineNumberArea(SqlEditor *editor) : QWidget(editor), editor(editor) {}
+
+    QSize sizeHint() const override {
+        return QSize(editor->lineNumberAreaWidth(), 0);
+    }
+
+protected:
+    void paintEvent(QPaintEvent *event) override {
+        editor->paintLineNumbers(event);
+    }
+
+private:
+    SqlEditor *editor;
+};
+
+} // namespace
+
+SqlEditor::SqlEditor(QWidget *parent)
+    : QPlainTextEdit(parent), schemaIndex(nullptr)
+{
+    setLineWrapMode(QPlainTextEdit::NoWrap);
+    setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+
+    bool darkPalette = palette().color(QPalette::Base).lightness() < 128;
+    highlighter = new SqlHighlighter(document(), darkPalette);
+    lineNumberArea = new LineNumberArea(this);
+
+    completionModel = new QStringListModel(this);
+    completer = new QCompleter(this);
+    completer->setModel(completionModel);
+    completer->setWidget(this);
+    completer->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+    completer->setCaseSensitivity(Qt::CaseInsensitive);
+    completer->setMaxVisibleItems(12);
+
+    connect(completer, QOverload<const QString &>::of(&QCompleter::activated),
+            this, &SqlEditor::insertCompletion);
+    connect(this, &QPlainTextEdit::blockCountChanged, this, &SqlEditor::updateLineNumberAreaWidth);
+    connect(this, &QPlainTextEdit::updateRequest, this, &SqlEditor::updateLineNumberArea);
+    connect(this, &QPlainTextEdit::cursorPositionChanged, this, &SqlEditor::updateExtraSelections);
+
+    updateLineNumberAreaWidth();
+    updateExtraSelections();
+}
+
+SqlEditor::~SqlEditor() {}
+
+void SqlEditor::setSchemaIndex(const SchemaIndex *index)
+{
+    schemaIndex = index;
+}
+
+void SqlEditor::setDialect(SqlHighlighter::Dialect dialect)
+{
+    highlighter->setDialect(dialect);
+}
+
+int SqlEditor::lineNumberAreaWidth() const
+{
+    int digits = 1;
+    int lines = qMax(1, blockCount());
+    while (lines >= 10) {
+        lines /= 10;
+        ++digits;
+    }
+    return 8 + fontMetrics().horizontalAdvance(QLatin1Char('9')) * digits;
+}
+
+void SqlEditor::updateLineNumberAreaWidth()
+{
+    setViewportMargins(lineNumberAreaWidth(), 0, 0, 0);
+}
+
+void SqlEditor::updateLineNumberArea(const QRect &rect, int dy)
+{
+    if (dy) {
+        lineNumberArea->scroll(0, dy);
+    } else {
+        lineNumberArea->update(0, rect.y(), lineNumberArea->width(), rect.height());
+    }
+    if (rect.contains(viewport()->rect())) {
+        updateLineNumberAreaWidth();
+    }
+}
+
+void SqlEditor::resizeEvent(QResizeEvent *event)
+{
+    QPlainTextEdit::resizeEvent(event);
+    QRect area = contentsRect();
+    lineNumberArea->setGeometry(QRect(area.left(), area.top(), lineNumberAreaWidth(), area.height()));
+}
+
+void SqlEditor::paintLineNumbers(QPaintEvent *event)
+{
+    QPainter painter(lineNumberArea);
+    painter.fillRect(event->rect(), palette().color(QPalette::Window));
+    painter.setPen(palette().color(QPalette::Disabled, QPalette::Text));
+
+    // Only the visible blocks are painted.
+    QTextBlock block = firstVisibleBlock();
+    int top = qRound(blockBoundingGeometry(block).translated(contentOffset()).top());
+    int bottom = top + qRound(blockBoundingRect(block).height());
+    int width = lineNumberArea->width() - 4;
+    while (block.isValid() && top <= event->rect().bottom()) {
+        if (block.isVisible() && bottom >= event->rect().top()) {
+            painter.drawText(0, top, width, fontMetrics().height(), Qt::AlignRight,
+                             QString::number(block.blockNumber() + 1));
+        }
+        block = block.next();
+        top = bottom;
+        bottom = top + qRound(blockBoundingRect(block).height());
+    }
+}
+
+void SqlEditor::updateExtraSelections()
+{
+    QList<QTextEdit::ExtraSelection> selections;
+    bool darkPalette = palette().color(QPalette::Base).lightness() < 128;
+
+    QTextEdit::ExtraSelection currentLine;
+    currentLine.format.setBackground(darkPalette ? QColor("#2a2d2e") : QColor("#f4f4e8"));
+    currentLine.format.setProperty(QTextFormat::FullWidthSelection, true);
+    currentLine.cursor = textCursor();
+    currentLine.cursor.clearSelection();
+    selections << currentLine;
+
+    int position = textCursor().position();
+    for (int candidate : {position, position - 1}) {
+        if (candidate < 0) continue;
+        int match = matchingBracket(candidate);
+        if (match < 0) continue;
+        for (int bracket : {candidate, match}) {
+            QTextEdit::ExtraSelection selection;
+            selection.format.setBackground(darkPalette ? QColor("#515c6a") : QColor("#b4e4b4"));
+            selection.cursor = QTextCursor(document());
+            selection.cursor.setPosition(bracket);
+            selection.cursor.setPosition(bracket + 1, QTextCursor::KeepAnchor);
+            selections << selection;
+        }
+        break;
+    }
+    setExtraSelections(selections);
+}
+
+int SqlEditor::matchingBracket(int position) const
+{
+    QTextBlock block = document()->findBlock(position);
+    if (!block.isValid()) return -1;
+    int offset = position - block.position();
+    QString text = block.text();
+    if (offset >= text.size()) return -1;
+
+    QChar bracket = text.at(offset);
+    static const QString opening = "([";
+    static const QString closing = ")]";
+    int kind = opening.indexOf(bracket);
+    bool forward = kind >= 0;
+    if (!forward) kind = closing.indexOf(bracket);
+    if (kind < 0) return -1;
+    QChar same = forward ? opening.at(kind) : closing.at(kind);
+    QChar other = forward ? closing.at(kind) : opening.at(kind);
+
+    // Walk bracket tokens only, so brackets inside strings and comments
+    // are ignored.
+    QVector<SqlHighlighter::Token> tokens;
+    SqlHighlighter::tokenize(text, blockStartState(block), highlighter->dialect(), &tokens);
+    bool isToken = false;
+    for (const SqlHighlighter::Token &token : tokens) {
+        if (token.type == SqlHighlighter::Bracket && token.start == offset) isToken = true;
+    }
+    if (!isToken) return -1;
+
+    int depth = 0;
+    for (int scanned = 0; block.isValid() && scanned < BracketScanBlocks; ++scanned) {
+        if (scanned > 0) {
+            text = block.text();
+            SqlHighlighter::tokenize(text, blockStartState(block), highlighter->dialect(), &tokens);
+        }
+        for (int i = forward ? 0 : tokens.size() - 1; forward ? i < tokens.size() : i >= 0; forward ? ++i : --i) {
+            const SqlHighlighter::Token &token = tokens.at(i);
+            if (token.type != SqlHighlighter::Bracket) continue;
+            if (scanned == 0 && (forward ? token.start < offset : token.start > offset)) continue;
+            QChar ch = text.at(token.start);
+            if (ch == same) {
+                ++depth;
+            } else if (ch == other && --depth == 0) {
+                return block.position() + token.start;
+            }
+        }
+        block = forward ? block.next() : block.previous();
+    }
+    return -1;
+}
+
+void SqlEditor::statementBounds(int position, int maxBlocks, int *start, int *end) const
+{
+    QTextBlock cursorBlock = document()->findBlock(position);
+    int offset = position - cursorBlock.position();
+    QVector<SqlHighlighter::Token> tokens;
+
+    // Backwards to the semicolon before the cursor.
+    *start = 0;
+    QTextBlock block = cursorBlock;
+    for (int scanned = 0; block.isValid(); ++scanned) {
+        if (scanned >= maxBlocks) {
+            *start = block.next().position();
+            break;
+        }
+        SqlHighlighter::tokenize(block.text(), blockStartState(block), highlighter->dialect(), &tokens);
+        int found = -1;
+        for (const SqlHighlighter::Token &token : tokens) {
+            if (token.type == SqlHighlighter::Semicolon && (scanned > 0 || token.start < offset)) {
+                found = token.start;
+            }
+        }
+        if (found >= 0) {
+            *start = block.position() + found + 1;
+            break;
+        }
+        block = block.previous();
+    }
+
+    // Forwards to the semicolon at or after the cursor.
+    *end = document()->characterCount() - 1;
+    block = cursorBlock;
+    for (int scanned = 0; block.isValid(); ++scanned) {
+        if (scanned >= maxBlocks) {
+            *end = block.position() - 1;
+            break;
+        }
+        SqlHighlighter::tokenize(block.text(), blockStartState(block), highlighter->dialect(), &tokens);
+        int found = -1;
+        for (const SqlHighlighter::Token &token : tokens) {
+            if (token.type == SqlHighlighter::Semicolon && (scanned > 0 || token.start >= offset)) {
+                found = token.start;
+                break;
+            }
+        }
+        if (found >= 0) {
+            *end = block.position() + found;
+            break;
+        }
+        block = block.next();
+    }
+}
+
+QString SqlEditor::textBetween(int start, int end) const
+{
+    QTextCursor cursor(document());
+    cursor.setPosition(start);
+    cursor.setPosition(qMax(start, end), QTextCursor::KeepAnchor);
+    QString text = cursor.selectedText();
+    text.replace(QChar::ParagraphSeparator, '\n');
+    text.replace(QChar::LineSeparator, '\n');
+    return text;
+}
+
+QString SqlEditor::statementUnderCursor() const
+{
+    int start = 0;
+    int end = 0;
+    statementBounds(textCursor().position(), INT_MAX, &start, &end);
+    QString statement = textBetween(start, end);
+    // Cursor right after "...;" means the statement that just ended.
+    if (statement.trimmed().isEmpty() && start > 0) {
+        statementBounds(start - 1, INT_MAX, &start, &end);
+        statement = textBetween(start, end);
+    }
+    return statement.trimmed();
+}
+
+bool SqlEditor::openFile(const QString &path, QString *error)
+{
+    QScopedPointer<QFile> file(new QFile(path));
+    if (!file->open(QIODevice::ReadOnly | QIODevice::Text)) {
+        *error = file->errorString();
+        return false;
+    }
+    loadingFile.reset(file.take());
+    loadingStream.reset(new QTextStream(loadingFile.data()));
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+    loadingStream->setCodec("UTF-8");
+#endif
+
+    clear();
+    setReadOnly(true);
+    document()->setUndoRedoEnabled(false);
+    QTimer::singleShot(0, this, &SqlEditor::loadNextChunk);
+    return true;
+}
+
+bool SqlEditor::isLoading() const
+{
+    return !loadingStream.isNull();
+}
+
+void SqlEditor::loadNextChunk()
+{
+    if (!loadingStream) return;
+
+    QString chunk = loadingStream->read(LoadChunkChars);
+    if (!chunk.isEmpty()) {
+        QTextCursor cursor(document());
+        cursor.movePosition(QTextCursor::End);
+        cursor.insertText(chunk);
+    }
+    emit loadProgress(loadingFile->pos(), loadingFile->size());
+
+    if (!loadingStream->atEnd()) {
+        QTimer::singleShot(0, this, &SqlEditor::loadNextChunk);
+        return;
+    }
+    loadingStream.reset();
+    loadingFile.reset();
+    document()->setUndoRedoEnabled(true);
+    setReadOnly(false);
+    moveCursor(QTextCursor::Start);
+    emit loadFinished();
+}
+
+void SqlEditor::focusInEvent(QFocusEvent *event)
+{
+    completer->setWidget(this);
+    QPlainTextEdit::focusInEvent(event);
+}
+
+void SqlEditor::keyPressEvent(QKeyEvent *event)
+{
+    if (completer->popup()->isVisible()) {
+        // The completer handles these on its popup.
+        switch (event->key()) {
+        case Qt::Key_Enter:
+        case Qt::Key_Return:
+        case Qt::Key_Escape:
+        case Qt::Key_Tab:
+        case Qt::Key_Backtab:
+            event->ignore();
+            return;
+        default:
+            break;
+        }
+    }
+
+    bool forced = (event->modifiers() & Qt::ControlModifier) && event->key() == Qt::Key_Space;
+    if (!forced) {
+        QPlainTextEdit::keyPressEvent(event);
+    }
+    if (!schemaIndex || isReadOnly()) {
+        return;
+    }
+
+    QString text = event->text();
+    bool typed = !text.isEmpty() && (isWordChar(text.at(0)) || text.at(0) == '.');
+    bool erased = event->key() == Qt::Key_Backspace && completer->popup()->isVisible();
+    if (forced || typed || erased) {
+        updateCompletion(forced);
+    } else {
+        completer->popup()->hide();
+    }
+}
+
+void SqlEditor::updateCompletion(bool forced)
+{
+    int position = textCursor().position();
+    int start = 0;
+    int end = 0;
+    statementBounds(position, CompletionScanBlocks, &start, &end);
+    QString statement = textBetween(start, end);
+    int cursor = position - start;
+    SchemaIndex::Completion completion = schemaIndex->complete(statement, cursor);
+
+    bool afterDot = completion.prefix.isEmpty() && cursor > 0 && statement.at(cursor - 1) == '.';
+    bool exactOnly = completion.items.size() == 1 &&
+                     completion.items.first().compare(completion.prefix, Qt::CaseInsensitive) == 0;
+    if ((!forced && !afterDot && completion.prefix.size() < MinimumPrefix) ||
+        completion.items.isEmpty() || exactOnly) {
+        completer->popup()->hide();
+        return;
+    }
+
+    completionPrefix = completion.prefix;
+    completionModel->setStringList(completion.items);
+    QAbstractItemView *popup = completer->popup();
+    popup->setCurrentIndex(completionModel->index(0, 0));
+
+    QRect rect = cursorRect();
+    rect.setWidth(popup->sizeHintForColumn(0) + popup->verticalScrollBar()->sizeHint().width());
+    completer->complete(rect);
+}
+
+void SqlEditor::insertCompletion(const QString &completion)
+{
+    if (completer->widget() != this) {
+        return;
+    }
+    QTextCursor cursor = textCursor();
+    cursor.movePosition(QTextCursor::Left, QTextCursor::KeepAnchor, completionPrefix.size());
+    cursor.insertText(completion);
+    setTextCursor(cursor);
+}
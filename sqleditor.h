@@ -0,0 +1,72 @@
+#ifndef SQLEDITOR_H
+#define SQLEDITOR_H
+
+#include <QPlainTextEdit>
+#include <QCompleter>
+#include <QStringListModel>
+#include <QTextStream>
+#include <QFile>
+#include <QScopedPointer>
+#include "schemaindex.h"
+#include "sqlhighlighter.h"
+
+// Query editor built for large scripts: QPlainTextEdit without line wrap,
+// incremental highlighting, a line-number gutter, bracket matching and
+// schema-aware completion. Completions are computed by SchemaIndex on every
+// keystroke; the popup only ever holds the current candidates.
+class SqlEditor : public QPlainTextEdit {
+    Q_OBJECT
+
+public:
+    explicit SqlEditor(QWidget *parent = nullptr);
+    ~SqlEditor();
+
+    void setSchemaIndex(const SchemaIndex *index);
+    // How strings are lexed for highlighting and statement boundaries.
+    void setDialect(SqlHighlighter::Dialect dialect);
+
+    // The statement around the cursor, split on semicolons outside strings
+    // and comments.
+    QString statementUnderCursor() const;
+
+    // Loads a file in chunks from the event loop, so the window stays
+    // responsive; emits loadProgress() and then loadFinished().
+    bool openFile(const QString &path, QString *error);
+    bool isLoading() const;
+
+    int lineNumberAreaWidth() const;
+    void paintLineNumbers(QPaintEvent *event);
+
+signals:
+    void loadProgress(qint64 bytesRead, qint64 bytesTotal);
+    void loadFinished();
+
+protected:
+    void keyPressEvent(QKeyEvent *event) override;
+    void focusInEvent(QFocusEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+
+private slots:
+    void insertCompletion(const QString &completion);
+    void updateLineNumberAreaWidth();
+    void updateLineNumberArea(const QRect &rect, int dy);
+    void updateExtraSelections();
+    void loadNextChunk();
+
+private:
+    void updateCompletion(bool forced);
+    void statementBounds(int position, int maxBlocks, int *start, int *end) const;
+    QString textBetween(int start, int end) const;
+    int matchingBracket(int position) const;
+
+    QWidget *lineNumberArea;
+    SqlHighlighter *highlighter;
+    QCompleter *completer;
+    QStringListModel *completionModel;
+    const SchemaIndex *schemaIndex;
+    QString completionPrefix;
+    QScopedPointer<QFile> loadingFile;
+    QScopedPointer<QTextStream> loadingStream;
+};
+
+#endif // SQLEDITOR_H
@@ -0,0 +1,230 @@
+#include "sqlhighlighter.h"
+#include <QSet>
+#include <QHash>
+
+namespace {
+
+const int StateBits = 3;
+const int StateMask = (1 << StateBits) - 1;
+const int MaxKeywordLength = 11;
+
+const QSet<QString> &keywords() {
+    static const QSet<QString> words = {
+        "ADD", "ALL", "ALTER", "AND", "ANY", "AS", "ASC", "BEGIN", "BETWEEN", "BY", "CASCADE",
+        "CASE", "CAST", "CHECK", "COLLATE", "COLUMN", "COMMIT", "CONSTRAINT", "CREATE", "CROSS",
+        "DATABASE", "DECLARE", "DEFAULT", "DELETE", "DESC", "DISTINCT", "DO", "DROP", "ELSE",
+        "END", "ESCAPE", "EXCEPT", "EXISTS", "EXPLAIN", "FALSE", "FETCH", "FOR", "FOREIGN",
+        "FROM", "FULL", "FUNCTION", "GRANT", "GROUP", "HAVING", "IF", "IN", "INDEX", "INNER",
+        "INSERT", "INTERSECT", "INTO", "IS", "JOIN", "KEY", "LANGUAGE", "LATERAL", "LEFT",
+        "LIKE", "ILIKE", "LIMIT", "NATURAL", "NOT", "NULL", "OFFSET", "ON", "OR", "ORDER",
+        "OUTER", "OVER", "PARTITION", "PRIMARY", "PROCEDURE", "REFERENCES", "RENAME", "REPLACE",
+        "RETURNING", "RETURNS", "REVOKE", "RIGHT", "ROLLBACK", "SCHEMA", "SELECT", "SEQUENCE",
+        "SET", "TABLE", "TEMPORARY", "THEN", "TO", "TRANSACTION", "TRIGGER", "TRUE", "TRUNCATE",
+        "UNION", "UNIQUE", "UPDATE", "USING", "VALUES", "VIEW", "WHEN", "WHERE", "WINDOW", "WITH",
+        // types
+        "BIGINT", "BOOLEAN", "CHAR", "DATE", "DECIMAL", "DOUBLE", "FLOAT", "INT", "INTEGER",
+        "JSON", "JSONB", "NUMERIC", "REAL", "SERIAL", "SMALLINT", "TEXT", "TIME", "TIMESTAMP",
+        "UUID", "VARCHAR"
+    };
+    return words;
+}
+
+bool isWordChar(QChar ch) {
+    return ch.isLetterOrNumber() || ch == '_' || ch == '$';
+}
+
+int dollarTagHash(const QString &tag) {
+    return static_cast<int>(qHash(tag) & 0xFFFFF);
+}
+
+// Length of a $tag$ delimiter at `pos`, or 0.
+int dollarQuoteLength(const QString &text, int pos, QString *tag) {
+    int i = pos + 1;
+    if (i < text.size() && text.at(i).isDigit()) return 0;  // $1 parameter
+    while (i < text.size() && (text.at(i).isLetterOrNumber() || text.at(i) == '_')) ++i;
+    if (i >= text.size() || text.at(i) != '$') return 0;
+    *tag = text.mid(pos + 1, i - pos - 1);
+    return i - pos + 1;
+}
+
+} // namespace
+
+SqlHighlighter::SqlHighlighter(QTextDocument *document, bool darkPalette)
+    : QSyntaxHighlighter(document), currentDialect(PostgreSql)
+{
+    keywordFormat.setForeground(QColor(darkPalette ? "#569cd6" : "#0000c0"));
+    keywordFormat.setFontWeight(QFont::Bold);
+    numberFormat.setForeground(QColor(darkPalette ? "#b5cea8" : "#a000a0"));
+    stringFormat.setForeground(QColor(darkPalette ? "#ce9178" : "#008000"));
+    commentFormat.setForeground(QColor(darkPalette ? "#6a9955" : "#808080"));
+    commentFormat.setFontItalic(true);
+    identifierFormat.setForeground(QColor(darkPalette ? "#dcdcaa" : "#806000"));
+}
+
+void SqlHighlighter::setDialect(Dialect dialect)
+{
+    if (dialect == currentDialect) return;
+    currentDialect = dialect;
+    rehighlight();
+}
+
+int SqlHighlighter::tokenize(const QString &text, int state, Dialect dialect, QVector<Token> *tokens) {
+    tokens->clear();
+    if (state < 0) {
+        state = Normal;
+    }
+    const int length = text.size();
+    int tokenStart = 0;
+    int i = 0;
+
+    while (i < length || (state & StateMask) != Normal) {
+        int kind = state & StateMask;
+        if (kind != Normal) {
+            // Find the end of the construct that is open at i.
+            int end = -1;
+            switch (kind) {
+            case InBlockComment: {
+                int close = text.indexOf("*/", i);
+                if (close >= 0) end = close + 2;
+                break;
+            }
+            case InString:
+            case InEscapeString: {
+                bool backslash = kind == InEscapeString || dialect == MySql;
+                for (int j = i; j < length; ++j) {
+                    if (backslash && text.at(j) == '\\') {
+                        ++j;
+                    } else if (text.at(j) == '\'') {
+                        if (j + 1 < length && text.at(j + 1) == '\'') {
+                            ++j;
+                        } else {
+                            end = j + 1;
+                            break;
+                        }
+                    }
+                }
+                break;
+            }
+            case InQuotedIdentifier:
+            case InBacktick: {
+                QChar quote = kind == InBacktick ? QChar('`') : QChar('"');
+                for (int j = i; j < length; ++j) {
+                    if (text.at(j) != quote) continue;
+                    if (j + 1 < length && text.at(j + 1) == quote) {
+                        ++j;
+                    } else {
+                        end = j + 1;
+                        break;
+                    }
+                }
+                break;
+            }
+            case InDollarQuote: {
+                int wanted = state >> StateBits;
+                for (int j = text.indexOf('$', i); j >= 0; j = text.indexOf('$', j + 1)) {
+                    QString tag;
+                    int delimiter = dollarQuoteLength(text, j, &tag);
+                    if (delimiter > 0 && dollarTagHash(tag) == wanted) {
+                        end = j + delimiter;
+                        break;
+                    }
+                }
+                break;
+            }
+            }
+
+            TokenType type = kind == InBlockComment ? Comment
+                           : kind == InQuotedIdentifier || kind == InBacktick ? QuotedIdentifier
+                           : String;
+            if (end < 0) {
+                tokens->append({tokenStart, length - tokenStart, type});
+                return state;
+            }
+            tokens->append({tokenStart, end - tokenStart, type});
+            i = end;
+            state = Normal;
+            continue;
+        }
+
+        QChar ch = text.at(i);
+        QChar next = i + 1 < length ? text.at(i + 1) : QChar();
+        if (ch.isSpace()) {
+            ++i;
+        } else if (ch == '-' && next == '-') {
+            tokens->append({i, length - i, Comment});
+            return Normal;
+        } else if (ch == '/' && next == '*') {
+            tokenStart = i;
+            state = InBlockComment;
+            i += 2;
+        } else if (ch == '\'') {
+            tokenStart = i;
+            state = InString;
+            ++i;
+        } else if (ch == '"') {
+            tokenStart = i;
+            state = InQuotedIdentifier;
+            ++i;
+        } else if (ch == '`') {
+            tokenStart = i;
+            state = InBacktick;
+            ++i;
+        } else if (ch == '$') {
+            QString tag;
+            int delimiter = dollarQuoteLength(text, i, &tag);
+            if (delimiter > 0) {
+                tokenStart = i;
+                state = InDollarQuote | (dollarTagHash(tag) << StateBits);
+                i += delimiter;
+            } else {
+                ++i;
+                while (i < length && isWordChar(text.at(i))) ++i;
+            }
+        } else if (ch.isDigit() || (ch == '.' && next.isDigit())) {
+            int start = i;
+            while (i < length && (text.at(i).isLetterOrNumber() || text.at(i) == '.')) ++i;
+            tokens->append({start, i - start, Number});
+        } else if (isWordChar(ch)) {
+            int start = i;
+            while (i < length && isWordChar(text.at(i))) ++i;
+            if (dialect == PostgreSql && i - start == 1 && text.at(start).toUpper() == 'E'
+                && i < length && text.at(i) == '\'') {
+                tokenStart = start;
+                state = InEscapeString;
+                ++i;
+                continue;
+            }
+            // Keywords are short; long identifiers skip the upper-casing and lookup.
+            if (i - start <= MaxKeywordLength && keywords().contains(text.mid(start, i - start).toUpper())) {
+                tokens->append({start, i - start, Keyword});
+            }
+        } else if (ch == ';') {
+            tokens->append({i, 1, Semicolon});
+            ++i;
+        } else if (ch == '(' || ch == ')' || ch == '[' || ch == ']') {
+            tokens->append({i, 1, Bracket});
+            ++i;
+        } else {
+            ++i;
+        }
+    }
+    return state;
+}
+
+void SqlHighlighter::highlightBlock(const QString &text)
+{
+    int state = tokenize(text, previousBlockState(), currentDialect, &tokens);
+    for (const Token &token : tokens) {
+        switch (token.type) {
+        case Keyword: setFormat(token.start, token.length, keywordFormat); break;
+        case Number: setFormat(token.start, token.length, numberFormat); break;
+        case String: setFormat(token.start, token.length, stringFormat); break;
+        case Comment: setFormat(token.start, token.length, commentFormat); break;
+        case QuotedIdentifier: setFormat(token.start, token.length, identifierFormat); break;
+        case Semicolon:
+        case Bracket:
+            break;
+        }
+    }
+    setCurrentBlockState(state);
+}
@@ -0,0 +1,73 @@
+#ifndef SQLHIGHLIGHTER_H
+#define SQLHIGHLIGHTER_H
+
+#include <QSyntaxHighlighter>
+#include <QTextCharFormat>
+#include <QVector>
+
+// SQL highlighting for SqlEditor. QSyntaxHighlighter re-runs highlightBlock()
+// only for edited blocks and keeps going while a block's end state changes,
+// so the lexer state that crosses lines (open comment, string or dollar
+// quote) is stored as the block state. The same lexer finds statement
+// boundaries for the editor.
+class SqlHighlighter : public QSyntaxHighlighter {
+    Q_OBJECT
+
+public:
+    enum State {
+        Normal = 0,
+        InBlockComment = 1,
+        InString = 2,
+        InQuotedIdentifier = 3,
+        InBacktick = 4,
+        InDollarQuote = 5,    // the tag's hash is kept in the upper bits
+        InEscapeString = 6    // PostgreSQL E'...', where backslash escapes
+    };
+
+    // Backslash escapes in '...' strings are MySQL's; PostgreSQL (with
+    // standard_conforming_strings, its default) takes them literally.
+    enum Dialect {
+        PostgreSql,
+        MySql
+    };
+
+    enum TokenType {
+        Keyword,
+        Number,
+        String,
+        Comment,
+        QuotedIdentifier,
+        Semicolon,
+        Bracket
+    };
+
+    struct Token {
+        int start;
+        int length;
+        TokenType type;
+    };
+
+    SqlHighlighter(QTextDocument *document, bool darkPalette);
+
+    // Re-highlights the document when the dialect changes.
+    void setDialect(Dialect dialect);
+    Dialect dialect() const { return currentDialect; }
+
+    // Lexes one line starting in `state` (a block state; -1 counts as Normal)
+    // and returns the state at its end.
+    static int tokenize(const QString &text, int state, Dialect dialect, QVector<Token> *tokens);
+
+protected:
+    void highlightBlock(const QString &text) override;
+
+private:
+    QTextCharFormat keywordFormat;
+    QTextCharFormat numberFormat;
+    QTextCharFormat stringFormat;
+    QTextCharFormat commentFormat;
+    QTextCharFormat identifierFormat;
+    QVector<Token> tokens;
+    Dialect currentDialect;
+};
+
+#endif // SQLHIGHLIGHTER_H
@@ -0,0 +1,495 @@
+#include "tablecomparer.h"
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QSqlIndex>
+#include <QSqlError>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QHash>
+#include <QThreadPool>
+#include <QElapsedTimer>
+#include <QObject>
+#include <QtConcurrent>
+#include <algorithm>
+#include <climits>
+
+namespace {
+
+// A drill-down splits a differing range into at most this many parts.
+const int SplitFanout = 16;
+// Keys per IN (...) list when fetching the differing rows.
+const int FetchBatch = 500;
+
+// Half-open key range [low, high); an invalid bound is unbounded.
+struct Range {
+    QVariant low;
+    QVariant high;
+};
+
+// Quoted names and hash expressions for one side of the comparison.
+struct TableSql {
+    QString table;
+    QString key;
+    QString columns;
+    QString rowHash;
+    bool postgres;
+};
+
+TableSql tableSql(DatabaseConnection &connection, const QString &table, const QString &key,
+                  const QStringList &columns) {
+    TableSql sql;
+    sql.postgres = connection.database().driverName() == "QPSQL";
+    sql.table = connection.quoteIdentifier(table);
+    sql.key = connection.quoteIdentifier(key);
+    QStringList quoted;
+    QStringList nullFlags;
+    for (const QString &column : columns) {
+        QString name = connection.quoteIdentifier(column);
+        quoted << name;
+        nullFlags << QString("ISNULL(%1)").arg(name);
+    }
+    sql.columns = quoted.join(", ");
+    if (sql.postgres) {
+        sql.rowHash = QString("md5(ROW(%1)::text)").arg(sql.columns);
+    } else {
+        // CONCAT_WS skips NULLs, so the null pattern is hashed as well.
+        sql.rowHash = QString("MD5(CONCAT_WS('|', %1, CONCAT(%2)))").arg(sql.columns, nullFlags.join(", "));
+    }
+    return sql;
+}
+
+QString rangeCondition(const TableSql &sql, const Range &range) {
+    QStringList parts;
+    if (range.low.isValid()) parts << sql.key + " >= ?";
+    if (range.high.isValid()) parts << sql.key + " < ?";
+    return parts.isEmpty() ? QString() : " WHERE " + parts.join(" AND ");
+}
+
+void bindRange(QSqlQuery &query, const Range &range) {
+    if (range.low.isValid()) query.addBindValue(range.low);
+    if (range.high.isValid()) query.addBindValue(range.high);
+}
+
+bool isCanceled(const TableComparer::Progress *progress) {
+    return progress->canceled.loadRelaxed() != 0;
+}
+
+bool keyLess(const QVariant &a, const QVariant &b) {
+    bool numericA = false;
+    bool numericB = false;
+    qlonglong x = a.toLongLong(&numericA);
+    qlonglong y = b.toLongLong(&numericB);
+    if (numericA && numericB) return x < y;
+    return a.toString() < b.toString();
+}
+
+// Row count plus the sum of the first 64 bits of every row hash. The sum is
+// order-independent, so both servers can scan the range however they like.
+bool rangeChecksum(QSqlDatabase &db, const TableSql &sql, const Range &range,
+                   qint64 *count, QString *checksum, QString *error) {
+    QString aggregate = sql.postgres
+        ? QString("COALESCE(SUM(('x' || substr(%1, 1, 16))::bit(64)::bigint), 0)::text").arg(sql.rowHash)
+        : QString("CAST(COALESCE(SUM(CAST(CONV(SUBSTRING(%1, 1, 16), 16, 10) AS UNSIGNED)), 0) AS CHAR)")
+              .arg(sql.rowHash);
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.prepare(QString("SELECT COUNT(*), %1 FROM %2%3").arg(aggregate, sql.table, rangeCondition(sql, range)));
+    bindRange(query, range);
+    if (!query.exec() || !query.next()) {
+        *error = query.lastError().text();
+        return false;
+    }
+    *count = query.value(0).toLongLong();
+    *checksum = query.value(1).toString();
+    return true;
+}
+
+// Walks the key index in steps of `step` rows, returning at most maxParts - 1
+// boundaries that cut the range into parts of `step` rows each.
+bool splitRange(QSqlDatabase &db, const TableSql &sql, const Range &range, int step, int maxParts,
+                const TableComparer::Progress *progress, QVector<QVariant> *bounds, QString *error) {
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    Range rest = range;
+    while (bounds->size() < maxParts - 1 && !isCanceled(progress)) {
+        query.prepare(QString("SELECT %1 FROM %2%3 ORDER BY %1 LIMIT 1 OFFSET %4")
+                          .arg(sql.key, sql.table, rangeCondition(sql, rest)).arg(step));
+        bindRange(query, rest);
+        if (!query.exec()) {
+            *error = query.lastError().text();
+            return false;
+        }
+        if (!query.next()) break;
+        rest.low = query.value(0);
+        bounds->append(rest.low);
+    }
+    return true;
+}
+
+QVector<Range> rangesBetween(const Range &range, const QVector<QVariant> &bounds) {
+    QVector<Range> ranges;
+    ranges.reserve(bounds.size() + 1);
+    Range current;
+    current.low = range.low;
+    for (const QVariant &bound : bounds) {
+        current.high = bound;
+        ranges << current;
+        current.low = bound;
+    }
+    current.high = range.high;
+    ranges << current;
+    return ranges;
+}
+
+struct KeyHash {
+    QVariant key;
+    QString hash;
+};
+
+bool rowHashes(QSqlDatabase &db, const TableSql &sql, const Range &range,
+               QHash<QString, KeyHash> *hashes, QString *error) {
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.prepare(QString("SELECT %1, %2 FROM %3%4").arg(sql.key, sql.rowHash, sql.table, rangeCondition(sql, range)));
+    bindRange(query, range);
+    if (!query.exec()) {
+        *error = query.lastError().text();
+        return false;
+    }
+    while (query.next()) {
+        KeyHash entry;
+        entry.key = query.value(0);
+        entry.hash = query.value(1).toString();
+        hashes->insert(entry.key.toString(), entry);
+    }
+    return true;
+}
+
+bool fetchRows(QSqlDatabase &db, const TableSql &sql, const QVector<QVariant> &keys,
+               QHash<QString, QVariantList> *rows, int keyIndex, QString *error) {
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    for (int start = 0; start < keys.size(); start += FetchBatch) {
+        int count = qMin(FetchBatch, keys.size() - start);
+        QStringList placeholders;
+        for (int i = 0; i < count; ++i) placeholders << "?";
+        query.prepare(QString("SELECT %1 FROM %2 WHERE %3 IN (%4)")
+                          .arg(sql.columns, sql.table, sql.key, placeholders.join(", ")));
+        for (int i = 0; i < count; ++i) {
+            query.addBindValue(keys.at(start + i));
+        }
+        if (!query.exec()) {
+            *error = query.lastError().text();
+            return false;
+        }
+        int columnCount = query.record().count();
+        while (query.next()) {
+            QVariantList row;
+            row.reserve(columnCount);
+            for (int col = 0; col < columnCount; ++col) {
+                row << query.value(col);
+            }
+            rows->insert(row.at(keyIndex).toString(), row);
+        }
+    }
+    return true;
+}
+
+// Ranges waiting to be compared, shared by the workers. A worker that finds a
+// differing range pushes its parts back here.
+class WorkQueue {
+public:
+    WorkQueue(const TableComparer::Options &options, TableComparer::Result *result,
+              TableComparer::Progress *progress)
+        : options(options), result(result), progress(progress), inFlight(0), stopped(false) {}
+
+    const TableComparer::Options &options;
+    TableComparer::Result *result;
+    TableComparer::Progress *progress;
+
+    void add(const QVector<Range> &ranges) {
+        QMutexLocker locker(&mutex);
+        for (const Range &range : ranges) pending.enqueue(range);
+        progress->rangesTotal.fetchAndAddRelaxed(ranges.size());
+    }
+
+    bool take(Range *range) {
+        QMutexLocker locker(&mutex);
+        while (!stopped && pending.isEmpty() && inFlight > 0) {
+            if (isCanceled(progress)) break;
+            wakeup.wait(&mutex, 100);
+        }
+        if (stopped || isCanceled(progress) || pending.isEmpty()) {
+            wakeup.wakeAll();
+            return false;
+        }
+        *range = pending.dequeue();
+        ++inFlight;
+        return true;
+    }
+
+    void finish(const QVector<Range> &parts, const QVector<TableComparer::Difference> &differences,
+                bool differing, qint64 rowsTransferred) {
+        QMutexLocker locker(&mutex);
+        --inFlight;
+        for (const Range &part : parts) pending.enqueue(part);
+        progress->rangesTotal.fetchAndAddRelaxed(parts.size());
+        progress->rangesDone.fetchAndAddRelaxed(1);
+        result->rangesCompared++;
+        if (differing) result->rangesDiffering++;
+        result->rowsTransferred += rowsTransferred;
+        result->differences += differences;
+        if (result->differences.size() >= options.maxDifferences) {
+            result->truncated = true;
+            stopped = true;
+        }
+        wakeup.wakeAll();
+    }
+
+    void fail(const QString &message) {
+        QMutexLocker locker(&mutex);
+        --inFlight;
+        if (result->error.isEmpty()) result->error = message;
+        stopped = true;
+        wakeup.wakeAll();
+    }
+
+    void failToStart(const QString &message) {
+        QMutexLocker locker(&mutex);
+        if (result->error.isEmpty()) result->error = message;
+        stopped = true;
+        wakeup.wakeAll();
+    }
+
+private:
+    QMutex mutex;
+    QWaitCondition wakeup;
+    QQueue<Range> pending;
+    int inFlight;
+    bool stopped;
+};
+
+bool compareRange(QSqlDatabase &sourceDb, QSqlDatabase &targetDb, const TableSql &sourceSql,
+                  const TableSql &targetSql, int keyIndex, const Range &range, const TableComparer::Options &options,
+                  const TableComparer::Progress *progress, QVector<Range> *parts,
+                  QVector<TableComparer::Difference> *differences, bool *differing,
+                  qint64 *rowsTransferred, QString *error) {
+    qint64 sourceCount = 0;
+    qint64 targetCount = 0;
+    QString sourceChecksum;
+    QString targetChecksum;
+    if (!rangeChecksum(sourceDb, sourceSql, range, &sourceCount, &sourceChecksum, error) ||
+        !rangeChecksum(targetDb, targetSql, range, &targetCount, &targetChecksum, error)) {
+        return false;
+    }
+    *differing = sourceCount != targetCount || sourceChecksum != targetChecksum;
+    if (!*differing) return true;
+
+    // Split on whichever side holds more rows of this range.
+    qint64 larger = qMax(sourceCount, targetCount);
+    if (larger > options.leafRows) {
+        int step = static_cast<int>(qMax<qint64>(options.leafRows, (larger + SplitFanout - 1) / SplitFanout));
+        QVector<QVariant> bounds;
+        bool splitSource = sourceCount >= targetCount;
+        if (!splitRange(splitSource ? sourceDb : targetDb, splitSource ? sourceSql : targetSql,
+                        range, step, SplitFanout, progress, &bounds, error)) {
+            return false;
+        }
+        if (!bounds.isEmpty()) {
+            *parts = rangesBetween(range, bounds);
+            return true;
+        }
+    }
+
+    QHash<QString, KeyHash> sourceHashes;
+    QHash<QString, KeyHash> targetHashes;
+    if (!rowHashes(sourceDb, sourceSql, range, &sourceHashes, error) ||
+        !rowHashes(targetDb, targetSql, range, &targetHashes, error)) {
+        return false;
+    }
+    *rowsTransferred += sourceHashes.size() + targetHashes.size();
+
+    QVector<QVariant> sourceKeys;
+    QVector<QVariant> targetKeys;
+    QVector<TableComparer::Difference> found;
+    for (auto it = sourceHashes.constBegin(); it != sourceHashes.constEnd(); ++it) {
+        auto match = targetHashes.constFind(it.key());
+        if (match != targetHashes.constEnd() && match->hash == it->hash) continue;
+        TableComparer::Difference difference;
+        difference.key = it->key;
+        difference.kind = match == targetHashes.constEnd() ? TableComparer::MissingInTarget
+                                                           : TableComparer::Changed;
+        sourceKeys << it->key;
+        if (difference.kind == TableComparer::Changed) targetKeys << match->key;
+        found << difference;
+    }
+    for (auto it = targetHashes.constBegin(); it != targetHashes.constEnd(); ++it) {
+        if (sourceHashes.contains(it.key())) continue;
+        TableComparer::Difference difference;
+        difference.key = it->key;
+        difference.kind = TableComparer::ExtraInTarget;
+        targetKeys << it->key;
+        found << difference;
+    }
+
+    QHash<QString, QVariantList> sourceRows;
+    QHash<QString, QVariantList> targetRows;
+    if (!fetchRows(sourceDb, sourceSql, sourceKeys, &sourceRows, keyIndex, error) ||
+        !fetchRows(targetDb, targetSql, targetKeys, &targetRows, keyIndex, error)) {
+        return false;
+    }
+    *rowsTransferred += sourceRows.size() + targetRows.size();
+    for (TableComparer::Difference &difference : found) {
+        QString key = difference.key.toString();
+        difference.sourceRow = sourceRows.value(key);
+        difference.targetRow = targetRows.value(key);
+    }
+    *differences = found;
+    return true;
+}
+
+void runWorker(WorkQueue &queue, const QString &keyColumn, const QStringList &columns) {
+    const TableComparer::Options &options = queue.options;
+    DatabaseConnection source;
+    DatabaseConnection target;
+    if (!source.connect(options.source)) {
+        queue.failToStart(QObject::tr("Source: %1").arg(source.lastError().text()));
+        return;
+    }
+    if (!target.connect(options.target)) {
+        queue.failToStart(QObject::tr("Target: %1").arg(target.lastError().text()));
+        return;
+    }
+    // Row hashes go through the servers' text output.
+    source.normalizeSessionFormats();
+    target.normalizeSessionFormats();
+    TableSql sourceSql = tableSql(source, options.sourceTable, keyColumn, columns);
+    TableSql targetSql = tableSql(target, options.targetTable, keyColumn, columns);
+    int keyIndex = columns.indexOf(keyColumn);
+
+    Range range;
+    while (queue.take(&range)) {
+        QVector<Range> parts;
+        QVector<TableComparer::Difference> differences;
+        bool differing = false;
+        qint64 rowsTransferred = 0;
+        QString error;
+        if (!compareRange(source.database(), target.database(), sourceSql, targetSql, keyIndex, range,
+                          options, queue.progress, &parts, &differences, &differing, &rowsTransferred, &error)) {
+            queue.fail(error);
+            return;
+        }
+        queue.finish(parts, differences, differing, rowsTransferred);
+    }
+}
+
+} // namespace
+
+TableComparer::Result TableComparer::compare(const Options &options, Progress *progress) {
+    Result result;
+    QElapsedTimer timer;
+    timer.start();
+    Progress localProgress;
+    if (!progress) {
+        progress = &localProgress;
+    }
+
+    if (options.source.driver != options.target.driver) {
+        result.error = QObject::tr("Both sides must use the same driver (%1 vs %2)")
+                           .arg(options.source.driver, options.target.driver);
+        return result;
+    }
+    if (options.source.driver != "QPSQL" && options.source.driver != "QMYSQL") {
+        result.error = QObject::tr("Comparing tables is not supported for %1").arg(options.source.driver);
+        return result;
+    }
+
+    QVector<Range> initialRanges;
+    {
+        DatabaseConnection source;
+        DatabaseConnection target;
+        if (!source.connect(options.source)) {
+            result.error = QObject::tr("Source: %1").arg(source.lastError().text());
+            return result;
+        }
+        if (!target.connect(options.target)) {
+            result.error = QObject::tr("Target: %1").arg(target.lastError().text());
+            return result;
+        }
+
+        QSqlIndex primary = source.database().primaryIndex(options.sourceTable);
+        if (primary.count() != 1) {
+            result.error = QObject::tr("%1 needs a single-column primary key").arg(options.sourceTable);
+            return result;
+        }
+        result.keyColumn = primary.fieldName(0);
+
+        QSqlRecord sourceRecord = source.database().record(options.sourceTable);
+        QSqlRecord targetRecord = target.database().record(options.targetTable);
+        if (targetRecord.isEmpty()) {
+            result.error = QObject::tr("Table %1 not found on the target").arg(options.targetTable);
+            return result;
+        }
+        for (int i = 0; i < sourceRecord.count(); ++i) {
+            QString name = sourceRecord.fieldName(i);
+            if (targetRecord.contains(name)) {
+                result.columns << name;
+            } else {
+                result.ignoredColumns << name;
+            }
+        }
+        for (int i = 0; i < targetRecord.count(); ++i) {
+            if (!sourceRecord.contains(targetRecord.fieldName(i))) {
+                result.ignoredColumns << targetRecord.fieldName(i);
+            }
+        }
+        if (!result.columns.contains(result.keyColumn)) {
+            result.error = QObject::tr("Key column %1 is missing on the target").arg(result.keyColumn);
+            return result;
+        }
+
+        QVector<QVariant> bounds;
+        TableSql sql = tableSql(source, options.sourceTable, result.keyColumn, result.columns);
+        if (!splitRange(source.database(), sql, Range(), qMax(1, options.chunkRows), INT_MAX,
+                        progress, &bounds, &result.error)) {
+            return result;
+        }
+        initialRanges = rangesBetween(Range(), bounds);
+    }
+
+    WorkQueue queue(options, &result, progress);
+    queue.add(initialRanges);
+
+    QThreadPool pool;
+    int workers = qBound(1, options.workers, 32);
+    pool.setMaxThreadCount(workers);
+    QVector<QFuture<void>> futures;
+    for (int i = 0; i < workers; ++i) {
+        futures << QtConcurrent::run(&pool, [&queue, &result]() {
+            runWorker(queue, result.keyColumn, result.columns);
+        });
+    }
+    for (QFuture<void> &future : futures) {
+        future.waitForFinished();
+    }
+
+    if (isCanceled(progress) && result.error.isEmpty()) {
+        result.error = QObject::tr("Canceled");
+    }
+    std::sort(result.differences.begin(), result.differences.end(),
+              [](const Difference &a, const Difference &b) { return keyLess(a.key, b.key); });
+    result.ok = result.error.isEmpty();
+    result.elapsedMs = timer.elapsed();
+    return result;
+}
+
+QString TableComparer::kindName(DifferenceKind kind) {
+    switch (kind) {
+    case MissingInTarget: return QObject::tr("Missing in target");
+    case ExtraInTarget: return QObject::tr("Extra in target");
+    case Changed: return QObject::tr("Changed");
+    }
+    return QString();
+}
@@ -0,0 +1,655 @@
+#include "tablecopier.h"
+#include "tablesampler.h"
+#include "boundedqueue.h"
+#include <QSqlQuery>
+#include <QSqlIndex>
+#include <QSqlError>
+#include <QSettings>
+#include <QCryptographicHash>
+#include <QRegularExpression>
+#include <QSharedPointer>
+#include <QThreadPool>
+#include <QElapsedTimer>
+#include <QObject>
+#include <QtConcurrent>
+#include <QtNumeric>
+
+namespace {
+
+// Pages buffered between two stages of one partition.
+const int QueuePages = 4;
+// Large pages are split into several INSERTs below this size (characters),
+// well under the default max_allowed_packet of MySQL.
+const int MaxStatementChars = 4 * 1024 * 1024;
+
+const QStringList &integerTypes() {
+    static const QStringList types = {"tinyint", "smallint", "mediumint", "int", "integer", "bigint"};
+    return types;
+}
+
+QString typeModifier(const QString &type) {
+    int open = type.indexOf('(');
+    int close = type.indexOf(')', open);
+    return open >= 0 && close > open ? type.mid(open + 1, close - open - 1) : QString();
+}
+
+QString mysqlToPostgres(const TableCopier::Column &column) {
+    const QString &base = column.baseType;
+    bool isUnsigned = column.type.contains("unsigned", Qt::CaseInsensitive);
+    QString modifier = typeModifier(column.type);
+    if (base == "tinyint" || base == "smallint" || base == "year") return "smallint";
+    if (base == "mediumint") return "integer";
+    if (base == "int" || base == "integer") return isUnsigned ? "bigint" : "integer";
+    if (base == "bigint") return isUnsigned ? "numeric(20)" : "bigint";
+    if (base == "decimal" || base == "numeric") return modifier.isEmpty() ? "numeric" : "numeric(" + modifier + ")";
+    if (base == "float") return "real";
+    if (base == "double" || base == "real") return "double precision";
+    if (base == "char") return modifier.isEmpty() ? "char" : "char(" + modifier + ")";
+    if (base == "varchar") return modifier.isEmpty() ? "varchar" : "varchar(" + modifier + ")";
+    if (base == "json") return "jsonb";
+    if (base == "date") return "date";
+    if (base == "datetime" || base == "timestamp") return "timestamp";
+    if (base == "time") return "time";
+    if (base.endsWith("binary") || base.endsWith("blob")) return "bytea";
+    if (base == "bit") return "bigint";
+    return "text";
+}
+
+QString postgresToMysql(const TableCopier::Column &column) {
+    const QString &base = column.baseType;
+    QString modifier = typeModifier(column.type);
+    if (base == "smallint") return "SMALLINT";
+    if (base == "integer") return "INT";
+    if (base == "bigint") return "BIGINT";
+    if (base == "numeric") return modifier.isEmpty() ? "DECIMAL(65,30)" : "DECIMAL(" + modifier + ")";
+    if (base == "real") return "FLOAT";
+    if (base == "double precision") return "DOUBLE";
+    if (base == "boolean") return "TINYINT(1)";
+    if (base == "character varying") {
+        return !modifier.isEmpty() && modifier.toInt() <= 16383 ? "VARCHAR(" + modifier + ")" : "LONGTEXT";
+    }
+    if (base == "character") {
+        return !modifier.isEmpty() && modifier.toInt() <= 255 ? "CHAR(" + modifier + ")" : "TEXT";
+    }
+    if (base == "json" || base == "jsonb") return "JSON";
+    if (base == "uuid") return "CHAR(36)";
+    if (base == "bytea") return "LONGBLOB";
+    if (base == "date") return "DATE";
+    if (base.startsWith("timestamp")) return "DATETIME(6)";
+    if (base.startsWith("time")) return "TIME(6)";
+    // text, arrays, intervals, enums, network types...
+    return "LONGTEXT";
+}
+
+// Half-open on the left: rows with after < key <= upTo.
+struct Partition {
+    Partition() : index(0), done(false), rows(0) {}
+    int index;
+    QVariant after;
+    QVariant upTo;
+    bool done;
+    qint64 rows;
+};
+
+struct Page {
+    QVector<QVariantList> rows;
+    QVariant lastKey;
+};
+
+// INSERTs for one page; the checkpoint moves to lastKey once all are written.
+struct Batch {
+    Batch() : rows(0), chars(0) {}
+    QStringList statements;
+    QVariant lastKey;
+    qint64 rows;
+    qint64 chars;
+};
+
+struct Pipeline {
+    explicit Pipeline(const Partition &partition)
+        : partition(partition), pages(QueuePages), batches(QueuePages) {}
+    Partition partition;
+    BoundedQueue<Page> pages;
+    BoundedQueue<Batch> batches;
+};
+
+QString checkpointGroup(const TableCopier::Options &options) {
+    QStringList parts = {
+        options.source.driver, options.source.host, QString::number(options.source.port),
+        options.source.dbName, options.sourceTable,
+        options.target.driver, options.target.host, QString::number(options.target.port),
+        options.target.dbName, options.targetTable
+    };
+    QByteArray id = QCryptographicHash::hash(parts.join('\n').toUtf8(), QCryptographicHash::Md5).toHex();
+    return "copy/" + QString::fromLatin1(id.left(16));
+}
+
+QString partitionKey(const QString &group, int index) {
+    return QString("%1/p%2").arg(group).arg(index);
+}
+
+class CopyJob {
+public:
+    CopyJob(const TableCopier::Options &options, TableCopier::Progress *progress)
+        : options(options), progress(progress), keyIndex(-1), columnCount(0), targetPostgres(false) {}
+
+    const TableCopier::Options &options;
+    TableCopier::Progress *progress;
+    QString group;
+    QString sourceTable;     // quoted for the source
+    QString sourceKey;       // quoted for the source
+    QString selectList;
+    QString insertPrefix;
+    QVector<bool> temporal;
+    int keyIndex;
+    int columnCount;
+    bool targetPostgres;
+    QVector<QSharedPointer<Pipeline>> pipelines;
+
+    void fail(const QString &message) {
+        QMutexLocker locker(&mutex);
+        if (error.isEmpty()) error = message;
+        for (const QSharedPointer<Pipeline> &pipeline : pipelines) {
+            pipeline->pages.abort();
+            pipeline->batches.abort();
+        }
+    }
+
+    QString errorString() {
+        QMutexLocker locker(&mutex);
+        return error;
+    }
+
+    void read(Pipeline &pipeline);
+    void convert(Pipeline &pipeline);
+    void write(Pipeline &pipeline);
+
+private:
+    QMutex mutex;
+    QString error;
+};
+
+void CopyJob::read(Pipeline &pipeline) {
+    DatabaseConnection source;
+    if (!source.connect(options.source)) {
+        fail(QObject::tr("Source: %1").arg(source.lastError().text()));
+        return;
+    }
+    source.normalizeSessionFormats();
+    QSqlQuery query(source.database());
+    query.setForwardOnly(true);
+    query.setNumericalPrecisionPolicy(QSql::HighPrecision);
+
+    auto readRow = [this, &query]() {
+        QVariantList row;
+        row.reserve(columnCount);
+        for (int col = 0; col < columnCount; ++col) {
+            row << query.value(col);
+        }
+        return row;
+    };
+
+    if (keyIndex < 0) {
+        // No usable key: one forward-only stream, cut into pages client-side.
+        if (!query.exec(QString("SELECT %1 FROM %2").arg(selectList, sourceTable))) {
+            fail(query.lastError().text());
+            return;
+        }
+        Page page;
+        while (query.next()) {
+            page.rows << readRow();
+            if (page.rows.size() >= options.pageRows) {
+                if (progress->canceled.loadRelaxed()) {
+                    fail(QObject::tr("Canceled"));
+                    return;
+                }
+                if (!pipeline.pages.push(page)) return;
+                page = Page();
+            }
+        }
+        if (!page.rows.isEmpty() && !pipeline.pages.push(page)) return;
+        pipeline.pages.close();
+        return;
+    }
+
+    // Keyset pages: each one is an index range scan, and the last key of a
+    // page is where a resumed copy starts again.
+    QVariant after = pipeline.partition.after;
+    const QVariant &upTo = pipeline.partition.upTo;
+    while (true) {
+        if (progress->canceled.loadRelaxed()) {
+            fail(QObject::tr("Canceled"));
+            return;
+        }
+        QStringList conditions;
+        if (after.isValid()) conditions << sourceKey + " > ?";
+        if (upTo.isValid()) conditions << sourceKey + " <= ?";
+        query.prepare(QString("SELECT %1 FROM %2%3 ORDER BY %4 LIMIT %5")
+                          .arg(selectList, sourceTable,
+                               conditions.isEmpty() ? QString() : " WHERE " + conditions.join(" AND "),
+                               sourceKey)
+                          .arg(options.pageRows));
+        if (after.isValid()) query.addBindValue(after);
+        if (upTo.isValid()) query.addBindValue(upTo);
+        if (!query.exec()) {
+            fail(query.lastError().text());
+            return;
+        }
+        Page page;
+        page.rows.reserve(options.pageRows);
+        while (query.next()) {
+            page.rows << readRow();
+        }
+        if (page.rows.isEmpty()) break;
+        page.lastKey = page.rows.constLast().at(keyIndex);
+        after = page.lastKey;
+        bool lastPage = page.rows.size() < options.pageRows;
+        if (!pipeline.pages.push(page)) return;
+        if (lastPage) break;
+    }
+    pipeline.pages.close();
+}
+
+void CopyJob::convert(Pipeline &pipeline) {
+    Page page;
+    while (pipeline.pages.pop(&page)) {
+        Batch batch;
+        batch.lastKey = page.lastKey;
+        batch.rows = page.rows.size();
+        QString statement;
+        for (const QVariantList &row : page.rows) {
+            statement += statement.isEmpty() ? insertPrefix : QString(",");
+            statement += '(';
+            for (int col = 0; col < columnCount; ++col) {
+                if (col > 0) statement += ',';
+                statement += TableCopier::sqlLiteral(row.at(col), temporal.at(col), targetPostgres);
+            }
+            statement += ')';
+            if (statement.size() >= MaxStatementChars) {
+                batch.chars += statement.size();
+                batch.statements << statement;
+                statement.clear();
+            }
+        }
+        if (!statement.isEmpty()) {
+            batch.chars += statement.size();
+            batch.statements << statement;
+        }
+        if (!pipeline.batches.push(batch)) return;
+    }
+    pipeline.batches.close();
+}
+
+void CopyJob::write(Pipeline &pipeline) {
+    DatabaseConnection target;
+    if (!target.connect(options.target)) {
+        fail(QObject::tr("Target: %1").arg(target.lastError().text()));
+        return;
+    }
+    target.normalizeSessionFormats();
+    QSqlDatabase &db = target.database();
+    QSqlQuery query(db);
+    QSettings checkpoints("DBManager", "Settings");
+    QString key = partitionKey(group, pipeline.partition.index);
+    qint64 rows = pipeline.partition.rows;
+
+    Batch batch;
+    while (pipeline.batches.pop(&batch)) {
+        if (!db.transaction()) {
+            fail(db.lastError().text());
+            return;
+        }
+        for (const QString &statement : batch.statements) {
+            if (!query.exec(statement)) {
+                QString message = query.lastError().text();
+                db.rollback();
+                fail(message);
+                return;
+            }
+        }
+        if (!db.commit()) {
+            fail(db.lastError().text());
+            return;
+        }
+        rows += batch.rows;
+        progress->rowsCopied.fetchAndAddRelaxed(batch.rows);
+        progress->bytesWritten.fetchAndAddRelaxed(batch.chars);
+        if (keyIndex >= 0) {
+            checkpoints.setValue(key + "/after", batch.lastKey);
+            checkpoints.setValue(key + "/rows", rows);
+            checkpoints.sync();
+        }
+    }
+    if (errorString().isEmpty()) {
+        checkpoints.setValue(key + "/done", true);
+    }
+}
+
+} // namespace
+
+bool TableCopier::readColumns(DatabaseConnection &connection, const QString &table,
+                              QVector<Column> *columns, QString *error) {
+    QSqlQuery query(connection.database());
+    bool postgres = connection.database().driverName() == "QPSQL";
+    if (postgres) {
+        query.prepare("SELECT a.attname, format_type(a.atttypid, a.atttypmod), a.attnotnull "
+                      "FROM pg_attribute a WHERE a.attrelid = to_regclass(?) "
+                      "AND a.attnum > 0 AND NOT a.attisdropped ORDER BY a.attnum");
+        query.addBindValue(connection.quoteIdentifier(table));
+    } else {
+        query.prepare("SELECT COLUMN_NAME, COLUMN_TYPE, IS_NULLABLE = 'NO', DATA_TYPE "
+                      "FROM information_schema.COLUMNS "
+                      "WHERE TABLE_SCHEMA = DATABASE() AND TABLE_NAME = ? ORDER BY ORDINAL_POSITION");
+        query.addBindValue(table);
+    }
+    if (!query.exec()) {
+        *error = query.lastError().text();
+        return false;
+    }
+    static const QRegularExpression modifiers("\\([^)]*\\)");
+    while (query.next()) {
+        Column column;
+        column.name = query.value(0).toString();
+        column.type = query.value(1).toString();
+        column.notNull = query.value(2).toBool();
+        column.baseType = postgres ? QString(column.type).remove(modifiers).simplified().toLower()
+                                   : query.value(3).toString().toLower();
+        *columns << column;
+    }
+    if (columns->isEmpty()) {
+        *error = QObject::tr("Table %1 not found").arg(table);
+        return false;
+    }
+    return true;
+}
+
+bool TableCopier::isTemporal(const QString &baseType) {
+    return baseType.startsWith("date") || baseType.startsWith("time") || baseType == "year";
+}
+
+// Values arrive as text for the temporal columns (see the SELECT list in copy()),
+// as QString for numerics (HighPrecision) and as native types otherwise.
+QString TableCopier::sqlLiteral(const QVariant &value, bool temporal, bool postgres) {
+    if (value.isNull()) {
+        return "NULL";
+    }
+    switch (value.userType()) {
+    case QMetaType::Bool:
+        if (postgres) return value.toBool() ? "TRUE" : "FALSE";
+        return value.toBool() ? "1" : "0";
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::LongLong:
+    case QMetaType::ULongLong:
+    case QMetaType::Short:
+    case QMetaType::UShort:
+        return value.toString();
+    case QMetaType::Double:
+    case QMetaType::Float: {
+        double number = value.toDouble();
+        if (qIsNaN(number) || qIsInf(number)) {
+            if (!postgres) return "NULL";
+            return qIsNaN(number) ? "'NaN'" : number > 0 ? "'Infinity'" : "'-Infinity'";
+        }
+        return QString::number(number, 'g', 17);
+    }
+    case QMetaType::QByteArray: {
+        QString hex = QString::fromLatin1(value.toByteArray().toHex());
+        return postgres ? "decode('" + hex + "', 'hex')" : "X'" + hex + "'";
+    }
+    default:
+        break;
+    }
+
+    QString text = value.toString();
+    // MySQL zero dates have no PostgreSQL equivalent.
+    if (temporal && postgres && text.startsWith("0000-00-00")) {
+        return "NULL";
+    }
+    text.replace('\'', "''");
+    if (!postgres) {
+        text.replace('\\', "\\\\");
+    }
+    return '\'' + text + '\'';
+}
+
+QString TableCopier::mapType(const Column &column, const QString &sourceDriver, const QString &targetDriver) {
+    if (sourceDriver == targetDriver) {
+        return column.type;
+    }
+    return sourceDriver == "QMYSQL" ? mysqlToPostgres(column) : postgresToMysql(column);
+}
+
+QString TableCopier::createTableSql(DatabaseConnection &target, const QString &table, const QVector<Column> &columns,
+                                    const QString &sourceDriver, const QString &keyColumn) {
+    QString targetDriver = target.database().driverName();
+    QStringList definitions;
+    for (const Column &column : columns) {
+        QString type = mapType(column, sourceDriver, targetDriver);
+        // MySQL cannot index unbounded text.
+        if (column.name == keyColumn && (type == "LONGTEXT" || type == "TEXT")) {
+            type = "VARCHAR(255)";
+        }
+        definitions << QString("%1 %2%3").arg(target.quoteIdentifier(column.name), type,
+                                              column.notNull ? QString(" NOT NULL") : QString());
+    }
+    if (!keyColumn.isEmpty()) {
+        definitions << QString("PRIMARY KEY (%1)").arg(target.quoteIdentifier(keyColumn));
+    }
+    return QString("CREATE TABLE IF NOT EXISTS %1 (\n    %2\n)")
+        .arg(target.quoteIdentifier(table), definitions.join(",\n    "));
+}
+
+void TableCopier::clearCheckpoint(const Options &options) {
+    QSettings settings("DBManager", "Settings");
+    settings.remove(checkpointGroup(options));
+}
+
+TableCopier::Result TableCopier::copy(const Options &options, Progress *progress) {
+    Result result;
+    QElapsedTimer timer;
+    timer.start();
+    Progress localProgress;
+    if (!progress) {
+        progress = &localProgress;
+    }
+
+    static const QStringList supported = {"QPSQL", "QMYSQL"};
+    if (!supported.contains(options.source.driver) || !supported.contains(options.target.driver)) {
+        result.error = QObject::tr("Copying is supported between MySQL and PostgreSQL only");
+        return result;
+    }
+
+    CopyJob job(options, progress);
+    job.group = checkpointGroup(options);
+    job.targetPostgres = options.target.driver == "QPSQL";
+    QSettings checkpoints("DBManager", "Settings");
+    QVector<Partition> partitions;
+
+    {
+        DatabaseConnection source;
+        DatabaseConnection target;
+        if (!source.connect(options.source)) {
+            result.error = QObject::tr("Source: %1").arg(source.lastError().text());
+            return result;
+        }
+        if (!target.connect(options.target)) {
+            result.error = QObject::tr("Target: %1").arg(target.lastError().text());
+            return result;
+        }
+
+        QVector<Column> columns;
+        if (!readColumns(source, options.sourceTable, &columns, &result.error)) {
+            return result;
+        }
+
+        QSqlIndex primary = source.database().primaryIndex(options.sourceTable);
+        QString keyColumn;
+        if (primary.count() == 1) {
+            keyColumn = primary.fieldName(0);
+        } else {
+            result.notes << QObject::tr("No single-column primary key: copying in one stream without checkpoints");
+        }
+
+        bool sourcePostgres = options.source.driver == "QPSQL";
+        QStringList selectExpressions;
+        QStringList targetColumns;
+        for (int i = 0; i < columns.size(); ++i) {
+            const Column &column = columns.at(i);
+            QString name = source.quoteIdentifier(column.name);
+            bool temporalColumn = isTemporal(column.baseType);
+            // Temporal values travel as server-formatted text, which avoids
+            // Qt's local-time conversions and keeps fractional seconds.
+            if (!temporalColumn) {
+                selectExpressions << name;
+            } else if (sourcePostgres && column.baseType.endsWith("with time zone") && !job.targetPostgres) {
+                selectExpressions << QString("(%1 AT TIME ZONE 'UTC')::text").arg(name);
+            } else if (sourcePostgres) {
+                selectExpressions << name + "::text";
+            } else {
+                selectExpressions << QString("CAST(%1 AS CHAR)").arg(name);
+            }
+            job.temporal << temporalColumn;
+            targetColumns << target.quoteIdentifier(column.name);
+            if (column.name == keyColumn) {
+                job.keyIndex = i;
+            }
+        }
+        job.columnCount = columns.size();
+        job.selectList = selectExpressions.join(", ");
+        job.sourceTable = source.quoteIdentifier(options.sourceTable);
+        job.sourceKey = keyColumn.isEmpty() ? QString() : source.quoteIdentifier(keyColumn);
+
+        // Resume from the stored partition plan when there is one.
+        int storedPartitions = checkpoints.value(job.group + "/partitions", 0).toInt();
+        if (options.resume && storedPartitions > 0 && job.keyIndex >= 0) {
+            for (int i = 0; i < storedPartitions; ++i) {
+                QString key = partitionKey(job.group, i);
+                Partition partition;
+                partition.index = i;
+                partition.after = checkpoints.value(key + "/after");
+                partition.upTo = checkpoints.value(key + "/upTo");
+                partition.done = checkpoints.value(key + "/done", false).toBool();
+                partition.rows = checkpoints.value(key + "/rows", 0).toLongLong();
+                progress->rowsCopied.fetchAndAddRelaxed(partition.rows);
+                partitions << partition;
+            }
+            // A page is committed before its checkpoint is stored, so the
+            // target may hold rows past it: start after the last key it has.
+            // Key order only carries over for integers or within one driver.
+            if (integerTypes().contains(columns.at(job.keyIndex).baseType) ||
+                options.source.driver == options.target.driver) {
+                QString targetKey = target.quoteIdentifier(keyColumn);
+                QSqlQuery last(target.database());
+                for (Partition &partition : partitions) {
+                    if (partition.done) continue;
+                    QStringList conditions;
+                    if (partition.after.isValid()) conditions << targetKey + " > ?";
+                    if (partition.upTo.isValid()) conditions << targetKey + " <= ?";
+                    last.prepare(QString("SELECT MAX(%1) FROM %2%3")
+                                     .arg(targetKey, target.quoteIdentifier(options.targetTable),
+                                          conditions.isEmpty() ? QString() : " WHERE " + conditions.join(" AND ")));
+                    if (partition.after.isValid()) last.addBindValue(partition.after);
+                    if (partition.upTo.isValid()) last.addBindValue(partition.upTo);
+                    if (!last.exec() || !last.next()) {
+                        result.error = QObject::tr("Reading the last copied key failed: %1")
+                                           .arg(last.lastError().text());
+                        return result;
+                    }
+                    if (!last.value(0).isNull()) {
+                        partition.after = last.value(0);
+                    }
+                }
+            }
+            result.resumed = true;
+            result.notes << QObject::tr("Resuming after %1 rows").arg(progress->rowsCopied.loadRelaxed());
+        } else {
+            checkpoints.remove(job.group);
+            int count = job.keyIndex >= 0 ? qBound(1, options.partitions, 64) : 1;
+            qint64 minKey = 0;
+            qint64 maxKey = -1;
+            QSqlQuery query(source.database());
+            if (count > 1 && integerTypes().contains(columns.at(job.keyIndex).baseType) &&
+                query.exec(QString("SELECT MIN(%1), MAX(%1) FROM %2").arg(job.sourceKey, job.sourceTable)) &&
+                query.next() && !query.value(0).isNull()) {
+                minKey = query.value(0).toLongLong();
+                maxKey = query.value(1).toLongLong();
+            }
+            qint64 span = maxKey - minKey + 1;
+            if (span < count * 2) {
+                count = 1;
+            }
+            for (int i = 0; i < count; ++i) {
+                Partition partition;
+                partition.index = i;
+                if (i > 0) partition.after = minKey + span * i / count - 1;
+                if (i < count - 1) partition.upTo = minKey + span * (i + 1) / count - 1;
+                partitions << partition;
+            }
+
+            QSqlQuery prepare(target.database());
+            if (options.createTable) {
+                QString sql = createTableSql(target, options.targetTable, columns, options.source.driver, keyColumn);
+                if (!prepare.exec(sql)) {
+                    result.error = QObject::tr("Creating %1 failed: %2").arg(options.targetTable,
+                                                                             prepare.lastError().text());
+                    return result;
+                }
+            }
+            if (options.truncateTarget &&
+                !prepare.exec(QString("TRUNCATE TABLE %1").arg(target.quoteIdentifier(options.targetTable)))) {
+                result.error = QObject::tr("Truncating %1 failed: %2").arg(options.targetTable,
+                                                                           prepare.lastError().text());
+                return result;
+            }
+            if (job.keyIndex >= 0) {
+                checkpoints.setValue(job.group + "/partitions", partitions.size());
+                for (const Partition &partition : partitions) {
+                    QString key = partitionKey(job.group, partition.index);
+                    checkpoints.setValue(key + "/after", partition.after);
+                    checkpoints.setValue(key + "/upTo", partition.upTo);
+                }
+                checkpoints.sync();
+            }
+        }
+
+        // Resumed partitions read past the last copied key, so a plain
+        // INSERT never meets a row written before; any other conflict fails.
+        job.insertPrefix = QString("INSERT INTO %1 (%2) VALUES ").arg(target.quoteIdentifier(options.targetTable),
+                                                                      targetColumns.join(", "));
+        progress->estimatedRows.storeRelaxed(TableSampler::estimatedRowCount(source, options.sourceTable));
+    }
+
+    for (const Partition &partition : partitions) {
+        if (!partition.done) {
+            job.pipelines << QSharedPointer<Pipeline>::create(partition);
+        }
+    }
+    result.partitions = partitions.size();
+
+    // At most as many threads as the global pool. Stages are queued in
+    // pipeline order and start first in, first out, so a started stage
+    // always gets the later stages of its pipeline and waits for no other;
+    // three threads are enough for that.
+    QThreadPool pool;
+    pool.setMaxThreadCount(qMax(3, qMin(job.pipelines.size() * 3, QThreadPool::globalInstance()->maxThreadCount())));
+    QVector<QFuture<void>> futures;
+    for (const QSharedPointer<Pipeline> &pipeline : job.pipelines) {
+        Pipeline *stages = pipeline.data();
+        futures << QtConcurrent::run(&pool, [&job, stages]() { job.read(*stages); });
+        futures << QtConcurrent::run(&pool, [&job, stages]() { job.convert(*stages); });
+        futures << QtConcurrent::run(&pool, [&job, stages]() { job.write(*stages); });
+    }
+    for (QFuture<void> &future : futures) {
+        future.waitForFinished();
+    }
+
+    result.error = job.errorString();
+    result.rowsCopied = progress->rowsCopied.loadRelaxed();
+    result.ok = result.error.isEmpty();
+    if (result.ok) {
+        checkpoints.remove(job.group);
+    }
+    result.elapsedMs = timer.elapsed();
+    return result;
+}
@@ -0,0 +1,74 @@
+#ifndef TABLECOPIER_H
+#define TABLECOPIER_H
+
+#include <QString>
+#include <QStringList>
+#include <QAtomicInt>
+#include <QAtomicInteger>
+#include "databaseconnection.h"
+
+// Copies a table between servers, including MySQL <-> PostgreSQL. The source
+// is split into primary-key partitions; each one runs a reader (keyset pages
+// from the source), a converter (values to target SQL literals) and a writer
+// (multi-row INSERTs) connected by bounded queues. Every written page is
+// checkpointed, so an interrupted copy resumes where it stopped.
+class TableCopier {
+public:
+    struct Options {
+        Options() : partitions(4), pageRows(5000), createTable(true), truncateTarget(false), resume(true) {}
+        DatabaseConnection::ConnectionParams source;
+        DatabaseConnection::ConnectionParams target;
+        QString sourceTable;
+        QString targetTable;
+        int partitions;
+        int pageRows;
+        bool createTable;      // CREATE TABLE IF NOT EXISTS with mapped types
+        bool truncateTarget;   // only on a fresh start, never when resuming
+        bool resume;           // continue from the last checkpoint, if any
+    };
+
+    // Shared with the GUI thread while copy() runs.
+    struct Progress {
+        QAtomicInteger<qint64> rowsCopied;
+        QAtomicInteger<qint64> bytesWritten;
+        QAtomicInteger<qint64> estimatedRows;
+        QAtomicInt canceled;
+    };
+
+    struct Result {
+        Result() : ok(false), resumed(false), partitions(0), rowsCopied(0), elapsedMs(0) {}
+        bool ok;
+        bool resumed;
+        QString error;
+        QStringList notes;
+        int partitions;
+        qint64 rowsCopied;
+        qint64 elapsedMs;
+    };
+
+    struct Column {
+        Column() : notNull(false) {}
+        QString name;
+        QString type;      // full type as the source declares it
+        QString baseType;  // lower-case type name without modifiers
+        bool notNull;
+    };
+
+    // Blocks until done; run it off the GUI thread.
+    static Result copy(const Options &options, Progress *progress = nullptr);
+
+    static bool readColumns(DatabaseConnection &connection, const QString &table,
+                            QVector<Column> *columns, QString *error);
+    // Target column type for a source column; same-driver copies keep the type.
+    static QString mapType(const Column &column, const QString &sourceDriver, const QString &targetDriver);
+    static QString createTableSql(DatabaseConnection &target, const QString &table, const QVector<Column> &columns,
+                                  const QString &sourceDriver, const QString &keyColumn);
+    static void clearCheckpoint(const Options &options);
+
+    // Literal helpers, also used by DatabaseDumper. Temporal values are
+    // expected as server-formatted text.
+    static bool isTemporal(const QString &baseType);
+    static QString sqlLiteral(const QVariant &value, bool temporal, bool postgres);
+};
+
+#endif // TABLECOPIER_H
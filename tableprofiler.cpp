@@ -0,0 +1,541 @@
+#include "tableprofiler.h"
+#include "sketches.h"
+#include <QSqlRecord>
+#include <QSqlError>
+#include <QThread>
+#include <QThreadPool>
+#include <QElapsedTimer>
+#include <QStandardPaths>
+#include <QDir>
+#include <QFile>
+#include <QLocale>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QObject>
+#include <QtConcurrent>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+TableProfiler::Kind kindOf(const QVariant &value) {
+    switch (value.userType()) {
+    case QMetaType::Bool:
+        return TableProfiler::Boolean;
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::Long:
+    case QMetaType::ULong:
+    case QMetaType::LongLong:
+    case QMetaType::ULongLong:
+    case QMetaType::Short:
+    case QMetaType::UShort:
+    case QMetaType::Double:
+    case QMetaType::Float:
+        return TableProfiler::Numeric;
+    case QMetaType::QDate:
+    case QMetaType::QDateTime:
+    case QMetaType::QTime:
+        return TableProfiler::Temporal;
+    case QMetaType::QByteArray:
+        return TableProfiler::Binary;
+    default:
+        return TableProfiler::Text;
+    }
+}
+
+double temporalMeasure(const QVariant &value) {
+    switch (value.userType()) {
+    case QMetaType::QDate:
+        return static_cast<double>(value.toDate().startOfDay().toMSecsSinceEpoch());
+    case QMetaType::QTime:
+        return value.toTime().msecsSinceStartOfDay();
+    default:
+        return static_cast<double>(value.toDateTime().toMSecsSinceEpoch());
+    }
+}
+
+// Everything one column accumulates. Only the owning worker touches it
+// while a batch is being folded in.
+class ColumnState {
+public:
+    ColumnState()
+        : kind(TableProfiler::Empty), values(0), nulls(0),
+          minMeasure(std::numeric_limits<double>::infinity()),
+          maxMeasure(-std::numeric_limits<double>::infinity()) {}
+
+    void add(const QVariant &value) {
+        if (value.isNull()) {
+            ++nulls;
+            return;
+        }
+        if (kind == TableProfiler::Empty) {
+            kind = kindOf(value);
+        }
+        ++values;
+        distinct.add(HyperLogLog::hash(value));
+
+        double measure;
+        QString text;
+        switch (kind) {
+        case TableProfiler::Binary: {
+            QByteArray bytes = value.toByteArray();
+            measure = bytes.size();
+            text = "\\x" + QString::fromLatin1(bytes.left(TopValues::MaxValueLength / 2).toHex());
+            break;
+        }
+        case TableProfiler::Text:
+            text = value.toString();
+            measure = text.size();
+            if (minText.isNull() || text < minText) minText = text.left(TopValues::MaxValueLength);
+            if (maxText.isNull() || text > maxText) maxText = text.left(TopValues::MaxValueLength);
+            break;
+        case TableProfiler::Temporal:
+            text = value.toString();
+            measure = temporalMeasure(value);
+            break;
+        case TableProfiler::Boolean:
+            measure = value.toBool() ? 1 : 0;
+            text = value.toBool() ? "true" : "false";
+            break;
+        default:
+            measure = value.toDouble();
+            text = value.toString();
+            break;
+        }
+        quantiles.add(measure);
+        top.add(text);
+        if (measure < minMeasure) {
+            minMeasure = measure;
+            minValue = value;
+        }
+        if (measure > maxMeasure) {
+            maxMeasure = measure;
+            maxValue = value;
+        }
+    }
+
+    TableProfiler::Column finish(const QString &name, int bins, int topCount) const {
+        TableProfiler::Column column;
+        column.name = name;
+        column.kind = kind;
+        column.values = values;
+        column.nulls = nulls;
+        if (values == 0) {
+            return column;
+        }
+        column.distinct = qMin(distinct.estimate(), static_cast<double>(values));
+
+        if (kind == TableProfiler::Text) {
+            column.min = minText;
+            column.max = maxText;
+        } else if (kind == TableProfiler::Binary) {
+            column.min = TableProfiler::formatMeasure(kind, minMeasure);
+            column.max = TableProfiler::formatMeasure(kind, maxMeasure);
+        } else {
+            column.min = minValue.toString();
+            column.max = maxValue.toString();
+        }
+
+        const QVector<double> &ranks = TableProfiler::quantileRanks();
+        for (double rank : ranks) {
+            // The extremes are known exactly.
+            column.quantiles << (rank <= 0 ? minMeasure : rank >= 1 ? maxMeasure : quantiles.quantile(rank));
+        }
+
+        if (kind != TableProfiler::Boolean) {
+            column.histogramLow = minMeasure;
+            column.histogramHigh = maxMeasure;
+            if (maxMeasure <= minMeasure) {
+                column.histogram << values;
+            } else {
+                double previous = 0;
+                for (int bin = 1; bin <= bins; ++bin) {
+                    double edge = minMeasure + (maxMeasure - minMeasure) * bin / bins;
+                    double atMost = bin == bins ? values : quantiles.countAtMost(edge);
+                    column.histogram << qMax<qint64>(0, qRound64(atMost - previous));
+                    previous = qMax(previous, atMost);
+                }
+            }
+        }
+
+        for (const TopValues::Entry &entry : top.top(topCount)) {
+            TableProfiler::TopValue value;
+            value.value = entry.value;
+            value.count = entry.count;
+            value.error = entry.error;
+            column.topValues << value;
+        }
+        return column;
+    }
+
+private:
+    TableProfiler::Kind kind;
+    qint64 values;
+    qint64 nulls;
+    double minMeasure;
+    double maxMeasure;
+    QVariant minValue;
+    QVariant maxValue;
+    QString minText;
+    QString maxText;
+    HyperLogLog distinct;
+    QuantileSketch quantiles;
+    TopValues top;
+};
+
+// Column-major rows; the reader fills one batch while the workers fold
+// the other into the sketches.
+struct Batch {
+    Batch() : rows(0) {}
+    QVector<QVector<QVariant>> columns;
+    int rows;
+    QAtomicInt next;   // next column a worker claims
+};
+
+QString kindKey(TableProfiler::Kind kind) {
+    static const char *const keys[] = {"empty", "numeric", "temporal", "text", "binary", "boolean"};
+    return keys[kind];
+}
+
+TableProfiler::Kind kindFromKey(const QString &key) {
+    for (int kind = TableProfiler::Empty; kind <= TableProfiler::Boolean; ++kind) {
+        if (kindKey(static_cast<TableProfiler::Kind>(kind)) == key) {
+            return static_cast<TableProfiler::Kind>(kind);
+        }
+    }
+    return TableProfiler::Empty;
+}
+
+qint64 toInteger(const QJsonValue &value) {
+    return static_cast<qint64>(value.toDouble());
+}
+
+QJsonObject columnToJson(const TableProfiler::Column &column) {
+    QJsonObject object;
+    object["name"] = column.name;
+    object["kind"] = kindKey(column.kind);
+    object["values"] = column.values;
+    object["nulls"] = column.nulls;
+    object["min"] = column.min;
+    object["max"] = column.max;
+    object["distinct"] = column.distinct;
+    QJsonArray quantiles;
+    for (double quantile : column.quantiles) {
+        quantiles.append(quantile);
+    }
+    object["quantiles"] = quantiles;
+    object["histogramLow"] = column.histogramLow;
+    object["histogramHigh"] = column.histogramHigh;
+    QJsonArray histogram;
+    for (qint64 count : column.histogram) {
+        histogram.append(count);
+    }
+    object["histogram"] = histogram;
+    QJsonArray top;
+    for (const TableProfiler::TopValue &value : column.topValues) {
+        QJsonObject entry;
+        entry["value"] = value.value;
+        entry["count"] = value.count;
+        entry["error"] = value.error;
+        top.append(entry);
+    }
+    object["top"] = top;
+    return object;
+}
+
+TableProfiler::Column columnFromJson(const QJsonObject &object) {
+    TableProfiler::Column column;
+    column.name = object["name"].toString();
+    column.kind = kindFromKey(object["kind"].toString());
+    column.values = toInteger(object["values"]);
+    column.nulls = toInteger(object["nulls"]);
+    column.min = object["min"].toString();
+    column.max = object["max"].toString();
+    column.distinct = object["distinct"].toDouble();
+    for (const QJsonValue &quantile : object["quantiles"].toArray()) {
+        column.quantiles << quantile.toDouble();
+    }
+    column.histogramLow = object["histogramLow"].toDouble();
+    column.histogramHigh = object["histogramHigh"].toDouble();
+    for (const QJsonValue &count : object["histogram"].toArray()) {
+        column.histogram << toInteger(count);
+    }
+    for (const QJsonValue &entry : object["top"].toArray()) {
+        TableProfiler::TopValue value;
+        value.value = entry.toObject()["value"].toString();
+        value.count = toInteger(entry.toObject()["count"]);
+        value.error = toInteger(entry.toObject()["error"]);
+        column.topValues << value;
+    }
+    return column;
+}
+
+QString fileNamePart(const QString &name) {
+    static const QRegularExpression unsafe("[^A-Za-z0-9_-]");
+    return QString(name).replace(unsafe, "_");
+}
+
+QString reportPrefix(const QString &serverName, const QString &database, const QString &table) {
+    return QString("%1.%2.%3.").arg(fileNamePart(serverName), fileNamePart(database), fileNamePart(table));
+}
+
+} // namespace
+
+TableProfiler::Options::Options()
+    : sample(false), workers(QThread::idealThreadCount()), batchRows(4096), histogramBins(20), topValues(10) {
+}
+
+TableProfiler::Result TableProfiler::profile(const Options &options, Progress *progress) {
+    Result result;
+    Progress localProgress;
+    if (!progress) {
+        progress = &localProgress;
+    }
+    QElapsedTimer timer;
+    timer.start();
+
+    Report &report = result.report;
+    report.serverName = options.serverName;
+    report.database = options.params.dbName;
+    report.table = options.table;
+    report.sampled = options.sample;
+    report.created = QDateTime::currentDateTime();
+
+    DatabaseConnection connection;
+    if (!connection.connect(options.params)) {
+        result.error = connection.lastError().text();
+        return result;
+    }
+
+    qint64 estimate = TableSampler::estimatedRowCount(connection, options.table);
+    if (options.sample && options.sampleOptions.byRows) {
+        estimate = estimate > 0 ? qMin<qint64>(estimate, options.sampleOptions.rows) : options.sampleOptions.rows;
+    } else if (options.sample && estimate > 0) {
+        estimate = static_cast<qint64>(estimate * options.sampleOptions.percent / 100.0);
+    }
+    progress->estimatedRows.storeRelaxed(estimate);
+
+    QString sql = "SELECT * FROM " + connection.quoteIdentifier(options.table);
+    if (options.sample &&
+        !TableSampler::buildQuery(connection, options.table, options.sampleOptions, &sql, &report.sampleNote)) {
+        result.error = report.sampleNote;
+        connection.disconnect();
+        return result;
+    }
+
+    {
+        QSqlQuery query(connection.database());
+        query.setForwardOnly(true);
+        if (!query.exec(sql)) {
+            result.error = query.lastError().text();
+        } else {
+            result.ok = profileQuery(query, options, progress, &report, &result.error);
+        }
+    }
+    connection.disconnect();
+    report.elapsedMs = timer.elapsed();
+    return result;
+}
+
+bool TableProfiler::profileQuery(QSqlQuery &query, const Options &options, Progress *progress,
+                                 Report *report, QString *error) {
+    QSqlRecord record = query.record();
+    const int columnCount = record.count();
+    const int batchRows = qMax(1, options.batchRows);
+    QVector<ColumnState> states(columnCount);
+    ColumnState *columnStates = states.data();
+
+    Batch batches[2];
+    for (Batch &batch : batches) {
+        batch.columns = QVector<QVector<QVariant>>(columnCount, QVector<QVariant>(batchRows));
+    }
+
+    QThreadPool pool;
+    const int workers = qBound(1, options.workers, qMax(1, columnCount));
+    pool.setMaxThreadCount(workers);
+    QVector<QFuture<void>> running;
+    auto waitForWorkers = [&running]() {
+        for (QFuture<void> &future : running) {
+            future.waitForFinished();
+        }
+        running.clear();
+    };
+
+    report->rows = 0;
+    bool canceled = false;
+    bool more = true;
+    int current = 0;
+    while (more) {
+        Batch &batch = batches[current];
+        batch.rows = 0;
+        while (batch.rows < batchRows && (more = query.next())) {
+            for (int column = 0; column < columnCount; ++column) {
+                batch.columns[column][batch.rows] = query.value(column);
+            }
+            ++batch.rows;
+        }
+
+        // The other batch must be folded in before its buffer is refilled.
+        waitForWorkers();
+        if (progress && progress->canceled.loadRelaxed()) {
+            canceled = true;
+            break;
+        }
+        if (batch.rows > 0) {
+            batch.next.storeRelaxed(0);
+            Batch *folded = &batch;
+            for (int worker = 0; worker < workers; ++worker) {
+                running << QtConcurrent::run(&pool, [folded, columnStates, columnCount]() {
+                    int column;
+                    while ((column = folded->next.fetchAndAddRelaxed(1)) < columnCount) {
+                        const QVector<QVariant> &values = folded->columns.at(column);
+                        ColumnState &state = columnStates[column];
+                        for (int row = 0; row < folded->rows; ++row) {
+                            state.add(values.at(row));
+                        }
+                    }
+                });
+            }
+            report->rows += batch.rows;
+            if (progress) {
+                progress->rowsRead.fetchAndAddRelaxed(batch.rows);
+            }
+        }
+        current = 1 - current;
+    }
+    waitForWorkers();
+
+    if (canceled) {
+        *error = QObject::tr("Canceled");
+        return false;
+    }
+    if (query.lastError().isValid()) {
+        *error = query.lastError().text();
+        return false;
+    }
+
+    report->columns.clear();
+    for (int column = 0; column < columnCount; ++column) {
+        report->columns << states.at(column).finish(record.fieldName(column), qMax(1, options.histogramBins),
+                                                    options.topValues);
+    }
+    return true;
+}
+
+const QVector<double> &TableProfiler::quantileRanks() {
+    static const QVector<double> ranks = {0.0, 0.01, 0.05, 0.25, 0.5, 0.75, 0.95, 0.99, 1.0};
+    return ranks;
+}
+
+QString TableProfiler::kindName(Kind kind) {
+    switch (kind) {
+    case Numeric:
+        return QObject::tr("numeric");
+    case Temporal:
+        return QObject::tr("date/time");
+    case Text:
+        return QObject::tr("text");
+    case Binary:
+        return QObject::tr("binary");
+    case Boolean:
+        return QObject::tr("boolean");
+    default:
+        return QObject::tr("all NULL");
+    }
+}
+
+QString TableProfiler::formatMeasure(Kind kind, double value) {
+    if (std::isnan(value)) {
+        return QString();
+    }
+    switch (kind) {
+    case Temporal:
+        return QDateTime::fromMSecsSinceEpoch(qRound64(value)).toString(Qt::ISODate);
+    case Text:
+        return QObject::tr("%1 chars").arg(qRound64(value));
+    case Binary:
+        return QLocale().formattedDataSize(qRound64(value));
+    case Boolean:
+        return value >= 0.5 ? "true" : "false";
+    default:
+        return QString::number(value, 'g', 10);
+    }
+}
+
+QString TableProfiler::reportsDirectory() {
+    return QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)).filePath("profiles");
+}
+
+bool TableProfiler::save(const Report &report, QString *path, QString *error) {
+    QDir directory(reportsDirectory());
+    if (!directory.mkpath(".")) {
+        *error = QObject::tr("Cannot create %1").arg(directory.path());
+        return false;
+    }
+
+    QJsonObject object;
+    object["server"] = report.serverName;
+    object["database"] = report.database;
+    object["table"] = report.table;
+    object["sampled"] = report.sampled;
+    object["sampleNote"] = report.sampleNote;
+    object["rows"] = report.rows;
+    object["elapsedMs"] = report.elapsedMs;
+    object["created"] = report.created.toString(Qt::ISODate);
+    QJsonArray columns;
+    for (const Column &column : report.columns) {
+        columns.append(columnToJson(column));
+    }
+    object["columns"] = columns;
+
+    *path = directory.filePath(reportPrefix(report.serverName, report.database, report.table) +
+                               report.created.toString("yyyyMMdd-HHmmss") + ".json");
+    QFile file(*path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) ||
+        file.write(QJsonDocument(object).toJson(QJsonDocument::Compact)) < 0) {
+        *error = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool TableProfiler::load(const QString &path, Report *report, QString *error) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *error = file.errorString();
+        return false;
+    }
+    QJsonParseError parseError;
+    QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (!document.isObject()) {
+        *error = parseError.error != QJsonParseError::NoError ? parseError.errorString()
+                                                              : QObject::tr("Not a profile report");
+        return false;
+    }
+
+    QJsonObject object = document.object();
+    *report = Report();
+    report->serverName = object["server"].toString();
+    report->database = object["database"].toString();
+    report->table = object["table"].toString();
+    report->sampled = object["sampled"].toBool();
+    report->sampleNote = object["sampleNote"].toString();
+    report->rows = toInteger(object["rows"]);
+    report->elapsedMs = toInteger(object["elapsedMs"]);
+    report->created = QDateTime::fromString(object["created"].toString(), Qt::ISODate);
+    for (const QJsonValue &column : object["columns"].toArray()) {
+        report->columns << columnFromJson(column.toObject());
+    }
+    return true;
+}
+
+QString TableProfiler::latestReport(const QString &serverName, const QString &database, const QString &table) {
+    QDir directory(reportsDirectory());
+    // The timestamp suffix has a fixed width, so name order is time order.
+    QStringList names = directory.entryList({reportPrefix(serverName, database, table) + "*.json"},
+                                            QDir::Files, QDir::Name);
+    return names.isEmpty() ? QString() : directory.filePath(names.last());
+}
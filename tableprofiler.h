@@ -0,0 +1,115 @@
+#ifndef TABLEPROFILER_H
+#define TABLEPROFILER_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QPair>
+#include <QDateTime>
+#include <QAtomicInt>
+#include <QAtomicInteger>
+#include <QSqlQuery>
+#include "databaseconnection.h"
+#include "tablesampler.h"
+
+// Profiles every column of a table (or a sample of it) in one pass: null
+// ratio, min/max, approximate distinct count, quantiles, a histogram and
+// the most frequent values. Each column is summarized by fixed-size
+// sketches (see sketches.h), so memory does not grow with the table. One
+// connection streams the rows in batches; the columns of a batch are
+// folded into their sketches by a pool of workers while the next batch is
+// read. Reports are saved as JSON and can be reopened later.
+class TableProfiler {
+public:
+    enum Kind {
+        Empty,      // only NULLs seen
+        Numeric,
+        Temporal,   // quantiles and histogram over milliseconds since the epoch
+        Text,       // quantiles and histogram over the length in characters
+        Binary,     // quantiles and histogram over the length in bytes
+        Boolean
+    };
+
+    struct Options {
+        Options();
+        DatabaseConnection::ConnectionParams params;
+        QString serverName;
+        QString table;
+        bool sample;
+        TableSampler::Options sampleOptions;
+        int workers;
+        int batchRows;
+        int histogramBins;
+        int topValues;
+    };
+
+    // Shared with the GUI thread while profile() runs.
+    struct Progress {
+        QAtomicInteger<qint64> rowsRead;
+        QAtomicInteger<qint64> estimatedRows;
+        QAtomicInt canceled;
+    };
+
+    struct TopValue {
+        TopValue() : count(0), error(0) {}
+        QString value;
+        qint64 count;
+        qint64 error;
+    };
+
+    struct Column {
+        Column() : kind(Empty), values(0), nulls(0), distinct(0), histogramLow(0), histogramHigh(0) {}
+        QString name;
+        Kind kind;
+        qint64 values;               // non-NULL
+        qint64 nulls;
+        QString min;
+        QString max;
+        double distinct;             // HyperLogLog estimate
+        QVector<double> quantiles;   // at quantileRanks()
+        double histogramLow;
+        double histogramHigh;
+        QVector<qint64> histogram;   // equal-width bins over [low, high]
+        QVector<TopValue> topValues;
+    };
+
+    struct Report {
+        Report() : sampled(false), rows(0), elapsedMs(0) {}
+        QString serverName;
+        QString database;
+        QString table;
+        bool sampled;
+        QString sampleNote;
+        qint64 rows;
+        qint64 elapsedMs;
+        QDateTime created;
+        QVector<Column> columns;
+    };
+
+    struct Result {
+        Result() : ok(false) {}
+        bool ok;
+        QString error;
+        Report report;
+    };
+
+    // Blocks until done; run it off the GUI thread.
+    static Result profile(const Options &options, Progress *progress = nullptr);
+    // The streaming pass over an executed forward-only query.
+    static bool profileQuery(QSqlQuery &query, const Options &options, Progress *progress,
+                             Report *report, QString *error);
+
+    static const QVector<double> &quantileRanks();
+    static QString kindName(Kind kind);
+    // Formats a quantile or histogram edge for display in the column's terms.
+    static QString formatMeasure(Kind kind, double value);
+
+    // Reports live in one directory, named after server, database and table.
+    static QString reportsDirectory();
+    static bool save(const Report &report, QString *path, QString *error);
+    static bool load(const QString &path, Report *report, QString *error);
+    // Newest saved report for the table, or an empty string.
+    static QString latestReport(const QString &serverName, const QString &database, const QString &table);
+};
+
+#endif // TABLEPROFILER_H
@@ -0,0 +1,145 @@
+#include "tablesampler.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QRandomGenerator>
+#include <QObject>
+#include <QVector>
+#include <algorithm>
+
+namespace {
+
+// Upper bound on random seeks per MySQL sample; each one is an index lookup.
+const int MaxSeekPoints = 100;
+
+} // namespace
+
+bool TableSampler::buildQuery(DatabaseConnection &connection, const QString &tableName,
+                              const Options &options, QString *sql, QString *note) {
+    QString driver = connection.database().driverName();
+    if (driver == "QPSQL") {
+        return buildPostgresQuery(connection, tableName, options, sql, note);
+    }
+    if (driver == "QMYSQL") {
+        return buildMysqlQuery(connection, tableName, options, sql, note);
+    }
+    *note = QObject::tr("Sampling is not supported for %1").arg(driver);
+    return false;
+}
+
+qint64 TableSampler::estimatedRowCount(DatabaseConnection &connection, const QString &tableName) {
+    QSqlQuery query(connection.database());
+    if (connection.database().driverName() == "QPSQL") {
+        query.prepare("SELECT reltuples::bigint FROM pg_class WHERE oid = to_regclass(?)");
+        query.addBindValue(connection.quoteIdentifier(tableName));
+    } else {
+        query.prepare("SELECT TABLE_ROWS FROM information_schema.TABLES "
+                      "WHERE TABLE_SCHEMA = DATABASE() AND TABLE_NAME = ?");
+        query.addBindValue(tableName);
+    }
+    if (query.exec() && query.next()) {
+        return query.value(0).toLongLong();
+    }
+    return -1;
+}
+
+bool TableSampler::buildPostgresQuery(DatabaseConnection &connection, const QString &tableName,
+                                      const Options &options, QString *sql, QString *note) {
+    double percent = options.percent;
+    QString limit;
+
+    if (options.byRows) {
+        qint64 estimate = estimatedRowCount(connection, tableName);
+        if (estimate > 0) {
+            // Oversample a little so SYSTEM's block granularity still yields enough rows.
+            percent = qMin(100.0, options.rows * 100.0 * 1.2 / estimate);
+            *note = QObject::tr("~%1 of an estimated %2 rows").arg(options.rows).arg(estimate);
+        } else {
+            percent = 100.0;
+            *note = QObject::tr("No row estimate (table not analyzed); reading the first matching rows");
+        }
+        limit = QString(" LIMIT %1").arg(options.rows);
+    } else {
+        *note = QObject::tr("%1% sample").arg(percent);
+    }
+
+    QString method = options.method == Bernoulli ? "BERNOULLI" : "SYSTEM";
+    *sql = QString("SELECT * FROM %1 TABLESAMPLE %2 (%3)")
+               .arg(connection.quoteIdentifier(tableName), method)
+               .arg(percent, 0, 'g', 10);
+    if (options.repeatable) {
+        *sql += QString(" REPEATABLE (%1)").arg(options.seed);
+    }
+    *sql += limit;
+    return true;
+}
+
+bool TableSampler::buildMysqlQuery(DatabaseConnection &connection, const QString &tableName,
+                                   const Options &options, QString *sql, QString *note) {
+    QString table = connection.quoteIdentifier(tableName);
+
+    qint64 target = options.rows;
+    if (!options.byRows) {
+        qint64 estimate = estimatedRowCount(connection, tableName);
+        if (estimate <= 0) {
+            *note = QObject::tr("No row estimate available for %1").arg(tableName);
+            return false;
+        }
+        target = qMax<qint64>(1, qRound64(estimate * options.percent / 100.0));
+    }
+
+    // The random seeks need a single-column integer primary key.
+    QSqlQuery query(connection.database());
+    query.prepare("SELECT k.COLUMN_NAME, c.DATA_TYPE "
+                  "FROM information_schema.KEY_COLUMN_USAGE k "
+                  "JOIN information_schema.COLUMNS c ON c.TABLE_SCHEMA = k.TABLE_SCHEMA "
+                  "AND c.TABLE_NAME = k.TABLE_NAME AND c.COLUMN_NAME = k.COLUMN_NAME "
+                  "WHERE k.TABLE_SCHEMA = DATABASE() AND k.TABLE_NAME = ? "
+                  "AND k.CONSTRAINT_NAME = 'PRIMARY' ORDER BY k.ORDINAL_POSITION");
+    query.addBindValue(tableName);
+    QString keyColumn;
+    if (query.exec() && query.next()) {
+        static const QStringList integerTypes = {"tinyint", "smallint", "mediumint", "int", "bigint"};
+        if (integerTypes.contains(query.value(1).toString().toLower())) {
+            keyColumn = query.value(0).toString();
+        }
+    }
+
+    if (keyColumn.isEmpty()) {
+        *sql = QString("SELECT * FROM %1 LIMIT %2").arg(table).arg(target);
+        *note = QObject::tr("No integer primary key; showing the first %1 rows").arg(target);
+        return true;
+    }
+
+    QString key = connection.quoteIdentifier(keyColumn);
+    if (!query.exec(QString("SELECT MIN(%1), MAX(%1) FROM %2").arg(key, table)) || !query.next() ||
+        query.value(0).isNull()) {
+        *note = QObject::tr("Table %1 is empty").arg(tableName);
+        *sql = QString("SELECT * FROM %1 LIMIT 0").arg(table);
+        return true;
+    }
+    qint64 minKey = query.value(0).toLongLong();
+    qint64 maxKey = query.value(1).toLongLong();
+
+    int points = static_cast<int>(qMin<qint64>(target, MaxSeekPoints));
+    qint64 perPoint = (target + points - 1) / points;
+
+    QRandomGenerator generator = options.repeatable ? QRandomGenerator(options.seed)
+                                                    : QRandomGenerator::securelySeeded();
+    QVector<qint64> starts;
+    starts.reserve(points);
+    for (int i = 0; i < points; ++i) {
+        starts << minKey + static_cast<qint64>(generator.generateDouble() * (maxKey - minKey + 1));
+    }
+    std::sort(starts.begin(), starts.end());
+
+    QStringList parts;
+    parts.reserve(points);
+    for (qint64 start : starts) {
+        parts << QString("(SELECT * FROM %1 WHERE %2 >= %3 ORDER BY %2 LIMIT %4)")
+                     .arg(table, key).arg(start).arg(perPoint);
+    }
+    // UNION (not UNION ALL) drops rows picked twice by overlapping ranges.
+    *sql = QString("SELECT * FROM (%1) AS sample LIMIT %2").arg(parts.join(" UNION ")).arg(target);
+    *note = QObject::tr("%1 random ranges of %2 rows over %3").arg(points).arg(perPoint).arg(keyColumn);
+    return true;
+}
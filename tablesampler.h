@@ -0,0 +1,39 @@
+#ifndef TABLESAMPLER_H
+#define TABLESAMPLER_H
+
+#include <QString>
+#include "databaseconnection.h"
+
+// Builds queries that return a sample of a table without scanning it:
+// TABLESAMPLE on PostgreSQL, random primary-key range seeks on MySQL.
+class TableSampler {
+public:
+    enum Method {
+        System,     // PostgreSQL block sampling, constant time
+        Bernoulli   // PostgreSQL row sampling, reads every block
+    };
+
+    struct Options {
+        Options() : method(System), byRows(false), percent(1.0), rows(1000),
+                    repeatable(false), seed(0) {}
+        Method method;
+        bool byRows;      // target a row count instead of a percentage
+        double percent;
+        int rows;
+        bool repeatable;
+        quint32 seed;
+    };
+
+    static bool buildQuery(DatabaseConnection &connection, const QString &tableName,
+                           const Options &options, QString *sql, QString *note);
+    // Catalog estimate (pg_class.reltuples / TABLE_ROWS), -1 if unknown.
+    static qint64 estimatedRowCount(DatabaseConnection &connection, const QString &tableName);
+
+private:
+    static bool buildPostgresQuery(DatabaseConnection &connection, const QString &tableName,
+                                   const Options &options, QString *sql, QString *note);
+    static bool buildMysqlQuery(DatabaseConnection &connection, const QString &tableName,
+                                const Options &options, QString *sql, QString *note);
+};
+
+#endif // TABLESAMPLER_H
@@ -0,0 +1,163 @@
+#include "tablestatistics.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QLocale>
+#include <QObject>
+
+namespace {
+
+qint64 valueOr(const QVariant &value, qint64 fallback) {
+    return value.isNull() ? fallback : value.toLongLong();
+}
+
+QDateTime latest(const QVariant &a, const QVariant &b) {
+    QDateTime first = a.toDateTime();
+    QDateTime second = b.toDateTime();
+    if (!first.isValid()) return second;
+    if (!second.isValid()) return first;
+    return qMax(first, second);
+}
+
+} // namespace
+
+bool TableStatistics::load(DatabaseConnection &connection, QHash<QString, Table> *tables, QString *error) {
+    tables->clear();
+    if (!connection.isConnected()) {
+        *error = QObject::tr("Not connected");
+        return false;
+    }
+    QString driver = connection.database().driverName();
+    if (driver == "QPSQL") {
+        return loadPostgres(connection, tables, error);
+    }
+    if (driver == "QMYSQL") {
+        return loadMysql(connection, tables, error);
+    }
+    *error = QObject::tr("Statistics are not supported for %1").arg(driver);
+    return false;
+}
+
+QString TableStatistics::formatBytes(qint64 bytes) {
+    if (bytes < 0) {
+        return QObject::tr("n/a");
+    }
+    return QLocale().formattedDataSize(bytes);
+}
+
+bool TableStatistics::loadPostgres(DatabaseConnection &connection, QHash<QString, Table> *tables, QString *error) {
+    // One row per index (or one row for a table without indexes); the table
+    // columns repeat on each row.
+    QSqlQuery query(connection.database());
+    query.setForwardOnly(true);
+    bool ok = query.exec(
+        "SELECT n.nspname, c.relname, c.reltuples::bigint, "
+        "pg_relation_size(c.oid), pg_indexes_size(c.oid), "
+        "CASE WHEN c.reltoastrelid = 0 THEN 0 ELSE pg_total_relation_size(c.reltoastrelid) END, "
+        "s.n_dead_tup, s.last_vacuum, s.last_autovacuum, s.last_analyze, s.last_autoanalyze, "
+        "ic.relname, pg_relation_size(ic.oid), si.idx_scan, x.indisunique, "
+        // Key columns from indkey, so partial indexes, INCLUDE lists and
+        // opclasses stay out; expressions (attnum 0) as the server prints them.
+        "array_to_string(ARRAY(SELECT CASE WHEN x.indkey[k.n - 1] = 0 "
+        "THEN pg_get_indexdef(x.indexrelid, k.n, true) "
+        "ELSE (SELECT quote_ident(a.attname) FROM pg_attribute a "
+        "WHERE a.attrelid = x.indrelid AND a.attnum = x.indkey[k.n - 1]) END "
+        "FROM generate_series(1, x.indnkeyatts) k(n) ORDER BY k.n), ', ') "
+        "FROM pg_class c "
+        "JOIN pg_namespace n ON n.oid = c.relnamespace "
+        "LEFT JOIN pg_stat_user_tables s ON s.relid = c.oid "
+        "LEFT JOIN pg_index x ON x.indrelid = c.oid "
+        "LEFT JOIN pg_class ic ON ic.oid = x.indexrelid "
+        "LEFT JOIN pg_stat_user_indexes si ON si.indexrelid = x.indexrelid "
+        "WHERE c.relkind IN ('r', 'p', 'm') "
+        "AND n.nspname NOT IN ('pg_catalog', 'information_schema') "
+        "AND n.nspname NOT LIKE 'pg_toast%' "
+        "ORDER BY n.nspname, c.relname, ic.relname");
+    if (!ok) {
+        *error = query.lastError().text();
+        return false;
+    }
+
+    while (query.next()) {
+        // QPSQL lists tables outside "public" as schema.table.
+        QString schema = query.value(0).toString();
+        QString name = schema == "public" ? query.value(1).toString()
+                                          : schema + "." + query.value(1).toString();
+        Table &table = (*tables)[name];
+        if (table.name.isEmpty()) {
+            table.name = name;
+            table.estimatedRows = valueOr(query.value(2), -1);
+            table.tableBytes = valueOr(query.value(3), -1);
+            table.indexBytes = valueOr(query.value(4), -1);
+            table.toastBytes = valueOr(query.value(5), -1);
+            table.deadTuples = valueOr(query.value(6), -1);
+            table.lastVacuum = latest(query.value(7), query.value(8));
+            table.lastAnalyze = latest(query.value(9), query.value(10));
+        }
+        if (!query.value(11).isNull()) {
+            Index index;
+            index.name = query.value(11).toString();
+            index.sizeBytes = valueOr(query.value(12), -1);
+            index.scans = valueOr(query.value(13), -1);
+            index.unique = query.value(14).toBool();
+            index.columns = query.value(15).toString();
+            table.indexes << index;
+        }
+    }
+    return true;
+}
+
+bool TableStatistics::loadMysql(DatabaseConnection &connection, QHash<QString, Table> *tables, QString *error) {
+    static const char *const baseSql =
+        "SELECT t.TABLE_NAME, t.TABLE_ROWS, t.DATA_LENGTH, t.INDEX_LENGTH, t.DATA_FREE, "
+        "t.UPDATE_TIME, t.CHECK_TIME, s.INDEX_NAME, MIN(s.NON_UNIQUE), MAX(s.CARDINALITY), "
+        "GROUP_CONCAT(s.COLUMN_NAME ORDER BY s.SEQ_IN_INDEX SEPARATOR ', '), %1 "
+        "FROM information_schema.TABLES t "
+        "LEFT JOIN information_schema.STATISTICS s "
+        "ON s.TABLE_SCHEMA = t.TABLE_SCHEMA AND s.TABLE_NAME = t.TABLE_NAME "
+        "%2"
+        "WHERE t.TABLE_SCHEMA = DATABASE() AND t.TABLE_TYPE = 'BASE TABLE' "
+        "GROUP BY t.TABLE_NAME, t.TABLE_ROWS, t.DATA_LENGTH, t.INDEX_LENGTH, t.DATA_FREE, "
+        "t.UPDATE_TIME, t.CHECK_TIME, s.INDEX_NAME "
+        "ORDER BY t.TABLE_NAME, s.INDEX_NAME";
+
+    // Index usage comes from performance_schema, which may be disabled or
+    // not readable; fall back to the information_schema part alone.
+    QSqlQuery query(connection.database());
+    query.setForwardOnly(true);
+    bool ok = query.exec(QString(baseSql)
+        .arg(QString("MAX(p.COUNT_STAR)"),
+             QString("LEFT JOIN performance_schema.table_io_waits_summary_by_index_usage p "
+                     "ON p.OBJECT_SCHEMA = t.TABLE_SCHEMA AND p.OBJECT_NAME = t.TABLE_NAME "
+                     "AND p.INDEX_NAME = s.INDEX_NAME ")));
+    if (!ok) {
+        ok = query.exec(QString(baseSql).arg(QString("NULL"), QString()));
+    }
+    if (!ok) {
+        *error = query.lastError().text();
+        return false;
+    }
+
+    while (query.next()) {
+        QString name = query.value(0).toString();
+        Table &table = (*tables)[name];
+        if (table.name.isEmpty()) {
+            table.name = name;
+            table.estimatedRows = valueOr(query.value(1), -1);
+            table.tableBytes = valueOr(query.value(2), -1);
+            table.indexBytes = valueOr(query.value(3), -1);
+            table.freeBytes = valueOr(query.value(4), -1);
+            table.lastUpdate = query.value(5).toDateTime();
+            table.lastAnalyze = query.value(6).toDateTime();
+        }
+        if (!query.value(7).isNull()) {
+            Index index;
+            index.name = query.value(7).toString();
+            index.unique = query.value(8).toInt() == 0;
+            index.cardinality = valueOr(query.value(9), -1);
+            index.columns = query.value(10).toString();
+            index.scans = valueOr(query.value(11), -1);
+            table.indexes << index;
+        }
+    }
+    return true;
+}
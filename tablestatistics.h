@@ -0,0 +1,54 @@
+#ifndef TABLESTATISTICS_H
+#define TABLESTATISTICS_H
+
+#include <QString>
+#include <QStringList>
+#include <QDateTime>
+#include <QHash>
+#include <QVector>
+#include "databaseconnection.h"
+
+// Size and maintenance figures for every table of the current database,
+// read from the catalog in a single query (no table scans). Values the
+// server does not expose are -1 / invalid.
+class TableStatistics {
+public:
+    struct Index {
+        Index() : sizeBytes(-1), scans(-1), cardinality(-1), unique(false) {}
+        QString name;
+        QString columns;
+        qint64 sizeBytes;
+        qint64 scans;
+        qint64 cardinality;
+        bool unique;
+    };
+
+    struct Table {
+        Table() : estimatedRows(-1), tableBytes(-1), indexBytes(-1), toastBytes(-1),
+                  deadTuples(-1), freeBytes(-1) {}
+        QString name;
+        qint64 estimatedRows;
+        qint64 tableBytes;
+        qint64 indexBytes;
+        qint64 toastBytes;
+        qint64 deadTuples;
+        qint64 freeBytes;
+        QDateTime lastVacuum;
+        QDateTime lastAnalyze;
+        QDateTime lastUpdate;
+        QVector<Index> indexes;
+
+        qint64 totalBytes() const {
+            return qMax<qint64>(0, tableBytes) + qMax<qint64>(0, indexBytes) + qMax<qint64>(0, toastBytes);
+        }
+    };
+
+    static bool load(DatabaseConnection &connection, QHash<QString, Table> *tables, QString *error);
+    static QString formatBytes(qint64 bytes);
+
+private:
+    static bool loadPostgres(DatabaseConnection &connection, QHash<QString, Table> *tables, QString *error);
+    static bool loadMysql(DatabaseConnection &connection, QHash<QString, Table> *tables, QString *error);
+};
+
+#endif // TABLESTATISTICS_H
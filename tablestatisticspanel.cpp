@@ -0,0 +1,100 @@
+#include "tablestatisticspanel.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QFormLayout>
+#include <QHeaderView>
+#include <QLocale>
+
+namespace {
+
+QString formatCount(qint64 value) {
+    return value < 0 ? QObject::tr("n/a") : QLocale().toString(value);
+}
+
+QString formatTime(const QDateTime &time) {
+    return time.isValid() ? QLocale().toString(time.toLocalTime(), QLocale::ShortFormat) : QObject::tr("never");
+}
+
+} // namespace
+
+TableStatisticsPanel::TableStatisticsPanel(QWidget *parent)
+    : QWidget(parent)
+{
+    auto layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+
+    auto headerLayout = new QHBoxLayout;
+    titleLabel = new QLabel(this);
+    titleLabel->setStyleSheet("font-weight: bold;");
+    refreshButton = new QPushButton(tr("Refresh"), this);
+    headerLayout->addWidget(titleLabel, 1);
+    headerLayout->addWidget(refreshButton);
+    layout->addLayout(headerLayout);
+
+    auto formLayout = new QFormLayout;
+    rowsLabel = new QLabel(this);
+    tableSizeLabel = new QLabel(this);
+    indexSizeLabel = new QLabel(this);
+    toastSizeLabel = new QLabel(this);
+    deadTuplesLabel = new QLabel(this);
+    lastVacuumLabel = new QLabel(this);
+    lastAnalyzeLabel = new QLabel(this);
+    formLayout->addRow(tr("Estimated rows:"), rowsLabel);
+    formLayout->addRow(tr("Table size:"), tableSizeLabel);
+    formLayout->addRow(tr("Index size:"), indexSizeLabel);
+    formLayout->addRow(tr("TOAST size:"), toastSizeLabel);
+    formLayout->addRow(tr("Dead tuples / free:"), deadTuplesLabel);
+    formLayout->addRow(tr("Last vacuum / update:"), lastVacuumLabel);
+    formLayout->addRow(tr("Last analyze / check:"), lastAnalyzeLabel);
+    layout->addLayout(formLayout);
+
+    indexTable = new QTableWidget(this);
+    indexTable->setColumnCount(5);
+    indexTable->setHorizontalHeaderLabels({tr("Index"), tr("Columns"), tr("Size"), tr("Scans"), tr("Cardinality")});
+    indexTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    indexTable->verticalHeader()->hide();
+    indexTable->horizontalHeader()->setStretchLastSection(true);
+    layout->addWidget(indexTable);
+
+    connect(refreshButton, &QPushButton::clicked, this, &TableStatisticsPanel::refreshRequested);
+
+    showMessage(tr("Select a table to see its statistics"));
+}
+
+TableStatisticsPanel::~TableStatisticsPanel() {}
+
+void TableStatisticsPanel::showTable(const TableStatistics::Table &table)
+{
+    titleLabel->setText(table.name);
+    rowsLabel->setText(formatCount(table.estimatedRows));
+    tableSizeLabel->setText(TableStatistics::formatBytes(table.tableBytes));
+    indexSizeLabel->setText(TableStatistics::formatBytes(table.indexBytes));
+    toastSizeLabel->setText(TableStatistics::formatBytes(table.toastBytes));
+    deadTuplesLabel->setText(table.deadTuples >= 0 ? formatCount(table.deadTuples)
+                                                   : TableStatistics::formatBytes(table.freeBytes));
+    lastVacuumLabel->setText(formatTime(table.lastVacuum.isValid() ? table.lastVacuum : table.lastUpdate));
+    lastAnalyzeLabel->setText(formatTime(table.lastAnalyze));
+
+    indexTable->setRowCount(table.indexes.size());
+    for (int row = 0; row < table.indexes.size(); ++row) {
+        const TableStatistics::Index &index = table.indexes.at(row);
+        QString name = index.unique ? tr("%1 (unique)").arg(index.name) : index.name;
+        indexTable->setItem(row, 0, new QTableWidgetItem(name));
+        indexTable->setItem(row, 1, new QTableWidgetItem(index.columns));
+        indexTable->setItem(row, 2, new QTableWidgetItem(TableStatistics::formatBytes(index.sizeBytes)));
+        indexTable->setItem(row, 3, new QTableWidgetItem(formatCount(index.scans)));
+        indexTable->setItem(row, 4, new QTableWidgetItem(formatCount(index.cardinality)));
+    }
+    indexTable->resizeColumnsToContents();
+    refreshButton->setEnabled(true);
+}
+
+void TableStatisticsPanel::showMessage(const QString &message)
+{
+    titleLabel->setText(message);
+    for (QLabel *label : {rowsLabel, tableSizeLabel, indexSizeLabel, toastSizeLabel,
+                          deadTuplesLabel, lastVacuumLabel, lastAnalyzeLabel}) {
+        label->clear();
+    }
+    indexTable->setRowCount(0);
+}
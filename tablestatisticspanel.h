@@ -0,0 +1,36 @@
+#ifndef TABLESTATISTICSPANEL_H
+#define TABLESTATISTICSPANEL_H
+
+#include <QWidget>
+#include <QLabel>
+#include <QTableWidget>
+#include <QPushButton>
+#include "tablestatistics.h"
+
+class TableStatisticsPanel : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit TableStatisticsPanel(QWidget *parent = nullptr);
+    ~TableStatisticsPanel();
+
+    void showTable(const TableStatistics::Table &table);
+    void showMessage(const QString &message);
+
+signals:
+    void refreshRequested();
+
+private:
+    QLabel *titleLabel;
+    QLabel *rowsLabel;
+    QLabel *tableSizeLabel;
+    QLabel *indexSizeLabel;
+    QLabel *toastSizeLabel;
+    QLabel *deadTuplesLabel;
+    QLabel *lastVacuumLabel;
+    QLabel *lastAnalyzeLabel;
+    QTableWidget *indexTable;
+    QPushButton *refreshButton;
+};
+
+#endif // TABLESTATISTICSPANEL_H
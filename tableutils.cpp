@@ -0,0 +1,348 @@
+#include "tableutils.h"
+#include "clipboardformatter.h"
+#include "tracer.h"
+#include <QSqlRecord>
+#include <QHeaderView>
+#include <QSignalBlocker>
+#include <QLocale>
+#include <QVector>
+#include <QPair>
+#include <algorithm>
+
+namespace {
+
+const int RowGrowth = 4096;
+
+// Rough per-cell cost of a QTableWidgetItem and its text, used for the
+// client memory budget.
+const qint64 CellOverhead = 96;
+
+// Text of a preview cell: binary values as hex, and a cut-short value
+// followed by its full size. `marked` is set for both.
+QString previewText(const QVariant &value, qint64 bytes, bool binary, bool *marked)
+{
+    QString text;
+    bool truncated;
+    if (binary) {
+        QByteArray head = value.toByteArray();
+        text = "0x" + QString::fromLatin1(head.toHex());
+        truncated = head.size() < bytes;
+    } else {
+        text = value.toString();
+        truncated = text.toUtf8().size() < bytes;
+    }
+    if (truncated) {
+        text += QString::fromUtf8("\u2026 (%1)").arg(QLocale().formattedDataSize(bytes));
+    }
+    *marked = truncated || binary;
+    return text;
+}
+
+// Cells cut short, and binary ones shown as hex, are read-only and carry the
+// full size; the value viewer loads the rest.
+QTableWidgetItem *previewItem(const QVariant &value, const QVariant &size, bool binary)
+{
+    if (value.isNull()) {
+        return new QTableWidgetItem(QString());
+    }
+    qint64 bytes = size.toLongLong();
+    bool marked;
+    auto item = new QTableWidgetItem(previewText(value, bytes, binary, &marked));
+    if (marked) {
+        item->setData(TableUtils::FullSizeRole, bytes);
+        item->setFlags(item->flags() & ~Qt::ItemIsEditable);
+    }
+    return item;
+}
+
+// Estimate of what a value costs once it is a grid cell, without
+// converting it to text on the worker.
+qint64 cellBytes(const QVariant &value)
+{
+    switch (value.userType()) {
+    case QMetaType::QString:
+        return CellOverhead + value.toString().size() * qint64(sizeof(QChar));
+    case QMetaType::QByteArray:
+        return CellOverhead + value.toByteArray().size() * qint64(sizeof(QChar));
+    default:
+        return CellOverhead + 16;
+    }
+}
+
+} // namespace
+
+TableUtils::FetchResult TableUtils::fillFromQuery(QTableWidget *table, QSqlQuery &result,
+                                                  const FetchLimits &limits, const PreviewLayout &layout)
+{
+    {
+        const QSignalBlocker blocker(table);
+        table->clear();
+        table->setRowCount(0);
+
+        QStringList headers;
+        QSqlRecord record = result.record();
+        int columnCount = layout.isEmpty() ? record.count() : layout.columns;
+        for (int i = 0; i < columnCount; ++i) {
+            headers << record.fieldName(i);
+        }
+        table->setColumnCount(columnCount);
+        table->setHorizontalHeaderLabels(headers);
+    }
+
+    return appendFromQuery(table, result, limits, false, layout);
+}
+
+TableUtils::FetchResult TableUtils::appendFromQuery(QTableWidget *table, QSqlQuery &result,
+                                                    const FetchLimits &limits, bool resumeCurrentRow,
+                                                    const PreviewLayout &layout)
+{
+    // setItem() reports every cell through cellChanged, which the window
+    // treats as a user edit; keep the widget quiet while it is being filled.
+    const QSignalBlocker blocker(table);
+    table->setUpdatesEnabled(false);
+    // Fetching and rendering are interleaved here; one span covers both.
+    Tracer::Scope span(Tracer::Render);
+
+    FetchResult fetched;
+    int columnCount = table->columnCount();
+    int firstRow = table->rowCount();
+
+    // Drivers that know the result size let us allocate the rows once;
+    // otherwise grow in blocks instead of inserting row by row.
+    qint64 expected = result.size() > 0 ? result.size() - qMax(0, result.at()) : RowGrowth;
+    if (limits.maxRows > 0) {
+        expected = qMin(expected, limits.maxRows);
+    }
+    int capacity = firstRow + static_cast<int>(expected);
+    table->setRowCount(capacity);
+
+    int row = firstRow;
+    bool hasRow = resumeCurrentRow ? result.isValid() : result.next();
+    while (hasRow) {
+        if ((limits.maxRows > 0 && fetched.rows >= limits.maxRows) ||
+            (limits.maxBytes > 0 && fetched.bytes >= limits.maxBytes)) {
+            fetched.truncated = true;
+            break;
+        }
+        if (row == capacity) {
+            capacity += qMax(capacity / 2, RowGrowth);
+            table->setRowCount(capacity);
+        }
+        for (int col = 0; col < columnCount; ++col) {
+            int sizeField = layout.isEmpty() ? -1 : layout.sizeField.at(col);
+            auto item = sizeField < 0 ? new QTableWidgetItem(result.value(col).toString())
+                                      : previewItem(result.value(col), result.value(sizeField), layout.binary.at(col));
+            fetched.bytes += CellOverhead + item->text().size() * qint64(sizeof(QChar));
+            table->setItem(row, col, item);
+        }
+        row++;
+        fetched.rows++;
+        hasRow = result.next();
+    }
+    table->setRowCount(row);
+    span.setValue(fetched.rows);
+    Tracer::count(Tracer::RowsFetched, fetched.rows);
+    Tracer::count(Tracer::BytesFetched, fetched.bytes);
+
+    table->setUpdatesEnabled(true);
+    table->viewport()->update();
+    return fetched;
+}
+
+TableUtils::FetchResult TableUtils::readBatch(QSqlQuery &result, const FetchLimits &limits,
+                                              bool resumeCurrentRow, RowBatch *batch)
+{
+    Tracer::Scope span(Tracer::Fetch);
+    FetchResult fetched;
+    QSqlRecord record = result.record();
+    int fieldCount = record.count();
+    batch->columns.clear();
+    for (int i = 0; i < fieldCount; ++i) {
+        batch->columns << record.fieldName(i);
+    }
+    batch->rows.clear();
+    if (result.size() > 0) {
+        qint64 expected = result.size() - qMax(0, result.at());
+        if (limits.maxRows > 0) {
+            expected = qMin(expected, limits.maxRows);
+        }
+        batch->rows.reserve(static_cast<int>(expected));
+    }
+
+    bool hasRow = resumeCurrentRow ? result.isValid() : result.next();
+    while (hasRow) {
+        if ((limits.maxRows > 0 && fetched.rows >= limits.maxRows) ||
+            (limits.maxBytes > 0 && fetched.bytes >= limits.maxBytes)) {
+            fetched.truncated = true;
+            break;
+        }
+        QVector<QVariant> row(fieldCount);
+        for (int col = 0; col < fieldCount; ++col) {
+            row[col] = result.value(col);
+            fetched.bytes += cellBytes(row.at(col));
+        }
+        batch->rows << row;
+        fetched.rows++;
+        hasRow = result.next();
+    }
+    span.setValue(fetched.rows);
+    Tracer::count(Tracer::RowsFetched, fetched.rows);
+    Tracer::count(Tracer::BytesFetched, fetched.bytes);
+    return fetched;
+}
+
+void TableUtils::fillFromBatch(QTableWidget *table, const RowBatch &batch, const PreviewLayout &layout)
+{
+    {
+        const QSignalBlocker blocker(table);
+        table->clear();
+        table->setRowCount(0);
+        int columnCount = layout.isEmpty() ? batch.columns.size() : layout.columns;
+        table->setColumnCount(columnCount);
+        table->setHorizontalHeaderLabels(batch.columns.mid(0, columnCount));
+    }
+    appendBatch(table, batch, layout);
+}
+
+void TableUtils::appendBatch(QTableWidget *table, const RowBatch &batch, const PreviewLayout &layout)
+{
+    Tracer::Scope span(Tracer::Render);
+    span.setValue(batch.rows.size());
+    const QSignalBlocker blocker(table);
+    table->setUpdatesEnabled(false);
+
+    int columnCount = table->columnCount();
+    int row = table->rowCount();
+    table->setRowCount(row + batch.rows.size());
+    for (const QVector<QVariant> &values : batch.rows) {
+        for (int col = 0; col < columnCount; ++col) {
+            int sizeField = layout.isEmpty() ? -1 : layout.sizeField.at(col);
+            auto item = sizeField < 0 ? new QTableWidgetItem(values.at(col).toString())
+                                      : previewItem(values.at(col), values.at(sizeField), layout.binary.at(col));
+            table->setItem(row, col, item);
+        }
+        row++;
+    }
+
+    table->setUpdatesEnabled(true);
+    table->viewport()->update();
+}
+
+QString TableUtils::cellText(const QVector<QVariant> &values, int column, const PreviewLayout &layout)
+{
+    int sizeField = layout.isEmpty() ? -1 : layout.sizeField.at(column);
+    if (sizeField < 0) {
+        return values.at(column).toString();
+    }
+    if (values.at(column).isNull()) {
+        return QString();
+    }
+    bool marked;
+    return previewText(values.at(column), values.at(sizeField).toLongLong(), layout.binary.at(column), &marked);
+}
+
+void TableUtils::sortRows(QTableWidget *table, int column, Qt::SortOrder order)
+{
+    Tracer::Scope span(Tracer::Sort);
+    span.setValue(table->rowCount());
+    const QSignalBlocker blocker(table);
+    table->setUpdatesEnabled(false);
+
+    int rowCount = table->rowCount();
+    int colCount = table->columnCount();
+
+    QVector<QPair<QStringList, int>> data;
+    data.reserve(rowCount);
+
+    for (int row = 0; row < rowCount; ++row) {
+        QStringList rowData;
+        rowData.reserve(colCount);
+
+        for (int col = 0; col < colCount; ++col) {
+            QTableWidgetItem *item = table->item(row, col);
+            rowData << (item ? item->text() : QString());
+        }
+        data.append({rowData, row});
+    }
+
+    std::sort(data.begin(), data.end(),
+        [column, order](const QPair<QStringList, int> &a, const QPair<QStringList, int> &b) {
+            QString val1 = a.first.value(column);
+            QString val2 = b.first.value(column);
+
+            bool ok1, ok2;
+            double num1 = val1.toDouble(&ok1);
+            double num2 = val2.toDouble(&ok2);
+
+            if (ok1 && ok2) {
+                return order == Qt::AscendingOrder ? num1 < num2 : num1 > num2;
+            } else {
+                return order == Qt::AscendingOrder ?
+                    val1.localeAwareCompare(val2) < 0 :
+                    val1.localeAwareCompare(val2) > 0;
+            }
+        }
+    );
+
+    QVector<QVector<QTableWidgetItem*>> sortedData(rowCount, QVector<QTableWidgetItem*>(colCount));
+
+    for (int row = 0; row < rowCount; ++row) {
+        for (int col = 0; col < colCount; ++col) {
+            sortedData[row][col] = table->takeItem(row, col);
+        }
+    }
+
+    for (int newRow = 0; newRow < data.size(); ++newRow) {
+        int oldRow = data[newRow].second;
+        for (int col = 0; col < colCount; ++col) {
+            table->setItem(newRow, col, sortedData[oldRow][col]);
+        }
+    }
+
+    QHeaderView* header = table->horizontalHeader();
+    header->setSortIndicator(column, order);
+    header->setSortIndicatorShown(true);
+
+    table->setUpdatesEnabled(true);
+    table->viewport()->update();
+}
+
+QString TableUtils::selectionToText(const QTableWidget *table)
+{
+    return ClipboardFormatter::format(ClipboardFormatter::capture(table), ClipboardFormatter::Tsv);
+}
+
+bool TableUtils::exportTable(const QTableWidget *table, QIODevice *device,
+                             ResultExporter::Format format, QString *errorMessage)
+{
+    Tracer::Scope span(Tracer::Export);
+    span.setValue(table->rowCount());
+    ResultExporter exporter(device, format);
+
+    int columnCount = table->columnCount();
+    QStringList headers;
+    for (int i = 0; i < columnCount; ++i) {
+        QTableWidgetItem *headerItem = table->horizontalHeaderItem(i);
+        headers << (headerItem ? headerItem->text() : QString());
+    }
+    exporter.writeHeader(headers);
+
+    QVariantList values;
+    values.reserve(columnCount);
+    for (int row = 0; row < table->rowCount(); ++row) {
+        values.clear();
+        for (int col = 0; col < columnCount; ++col) {
+            QTableWidgetItem *item = table->item(row, col);
+            values << (item ? QVariant(item->text()) : QVariant());
+        }
+        exporter.writeRow(values);
+    }
+
+    if (!exporter.finish()) {
+        if (errorMessage) {
+            *errorMessage = exporter.errorString();
+        }
+        return false;
+    }
+    return true;
+}
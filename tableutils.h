@@ -0,0 +1,75 @@
+#ifndef TABLEUTILS_H
+#define TABLEUTILS_H
+
+#include <QTableWidget>
+#include <QSqlQuery>
+#include <QIODevice>
+#include <QString>
+#include <QVector>
+#include <QVariant>
+#include <QStringList>
+#include "resultexporter.h"
+
+// Row loops shared by the main window and the benchmark suite: filling the
+// grid from a query, sorting it, building clipboard text and exporting it.
+class TableUtils {
+public:
+    // Caps for one fetch batch; 0 disables a limit.
+    struct FetchLimits {
+        FetchLimits() : maxRows(0), maxBytes(0) {}
+        qint64 maxRows;
+        qint64 maxBytes;
+    };
+
+    struct FetchResult {
+        FetchResult() : rows(0), bytes(0), truncated(false) {}
+        int rows;
+        qint64 bytes;
+        // Stopped by a limit; the query is positioned on the first unread row.
+        bool truncated;
+    };
+
+    // Large columns fetched as bounded previews (see LargeValues). The grid
+    // shows the first `columns` fields of the result; sizeField maps a grid
+    // column to the trailing field holding the full value's size in bytes.
+    struct PreviewLayout {
+        PreviewLayout() : columns(-1) {}
+        int columns;
+        QVector<int> sizeField;     // per grid column, -1 for ordinary columns
+        QVector<bool> binary;
+        bool isEmpty() const { return columns < 0; }
+    };
+
+    // Set on preview cells that are truncated or binary: the full size in
+    // bytes. Such cells are read-only and do not identify their row.
+    static const int FullSizeRole = Qt::UserRole + 1;
+
+    static FetchResult fillFromQuery(QTableWidget *table, QSqlQuery &result,
+                                     const FetchLimits &limits = FetchLimits(),
+                                     const PreviewLayout &layout = PreviewLayout());
+    static FetchResult appendFromQuery(QTableWidget *table, QSqlQuery &result,
+                                       const FetchLimits &limits, bool resumeCurrentRow,
+                                       const PreviewLayout &layout = PreviewLayout());
+    // Rows read from a query on a worker thread. Widgets live on the GUI
+    // thread, so the grid is filled from the batch afterwards.
+    struct RowBatch {
+        QStringList columns;            // every field of the record
+        QVector<QVector<QVariant>> rows;
+    };
+
+    static FetchResult readBatch(QSqlQuery &result, const FetchLimits &limits, bool resumeCurrentRow,
+                                 RowBatch *batch);
+    static void fillFromBatch(QTableWidget *table, const RowBatch &batch,
+                              const PreviewLayout &layout = PreviewLayout());
+    static void appendBatch(QTableWidget *table, const RowBatch &batch,
+                            const PreviewLayout &layout = PreviewLayout());
+    // What the grid shows for a field of a batch row.
+    static QString cellText(const QVector<QVariant> &values, int column,
+                            const PreviewLayout &layout = PreviewLayout());
+    static void sortRows(QTableWidget *table, int column, Qt::SortOrder order);
+    static QString selectionToText(const QTableWidget *table);
+    static bool exportTable(const QTableWidget *table, QIODevice *device,
+                            ResultExporter::Format format, QString *errorMessage = nullptr);
+};
+
+#endif // TABLEUTILS_H
@@ -0,0 +1,7 @@
+TEMPLATE = app
+TARGET = tst_browsequery
+
+include(../tests.pri)
+
+SOURCES += \
+    tst_browsequery.cpp
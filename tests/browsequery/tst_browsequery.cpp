@@ -0,0 +1,219 @@
+#include <QtTest>
+#include "browsequery.h"
+
+namespace {
+
+LargeValues::Browse browseOf(const QStringList &keys, const QStringList &tableColumns = QStringList())
+{
+    LargeValues::Browse browse;
+    browse.table = "t";
+    browse.sql = "SELECT * FROM t";
+    browse.keyColumns = keys;
+    for (const QString &name : tableColumns) {
+        LargeValues::Column column;
+        column.name = name;
+        browse.tableColumns << column;
+    }
+    return browse;
+}
+
+BrowseQuery::Condition conditionOf(const QString &column, BrowseQuery::Operator op, const QString &value)
+{
+    BrowseQuery::Condition condition;
+    condition.column = column;
+    condition.op = op;
+    condition.value = value;
+    return condition;
+}
+
+} // namespace
+
+// The browse statement for each page: filter, keyset predicate and order.
+// Without a driver names come back unquoted and the MySQL forms are built.
+class BrowseQueryTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void pages_data();
+    void pages();
+    void conditions_data();
+    void conditions();
+    void conditionsBeforeSeek();
+    void unknownColumn();
+    void emptyInList();
+
+private:
+    DatabaseConnection connection;
+};
+
+void BrowseQueryTest::pages_data()
+{
+    QTest::addColumn<QStringList>("keys");
+    QTest::addColumn<QString>("sortColumn");
+    QTest::addColumn<bool>("descending");
+    QTest::addColumn<bool>("afterValid");
+    QTest::addColumn<QVariant>("sortValue");
+    QTest::addColumn<QVariantList>("keyValues");
+    QTest::addColumn<int>("limit");
+    QTest::addColumn<QString>("sql");
+    QTest::addColumn<QVariantList>("values");
+
+    const int limit = BrowseQuery::PageRows + 1;
+    const QStringList keys = {"a", "b"};
+    const QVariantList after = {1, "x"};
+
+    QTest::newRow("first page") << keys << QString() << false << false << QVariant() << QVariantList()
+        << limit << "SELECT * FROM t ORDER BY a, b LIMIT 1001" << QVariantList();
+    QTest::newRow("composite key, next page") << keys << QString() << false << true << QVariant() << after
+        << limit << "SELECT * FROM t WHERE (a, b) > (?, ?) ORDER BY a, b LIMIT 1001" << after;
+    QTest::newRow("composite key, descending") << keys << QString() << true << true << QVariant() << after
+        << limit << "SELECT * FROM t WHERE (a, b) < (?, ?) ORDER BY a DESC, b DESC LIMIT 1001" << after;
+    QTest::newRow("single key sorted by itself") << QStringList{"id"} << "id" << true << true << QVariant()
+        << QVariantList{7} << limit << "SELECT * FROM t WHERE (id) < (?) ORDER BY id DESC LIMIT 1001"
+        << QVariantList{7};
+    // NULLs sort last; the key breaks ties and stays ascending.
+    QTest::newRow("sort column, first page") << keys << "c" << false << false << QVariant() << QVariantList()
+        << limit << "SELECT * FROM t ORDER BY c IS NULL, c, a, b LIMIT 1001" << QVariantList();
+    QTest::newRow("sort column, after a value") << keys << "c" << false << true << QVariant(5) << after
+        << limit << "SELECT * FROM t WHERE (c > ? OR (c = ? AND (a, b) > (?, ?)) OR c IS NULL) "
+                    "ORDER BY c IS NULL, c, a, b LIMIT 1001"
+        << QVariantList{5, 5, 1, "x"};
+    QTest::newRow("sort column descending, after a value") << keys << "c" << true << true << QVariant(5) << after
+        << limit << "SELECT * FROM t WHERE (c < ? OR (c = ? AND (a, b) > (?, ?)) OR c IS NULL) "
+                    "ORDER BY c IS NULL, c DESC, a, b LIMIT 1001"
+        << QVariantList{5, 5, 1, "x"};
+    // A page ending on NULL continues with the remaining NULLs only.
+    QTest::newRow("sort column, after NULL") << keys << "c" << false << true << QVariant() << after
+        << limit << "SELECT * FROM t WHERE (c IS NULL AND (a, b) > (?, ?)) ORDER BY c IS NULL, c, a, b LIMIT 1001"
+        << after;
+    QTest::newRow("no key, sorted") << QStringList() << "c" << false << true << QVariant(5) << QVariantList()
+        << limit << "SELECT * FROM t ORDER BY c IS NULL, c LIMIT 1001" << QVariantList();
+    QTest::newRow("no key, to the end") << QStringList() << QString() << false << false << QVariant()
+        << QVariantList() << 0 << "SELECT * FROM t" << QVariantList();
+}
+
+void BrowseQueryTest::pages()
+{
+    QFETCH(QStringList, keys);
+    QFETCH(QString, sortColumn);
+    QFETCH(bool, descending);
+    QFETCH(bool, afterValid);
+    QFETCH(QVariant, sortValue);
+    QFETCH(QVariantList, keyValues);
+    QFETCH(int, limit);
+    QFETCH(QString, sql);
+    QFETCH(QVariantList, values);
+
+    BrowseQuery::Request request;
+    request.table = "t";
+    request.sortColumn = sortColumn;
+    request.descending = descending;
+    BrowseQuery::Position after;
+    after.valid = afterValid;
+    after.sortValue = sortValue;
+    for (const QVariant &value : keyValues) {
+        after.keyValues << value;
+    }
+
+    BrowseQuery::Statement statement;
+    QString error;
+    QVERIFY(BrowseQuery::build(connection, browseOf(keys), request, after, limit, &statement, &error));
+    QCOMPARE(statement.sql, sql);
+    QCOMPARE(statement.values, values);
+}
+
+void BrowseQueryTest::conditions_data()
+{
+    QTest::addColumn<QString>("column");
+    QTest::addColumn<int>("op");
+    QTest::addColumn<QString>("value");
+    QTest::addColumn<QString>("where");
+    QTest::addColumn<QVariantList>("values");
+
+    QTest::newRow("equals") << "name" << int(BrowseQuery::Equals) << "bob" << "name = ?" << QVariantList{"bob"};
+    QTest::newRow("not equals") << "name" << int(BrowseQuery::NotEquals) << "bob" << "name <> ?"
+        << QVariantList{"bob"};
+    QTest::newRow("at least") << "age" << int(BrowseQuery::GreaterOrEqual) << "30" << "age >= ?"
+        << QVariantList{"30"};
+    // LIKE wildcards and the escape character in the value match literally.
+    QTest::newRow("starts with") << "name" << int(BrowseQuery::StartsWith) << "50%_a\\b" << "name LIKE ?"
+        << QVariantList{"50\\%\\_a\\\\b%"};
+    QTest::newRow("contains") << "name" << int(BrowseQuery::Contains) << "a_b" << "name LIKE ?"
+        << QVariantList{"%a\\_b%"};
+    QTest::newRow("in") << "id" << int(BrowseQuery::In) << " 1, 2 ,,3 " << "id IN (?, ?, ?)"
+        << QVariantList{"1", "2", "3"};
+    QTest::newRow("is null") << "deleted_at" << int(BrowseQuery::IsNull) << "ignored" << "deleted_at IS NULL"
+        << QVariantList();
+    QTest::newRow("is not null") << "deleted_at" << int(BrowseQuery::IsNotNull) << QString()
+        << "deleted_at IS NOT NULL" << QVariantList();
+}
+
+void BrowseQueryTest::conditions()
+{
+    QFETCH(QString, column);
+    QFETCH(int, op);
+    QFETCH(QString, value);
+    QFETCH(QString, where);
+    QFETCH(QVariantList, values);
+
+    BrowseQuery::Request request;
+    request.table = "t";
+    request.conditions << conditionOf(column, static_cast<BrowseQuery::Operator>(op), value);
+
+    BrowseQuery::Statement statement;
+    QString error;
+    QVERIFY(BrowseQuery::build(connection, browseOf(QStringList()), request, BrowseQuery::Position(), 0,
+                               &statement, &error));
+    QCOMPARE(statement.sql, QString("SELECT * FROM t WHERE " + where));
+    QCOMPARE(statement.values, values);
+}
+
+void BrowseQueryTest::conditionsBeforeSeek()
+{
+    BrowseQuery::Request request;
+    request.table = "t";
+    request.conditions << conditionOf("status", BrowseQuery::Equals, "open")
+                       << conditionOf("name", BrowseQuery::StartsWith, "a");
+    BrowseQuery::Position after;
+    after.valid = true;
+    after.keyValues << 1 << 2;
+
+    // The filter may name a column the grid does not show.
+    BrowseQuery::Statement statement;
+    QString error;
+    QVERIFY(BrowseQuery::build(connection, browseOf({"a", "b"}, {"a", "b", "name", "status"}), request, after,
+                               BrowseQuery::PageRows + 1, &statement, &error));
+    QCOMPARE(statement.sql, QString("SELECT * FROM t WHERE status = ? AND name LIKE ? AND (a, b) > (?, ?) "
+                                    "ORDER BY a, b LIMIT 1001"));
+    QCOMPARE(statement.values, QVariantList({"open", "a%", 1, 2}));
+}
+
+void BrowseQueryTest::unknownColumn()
+{
+    BrowseQuery::Request request;
+    request.table = "t";
+    request.conditions << conditionOf("missing", BrowseQuery::Equals, "1");
+
+    BrowseQuery::Statement statement;
+    QString error;
+    QVERIFY(!BrowseQuery::build(connection, browseOf({"a"}, {"a", "b"}), request, BrowseQuery::Position(), 0,
+                                &statement, &error));
+    QCOMPARE(error, QString("t has no column missing"));
+}
+
+void BrowseQueryTest::emptyInList()
+{
+    BrowseQuery::Request request;
+    request.table = "t";
+    request.conditions << conditionOf("id", BrowseQuery::In, " , ");
+
+    BrowseQuery::Statement statement;
+    QString error;
+    QVERIFY(!BrowseQuery::build(connection, browseOf({"a"}), request, BrowseQuery::Position(), 0, &statement,
+                                &error));
+    QCOMPARE(error, QString("Enter comma-separated values for id in"));
+}
+
+QTEST_GUILESS_MAIN(BrowseQueryTest)
+
+#include "tst_browsequery.moc"
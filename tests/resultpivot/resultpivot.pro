@@ -0,0 +1,7 @@
+TEMPLATE = app
+TARGET = tst_resultpivot
+
+include(../tests.pri)
+
+SOURCES += \
+    tst_resultpivot.cpp
@@ -0,0 +1,234 @@
+#include <QtTest>
+#include <cmath>
+#include "resultpivot.h"
+
+namespace {
+
+// region, year, amount, product
+const QStringList Headers = {"region", "year", "amount", "product"};
+
+QVector<QStringList> sales()
+{
+    return {
+        {"north", "2023", "10", "apple"},
+        {"south", "2023", "5", "pear"},
+        {"north", "2024", "7", "apple"},
+        {"north", "2023", "", "pear"},
+        {"", "2024", "3", "apple"},
+        {"south", "2024", "20", ""},
+    };
+}
+
+QVector<ResultPivot::ColumnPtr> encodeAll(const QVector<QStringList> &rows, int threads)
+{
+    QVector<ResultPivot::ColumnPtr> columns;
+    for (int column = 0; column < rows.first().size(); ++column) {
+        QVector<QString> texts;
+        for (const QStringList &row : rows) {
+            texts << row.at(column);
+        }
+        columns << ResultPivot::encode(texts, threads);
+    }
+    return columns;
+}
+
+ResultPivot::Aggregate aggregateOf(ResultPivot::Function function, int column)
+{
+    ResultPivot::Aggregate aggregate;
+    aggregate.function = function;
+    aggregate.column = column;
+    return aggregate;
+}
+
+} // namespace
+
+// Dictionary encoding and the group-by / pivot cells it produces.
+class ResultPivotTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void encodeText();
+    void encodeNumbers();
+    void encodeAcrossWorkers();
+    void groupBy();
+    void pivotOneAggregate();
+    void pivotTwoAggregates();
+    void pivotDropsRareValues();
+    void noAggregate();
+    void aggregateAcrossWorkers();
+};
+
+void ResultPivotTest::encodeText()
+{
+    ResultPivot::ColumnPtr column = ResultPivot::encode({"b", "a", "", "b", "10"}, 1);
+    QCOMPARE(column->values, QVector<QString>({"", "b", "a", "10"}));
+    QCOMPARE(column->codes, QVector<quint32>({1, 2, 0, 1, 3}));
+    QVERIFY(!column->numeric);
+    // The empty cell first, then text order.
+    QCOMPARE(column->sorted, QVector<quint32>({0, 3, 2, 1}));
+    QCOMPARE(column->ranks, QVector<quint32>({0, 3, 2, 1}));
+}
+
+void ResultPivotTest::encodeNumbers()
+{
+    ResultPivot::ColumnPtr column = ResultPivot::encode({"10", "9", "", "9.5", "9"}, 1);
+    QCOMPARE(column->values, QVector<QString>({"", "10", "9", "9.5"}));
+    QCOMPARE(column->codes, QVector<quint32>({1, 2, 0, 3, 2}));
+    QVERIFY(column->numeric);
+    QVERIFY(std::isnan(column->numbers.at(0)));
+    QCOMPARE(column->numbers.at(3), 9.5);
+    // By value, not by text: 9 < 9.5 < 10.
+    QCOMPARE(column->sorted, QVector<quint32>({0, 2, 3, 1}));
+    QCOMPARE(column->ranks, QVector<quint32>({0, 3, 1, 2}));
+}
+
+void ResultPivotTest::encodeAcrossWorkers()
+{
+    // Enough rows for several workers, whose dictionaries overlap.
+    QVector<QString> texts;
+    for (int row = 0; row < 100000; ++row) {
+        texts << (row % 11 == 0 ? QString() : QString("v%1").arg(qint64(row) * 7 % 1000));
+    }
+    ResultPivot::ColumnPtr single = ResultPivot::encode(texts, 1);
+    ResultPivot::ColumnPtr parallel = ResultPivot::encode(texts, 4);
+    QCOMPARE(parallel->values, single->values);
+    QCOMPARE(parallel->codes, single->codes);
+    QCOMPARE(parallel->sorted, single->sorted);
+    QCOMPARE(single->values.size(), 1001);
+    for (int row = 0; row < texts.size(); ++row) {
+        QCOMPARE(parallel->values.at(parallel->codes.at(row)), texts.at(row));
+    }
+}
+
+void ResultPivotTest::groupBy()
+{
+    QVector<QStringList> rows = sales();
+    ResultPivot::Spec spec;
+    spec.groupColumns = {0};
+    spec.aggregates = {aggregateOf(ResultPivot::Count, -1),
+                       aggregateOf(ResultPivot::Count, 2),
+                       aggregateOf(ResultPivot::Sum, 2),
+                       aggregateOf(ResultPivot::Avg, 2),
+                       aggregateOf(ResultPivot::Min, 2),
+                       aggregateOf(ResultPivot::Max, 2),
+                       aggregateOf(ResultPivot::CountDistinct, 3)};
+    ResultPivot::Result result = ResultPivot::aggregate(encodeAll(rows, 1), Headers, rows.size(), spec, 1);
+
+    QVERIFY(result.ok);
+    QCOMPARE(result.headers, QStringList({"region", "count(*)", "count(amount)", "sum(amount)", "avg(amount)",
+                                          "min(amount)", "max(amount)", "count(distinct product)"}));
+    QCOMPARE(result.keyColumns, 1);
+    QCOMPARE(result.inputRows, qint64(6));
+    QCOMPARE(result.groups, 3);
+    // Empty cells are skipped by column aggregates; min and max compare
+    // numbers, so 7 < 10.
+    QCOMPARE(result.rows, QVector<QStringList>({
+        {"", "1", "1", "3", "3", "3", "3", "1"},
+        {"north", "3", "2", "17", "8.5", "7", "10", "2"},
+        {"south", "2", "2", "25", "12.5", "5", "20", "1"},
+    }));
+}
+
+void ResultPivotTest::pivotOneAggregate()
+{
+    QVector<QStringList> rows = sales();
+    ResultPivot::Spec spec;
+    spec.groupColumns = {0};
+    spec.pivotColumn = 1;
+    spec.aggregates = {aggregateOf(ResultPivot::Sum, 2)};
+    ResultPivot::Result result = ResultPivot::aggregate(encodeAll(rows, 1), Headers, rows.size(), spec, 1);
+
+    QVERIFY(result.ok);
+    QCOMPARE(result.headers, QStringList({"region", "2023", "2024"}));
+    QCOMPARE(result.rows, QVector<QStringList>({
+        {"", "", "3"},
+        {"north", "10", "7"},
+        {"south", "5", "20"},
+    }));
+    QCOMPARE(result.droppedPivotValues, 0);
+}
+
+void ResultPivotTest::pivotTwoAggregates()
+{
+    QVector<QStringList> rows = sales();
+    ResultPivot::Spec spec;
+    spec.groupColumns = {0};
+    spec.pivotColumn = 3;
+    spec.aggregates = {aggregateOf(ResultPivot::Count, -1), aggregateOf(ResultPivot::Sum, 2)};
+    ResultPivot::Result result = ResultPivot::aggregate(encodeAll(rows, 1), Headers, rows.size(), spec, 1);
+
+    QVERIFY(result.ok);
+    QCOMPARE(result.headers, QStringList({"region", "(empty): count(*)", "(empty): sum(amount)",
+                                          "apple: count(*)", "apple: sum(amount)",
+                                          "pear: count(*)", "pear: sum(amount)"}));
+    // A sum over no values is an empty cell, not 0.
+    QCOMPARE(result.rows, QVector<QStringList>({
+        {"", "", "", "1", "3", "", ""},
+        {"north", "", "", "2", "17", "1", ""},
+        {"south", "1", "20", "", "", "1", "5"},
+    }));
+}
+
+void ResultPivotTest::pivotDropsRareValues()
+{
+    QVector<QStringList> rows = sales();
+    ResultPivot::Spec spec;
+    spec.groupColumns = {0};
+    spec.pivotColumn = 3;
+    spec.maxPivotValues = 2;
+    spec.aggregates = {aggregateOf(ResultPivot::Count, -1)};
+    ResultPivot::Result result = ResultPivot::aggregate(encodeAll(rows, 1), Headers, rows.size(), spec, 1);
+
+    QVERIFY(result.ok);
+    // apple (3 rows) and pear (2) stay; the empty product (1) is dropped.
+    QCOMPARE(result.droppedPivotValues, 1);
+    QCOMPARE(result.headers, QStringList({"region", "apple", "pear"}));
+    QCOMPARE(result.rows, QVector<QStringList>({
+        {"", "1", ""},
+        {"north", "2", "1"},
+        {"south", "", "1"},
+    }));
+}
+
+void ResultPivotTest::noAggregate()
+{
+    QVector<QStringList> rows = sales();
+    ResultPivot::Spec spec;
+    spec.groupColumns = {0};
+    ResultPivot::Result result = ResultPivot::aggregate(encodeAll(rows, 1), Headers, rows.size(), spec, 1);
+    QVERIFY(!result.ok);
+    QCOMPARE(result.error, QString("Choose at least one aggregate"));
+}
+
+void ResultPivotTest::aggregateAcrossWorkers()
+{
+    QVector<QStringList> rows;
+    for (int row = 0; row < 100000; ++row) {
+        rows << QStringList{QString("g%1").arg(row % 7), QString::number(row % 3),
+                            row % 13 == 0 ? QString() : QString::number(row % 100), QString::number(row % 37)};
+    }
+    ResultPivot::Spec spec;
+    spec.groupColumns = {0};
+    spec.pivotColumn = 1;
+    spec.aggregates = {aggregateOf(ResultPivot::Count, -1), aggregateOf(ResultPivot::Avg, 2),
+                       aggregateOf(ResultPivot::Max, 2), aggregateOf(ResultPivot::CountDistinct, 3)};
+    QStringList headers = {"group", "pivot", "value", "other"};
+    ResultPivot::Result single = ResultPivot::aggregate(encodeAll(rows, 1), headers, rows.size(), spec, 1);
+    ResultPivot::Result parallel = ResultPivot::aggregate(encodeAll(rows, 4), headers, rows.size(), spec, 4);
+
+    QVERIFY(single.ok && parallel.ok);
+    QCOMPARE(single.groups, 7);
+    QCOMPARE(parallel.headers, single.headers);
+    QCOMPARE(parallel.rows, single.rows);
+    qint64 counted = 0;
+    for (const QStringList &row : single.rows) {
+        for (int block = 0; block < 3; ++block) {
+            counted += row.at(1 + block * 4).toLongLong();
+        }
+    }
+    QCOMPARE(counted, qint64(rows.size()));
+}
+
+QTEST_GUILESS_MAIN(ResultPivotTest)
+
+#include "tst_resultpivot.moc"
@@ -0,0 +1,7 @@
+TEMPLATE = app
+TARGET = tst_schemaindex
+
+include(../tests.pri)
+
+SOURCES += \
+    tst_schemaindex.cpp
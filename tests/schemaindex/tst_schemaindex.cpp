@@ -0,0 +1,131 @@
+#include <QtTest>
+#include "schemaindex.h"
+
+namespace {
+
+void loadShop(SchemaIndex *index)
+{
+    QVector<QPair<QString, QString>> catalog = {
+        {"orders", "id"}, {"orders", "user_id"}, {"orders", "total"}, {"orders", "created_at"},
+        {"sales.invoices", "id"}, {"sales.invoices", "amount"},
+        {"users", "id"}, {"users", "name"}, {"users", "email"},
+    };
+    index->load(catalog, {"COUNT", "COALESCE", "CONCAT"});
+}
+
+} // namespace
+
+// Completions for a cursor inside a statement, marked by '|' in the data.
+class SchemaIndexTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void complete_data();
+    void complete();
+    void limit();
+    void keywordsOnly();
+    void isSchemaChange_data();
+    void isSchemaChange();
+
+private:
+    SchemaIndex index;
+};
+
+void SchemaIndexTest::initTestCase()
+{
+    loadShop(&index);
+    QVERIFY(!index.isEmpty());
+    QCOMPARE(index.tableCount(), 3);
+    QCOMPARE(index.columnCount(), 9);
+}
+
+void SchemaIndexTest::complete_data()
+{
+    QTest::addColumn<QString>("statement");
+    QTest::addColumn<QString>("prefix");
+    QTest::addColumn<QStringList>("items");
+
+    QTest::newRow("alias") << "SELECT u.| FROM users u" << ""
+        << QStringList{"email", "id", "name"};
+    QTest::newRow("alias with a prefix") << "SELECT o.u| FROM orders o JOIN users u ON u.id = o.user_id" << "u"
+        << QStringList{"user_id"};
+    QTest::newRow("quoted alias") << "SELECT \"U\".na| FROM \"users\" AS \"U\"" << "na"
+        << QStringList{"name"};
+    QTest::newRow("table after FROM") << "SELECT * FROM us|" << "us"
+        << QStringList{"users"};
+    QTest::newRow("table after a comma") << "SELECT * FROM users, or|" << "or"
+        << QStringList{"orders"};
+    QTest::newRow("schema-qualified table") << "SELECT * FROM sales.i|" << "i"
+        << QStringList{"invoices"};
+    // Columns of the referenced tables, then functions, then keywords.
+    QTest::newRow("referenced columns first") << "SELECT c| FROM orders" << "c"
+        << QStringList{"created_at", "COALESCE", "CONCAT", "COUNT", "CASE", "COLUMN", "COMMIT", "CREATE", "CROSS"};
+    QTest::newRow("no table yet, every column") << "SELECT tot|" << "tot"
+        << QStringList{"total"};
+    QTest::newRow("fuzzy table") << "SELECT * FROM usr|" << "usr"
+        << QStringList{"users"};
+    QTest::newRow("fuzzy column") << "SELECT o.ttl| FROM orders o" << "ttl"
+        << QStringList{"total"};
+    QTest::newRow("unknown alias") << "SELECT x.| FROM users u" << ""
+        << QStringList();
+}
+
+void SchemaIndexTest::complete()
+{
+    QFETCH(QString, statement);
+    QFETCH(QString, prefix);
+    QFETCH(QStringList, items);
+
+    int cursor = statement.indexOf('|');
+    statement.remove(cursor, 1);
+    SchemaIndex::Completion completion = index.complete(statement, cursor);
+    QCOMPARE(completion.prefix, prefix);
+    QCOMPARE(completion.items, items);
+}
+
+void SchemaIndexTest::limit()
+{
+    SchemaIndex::Completion completion = index.complete("SELECT c FROM orders", 8, 2);
+    QCOMPARE(completion.items, QStringList({"created_at", "COALESCE"}));
+}
+
+void SchemaIndexTest::keywordsOnly()
+{
+    SchemaIndex empty;
+    QVERIFY(empty.isEmpty());
+    QCOMPARE(empty.complete("sel", 3).items, QStringList({"SELECT"}));
+    QCOMPARE(empty.complete("SELECT * FROM us", 16).items, QStringList());
+
+    SchemaIndex cleared;
+    loadShop(&cleared);
+    cleared.clear();
+    QVERIFY(cleared.isEmpty());
+    QCOMPARE(cleared.columnCount(), 0);
+    QCOMPARE(cleared.complete("SELECT tot", 10).items, QStringList());
+}
+
+void SchemaIndexTest::isSchemaChange_data()
+{
+    QTest::addColumn<QString>("query");
+    QTest::addColumn<bool>("change");
+
+    QTest::newRow("alter") << "  alter table t add c int" << true;
+    QTest::newRow("create") << "CREATE INDEX i ON t (c)" << true;
+    QTest::newRow("drop") << "DROP TABLE t" << true;
+    QTest::newRow("rename") << "RENAME TABLE a TO b" << true;
+    QTest::newRow("select") << "SELECT 1" << false;
+    QTest::newRow("insert") << "INSERT INTO t VALUES (1)" << false;
+    QTest::newRow("empty") << "" << false;
+}
+
+void SchemaIndexTest::isSchemaChange()
+{
+    QFETCH(QString, query);
+    QFETCH(bool, change);
+    QCOMPARE(SchemaIndex::isSchemaChange(query), change);
+}
+
+QTEST_GUILESS_MAIN(SchemaIndexTest)
+
+#include "tst_schemaindex.moc"
@@ -0,0 +1,7 @@
+TEMPLATE = app
+TARGET = tst_sketches
+
+include(../tests.pri)
+
+SOURCES += \
+    tst_sketches.cpp
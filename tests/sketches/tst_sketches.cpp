@@ -0,0 +1,146 @@
+#include <QtTest>
+#include <cmath>
+#include "sketches.h"
+
+// The profiler's sketches against exact answers: estimates must stay
+// within the error bounds the headers promise.
+class SketchesTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void distinctCount_data();
+    void distinctCount();
+    void hashMatchesEqualValues();
+    void quantiles_data();
+    void quantiles();
+    void emptyQuantile();
+    void topValues();
+    void topValuesLongValue();
+};
+
+void SketchesTest::distinctCount_data()
+{
+    QTest::addColumn<int>("precision");
+    QTest::addColumn<int>("distinct");
+
+    QTest::newRow("small, linear counting") << 14 << 100;
+    QTest::newRow("1k") << 14 << 1000;
+    QTest::newRow("100k") << 14 << 100000;
+    QTest::newRow("1M") << 14 << 1000000;
+    QTest::newRow("precision 10") << 10 << 100000;
+}
+
+void SketchesTest::distinctCount()
+{
+    QFETCH(int, precision);
+    QFETCH(int, distinct);
+
+    HyperLogLog sketch(precision);
+    for (int i = 0; i < distinct; ++i) {
+        // Repeats must not count.
+        sketch.add(HyperLogLog::hash(QVariant(qlonglong(i))));
+        sketch.add(HyperLogLog::hash(QVariant(qlonglong(i))));
+    }
+    double standardError = 1.04 / std::sqrt(double(1 << precision));
+    double relative = std::fabs(sketch.estimate() - distinct) / distinct;
+    QVERIFY2(relative <= 3 * standardError,
+             qPrintable(QString("estimate %1 for %2").arg(sketch.estimate()).arg(distinct)));
+}
+
+void SketchesTest::hashMatchesEqualValues()
+{
+    QCOMPARE(HyperLogLog::hash(QVariant(5)), HyperLogLog::hash(QVariant(5.0)));
+    QCOMPARE(HyperLogLog::hash(QVariant(5)), HyperLogLog::hash(QVariant(qlonglong(5))));
+    QCOMPARE(HyperLogLog::hash(QVariant(QString("abc"))), HyperLogLog::hash(QVariant(QString("abc"))));
+    QVERIFY(HyperLogLog::hash(QVariant(5.5)) != HyperLogLog::hash(QVariant(5)));
+    QVERIFY(HyperLogLog::hash(QVariant(QString("abc"))) != HyperLogLog::hash(QVariant(QString("abd"))));
+}
+
+void SketchesTest::quantiles_data()
+{
+    QTest::addColumn<int>("order");
+
+    QTest::newRow("shuffled") << 0;
+    QTest::newRow("ascending") << 1;
+    QTest::newRow("descending") << 2;
+}
+
+void SketchesTest::quantiles()
+{
+    QFETCH(int, order);
+
+    const int n = 100000;
+    const int k = 200;
+    QuantileSketch sketch(k);
+    for (int i = 0; i < n; ++i) {
+        // 7919 is coprime to n, so the shuffle visits every value once.
+        int value = order == 0 ? int(qint64(i) * 7919 % n) : order == 1 ? i : n - 1 - i;
+        sketch.add(value);
+    }
+    sketch.add(std::nan(""));
+    QCOMPARE(sketch.count(), qint64(n));
+
+    // Values are 0..n-1, so value v has rank (v + 1) / n.
+    const double bound = 2 * 1.7 / k;
+    for (double rank : {0.01, 0.1, 0.25, 0.5, 0.75, 0.9, 0.99}) {
+        double value = sketch.quantile(rank);
+        QVERIFY2(std::fabs((value + 1) / n - rank) <= bound,
+                 qPrintable(QString("quantile(%1) = %2").arg(rank).arg(value)));
+    }
+    for (int value = 0; value < n; value += 997) {
+        double atMost = sketch.countAtMost(value);
+        QVERIFY2(std::fabs(atMost - (value + 1)) / n <= bound,
+                 qPrintable(QString("countAtMost(%1) = %2").arg(value).arg(atMost)));
+    }
+    QCOMPARE(sketch.countAtMost(n), double(n));
+}
+
+void SketchesTest::emptyQuantile()
+{
+    QuantileSketch sketch;
+    QVERIFY(std::isnan(sketch.quantile(0.5)));
+    QCOMPARE(sketch.countAtMost(0), 0.0);
+}
+
+void SketchesTest::topValues()
+{
+    // 30% a, 20% b, 10% c and 4000 values seen once.
+    const int total = 10000;
+    const int capacity = 64;
+    TopValues sketch(capacity);
+    QHash<QString, qint64> exact;
+    for (int i = 0; i < total; ++i) {
+        int slot = i % 10;
+        QString value = slot < 3 ? "a" : slot < 5 ? "b" : slot == 5 ? "c" : QString("noise %1").arg(i);
+        sketch.add(value);
+        ++exact[value];
+    }
+
+    QVector<TopValues::Entry> top = sketch.top(capacity);
+    QCOMPARE(top.size(), capacity);
+    QCOMPARE(top.at(0).value, QString("a"));
+    QCOMPARE(top.at(1).value, QString("b"));
+    QCOMPARE(top.at(2).value, QString("c"));
+    for (const TopValues::Entry &entry : top) {
+        qint64 count = exact.value(entry.value);
+        QVERIFY2(entry.count >= count && entry.count - entry.error <= count, qPrintable(entry.value));
+        QVERIFY(entry.error <= total / capacity);
+    }
+    QCOMPARE(sketch.top(2).size(), 2);
+}
+
+void SketchesTest::topValuesLongValue()
+{
+    TopValues sketch;
+    sketch.add(QString(TopValues::MaxValueLength + 50, 'x'));
+    sketch.add(QString(TopValues::MaxValueLength + 1, 'x'));
+    QVector<TopValues::Entry> top = sketch.top(10);
+    QCOMPARE(top.size(), 1);
+    QCOMPARE(top.at(0).value, QString(TopValues::MaxValueLength, 'x'));
+    QCOMPARE(top.at(0).count, qint64(2));
+    QCOMPARE(top.at(0).error, qint64(0));
+}
+
+QTEST_GUILESS_MAIN(SketchesTest)
+
+#include "tst_sketches.moc"
@@ -0,0 +1,7 @@
+TEMPLATE = app
+TARGET = tst_sqlsplitter
+
+include(../tests.pri)
+
+SOURCES += \
+    tst_sqlsplitter.cpp
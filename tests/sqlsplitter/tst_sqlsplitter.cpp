@@ -0,0 +1,54 @@
+#include <QtTest>
+#include "sqleditor.h"
+
+// Statement boundaries as Ctrl+Enter finds them, per dialect.
+class SqlSplitterTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void statementUnderCursor_data();
+    void statementUnderCursor();
+};
+
+void SqlSplitterTest::statementUnderCursor_data()
+{
+    QTest::addColumn<int>("dialect");
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<bool>("atEnd");
+    QTest::addColumn<QString>("expected");
+
+    // standard_conforming_strings: the backslash is an ordinary character.
+    QTest::newRow("postgres backslash, last") << int(SqlHighlighter::PostgreSql)
+        << "SELECT 'a\\'; SELECT 1" << true << "SELECT 1";
+    QTest::newRow("postgres backslash, first") << int(SqlHighlighter::PostgreSql)
+        << "SELECT 'a\\'; SELECT 1" << false << "SELECT 'a\\'";
+    QTest::newRow("postgres backslash across lines") << int(SqlHighlighter::PostgreSql)
+        << "SELECT 'C:\\'\n;\nSELECT 1" << true << "SELECT 1";
+    QTest::newRow("postgres escape string") << int(SqlHighlighter::PostgreSql)
+        << "SELECT E'a\\'; b'; SELECT 1" << true << "SELECT 1";
+    QTest::newRow("postgres doubled quote") << int(SqlHighlighter::PostgreSql)
+        << "SELECT 'it''s;'; SELECT 1" << true << "SELECT 1";
+    // MySQL escapes the quote, so the string runs on past the semicolon.
+    QTest::newRow("mysql backslash") << int(SqlHighlighter::MySql)
+        << "SELECT 'a\\'; SELECT 1" << true << "SELECT 'a\\'; SELECT 1";
+    QTest::newRow("mysql escaped quote") << int(SqlHighlighter::MySql)
+        << "SELECT 'a\\';'; SELECT 1" << true << "SELECT 1";
+}
+
+void SqlSplitterTest::statementUnderCursor()
+{
+    QFETCH(int, dialect);
+    QFETCH(QString, text);
+    QFETCH(bool, atEnd);
+    QFETCH(QString, expected);
+
+    SqlEditor editor;
+    editor.setDialect(static_cast<SqlHighlighter::Dialect>(dialect));
+    editor.setPlainText(text);
+    editor.moveCursor(atEnd ? QTextCursor::End : QTextCursor::Start);
+    QCOMPARE(editor.statementUnderCursor(), expected);
+}
+
+QTEST_MAIN(SqlSplitterTest)
+
+#include "tst_sqlsplitter.moc"
@@ -0,0 +1,8 @@
+# Shared by the test binaries: the application sources plus QtTest.
+
+QT += testlib
+
+CONFIG += console testcase
+CONFIG -= app_bundle
+
+include(../db_manager.pri)
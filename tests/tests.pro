@@ -0,0 +1,9 @@
+TEMPLATE = subdirs
+
+# One QtTest binary per module; make check runs them all.
+SUBDIRS += \
+    sqlsplitter \
+    sketches \
+    resultpivot \
+    browsequery \
+    schemaindex
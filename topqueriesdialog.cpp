@@ -0,0 +1,256 @@
+#include "topqueriesdialog.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QSplitter>
+#include <QHeaderView>
+#include <QLocale>
+#include <QtConcurrent>
+
+namespace {
+
+// Samples older than the longest window are dropped, except the baseline
+// taken when the dialog opened.
+const qint64 MaxWindowMs = 15 * 60 * 1000;
+
+} // namespace
+
+TopQueriesDialog::TopQueriesDialog(QWidget *parent, const QString &serverName,
+                                   const DatabaseConnection::ConnectionParams &params)
+    : QDialog(parent), params(params), statistics(params), settings("DBManager", "Settings"), lastSampleMs(0)
+{
+    setWindowTitle(tr("Top Queries - %1").arg(serverName));
+    resize(1100, 650);
+
+    pool.setMaxThreadCount(1);
+    pool.setExpiryTimeout(-1);
+
+    auto layout = new QVBoxLayout(this);
+    auto controlsLayout = new QHBoxLayout;
+    controlsLayout->addWidget(new QLabel(tr("Sample every"), this));
+    intervalSpinBox = new QDoubleSpinBox(this);
+    intervalSpinBox->setRange(1.0, 300.0);
+    intervalSpinBox->setDecimals(0);
+    intervalSpinBox->setSuffix(tr(" s"));
+    intervalSpinBox->setValue(settings.value("topQueries/interval", 10).toDouble());
+    controlsLayout->addWidget(intervalSpinBox);
+    controlsLayout->addWidget(new QLabel(tr("Window:"), this));
+    windowComboBox = new QComboBox(this);
+    windowComboBox->addItem(tr("Last sample"), 0);
+    windowComboBox->addItem(tr("1 minute"), 60);
+    windowComboBox->addItem(tr("5 minutes"), 300);
+    windowComboBox->addItem(tr("15 minutes"), 900);
+    windowComboBox->addItem(tr("Since opened"), -1);
+    int windowIndex = windowComboBox->findData(settings.value("topQueries/window", 300).toInt());
+    windowComboBox->setCurrentIndex(windowIndex >= 0 ? windowIndex : 2);
+    controlsLayout->addWidget(windowComboBox);
+    pauseButton = new QPushButton(tr("Pause"), this);
+    controlsLayout->addWidget(pauseButton);
+    controlsLayout->addStretch();
+    openButton = new QPushButton(tr("Open in Editor with Plan"), this);
+    openButton->setEnabled(false);
+    controlsLayout->addWidget(openButton);
+    layout->addLayout(controlsLayout);
+
+    auto splitter = new QSplitter(Qt::Vertical, this);
+    model = new TopQueriesModel(this);
+    proxy = new QSortFilterProxyModel(this);
+    proxy->setSourceModel(model);
+    proxy->setSortRole(Qt::UserRole);
+    queriesView = new QTableView(splitter);
+    queriesView->setModel(proxy);
+    queriesView->setSortingEnabled(true);
+    queriesView->sortByColumn(TopQueriesModel::TotalTime, Qt::DescendingOrder);
+    queriesView->setSelectionBehavior(QAbstractItemView::SelectRows);
+    queriesView->setSelectionMode(QAbstractItemView::SingleSelection);
+    queriesView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    queriesView->verticalHeader()->hide();
+    queriesView->verticalHeader()->setDefaultSectionSize(queriesView->fontMetrics().height() + 6);
+    queriesView->horizontalHeader()->resizeSection(TopQueriesModel::Query, 420);
+    detailsEdit = new QPlainTextEdit(splitter);
+    detailsEdit->setReadOnly(true);
+    splitter->setStretchFactor(0, 4);
+    splitter->setStretchFactor(1, 1);
+    layout->addWidget(splitter);
+
+    statusLabel = new QLabel(tr("Taking the first sample..."), this);
+    layout->addWidget(statusLabel);
+
+    connect(&sampleTimer, &QTimer::timeout, this, &TopQueriesDialog::takeSample);
+    connect(&sampleWatcher, &QFutureWatcher<QueryStatistics::Sample>::finished, this, &TopQueriesDialog::showSample);
+    connect(&planWatcher, &QFutureWatcher<QString>::finished, this, &TopQueriesDialog::showPlan);
+    connect(pauseButton, &QPushButton::clicked, this, &TopQueriesDialog::togglePause);
+    connect(openButton, &QPushButton::clicked, this, &TopQueriesDialog::openSelected);
+    connect(queriesView, &QTableView::doubleClicked, this, &TopQueriesDialog::openSelected);
+    connect(intervalSpinBox, QOverload<double>::of(&QDoubleSpinBox::valueChanged), [this](double seconds) {
+        settings.setValue("topQueries/interval", seconds);
+        sampleTimer.setInterval(static_cast<int>(seconds * 1000));
+    });
+    connect(windowComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged), [this]() {
+        settings.setValue("topQueries/window", windowComboBox->currentData());
+        refreshView();
+    });
+    connect(queriesView->selectionModel(), &QItemSelectionModel::currentRowChanged,
+            this, &TopQueriesDialog::updateDetails);
+
+    sampleTimer.setInterval(static_cast<int>(intervalSpinBox->value() * 1000));
+    sampleTimer.start();
+    takeSample();
+}
+
+TopQueriesDialog::~TopQueriesDialog()
+{
+    sampleTimer.stop();
+    sampleWatcher.waitForFinished();
+    planWatcher.waitForFinished();
+    QueryStatistics *source = &statistics;
+    QtConcurrent::run(&pool, [source]() { source->close(); }).waitForFinished();
+}
+
+void TopQueriesDialog::takeSample()
+{
+    if (sampleWatcher.isRunning()) return;
+    QueryStatistics *source = &statistics;
+    sampleWatcher.setFuture(QtConcurrent::run(&pool, [source]() { return source->sample(); }));
+}
+
+void TopQueriesDialog::showSample()
+{
+    QueryStatistics::Sample sample = sampleWatcher.result();
+    if (!sample.ok) {
+        statusLabel->setText(tr("Sampling failed: %1").arg(sample.error));
+        return;
+    }
+    lastSampleMs = sample.elapsedMs;
+    for (auto it = sample.texts.constBegin(); it != sample.texts.constEnd(); ++it) {
+        texts.insert(it.key(), it.value());
+    }
+    sample.texts.clear();
+
+    bool postgres = sample.postgres;
+    queriesView->setColumnHidden(TopQueriesModel::HitRatio, !postgres);
+    queriesView->setColumnHidden(TopQueriesModel::BlocksRead, !postgres);
+    queriesView->setColumnHidden(TopQueriesModel::RowsExamined, postgres);
+
+    if (history.isEmpty()) {
+        baseline = sample;
+    }
+    history << sample;
+    qint64 oldest = sample.takenMs - MaxWindowMs;
+    // Keep one sample at or before the window start as its anchor.
+    while (history.size() > 2 && history.at(1).takenMs <= oldest) {
+        history.removeFirst();
+    }
+    refreshView();
+}
+
+void TopQueriesDialog::refreshView()
+{
+    if (history.size() < 2) {
+        statusLabel->setText(tr("First sample taken; rates appear with the next one"));
+        return;
+    }
+    const QueryStatistics::Sample &latest = history.last();
+
+    int windowSeconds = windowComboBox->currentData().toInt();
+    const QueryStatistics::Sample *from = &history.at(history.size() - 2);
+    if (windowSeconds < 0) {
+        from = &baseline;
+    } else if (windowSeconds > 0) {
+        // The newest sample that still covers the whole window, or the
+        // oldest one while the window is filling up.
+        qint64 start = latest.takenMs - windowSeconds * 1000LL;
+        from = &history.first();
+        for (int i = 0; i < history.size() - 1; ++i) {
+            if (history.at(i).takenMs > start) break;
+            from = &history.at(i);
+        }
+    }
+
+    QVector<QueryStatistics::Statement> statements = QueryStatistics::delta(*from, latest);
+    for (QueryStatistics::Statement &statement : statements) {
+        auto text = texts.constFind(statement.id);
+        if (text != texts.constEnd()) {
+            statement.database = text->database;
+            statement.query = text->query;
+        } else {
+            statement.query = tr("(text not available yet)");
+        }
+    }
+
+    const QueryStatistics::Statement *selected = selectedStatement();
+    QString selectedId = selected ? selected->id : QString();
+    double seconds = (latest.takenMs - from->takenMs) / 1000.0;
+    model->setStatements(statements, seconds);
+    int row = model->rowOf(selectedId);
+    if (row >= 0) {
+        queriesView->setCurrentIndex(proxy->mapFromSource(model->index(row, 0)));
+    }
+    updateDetails();
+
+    statusLabel->setText(tr("%1 statements over %2 s, %3 s of server time; sampled in %4 ms")
+                             .arg(QLocale().toString(statements.size()))
+                             .arg(seconds, 0, 'f', 0)
+                             .arg(model->totalMs() / 1000, 0, 'f', 1)
+                             .arg(lastSampleMs));
+}
+
+void TopQueriesDialog::togglePause()
+{
+    if (sampleTimer.isActive()) {
+        sampleTimer.stop();
+        pauseButton->setText(tr("Resume"));
+    } else {
+        sampleTimer.start();
+        pauseButton->setText(tr("Pause"));
+        takeSample();
+    }
+}
+
+const QueryStatistics::Statement *TopQueriesDialog::selectedStatement() const
+{
+    QModelIndex current = queriesView->currentIndex();
+    if (!current.isValid()) return nullptr;
+    return &model->statement(proxy->mapToSource(current).row());
+}
+
+void TopQueriesDialog::openSelected()
+{
+    const QueryStatistics::Statement *statement = selectedStatement();
+    if (!statement || !texts.contains(statement->id) || planWatcher.isRunning()) return;
+
+    DatabaseConnection::ConnectionParams explainParams = params;
+    QString database = statement->database;
+    QString sql = statement->query.trimmed();
+    planWatcher.setFuture(QtConcurrent::run(&pool, [explainParams, database, sql]() {
+        QString plan;
+        QString error;
+        QString text;
+        if (QueryStatistics::explain(explainParams, database, sql, &plan, &error)) {
+            text = QObject::tr("-- Plan in %1:\n").arg(database.isEmpty() ? explainParams.dbName : database);
+            for (const QString &line : plan.split('\n')) {
+                text += "-- " + line + "\n";
+            }
+        } else {
+            text = QObject::tr("-- No plan: %1\n").arg(error.simplified());
+        }
+        return text + sql + (sql.endsWith(';') ? "\n" : ";\n");
+    }));
+    openButton->setEnabled(false);
+    statusLabel->setText(tr("Explaining the statement..."));
+}
+
+void TopQueriesDialog::showPlan()
+{
+    updateDetails();
+    emit openStatement(planWatcher.result());
+}
+
+void TopQueriesDialog::updateDetails()
+{
+    const QueryStatistics::Statement *statement = selectedStatement();
+    openButton->setEnabled(statement && !planWatcher.isRunning());
+    QString details = statement ? statement->query : QString();
+    if (detailsEdit->toPlainText() != details) {
+        detailsEdit->setPlainText(details);
+    }
+}
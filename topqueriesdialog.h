@@ -0,0 +1,70 @@
+#ifndef TOPQUERIESDIALOG_H
+#define TOPQUERIESDIALOG_H
+
+#include <QDialog>
+#include <QTableView>
+#include <QSortFilterProxyModel>
+#include <QDoubleSpinBox>
+#include <QComboBox>
+#include <QPushButton>
+#include <QPlainTextEdit>
+#include <QLabel>
+#include <QTimer>
+#include <QThreadPool>
+#include <QFutureWatcher>
+#include <QSettings>
+#include <QList>
+#include "querystatistics.h"
+#include "topqueriesmodel.h"
+
+// Statements that used the most server time over a chosen window. Samples
+// of the cumulative counters are taken on one pooled thread; the window is
+// the difference between the newest sample and an older one kept here.
+class TopQueriesDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    TopQueriesDialog(QWidget *parent, const QString &serverName,
+                     const DatabaseConnection::ConnectionParams &params);
+    ~TopQueriesDialog();
+
+signals:
+    // Editor text: the plan as SQL comments, then the statement.
+    void openStatement(const QString &sql);
+
+private slots:
+    void takeSample();
+    void showSample();
+    void refreshView();
+    void togglePause();
+    void openSelected();
+    void showPlan();
+    void updateDetails();
+
+private:
+    const QueryStatistics::Statement *selectedStatement() const;
+
+    QTableView *queriesView;
+    TopQueriesModel *model;
+    QSortFilterProxyModel *proxy;
+    QDoubleSpinBox *intervalSpinBox;
+    QComboBox *windowComboBox;
+    QPushButton *pauseButton;
+    QPushButton *openButton;
+    QPlainTextEdit *detailsEdit;
+    QLabel *statusLabel;
+    QTimer sampleTimer;
+    QThreadPool pool;
+    DatabaseConnection::ConnectionParams params;
+    QueryStatistics statistics;
+    QFutureWatcher<QueryStatistics::Sample> sampleWatcher;
+    QFutureWatcher<QString> planWatcher;
+    QSettings settings;
+
+    QueryStatistics::Sample baseline;
+    QList<QueryStatistics::Sample> history;
+    QHash<QString, QueryStatistics::Text> texts;
+    qint64 lastSampleMs;
+};
+
+#endif // TOPQUERIESDIALOG_H
@@ -0,0 +1,133 @@
+#include "topqueriesmodel.h"
+#include <QLocale>
+
+namespace {
+
+const int DisplayQueryChars = 200;
+
+QString formatMs(double ms) {
+    if (ms < 1000) return QString("%1 ms").arg(ms, 0, 'f', ms < 10 ? 2 : 1);
+    return QString("%1 s").arg(ms / 1000, 0, 'f', ms < 60000 ? 2 : 0);
+}
+
+} // namespace
+
+TopQueriesModel::TopQueriesModel(QObject *parent)
+    : QAbstractTableModel(parent), seconds(0), windowTotalMs(0)
+{
+}
+
+int TopQueriesModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : statements.size();
+}
+
+int TopQueriesModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant TopQueriesModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QVariant();
+    }
+    switch (section) {
+    case Query: return QObject::tr("Query");
+    case Database: return QObject::tr("Database");
+    case CallsPerSecond: return QObject::tr("Calls/s");
+    case Calls: return QObject::tr("Calls");
+    case TotalTime: return QObject::tr("Total Time");
+    case MeanTime: return QObject::tr("Mean Time");
+    case TimeShare: return QObject::tr("% Time");
+    case Rows: return QObject::tr("Rows");
+    case HitRatio: return QObject::tr("Hit %");
+    case BlocksRead: return QObject::tr("Blocks Read");
+    case RowsExamined: return QObject::tr("Rows Examined");
+    }
+    return QVariant();
+}
+
+QVariant TopQueriesModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= statements.size()) {
+        return QVariant();
+    }
+    const QueryStatistics::Statement &statement = statements.at(index.row());
+    const QueryStatistics::Counters &delta = statement.delta;
+
+    if (role == Qt::ToolTipRole && index.column() == Query) {
+        return statement.query;
+    }
+    if (role == Qt::TextAlignmentRole) {
+        if (index.column() == Query || index.column() == Database) return QVariant();
+        return int(Qt::AlignRight | Qt::AlignVCenter);
+    }
+    if (role != Qt::DisplayRole && role != Qt::UserRole) {
+        return QVariant();
+    }
+
+    // Qt::UserRole carries raw numbers for sorting through the proxy.
+    bool raw = role == Qt::UserRole;
+    QLocale locale;
+    qint64 blocks = delta.blocksHit + delta.blocksRead;
+    switch (index.column()) {
+    case Query:
+        return raw ? statement.query : statement.query.simplified().left(DisplayQueryChars);
+    case Database:
+        return statement.database;
+    case CallsPerSecond: {
+        double rate = seconds > 0 ? delta.calls / seconds : 0;
+        return raw ? QVariant(rate) : QVariant(locale.toString(rate, 'f', rate < 10 ? 2 : 0));
+    }
+    case Calls:
+        return raw ? QVariant(delta.calls) : QVariant(locale.toString(delta.calls));
+    case TotalTime:
+        return raw ? QVariant(delta.totalMs) : QVariant(formatMs(delta.totalMs));
+    case MeanTime: {
+        double mean = delta.totalMs / delta.calls;
+        return raw ? QVariant(mean) : QVariant(formatMs(mean));
+    }
+    case TimeShare: {
+        double share = windowTotalMs > 0 ? delta.totalMs * 100 / windowTotalMs : 0;
+        return raw ? QVariant(share) : QVariant(QString::number(share, 'f', 1));
+    }
+    case Rows:
+        return raw ? QVariant(delta.rows) : QVariant(locale.toString(delta.rows));
+    case HitRatio: {
+        if (blocks == 0) return raw ? QVariant(-1.0) : QVariant();
+        double ratio = delta.blocksHit * 100.0 / blocks;
+        return raw ? QVariant(ratio) : QVariant(QString::number(ratio, 'f', 1));
+    }
+    case BlocksRead:
+        return raw ? QVariant(delta.blocksRead) : QVariant(locale.toString(delta.blocksRead));
+    case RowsExamined:
+        return raw ? QVariant(delta.rowsExamined) : QVariant(locale.toString(delta.rowsExamined));
+    }
+    return QVariant();
+}
+
+void TopQueriesModel::setStatements(const QVector<QueryStatistics::Statement> &fresh, double windowSeconds)
+{
+    beginResetModel();
+    statements = fresh;
+    seconds = windowSeconds;
+    windowTotalMs = 0;
+    for (const QueryStatistics::Statement &statement : statements) {
+        windowTotalMs += statement.delta.totalMs;
+    }
+    endResetModel();
+}
+
+const QueryStatistics::Statement &TopQueriesModel::statement(int row) const
+{
+    return statements.at(row);
+}
+
+int TopQueriesModel::rowOf(const QString &id) const
+{
+    for (int row = 0; row < statements.size(); ++row) {
+        if (statements.at(row).id == id) return row;
+    }
+    return -1;
+}
@@ -0,0 +1,35 @@
+#ifndef TOPQUERIESMODEL_H
+#define TOPQUERIESMODEL_H
+
+#include <QAbstractTableModel>
+#include <QVector>
+#include "querystatistics.h"
+
+// Statements that ran during a window, with rates over its length. The
+// whole set is replaced on every refresh; the view's proxy keeps the order.
+class TopQueriesModel : public QAbstractTableModel {
+public:
+    enum Column {
+        Query, Database, CallsPerSecond, Calls, TotalTime, MeanTime, TimeShare,
+        Rows, HitRatio, BlocksRead, RowsExamined, ColumnCount
+    };
+
+    explicit TopQueriesModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    void setStatements(const QVector<QueryStatistics::Statement> &statements, double seconds);
+    const QueryStatistics::Statement &statement(int row) const;
+    int rowOf(const QString &id) const;
+    double totalMs() const { return windowTotalMs; }
+
+private:
+    QVector<QueryStatistics::Statement> statements;
+    double seconds;
+    double windowTotalMs;
+};
+
+#endif // TOPQUERIESMODEL_H
@@ -0,0 +1,294 @@
+#include "tracer.h"
+#include "resultmemory.h"
+#include <QSettings>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QVector>
+#include <QHash>
+#include <QThread>
+#include <QCoreApplication>
+#include <QSaveFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <atomic>
+#include <chrono>
+
+namespace {
+
+const char *const SpanNames[] = {"connect", "execute", "fetch", "decode", "render", "sort", "export", "spill"};
+
+struct CounterInfo {
+    const char *name;
+    const char *help;
+    double scale;
+};
+
+const CounterInfo Counters[] = {
+    {"db_manager_statements_total", "Statements executed.", 1},
+    {"db_manager_statement_errors_total", "Statements that failed.", 1},
+    {"db_manager_rows_fetched_total", "Rows read from result sets.", 1},
+    {"db_manager_fetched_bytes_total", "Estimated size of the rows read.", 1},
+    {"db_manager_queue_waits_total", "Times a pipeline stage blocked on a full or empty queue.", 1},
+    {"db_manager_queue_wait_seconds_total", "Time pipeline stages spent blocked on their queues.", 1e-9},
+    {"db_manager_cache_hits_total", "Spooled rows served from an already decoded chunk.", 1},
+    {"db_manager_cache_misses_total", "Spooled rows that needed a chunk decoded.", 1},
+};
+
+// One slot of a ring, as a seqlock: the owner makes the sequence odd while
+// it fills the slot, and a reader keeps what it copied only if the
+// sequence was even before and unchanged after.
+struct Event {
+    QAtomicInteger<quint64> sequence;
+    QAtomicInteger<qint64> startNs;
+    QAtomicInteger<qint64> durationNs;
+    QAtomicInteger<qint64> value;
+    QAtomicInt span;
+    QAtomicInt thread;
+};
+
+struct Ring {
+    Ring() : next(0), thread(0) {}
+    Event events[Tracer::RingEvents];
+    quint64 next;          // touched by the owning thread only
+    int thread;            // id of the owner
+};
+
+struct Recorded {
+    int span;
+    int thread;
+    qint64 startNs;
+    qint64 durationNs;
+    qint64 value;
+};
+
+QMutex settingsMutex;
+bool settingsLoaded = false;
+Tracer::Settings cachedSettings;
+
+QAtomicInteger<qint64> spanCounts[Tracer::SpanCount];
+QAtomicInteger<qint64> spanNs[Tracer::SpanCount];
+
+// Rings are never freed: a thread that ends hands its ring back and the
+// next new thread takes it over, so pools replacing idle threads do not
+// grow the registry. Events carry their thread, so they keep their owner.
+QMutex registryMutex;
+QVector<Ring *> rings;
+QVector<Ring *> freeRings;
+QHash<int, QString> threadNames;
+int lastThread = 0;
+
+struct RingOwner {
+    RingOwner() : ring(nullptr) {}
+    ~RingOwner() {
+        if (ring) {
+            QMutexLocker locker(&registryMutex);
+            freeRings << ring;
+        }
+    }
+    Ring *ring;
+};
+
+thread_local RingOwner owner;
+
+Ring *threadRing() {
+    if (owner.ring) {
+        return owner.ring;
+    }
+    QMutexLocker locker(&registryMutex);
+    Ring *ring = freeRings.isEmpty() ? nullptr : freeRings.takeLast();
+    if (!ring) {
+        ring = new Ring;
+        rings << ring;
+    }
+    ring->thread = ++lastThread;
+    QThread *thread = QThread::currentThread();
+    QString name = thread->objectName();
+    if (name.isEmpty()) {
+        QCoreApplication *app = QCoreApplication::instance();
+        name = app && app->thread() == thread ? QString("main") : QString("thread %1").arg(ring->thread);
+    }
+    threadNames.insert(ring->thread, name);
+    owner.ring = ring;
+    return ring;
+}
+
+QVector<Recorded> snapshot(QHash<int, QString> *names) {
+    QVector<Recorded> recorded;
+    QMutexLocker locker(&registryMutex);
+    *names = threadNames;
+    for (const Ring *ring : rings) {
+        for (const Event &event : ring->events) {
+            quint64 before = event.sequence.loadAcquire();
+            if (before == 0 || (before & 1)) continue;
+            Recorded copy;
+            copy.span = event.span.loadRelaxed();
+            copy.thread = event.thread.loadRelaxed();
+            copy.startNs = event.startNs.loadRelaxed();
+            copy.durationNs = event.durationNs.loadRelaxed();
+            copy.value = event.value.loadRelaxed();
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (event.sequence.loadRelaxed() == before) {
+                recorded << copy;
+            }
+        }
+    }
+    return recorded;
+}
+
+Tracer::Settings readSettings() {
+    QSettings stored("DBManager", "Settings");
+    Tracer::Settings settings;
+    settings.enabled = stored.value("traceEnabled", false).toBool();
+    settings.metricsFile = stored.value("traceMetricsFile").toString();
+    settings.metricsIntervalSec = stored.value("traceMetricsIntervalSec", 15).toInt();
+    return settings;
+}
+
+} // namespace
+
+QAtomicInt Tracer::enabled(0);
+QAtomicInteger<qint64> Tracer::counters[Tracer::CounterCount];
+
+Tracer::Settings Tracer::settings() {
+    QMutexLocker locker(&settingsMutex);
+    if (!settingsLoaded) {
+        cachedSettings = readSettings();
+        enabled.storeRelaxed(cachedSettings.enabled ? 1 : 0);
+        settingsLoaded = true;
+    }
+    return cachedSettings;
+}
+
+void Tracer::reload() {
+    setSettings(readSettings());
+}
+
+void Tracer::setSettings(const Settings &settings) {
+    QMutexLocker locker(&settingsMutex);
+    cachedSettings = settings;
+    enabled.storeRelaxed(cachedSettings.enabled ? 1 : 0);
+    settingsLoaded = true;
+}
+
+qint64 Tracer::now() {
+    static const std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count();
+}
+
+void Tracer::record(Span span, qint64 startNs, qint64 value) {
+    qint64 durationNs = now() - startNs;
+    spanCounts[span].fetchAndAddRelaxed(1);
+    spanNs[span].fetchAndAddRelaxed(durationNs);
+
+    Ring *ring = threadRing();
+    quint64 index = ring->next++;
+    Event &event = ring->events[index % RingEvents];
+    event.sequence.storeRelaxed(2 * index + 1);
+    std::atomic_thread_fence(std::memory_order_release);
+    event.span.storeRelaxed(span);
+    event.thread.storeRelaxed(ring->thread);
+    event.startNs.storeRelaxed(startNs);
+    event.durationNs.storeRelaxed(durationNs);
+    event.value.storeRelaxed(value);
+    event.sequence.storeRelease(2 * index + 2);
+}
+
+QString Tracer::spanName(Span span) {
+    return QString::fromLatin1(SpanNames[span]);
+}
+
+bool Tracer::writeChromeTrace(const QString &path, QString *error) {
+    QHash<int, QString> names;
+    QVector<Recorded> recorded = snapshot(&names);
+    qint64 pid = QCoreApplication::applicationPid();
+
+    QJsonArray events;
+    for (auto it = names.constBegin(); it != names.constEnd(); ++it) {
+        QJsonObject args;
+        args["name"] = it.value();
+        QJsonObject event;
+        event["name"] = "thread_name";
+        event["ph"] = "M";
+        event["pid"] = double(pid);
+        event["tid"] = it.key();
+        event["args"] = args;
+        events.append(event);
+    }
+    for (const Recorded &span : recorded) {
+        QJsonObject event;
+        event["name"] = spanName(static_cast<Span>(span.span));
+        event["cat"] = "db_manager";
+        event["ph"] = "X";
+        event["ts"] = span.startNs / 1000.0;
+        event["dur"] = span.durationNs / 1000.0;
+        event["pid"] = double(pid);
+        event["tid"] = span.thread;
+        if (span.value != 0) {
+            QJsonObject args;
+            args["value"] = double(span.value);
+            event["args"] = args;
+        }
+        events.append(event);
+    }
+    // The counters as they are now, as one counter sample at the end.
+    QJsonObject totals;
+    for (int i = 0; i < CounterCount; ++i) {
+        totals[QString::fromLatin1(Counters[i].name)] = double(counters[i].loadRelaxed());
+    }
+    QJsonObject sample;
+    sample["name"] = "counters";
+    sample["ph"] = "C";
+    sample["ts"] = now() / 1000.0;
+    sample["pid"] = double(pid);
+    sample["args"] = totals;
+    events.append(sample);
+
+    QJsonObject trace;
+    trace["traceEvents"] = events;
+    trace["displayTimeUnit"] = "ms";
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) ||
+        file.write(QJsonDocument(trace).toJson(QJsonDocument::Compact)) < 0 || !file.commit()) {
+        *error = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+QString Tracer::prometheusText() {
+    QString text;
+    for (int i = 0; i < CounterCount; ++i) {
+        const CounterInfo &info = Counters[i];
+        text += QString("# HELP %1 %2\n# TYPE %1 counter\n").arg(info.name, info.help);
+        text += QString("%1 %2\n").arg(info.name).arg(counters[i].loadRelaxed() * info.scale, 0, 'g', 15);
+    }
+    text += "# HELP db_manager_spans_total Traced spans completed.\n# TYPE db_manager_spans_total counter\n";
+    for (int span = 0; span < SpanCount; ++span) {
+        text += QString("db_manager_spans_total{span=\"%1\"} %2\n").arg(SpanNames[span]).arg(spanCounts[span].loadRelaxed());
+    }
+    text += "# HELP db_manager_span_seconds_total Time spent in traced spans.\n"
+            "# TYPE db_manager_span_seconds_total counter\n";
+    for (int span = 0; span < SpanCount; ++span) {
+        text += QString("db_manager_span_seconds_total{span=\"%1\"} %2\n")
+                    .arg(SpanNames[span]).arg(spanNs[span].loadRelaxed() / 1e9, 0, 'g', 15);
+    }
+    text += QString("# HELP db_manager_result_resident_bytes Memory held by results.\n"
+                    "# TYPE db_manager_result_resident_bytes gauge\n"
+                    "db_manager_result_resident_bytes %1\n"
+                    "# HELP db_manager_result_spilled_bytes Results spilled to disk.\n"
+                    "# TYPE db_manager_result_spilled_bytes gauge\n"
+                    "db_manager_result_spilled_bytes %2\n")
+                .arg(ResultMemory::resident()).arg(ResultMemory::spilled());
+    return text;
+}
+
+bool Tracer::writePrometheus(const QString &path, QString *error) {
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(prometheusText().toUtf8()) < 0 || !file.commit()) {
+        *error = file.errorString();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,87 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <QString>
+#include <QAtomicInt>
+#include <QAtomicInteger>
+
+// Scoped spans and counters for seeing where the time of a result goes:
+// connect, execute, fetch, decode, render, sort, export. Each thread writes
+// its spans into a ring of its own without taking a lock, keeping the last
+// RingEvents of them, and the rings can be written out as a Chrome trace
+// (chrome://tracing, Perfetto). Counters and span totals add up since the
+// start and can be written as a Prometheus textfile for node_exporter.
+//
+// Off unless enabled in the settings; a span then costs one relaxed load.
+class Tracer {
+public:
+    enum Span { Connect, Execute, Fetch, Decode, Render, Sort, Export, Spill, SpanCount };
+    enum Counter {
+        Statements,
+        StatementErrors,
+        RowsFetched,
+        BytesFetched,
+        QueueWaits,        // a pipeline stage blocked on a full or empty queue
+        QueueWaitNs,
+        CacheHits,         // spooled rows served from decoded chunks
+        CacheMisses,
+        CounterCount
+    };
+
+    static const int RingEvents = 8192;
+
+    struct Settings {
+        Settings() : enabled(false), metricsIntervalSec(15) {}
+        bool enabled;
+        QString metricsFile;       // Prometheus textfile; empty for none
+        int metricsIntervalSec;
+    };
+
+    // Records a span from construction to destruction on this thread.
+    class Scope {
+    public:
+        explicit Scope(Span span) : span(span), startNs(Tracer::isEnabled() ? Tracer::now() : -1), value(0) {}
+        ~Scope() {
+            if (startNs >= 0) {
+                Tracer::record(span, startNs, value);
+            }
+        }
+        // Shown with the span, such as the rows it handled.
+        void setValue(qint64 value) { this->value = value; }
+
+    private:
+        Q_DISABLE_COPY(Scope)
+        Span span;
+        qint64 startNs;
+        qint64 value;
+    };
+
+    // Cached; reload() after the settings dialog saved them.
+    static Settings settings();
+    static void reload();
+    static void setSettings(const Settings &settings);
+
+    static bool isEnabled() { return enabled.loadRelaxed() != 0; }
+    static void count(Counter counter, qint64 amount = 1) {
+        if (isEnabled()) {
+            counters[counter].fetchAndAddRelaxed(amount);
+        }
+    }
+    static qint64 counter(Counter counter) { return counters[counter].loadRelaxed(); }
+
+    static qint64 now();
+    static void record(Span span, qint64 startNs, qint64 value);
+
+    static QString spanName(Span span);
+    // The spans still in the rings, as Chrome trace JSON.
+    static bool writeChromeTrace(const QString &path, QString *error);
+    static QString prometheusText();
+    // Replaced atomically, as the textfile collector expects.
+    static bool writePrometheus(const QString &path, QString *error);
+
+private:
+    static QAtomicInt enabled;
+    static QAtomicInteger<qint64> counters[CounterCount];
+};
+
+#endif // TRACER_H
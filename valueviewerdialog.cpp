@@ -0,0 +1,224 @@
+#include "valueviewerdialog.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QFileDialog>
+#include <QFile>
+#include <QFontDatabase>
+#include <QJsonDocument>
+#include <QJsonParseError>
+#include <QLocale>
+#include <QTextCursor>
+#include <QSignalBlocker>
+
+namespace {
+
+enum Mode { TextMode, JsonMode, HexMode };
+
+// Characters (or bytes) read per round trip.
+const int ChunkLength = 256 * 1024;
+// Hex dumps grow a value about four times; larger values are cut here.
+const int MaxHexBytes = 4 * 1024 * 1024;
+
+QString hexDump(const QByteArray &data, int limit) {
+    QString dump;
+    int size = qMin(data.size(), limit);
+    dump.reserve(size / 16 * 78);
+    for (int offset = 0; offset < size; offset += 16) {
+        QByteArray line = data.mid(offset, qMin(16, size - offset));
+        QString hex = QString::fromLatin1(line.toHex(' '));
+        QString ascii;
+        for (char byte : line) {
+            ascii += (byte >= 32 && byte < 127) ? QLatin1Char(byte) : QLatin1Char('.');
+        }
+        dump += QString("%1  %2  |%3|\n").arg(offset, 8, 16, QChar('0')).arg(hex, -47).arg(ascii);
+    }
+    return dump;
+}
+
+} // namespace
+
+ValueViewerDialog::ValueViewerDialog(QWidget *parent, const QString &title)
+    : QDialog(parent), connection(nullptr), length(-1), loaded(0), binary(false)
+{
+    setWindowTitle(title);
+    resize(800, 600);
+
+    auto layout = new QVBoxLayout(this);
+    auto topLayout = new QHBoxLayout;
+    modeComboBox = new QComboBox(this);
+    modeComboBox->addItem(tr("Text"), TextMode);
+    modeComboBox->addItem(tr("JSON"), JsonMode);
+    modeComboBox->addItem(tr("Hex"), HexMode);
+    topLayout->addWidget(modeComboBox);
+    statusLabel = new QLabel(this);
+    topLayout->addWidget(statusLabel, 1);
+    layout->addLayout(topLayout);
+
+    valueEdit = new QPlainTextEdit(this);
+    valueEdit->setReadOnly(true);
+    valueEdit->setLineWrapMode(QPlainTextEdit::NoWrap);
+    valueEdit->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    layout->addWidget(valueEdit);
+
+    progressBar = new QProgressBar(this);
+    progressBar->hide();
+    layout->addWidget(progressBar);
+
+    auto buttonLayout = new QHBoxLayout;
+    auto saveButton = new QPushButton(tr("Save to File..."), this);
+    cancelButton = new QPushButton(tr("Stop Loading"), this);
+    cancelButton->hide();
+    auto closeButton = new QPushButton(tr("Close"), this);
+    buttonLayout->addWidget(saveButton);
+    buttonLayout->addStretch();
+    buttonLayout->addWidget(cancelButton);
+    buttonLayout->addWidget(closeButton);
+    layout->addLayout(buttonLayout);
+
+    connect(&chunkTimer, &QTimer::timeout, this, &ValueViewerDialog::loadNextChunk);
+    connect(modeComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &ValueViewerDialog::render);
+    connect(saveButton, &QPushButton::clicked, this, &ValueViewerDialog::saveToFile);
+    connect(cancelButton, &QPushButton::clicked, [this]() { finishLoading(tr("Stopped")); });
+    connect(closeButton, &QPushButton::clicked, this, &QDialog::accept);
+}
+
+void ValueViewerDialog::showValue(const QString &text)
+{
+    value = text.toUtf8();
+    length = text.size();
+    loaded = length;
+    binary = false;
+    if (modeComboBox->currentData().toInt() == TextMode && text.trimmed().startsWith('{')) {
+        modeComboBox->setCurrentIndex(modeComboBox->findData(JsonMode));
+    }
+    render();
+}
+
+void ValueViewerDialog::load(DatabaseConnection *databaseConnection, const LargeValues::ValueRef &valueRef)
+{
+    connection = databaseConnection;
+    ref = valueRef;
+    binary = ref.binary;
+    value.clear();
+    loaded = 0;
+
+    QString error;
+    if (!LargeValues::valueLength(*connection, ref, &length, &error)) {
+        statusLabel->setText(tr("Cannot load the value: %1").arg(error));
+        return;
+    }
+    if (length < 0) {
+        statusLabel->setText(tr("NULL"));
+        return;
+    }
+
+    int mode = binary ? HexMode : ref.json ? JsonMode : TextMode;
+    {
+        const QSignalBlocker blocker(modeComboBox);
+        modeComboBox->setCurrentIndex(modeComboBox->findData(mode));
+    }
+    valueEdit->clear();
+    progressBar->setRange(0, 1000);
+    progressBar->setValue(0);
+    progressBar->show();
+    cancelButton->show();
+    chunkTimer.start(0);
+}
+
+void ValueViewerDialog::loadNextChunk()
+{
+    QVariant chunk;
+    QString error;
+    int wanted = static_cast<int>(qMin<qint64>(ChunkLength, length - loaded));
+    if (wanted <= 0) {
+        finishLoading(QString());
+        return;
+    }
+    if (!LargeValues::readChunk(*connection, ref, loaded, wanted, &chunk, &error)) {
+        finishLoading(tr("Loading failed: %1").arg(error));
+        return;
+    }
+
+    qint64 received;
+    if (binary) {
+        QByteArray bytes = chunk.toByteArray();
+        value += bytes;
+        received = bytes.size();
+    } else {
+        QString text = chunk.toString();
+        value += text.toUtf8();
+        received = text.size();
+        // Text streams into the view as it arrives; other modes render at the end.
+        if (modeComboBox->currentData().toInt() == TextMode) {
+            QTextCursor cursor(valueEdit->document());
+            cursor.movePosition(QTextCursor::End);
+            cursor.insertText(text);
+        }
+    }
+    loaded += received;
+    progressBar->setValue(length > 0 ? static_cast<int>(loaded * 1000 / length) : 1000);
+    statusLabel->setText(tr("Loading... %1").arg(QLocale().formattedDataSize(value.size())));
+    if (received == 0 || loaded >= length) {
+        finishLoading(QString());
+    }
+}
+
+void ValueViewerDialog::finishLoading(const QString &message)
+{
+    chunkTimer.stop();
+    progressBar->hide();
+    cancelButton->hide();
+    render();
+    if (!message.isEmpty()) {
+        statusLabel->setText(message + " - " + statusLabel->text());
+    }
+}
+
+void ValueViewerDialog::render()
+{
+    if (chunkTimer.isActive()) {
+        return;
+    }
+    QLocale locale;
+    QString status = binary ? locale.formattedDataSize(value.size())
+                            : tr("%1 characters").arg(locale.toString(loaded));
+    if (length >= 0 && loaded < length) {
+        status += tr(" of %1 loaded").arg(binary ? locale.formattedDataSize(length) : locale.toString(length));
+    }
+
+    switch (modeComboBox->currentData().toInt()) {
+    case TextMode:
+        valueEdit->setPlainText(QString::fromUtf8(value));
+        break;
+    case JsonMode: {
+        QJsonParseError parseError;
+        QJsonDocument document = QJsonDocument::fromJson(value, &parseError);
+        if (parseError.error == QJsonParseError::NoError) {
+            valueEdit->setPlainText(QString::fromUtf8(document.toJson(QJsonDocument::Indented)));
+        } else {
+            valueEdit->setPlainText(QString::fromUtf8(value));
+            status += tr(", not valid JSON: %1").arg(parseError.errorString());
+        }
+        break;
+    }
+    case HexMode:
+        valueEdit->setPlainText(hexDump(value, MaxHexBytes));
+        if (value.size() > MaxHexBytes) {
+            status += tr(", first %1 shown").arg(locale.formattedDataSize(MaxHexBytes));
+        }
+        break;
+    }
+    statusLabel->setText(status);
+}
+
+void ValueViewerDialog::saveToFile()
+{
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Save Value"));
+    if (fileName.isEmpty()) return;
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly) || file.write(value) != value.size()) {
+        statusLabel->setText(tr("Cannot save %1: %2").arg(fileName, file.errorString()));
+        return;
+    }
+    statusLabel->setText(tr("Saved %1").arg(QLocale().formattedDataSize(value.size())));
+}
@@ -0,0 +1,46 @@
+#ifndef VALUEVIEWERDIALOG_H
+#define VALUEVIEWERDIALOG_H
+
+#include <QDialog>
+#include <QComboBox>
+#include <QPlainTextEdit>
+#include <QProgressBar>
+#include <QLabel>
+#include <QPushButton>
+#include <QTimer>
+#include "largevalues.h"
+
+// Shows one cell as text, formatted JSON or a hex dump. Large values are
+// streamed from the server in chunks through the window's connection.
+class ValueViewerDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    ValueViewerDialog(QWidget *parent, const QString &title);
+
+    void showValue(const QString &text);
+    void load(DatabaseConnection *connection, const LargeValues::ValueRef &ref);
+
+private slots:
+    void loadNextChunk();
+    void render();
+    void saveToFile();
+
+private:
+    void finishLoading(const QString &message);
+
+    QComboBox *modeComboBox;
+    QPlainTextEdit *valueEdit;
+    QProgressBar *progressBar;
+    QLabel *statusLabel;
+    QPushButton *cancelButton;
+    QTimer chunkTimer;
+    DatabaseConnection *connection;
+    LargeValues::ValueRef ref;
+    QByteArray value;         // UTF-8 for text values
+    qint64 length;            // characters or bytes, see LargeValues::valueLength()
+    qint64 loaded;
+    bool binary;
+};
+
+#endif // VALUEVIEWERDIALOG_H